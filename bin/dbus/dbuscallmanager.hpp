@@ -273,6 +273,12 @@ public:
         return libjami::currentMediaList(accountId, callId);
     }
 
+    auto getCallMediaStats(const std::string& accountId,
+                           const std::string& callId) -> decltype(libjami::getCallMediaStats(accountId, callId))
+    {
+        return libjami::getCallMediaStats(accountId, callId);
+    }
+
     auto startRecordedFilePlayback(const std::string& filepath) -> decltype(libjami::startRecordedFilePlayback(filepath))
     {
         return libjami::startRecordedFilePlayback(filepath);
@@ -399,7 +405,9 @@ private:
                exportable_serialized_callback<CallSignal::RemoteRecordingChanged>(
                    std::bind(&DBusCallManager::emitRemoteRecordingChanged, this, _1, _2, _3)),
                exportable_serialized_callback<CallSignal::MediaNegotiationStatus>(
-                   std::bind(&DBusCallManager::emitMediaNegotiationStatus, this, _1, _2, _3))};
+                   std::bind(&DBusCallManager::emitMediaNegotiationStatus, this, _1, _2, _3)),
+               exportable_serialized_callback<CallSignal::MediaStatsUpdated>(
+                   std::bind(&DBusCallManager::emitMediaStatsUpdated, this, _1, _2, _3))};
 
         libjami::registerSignalHandlers(callEvHandlers);
     }
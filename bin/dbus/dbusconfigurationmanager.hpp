@@ -639,6 +639,12 @@ public:
         return libjami::conversationInfos(accountId, conversationId);
     }
 
+    std::map<std::string, std::string> conversationSummary(const std::string& accountId,
+                                                           const std::string& conversationId)
+    {
+        return libjami::conversationSummary(accountId, conversationId);
+    }
+
     void setConversationPreferences(const std::string& accountId,
                                     const std::string& conversationId,
                                     const std::map<std::string, std::string>& infos)
@@ -652,6 +658,11 @@ public:
         return libjami::getConversationPreferences(accountId, conversationId);
     }
 
+    std::map<std::string, std::string> getConversationMaintenanceStats(const std::string& accountId)
+    {
+        return libjami::getConversationMaintenanceStats(accountId);
+    }
+
     void addConversationMember(const std::string& accountId,
                                const std::string& conversationId,
                                const std::string& contactUri)
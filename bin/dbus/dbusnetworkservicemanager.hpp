@@ -78,6 +78,12 @@ public:
         return libjami::closeServiceTunnel(accountId, tunnelId);
     }
 
+    auto setServiceTunnelPoolSize(const std::string& accountId, const std::string& tunnelId, const uint32_t& poolSize)
+        -> decltype(libjami::setServiceTunnelPoolSize(accountId, tunnelId, poolSize))
+    {
+        return libjami::setServiceTunnelPoolSize(accountId, tunnelId, poolSize);
+    }
+
     auto getActiveTunnels(const std::string& accountId) -> decltype(libjami::getActiveTunnels(accountId))
     {
         return libjami::getActiveTunnels(accountId);
@@ -50,6 +50,8 @@ public:
     virtual void remoteRecordingChanged(const std::string& callId, const std::string& peer_number, bool state){}
     virtual void mediaNegotiationStatus(const std::string& callId, const std::string& event,
         const std::vector<std::map<std::string, std::string>>& mediaList){}
+    virtual void mediaStatsUpdated(const std::string& accountId, const std::string& callId,
+        const std::vector<std::map<std::string, std::string>>& stats){}
 };
 
 
@@ -96,6 +98,7 @@ std::string getConferenceId(const std::string& accountId, const std::string& cal
 std::map<std::string, std::string> getConferenceDetails(const std::string& accountId, const std::string& callId);
 std::vector<libjami::MediaMap> currentMediaList(const std::string& accountId, const std::string& callId);
 std::vector<std::map<std::string, std::string>> getConferenceInfos(const std::string& accountId, const std::string& confId);
+std::vector<std::map<std::string, std::string>> getCallMediaStats(const std::string& accountId, const std::string& callId);
 void setModerator(const std::string& accountId, const std::string& confId, const std::string& peerId, const bool& state);
 void muteStream(const std::string& accountId,
                     const std::string& confId,
@@ -173,4 +176,6 @@ public:
     virtual void remoteRecordingChanged(const std::string& callId, const std::string& peer_number, bool state){}
     virtual void mediaNegotiationStatus(const std::string& callId, const std::string& event,
         const std::vector<std::map<std::string, std::string>>& mediaList){}
+    virtual void mediaStatsUpdated(const std::string& accountId, const std::string& callId,
+        const std::vector<std::map<std::string, std::string>>& stats){}
 };
@@ -46,6 +46,7 @@ std::string openServiceTunnel(const std::string& accountId,
                               const std::string& serviceName,
                               uint16_t localPort);
 bool closeServiceTunnel(const std::string& accountId, const std::string& tunnelId);
+bool setServiceTunnelPoolSize(const std::string& accountId, const std::string& tunnelId, uint32_t poolSize);
 std::vector<std::map<std::string, std::string>> getActiveTunnels(const std::string& accountId);
 
 }
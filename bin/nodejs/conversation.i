@@ -64,8 +64,10 @@ struct SwarmMessage
   std::vector<std::map<std::string, std::string>> getConversationRequests(const std::string& accountId);
   void updateConversationInfos(const std::string& accountId, const std::string& conversationId, const std::map<std::string, std::string>& infos);
   std::map<std::string, std::string> conversationInfos(const std::string& accountId, const std::string& conversationId);
+  std::map<std::string, std::string> conversationSummary(const std::string& accountId, const std::string& conversationId);
   void setConversationPreferences(const std::string& accountId, const std::string& conversationId, const std::map<std::string, std::string>& prefs);
   std::map<std::string, std::string> getConversationPreferences(const std::string& accountId, const std::string& conversationId);
+  std::map<std::string, std::string> getConversationMaintenanceStats(const std::string& accountId);
 
   // Member management
   void addConversationMember(const std::string& accountId, const std::string& conversationId, const std::string& contactUri);
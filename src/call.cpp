@@ -72,6 +72,7 @@ Call::Call(const std::shared_ptr<Account>& account, const std::string& id, Call:
     , type_(type)
     , account_(account)
     , timeoutTimer_(*Manager::instance().ioContext())
+    , mediaStatsTimer_(*Manager::instance().ioContext())
 {
     addStateListener([this](Call::CallState call_state, Call::ConnectionState cnx_state, int code) {
         checkPendingIM();
@@ -114,6 +115,13 @@ Call::Call(const std::shared_ptr<Account>& account, const std::string& id, Call:
             }
         }
 
+        if (call_state == CallState::ACTIVE and cnx_state == ConnectionState::CONNECTED) {
+            runOnMainThread([callWkPtr = weak_from_this()] {
+                if (auto call = callWkPtr.lock())
+                    call->scheduleMediaStats();
+            });
+        }
+
         // kill pending subcalls at disconnect
         if (call_state == CallState::OVER)
             hangupCalls(safePopSubcalls(), 0);
@@ -126,6 +134,25 @@ Call::Call(const std::shared_ptr<Account>& account, const std::string& id, Call:
 
 Call::~Call() {}
 
+void
+Call::scheduleMediaStats()
+{
+    mediaStatsTimer_.expires_after(MEDIA_STATS_INTERVAL);
+    mediaStatsTimer_.async_wait([callWkPtr = weak_from_this()](const std::error_code& ec) {
+        if (ec == asio::error::operation_aborted)
+            return;
+        auto call = callWkPtr.lock();
+        if (not call or call->getState() == CallState::OVER)
+            return;
+        if (call->getState() == CallState::ACTIVE) {
+            auto stats = call->getMediaStats();
+            if (not stats.empty())
+                emitSignal<libjami::CallSignal::MediaStatsUpdated>(call->getAccountId(), call->getCallId(), stats);
+        }
+        call->scheduleMediaStats();
+    });
+}
+
 void
 Call::removeCall(int code)
 {
@@ -600,7 +627,22 @@ Call::setConferenceInfo(const std::string& msg)
     ConfInfo newInfo;
     Json::Value json;
     if (json::parse(msg, json)) {
-        if (json.isObject()) {
+        if (json.isObject() and json.isMember("base")) {
+            // incremental confInfo
+            std::lock_guard lk(confInfoMutex_);
+            if (receivedConfInfoSeq_ == 0 or json["base"].asUInt64() != receivedConfInfoSeq_) {
+                if (not confInfoResyncing_) {
+                    JAMI_WARNING("[call:{}] Missed a conference info revision, asking for a full one", getCallId());
+                    requestConfInfo();
+                }
+                return;
+            }
+            receivedConfInfo_.applyDelta(json);
+            receivedConfInfoSeq_ = json["seq"].asUInt64();
+            confInfoDeltasApplied_++;
+            newInfo = receivedConfInfo_;
+            peerConfProtocol_ = newInfo.v;
+        } else if (json.isObject()) {
             // new confInfo
             if (json.isMember("p")) {
                 for (const auto& participantInfo : json["p"]) {
@@ -619,6 +661,18 @@ Call::setConferenceInfo(const std::string& msg)
                 newInfo.w = json["w"].asInt();
             if (json.isMember("h"))
                 newInfo.h = json["h"].asInt();
+            if (json.isMember("layout"))
+                newInfo.layout = json["layout"].asInt();
+
+            // A revision number means the host is able to send deltas
+            std::lock_guard lk(confInfoMutex_);
+            receivedConfInfoSeq_ = json["seq"].asUInt64();
+            receivedConfInfo_ = newInfo;
+            confInfoResyncing_ = false;
+            if (receivedConfInfoSeq_ == 0)
+                confInfoRequested_ = false;
+            else if (not confInfoRequested_)
+                requestConfInfo();
         } else {
             // old confInfo
             for (const auto& participantInfo : json) {
@@ -649,6 +703,20 @@ Call::setConferenceInfo(const std::string& msg)
     }
 }
 
+void
+Call::requestConfInfo()
+{
+    confInfoRequested_ = true;
+    confInfoResyncing_ = true;
+    Json::Value root;
+    root["version"] = 1;
+    root[ConfInfo::REQUEST_KEY]["delta"] = ConfInfo::DELTA_VERSION;
+    dht::ThreadPool::io().run([w = weak_from_this(), root = std::move(root)] {
+        if (auto shared = w.lock())
+            shared->sendConfOrder(root);
+    });
+}
+
 void
 Call::sendConfOrder(const Json::Value& root)
 {
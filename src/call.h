@@ -26,6 +26,7 @@
 #include "media/peerrecorder.h"
 #include "media/media_codec.h"
 #include "media/media_attribute.h"
+#include "media/media_stats.h"
 
 #include <dhtnet/ip_utils.h>
 #include <asio/steady_timer.hpp>
@@ -427,6 +428,20 @@ public:
         return confInfo_.toVectorMapStringString();
     }
 
+    /**
+     * Number of conference info deltas received from the host and applied
+     */
+    uint64_t getConfInfoDeltasApplied() const
+    {
+        std::lock_guard lk(confInfoMutex_);
+        return confInfoDeltasApplied_;
+    }
+
+    /**
+     * Media pipeline statistics of every stream of the call
+     */
+    std::vector<std::map<std::string, std::string>> getMediaStats() const { return mediaStats_->report(); }
+
     std::unique_ptr<AudioDeviceGuard> audioGuard;
     void sendConfOrder(const Json::Value& root);
     void sendConfInfo(const std::string& json);
@@ -517,9 +532,32 @@ protected:
 
     /// Supported conference protocol version
     int peerConfProtocol_ {0};
+
+    // Last revision received from the conference host, deltas are applied on top of it.
+    // Protected by confInfoMutex_
+    ConfInfo receivedConfInfo_ {};
+    uint64_t receivedConfInfoSeq_ {0};
+    // The host was asked for deltas
+    bool confInfoRequested_ {false};
+    // Waiting for the full revision following a request
+    bool confInfoResyncing_ {false};
+    uint64_t confInfoDeltasApplied_ {0};
+
+    /**
+     * Ask the conference host to send deltas, starting with a full revision.
+     * Must be called with confInfoMutex_ held.
+     */
+    void requestConfInfo();
     std::string toUsername_ {};
 
     asio::steady_timer timeoutTimer_;
+
+    // Period of MediaStatsUpdated signals while the call is active
+    static constexpr std::chrono::seconds MEDIA_STATS_INTERVAL {5};
+    asio::steady_timer mediaStatsTimer_;
+    void scheduleMediaStats();
+
+    const std::shared_ptr<CallMediaStats> mediaStats_ {std::make_shared<CallMediaStats>()};
 };
 
 // Helpers
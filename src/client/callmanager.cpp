@@ -390,6 +390,16 @@ getConferenceInfos(const std::string& accountId, const std::string& confId)
     return {};
 }
 
+std::vector<std::map<std::string, std::string>>
+getCallMediaStats(const std::string& accountId, const std::string& callId)
+{
+    if (const auto account = jami::Manager::instance().getAccount(accountId)) {
+        if (auto call = account->getCall(callId))
+            return call->getMediaStats();
+    }
+    return {};
+}
+
 void
 playDTMF(const std::string& key)
 {
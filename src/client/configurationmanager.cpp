@@ -575,6 +575,14 @@ closeServiceTunnel(const std::string& accountId, const std::string& tunnelId)
     return false;
 }
 
+bool
+setServiceTunnelPoolSize(const std::string& accountId, const std::string& tunnelId, uint32_t poolSize)
+{
+    if (auto acc = jami::Manager::instance().getAccount<jami::JamiAccount>(accountId))
+        return acc->setServiceTunnelPoolSize(tunnelId, poolSize);
+    return false;
+}
+
 std::vector<std::map<std::string, std::string>>
 getActiveTunnels(const std::string& accountId)
 {
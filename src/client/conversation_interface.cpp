@@ -111,6 +111,15 @@ conversationInfos(const std::string& accountId, const std::string& conversationI
     return {};
 }
 
+std::map<std::string, std::string>
+conversationSummary(const std::string& accountId, const std::string& conversationId)
+{
+    if (auto acc = jami::Manager::instance().getAccount<jami::JamiAccount>(accountId))
+        if (auto* convModule = acc->convModule(true))
+            return convModule->conversationSummary(conversationId);
+    return {};
+}
+
 void
 setConversationPreferences(const std::string& accountId,
                            const std::string& conversationId,
@@ -130,6 +139,15 @@ getConversationPreferences(const std::string& accountId, const std::string& conv
     return {};
 }
 
+std::map<std::string, std::string>
+getConversationMaintenanceStats(const std::string& accountId)
+{
+    if (auto acc = jami::Manager::instance().getAccount<jami::JamiAccount>(accountId))
+        if (auto* convModule = acc->convModule(true))
+            return convModule->maintenanceStats();
+    return {};
+}
+
 // Member management
 void
 addConversationMember(const std::string& accountId, const std::string& conversationId, const std::string& contactUri)
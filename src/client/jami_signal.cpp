@@ -46,6 +46,7 @@ getSignalHandlers()
         exported_callback<libjami::CallSignal::OnConferenceInfosUpdated>(),
         exported_callback<libjami::CallSignal::RemoteRecordingChanged>(),
         exported_callback<libjami::CallSignal::MediaNegotiationStatus>(),
+        exported_callback<libjami::CallSignal::MediaStatsUpdated>(),
 
         /* Configuration */
         exported_callback<libjami::ConfigurationSignal::VolumeChanged>(),
@@ -50,6 +50,7 @@ namespace jami {
 Conference::Conference(const std::shared_ptr<Account>& account, const std::string& confId)
     : id_(confId.empty() ? Manager::instance().callFactory.getNewCallID() : confId)
     , account_(account)
+    , confInfoTimer_(*Manager::instance().ioContext())
 #ifdef ENABLE_VIDEO
     , videoEnabled_(account->isVideoEnabled())
 #endif
@@ -247,6 +248,7 @@ Conference::registerProtocolHandlers()
 Conference::~Conference()
 {
     JAMI_LOG("[conf:{}] Destroying conference", id_);
+    confInfoTimer_.cancel();
 
 #ifdef ENABLE_VIDEO
     auto* videoManager = Manager::instance().getVideoManager();
@@ -979,7 +981,7 @@ ConfInfo::toVectorMapStringString() const
 }
 
 std::string
-ConfInfo::toString() const
+ConfInfo::toString(uint64_t seq) const
 {
     Json::Value val = {};
     for (const auto& info : *this) {
@@ -989,26 +991,73 @@ ConfInfo::toString() const
     val["h"] = h;
     val["v"] = v;
     val["layout"] = layout;
+    if (seq)
+        val["seq"] = Json::UInt64(seq);
+    return json::toString(val);
+}
+
+std::string
+ConfInfo::toDeltaString(const ConfInfo& base, uint64_t seq) const
+{
+    Json::Value val = {};
+    val["p"] = Json::arrayValue;
+    val["removed"] = Json::arrayValue;
+    for (const auto& info : *this) {
+        auto it = std::find_if(base.begin(), base.end(), [&](const auto& b) { return b.isSameStream(info); });
+        if (it == base.end() or *it != info)
+            val["p"].append(info.toJson());
+    }
+    for (const auto& info : base) {
+        if (std::none_of(begin(), end(), [&](const auto& p) { return p.isSameStream(info); })) {
+            Json::Value removed;
+            removed["uri"] = info.uri;
+            removed["device"] = info.device;
+            removed["sinkId"] = info.sinkId;
+            val["removed"].append(std::move(removed));
+        }
+    }
+    val["w"] = w;
+    val["h"] = h;
+    val["v"] = v;
+    val["layout"] = layout;
+    val["seq"] = Json::UInt64(seq);
+    val["base"] = Json::UInt64(seq - 1);
     return json::toString(val);
 }
 
 void
-Conference::sendConferenceInfos()
+ConfInfo::applyDelta(const Json::Value& delta)
 {
-    // Inform calls that the layout has changed
-    foreachCall([&](const auto& call) {
-        // Produce specific JSON for each participant (2 separate accounts can host ...
-        // a conference on a same device, the conference is not link to one account).
-        auto w = call->getAccount();
-        auto account = w.lock();
-        if (!account)
-            return;
+    for (const auto& removed : delta["removed"]) {
+        ParticipantInfo info;
+        info.fromJson(removed);
+        erase(std::remove_if(begin(), end(), [&](const auto& p) { return p.isSameStream(info); }), end());
+    }
+    for (const auto& participantInfo : delta["p"]) {
+        if (!participantInfo.isMember("uri"))
+            continue;
+        ParticipantInfo info;
+        info.fromJson(participantInfo);
+        auto it = std::find_if(begin(), end(), [&](const auto& p) { return p.isSameStream(info); });
+        if (it != end())
+            *it = std::move(info);
+        else
+            emplace_back(std::move(info));
+    }
+    if (delta.isMember("w"))
+        w = delta["w"].asInt();
+    if (delta.isMember("h"))
+        h = delta["h"].asInt();
+    if (delta.isMember("v"))
+        v = delta["v"].asInt();
+    if (delta.isMember("layout"))
+        layout = delta["layout"].asInt();
+}
 
-        dht::ThreadPool::io().run(
-            [call, confInfo = getConfInfoHostUri(account->getUsername() + "@ring.dht", call->getPeerNumber())] {
-                call->sendConfInfo(confInfo.toString());
-            });
-    });
+void
+Conference::sendConferenceInfos()
+{
+    scheduleConfInfoDistribution();
 
     auto confInfo = getConfInfoHostUri("", "");
 #ifdef ENABLE_VIDEO
@@ -1019,6 +1068,133 @@ Conference::sendConferenceInfos()
     jami::emitSignal<libjami::CallSignal::OnConferenceInfosUpdated>(id_, confInfo.toVectorMapStringString());
 }
 
+void
+Conference::scheduleConfInfoDistribution()
+{
+    if (confInfoScheduled_.exchange(true))
+        return;
+    confInfoTimer_.expires_after(CONF_INFO_TICK);
+    confInfoTimer_.async_wait([w = weak()](const std::error_code& ec) {
+        if (ec)
+            return;
+        if (auto shared = w.lock())
+            shared->distributeConferenceInfos();
+    });
+}
+
+std::string
+Conference::confInfoViewId(const Call& call) const
+{
+    auto account = call.getAccount().lock();
+    if (!account)
+        return {};
+    auto viewId = account->getUsername() + "@ring.dht";
+    auto peerUri = call.getPeerNumber();
+    if (remoteHosts_.find(peerUri) != remoteHosts_.end())
+        viewId += "/" + peerUri;
+    return viewId;
+}
+
+void
+Conference::distributeConferenceInfos()
+{
+    std::lock_guard lk(confInfoMutex_);
+    confInfoScheduled_ = false;
+    auto now = clock::now();
+
+    // Serialized documents of this tick, shared by all the peers of a view
+    struct Documents
+    {
+        uint64_t previousSeq {0};
+        std::shared_ptr<std::string> full;
+        std::shared_ptr<std::string> delta;
+    };
+    std::map<std::string, Documents> documents;
+    std::set<std::string> calls;
+
+    // Inform calls that the layout has changed
+    foreachCall([&](const auto& call) {
+        // Produce specific JSON for each view (2 separate accounts can host ...
+        // a conference on a same device, the conference is not link to one account).
+        auto viewId = confInfoViewId(*call);
+        if (viewId.empty())
+            return;
+
+        auto& view = confInfoViews_[viewId];
+        auto [docIt, newView] = documents.try_emplace(viewId);
+        auto& docs = docIt->second;
+        if (newView) {
+            docs.previousSeq = view.seq;
+            auto localHostUri = viewId.substr(0, viewId.find('/'));
+            auto info = getConfInfoHostUri(localHostUri, call->getPeerNumber());
+            if (view.seq == 0 or not info.sameContent(view.info)) {
+                if (view.seq != 0)
+                    docs.delta = std::make_shared<std::string>(info.toDeltaString(view.info, view.seq + 1));
+                view.info = std::move(info);
+                view.seq++;
+            }
+        }
+
+        calls.emplace(call->getCallId());
+        auto& peer = confInfoPeers_[call->getCallId()];
+        if (peer.seq == view.seq)
+            return;
+
+        // Full documents carry the revision: older peers ignore it, newer
+        // ones answer with a request for deltas
+        std::shared_ptr<std::string> document;
+        if (peer.deltas and docs.delta and peer.seq == docs.previousSeq
+            and now - peer.lastFull < CONF_INFO_FULL_INTERVAL) {
+            document = docs.delta;
+        } else {
+            if (not docs.full)
+                docs.full = std::make_shared<std::string>(view.info.toString(view.seq));
+            document = docs.full;
+            peer.lastFull = now;
+        }
+        peer.seq = view.seq;
+
+        dht::ThreadPool::io().run([call, document = std::move(document)] { call->sendConfInfo(*document); });
+    });
+
+    // Forget calls that left and views nobody uses anymore
+    for (auto it = confInfoPeers_.begin(); it != confInfoPeers_.end();) {
+        if (calls.find(it->first) == calls.end())
+            it = confInfoPeers_.erase(it);
+        else
+            ++it;
+    }
+    for (auto it = confInfoViews_.begin(); it != confInfoViews_.end();) {
+        if (documents.find(it->first) == documents.end())
+            it = confInfoViews_.erase(it);
+        else
+            ++it;
+    }
+}
+
+void
+Conference::onConfInfoRequest(const std::string& callId, const Json::Value& request)
+{
+    JAMI_DEBUG("[conf:{}] Call {} requested conference info", id_, callId);
+    auto call = getCall(callId);
+    std::lock_guard lk(confInfoMutex_);
+    auto& peer = confInfoPeers_[callId];
+    peer.deltas = request.isObject() and request["delta"].asInt() >= ConfInfo::DELTA_VERSION;
+    // Start again from a full document
+    peer.seq = 0;
+
+    // Only the requester gets the current revision, the other peers are up to date
+    auto view = call ? confInfoViews_.find(confInfoViewId(*call)) : confInfoViews_.end();
+    if (view == confInfoViews_.end() or view->second.seq == 0) {
+        scheduleConfInfoDistribution();
+        return;
+    }
+    auto document = view->second.info.toString(view->second.seq);
+    peer.seq = view->second.seq;
+    peer.lastFull = clock::now();
+    dht::ThreadPool::io().run([call, document = std::move(document)] { call->sendConfInfo(document); });
+}
+
 #ifdef ENABLE_VIDEO
 void
 Conference::createSinks(const ConfInfo& infos)
@@ -1252,6 +1428,10 @@ Conference::onConfOrder(const std::string& callId, const std::string& confOrder)
             JAMI_WARNING("[conf:{}] Unable to parse conference order from {}", id_, peerId);
             return;
         }
+        if (root.isObject() and root.isMember(ConfInfo::REQUEST_KEY)) {
+            onConfInfoRequest(callId, root[ConfInfo::REQUEST_KEY]);
+            root.removeMember(ConfInfo::REQUEST_KEY);
+        }
 
         parser_.initData(std::move(root), peerId);
         parser_.parse();
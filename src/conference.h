@@ -20,6 +20,7 @@
 #include "config.h"
 #endif
 
+#include <atomic>
 #include <chrono>
 #include <set>
 #include <string>
@@ -43,6 +44,7 @@
 #endif
 
 #include <json/json.h>
+#include <asio/steady_timer.hpp>
 
 namespace jami {
 
@@ -145,10 +147,22 @@ struct ParticipantInfo
     }
 
     friend bool operator!=(const ParticipantInfo& p1, const ParticipantInfo& p2) { return !(p1 == p2); }
+
+    /**
+     * Identifies the same stream across ConfInfo revisions
+     */
+    bool isSameStream(const ParticipantInfo& other) const
+    {
+        return uri == other.uri and device == other.device and sinkId == other.sinkId;
+    }
 };
 
 struct ConfInfo : public std::vector<ParticipantInfo>
 {
+    // confOrder member used by peers to ask for deltas (and a full document to start from)
+    static constexpr const char* REQUEST_KEY = "confInfo";
+    static constexpr int DELTA_VERSION {1};
+
     int h {0};
     int w {0};
     int v {1}; // Supported conference protocol version
@@ -174,7 +188,26 @@ struct ConfInfo : public std::vector<ParticipantInfo>
     friend bool operator!=(const ConfInfo& c1, const ConfInfo& c2) { return !(c1 == c2); }
 
     std::vector<std::map<std::string, std::string>> toVectorMapStringString() const;
-    std::string toString() const;
+
+    /**
+     * Full document. A non zero seq marks it as a revision peers can apply
+     * later deltas on.
+     */
+    std::string toString(uint64_t seq = 0) const;
+
+    /**
+     * Incremental document going from revision seq - 1 (base) to seq. Only
+     * contains the participants that were added or changed and the streams
+     * that were removed.
+     */
+    std::string toDeltaString(const ConfInfo& base, uint64_t seq) const;
+
+    /**
+     * Apply an incremental document produced by toDeltaString()
+     */
+    void applyDelta(const Json::Value& delta);
+
+    bool sameContent(const ConfInfo& other) const { return layout == other.layout and *this == other; }
 };
 
 using CallIdSet = std::set<std::string>;
@@ -403,7 +436,52 @@ private:
     mutable std::mutex confInfoMutex_ {};
     ConfInfo confInfo_ {};
 
+    /**
+     * Notify the local client right away, and schedule the distribution of
+     * the new ConfInfo to the peers. Changes made within a tick are coalesced.
+     */
     void sendConferenceInfos();
+    /**
+     * Distribute the ConfInfo to the peers at the next tick, without
+     * notifying the local client
+     */
+    void scheduleConfInfoDistribution();
+
+    // Delay used to coalesce ConfInfo changes before sending them to peers
+    static constexpr std::chrono::milliseconds CONF_INFO_TICK {100};
+    // Delta capable peers still receive a full document at least this often
+    static constexpr std::chrono::seconds CONF_INFO_FULL_INTERVAL {30};
+
+    /**
+     * What a group of peers receive is the same: the host URI is per account
+     * and remote hosts don't receive their own participants.
+     */
+    struct ConfInfoView
+    {
+        ConfInfo info;
+        uint64_t seq {0};
+    };
+    struct ConfInfoPeer
+    {
+        // Last revision sent, 0 if the peer must receive a full document
+        uint64_t seq {0};
+        // Peer announced it can apply deltas
+        bool deltas {false};
+        clock::time_point lastFull {};
+    };
+    // Protected by confInfoMutex_
+    std::map<std::string, ConfInfoView> confInfoViews_;
+    std::map<std::string, ConfInfoPeer> confInfoPeers_;
+    std::atomic_bool confInfoScheduled_ {false};
+    asio::steady_timer confInfoTimer_;
+
+    void distributeConferenceInfos();
+    /**
+     * View received by the peer of call, empty if its account is gone.
+     * Must be called with confInfoMutex_ held.
+     */
+    std::string confInfoViewId(const Call& call) const;
+    void onConfInfoRequest(const std::string& callId, const Json::Value& request);
     std::shared_ptr<RingBuffer> ghostRingBuffer_;
 
 #ifdef ENABLE_VIDEO
@@ -19,6 +19,9 @@
 
 #include "base64.h"
 #include "fileutils.h"
+#include "jamidht/file_digest_cache.h"
+#include "jamidht/file_store.h"
+#include "jamidht/journal_store.h"
 #include "manager.h"
 #include "client/jami_signal.h"
 
@@ -90,8 +93,8 @@ OutgoingFile::OutgoingFile(const std::shared_ptr<dhtnet::ChannelSocket>& channel
         dht::ThreadPool::io().run([channel = std::move(channel_)] { channel->shutdown(); });
         return;
     }
-    stream_.open(fpath, std::ios::binary | std::ios::in);
-    if (!stream_ || !stream_.is_open()) {
+    reader_ = std::make_unique<fileutils::FileReader>(fpath);
+    if (!reader_->isOpen()) {
         dht::ThreadPool::io().run([channel = std::move(channel_)] { channel->shutdown(); });
         return;
     }
@@ -99,8 +102,6 @@ OutgoingFile::OutgoingFile(const std::shared_ptr<dhtnet::ChannelSocket>& channel
 
 OutgoingFile::~OutgoingFile()
 {
-    if (stream_ && stream_.is_open())
-        stream_.close();
     if (channel_) {
         dht::ThreadPool::io().run([channel = std::move(channel_)] { channel->shutdown(); });
     }
@@ -109,27 +110,31 @@ OutgoingFile::~OutgoingFile()
 void
 OutgoingFile::process()
 {
-    if (!channel_ or !stream_ or !stream_.is_open())
+    if (!channel_ or !reader_ or !reader_->isOpen())
         return;
     auto correct = false;
-    stream_.seekg(static_cast<long>(start_), std::ios::beg);
     try {
-        std::vector<char> buffer(UINT16_MAX, 0);
+        std::vector<uint8_t> buffer(UINT16_MAX, 0);
         std::error_code ec;
-        auto pos = start_;
-        while (!stream_.eof()) {
-            stream_.read(buffer.data(),
-                         end_ > start_ ? static_cast<long>(std::min(end_ - pos, buffer.size()))
-                                       : static_cast<long>(buffer.size()));
-            auto gcount = stream_.gcount();
-            pos += gcount;
-            channel_->write(reinterpret_cast<const uint8_t*>(buffer.data()), gcount, ec);
+        auto pos = static_cast<uint64_t>(start_);
+        // Without an end, whatever the file holds is sent
+        auto end = end_ > start_ ? static_cast<uint64_t>(end_) : std::numeric_limits<uint64_t>::max();
+        int64_t read = 0;
+        while (pos < end) {
+            read = reader_->read(pos, buffer.data(), static_cast<size_t>(std::min<uint64_t>(end - pos, buffer.size())));
+            if (read <= 0)
+                break;
+            // Blocks while the transport is congested, the reader keeps reading ahead meanwhile
+            channel_->write(buffer.data(), static_cast<size_t>(read), ec);
             if (ec)
                 break;
+            pos += static_cast<uint64_t>(read);
         }
-        if (!ec)
+        if (!ec && read >= 0)
             correct = true;
-        stream_.close();
+        else if (read < 0)
+            JAMI_WARNING("Failed to read {}", info_.path);
+        reader_.reset();
     } catch (const std::exception& e) {
         JAMI_WARNING("Failed to read from stream: {}", e.what());
     }
@@ -165,6 +170,10 @@ IncomingFile::IncomingFile(const std::shared_ptr<dhtnet::ChannelSocket>& channel
     , sha3Sum_(sha3Sum)
     , path_(info.path + ".tmp")
 {
+    // A resumed transfer appends to what was already received
+    std::error_code ec;
+    if (!sha3Sum_.empty() && std::filesystem::file_size(path_, ec) > 0 && !ec)
+        hash_.updateFile(path_);
     stream_.open(path_, std::ios::binary | std::ios::out | std::ios::app);
     if (!stream_)
         return;
@@ -198,8 +207,11 @@ IncomingFile::process()
     channel_->setOnRecv([w = weak_from_this()](const uint8_t* buf, size_t len) {
         if (auto shared = w.lock()) {
             std::lock_guard<std::mutex> lk(shared->streamMtx_);
-            if (shared->stream_.is_open())
+            if (shared->stream_.is_open()) {
                 shared->stream_.write(reinterpret_cast<const char*>(buf), static_cast<long>(len));
+                if (!shared->sha3Sum_.empty())
+                    shared->hash_.update(buf, len);
+            }
             shared->info_.bytesProgress = shared->stream_.tellp();
             return static_cast<int>(len);
         }
@@ -233,7 +245,12 @@ IncomingFile::process()
                              shared->info_.totalSize);
                 std::filesystem::remove(shared->path_, ec);
             } else {
-                auto sha3Sum = fileutils::sha3File(shared->path_);
+                auto sha3Sum = shared->hash_.digest();
+                if (shared->sha3Sum_ != sha3Sum) {
+                    // The file may have been written by something else, read it back to be sure
+                    JAMI_DEBUG("Received data of {} does not match its sha3sum, checking the file", shared->path_);
+                    sha3Sum = fileutils::sha3File(shared->path_);
+                }
                 if (shared->sha3Sum_ == sha3Sum) {
                     JAMI_LOG("New file received: {}", shared->info_.path);
                     correct = true;
@@ -256,6 +273,9 @@ IncomingFile::process()
             if (ec) {
                 JAMI_ERROR("Failed to rename file from {} to {}: {}", shared->path_, shared->info_.path, ec.message());
                 correct = false;
+            } else if (!shared->sha3Sum_.empty()) {
+                // Serving the file to other members will not hash it again
+                FileDigestCache::instance().set(shared->info_.path, shared->sha3Sum_);
             }
         }
         if (shared->isUserCancelled_)
@@ -268,6 +288,514 @@ IncomingFile::process()
 
 //==============================================================================
 
+ChunkScheduler::ChunkScheduler(uint64_t totalSize, uint64_t chunkSize)
+    : totalSize_(totalSize)
+    , chunkSize_(std::max<uint64_t>(chunkSize, 1))
+    , done_(static_cast<size_t>((totalSize + chunkSize_ - 1) / chunkSize_), false)
+    , requested_(done_.size(), 0)
+{}
+
+std::pair<uint64_t, uint64_t>
+ChunkScheduler::byteRange(size_t first, size_t last) const
+{
+    auto offset = std::min(first * chunkSize_, totalSize_);
+    auto end = std::min(last * chunkSize_, totalSize_);
+    return {offset, end - offset};
+}
+
+void
+ChunkScheduler::setDone(size_t chunk)
+{
+    if (done_[chunk])
+        return;
+    done_[chunk] = true;
+    ++doneCount_;
+}
+
+uint64_t
+ChunkScheduler::doneBytes() const
+{
+    auto bytes = doneCount_ * chunkSize_;
+    // The last chunk may be shorter
+    if (!done_.empty() && done_.back())
+        bytes -= done_.size() * chunkSize_ - totalSize_;
+    return bytes;
+}
+
+std::optional<std::pair<size_t, size_t>>
+ChunkScheduler::assign(const std::string& device, clock::time_point now)
+{
+    release(device);
+    auto& source = sources_[device];
+    size_t count = 1;
+    if (source.throughput > 0) {
+        auto bytes = source.throughput * static_cast<double>(RANGE_DURATION.count());
+        count = std::clamp<size_t>(static_cast<size_t>(bytes / static_cast<double>(chunkSize_)), 1, MAX_RANGE_CHUNKS);
+    }
+
+    // First chunks nobody is asked for
+    for (size_t first = 0; first < done_.size(); ++first) {
+        if (done_[first] || requested_[first] != 0)
+            continue;
+        auto last = first + 1;
+        while (last < done_.size() && last - first < count && !done_[last] && requested_[last] == 0)
+            ++last;
+        return start(source, first, last, now);
+    }
+
+    // Every chunk is requested: help the slowest device with the end of its range
+    const Source* slowest = nullptr;
+    size_t chunk = 0;
+    for (const auto& [id, other] : sources_) {
+        if (&other == &source || !other.active)
+            continue;
+        for (auto i = other.last; i > other.first; --i) {
+            if (done_[i - 1] || requested_[i - 1] > 1)
+                continue;
+            if (!slowest || other.throughput < slowest->throughput) {
+                slowest = &other;
+                chunk = i - 1;
+            }
+            break;
+        }
+    }
+    if (slowest)
+        return start(source, chunk, chunk + 1, now);
+    return std::nullopt;
+}
+
+std::optional<std::pair<size_t, size_t>>
+ChunkScheduler::start(Source& source, size_t first, size_t last, clock::time_point now)
+{
+    source.first = first;
+    source.last = last;
+    source.active = true;
+    source.since = now;
+    for (auto i = first; i < last; ++i)
+        ++requested_[i];
+    return std::make_pair(first, last);
+}
+
+bool
+ChunkScheduler::received(const std::string& device, size_t chunk, clock::time_point now)
+{
+    auto it = sources_.find(device);
+    if (it != sources_.end() && it->second.active) {
+        auto& source = it->second;
+        auto elapsed = std::chrono::duration<double>(now - source.since).count();
+        if (elapsed > 0) {
+            auto rate = static_cast<double>(byteRange(chunk, chunk + 1).second) / elapsed;
+            source.throughput = source.throughput == 0 ? rate : .7 * source.throughput + .3 * rate;
+        }
+        source.since = now;
+    }
+    if (done_[chunk])
+        return false;
+    setDone(chunk);
+    return true;
+}
+
+void
+ChunkScheduler::release(const std::string& device)
+{
+    auto it = sources_.find(device);
+    if (it == sources_.end() || !it->second.active)
+        return;
+    auto& source = it->second;
+    for (auto i = source.first; i < source.last; ++i)
+        if (requested_[i] != 0)
+            --requested_[i];
+    source.active = false;
+}
+
+bool
+ChunkScheduler::isActive(const std::string& device) const
+{
+    auto it = sources_.find(device);
+    return it != sources_.end() && it->second.active;
+}
+
+size_t
+ChunkScheduler::activeCount() const
+{
+    return static_cast<size_t>(
+        std::count_if(sources_.begin(), sources_.end(), [](const auto& source) { return source.second.active; }));
+}
+
+double
+ChunkScheduler::throughput(const std::string& device) const
+{
+    auto it = sources_.find(device);
+    return it != sources_.end() ? it->second.throughput : 0;
+}
+
+//==============================================================================
+
+struct ChunkedFile::Range
+{
+    std::string deviceId;
+    std::shared_ptr<dhtnet::ChannelSocket> channel;
+    std::mutex mutex;
+    std::fstream stream;
+    uint64_t pos {0};
+    uint64_t end {0};
+    size_t chunk {0};
+    fileutils::Sha3Stream hash;
+    // Set once the download finished or stopped: nothing is written anymore
+    bool closed {false};
+};
+
+static bool
+readChunk(std::ifstream& file, uint64_t offset, uint64_t size, std::vector<uint8_t>& buffer)
+{
+    buffer.resize(static_cast<size_t>(size));
+    file.clear();
+    file.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
+    file.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(size));
+    return file.gcount() == static_cast<std::streamsize>(size);
+}
+
+ChunkedFile::ChunkedFile(const libjami::DataTransferInfo& info,
+                         const std::string& fileId,
+                         const std::string& interactionId,
+                         const std::string& sha3Sum,
+                         uint64_t chunkSize)
+    : FileInfo(nullptr, fileId, interactionId, info)
+    , sha3Sum_(sha3Sum)
+    , path_(info.path + ".tmp")
+    , journalPath_(info.path + ".chunks")
+    , scheduler_(static_cast<uint64_t>(info.totalSize), chunkSize)
+{}
+
+ChunkedFile::~ChunkedFile()
+{
+    for (const auto& range : ranges_)
+        if (range->channel)
+            dht::ThreadPool::io().run([channel = range->channel] { channel->shutdown(); });
+}
+
+void
+ChunkedFile::process()
+{
+    // Checking what was already received reads the partial file
+    dht::ThreadPool::io().run([w = weak_from_this()] {
+        if (auto shared = w.lock())
+            shared->load();
+    });
+}
+
+void
+ChunkedFile::load()
+{
+    std::lock_guard lk(mutex_);
+    if (stopped_)
+        return;
+    journal_ = std::make_unique<JournalStore>(journalPath_);
+    auto recorded = journal_->values();
+    auto layout = fmt::format("{}:{}", info_.totalSize, scheduler_.chunkSize());
+    auto itLayout = recorded.find("layout");
+    // Without a record, the partial file was received through a single channel
+    auto sequential = itLayout == recorded.end();
+    std::map<std::string, std::optional<std::string>> changes;
+    if (!sequential && itLayout->second != layout) {
+        JAMI_WARNING("Discarding partial file {} split in other chunks", path_);
+        std::error_code ec;
+        std::filesystem::remove(path_, ec);
+        for (const auto& [key, _] : recorded)
+            changes.emplace(key, std::nullopt);
+        recorded.clear();
+        sequential = true;
+    }
+    changes["layout"] = layout;
+
+    std::error_code ec;
+    auto size = std::filesystem::file_size(path_, ec);
+    if (ec) {
+        size = 0;
+        std::ofstream create(path_, std::ios::binary | std::ios::app);
+    }
+    std::ifstream file(path_, std::ios::binary);
+    std::vector<uint8_t> buffer;
+    for (size_t chunk = 0; chunk < scheduler_.chunkCount(); ++chunk) {
+        auto key = std::to_string(chunk);
+        auto it = recorded.find(key);
+        auto [offset, length] = scheduler_.byteRange(chunk, chunk + 1);
+        if ((it == recorded.end() && !sequential) || offset + length > size)
+            continue;
+        if (!readChunk(file, offset, length, buffer))
+            break;
+        fileutils::Sha3Stream chunkHash;
+        chunkHash.update(buffer.data(), buffer.size());
+        auto digest = chunkHash.digest();
+        if (it != recorded.end() && it->second != digest) {
+            JAMI_WARNING("Chunk {} of {} was altered, downloading it again", chunk, path_);
+            changes.emplace(key, std::nullopt);
+            continue;
+        }
+        if (it == recorded.end())
+            changes.emplace(key, digest);
+        scheduler_.setDone(chunk);
+        if (hashed_ == chunk) {
+            hash_.update(buffer.data(), buffer.size());
+            ++hashed_;
+        }
+    }
+    journal_->update(changes);
+    if (scheduler_.doneCount() != 0)
+        JAMI_LOG("Resuming download of {} with {}/{} chunks",
+                 info_.path,
+                 scheduler_.doneCount(),
+                 scheduler_.chunkCount());
+    info_.bytesProgress = static_cast<int64_t>(scheduler_.doneBytes());
+    loaded_ = true;
+    emit(libjami::DataTransferEventCode::ongoing);
+
+    if (scheduler_.complete()) {
+        finish();
+        return;
+    }
+    for (const auto& [deviceId, _] : sources_)
+        requestRange(deviceId);
+}
+
+bool
+ChunkedFile::addSource(const std::string& deviceId, const RangeRequest& request)
+{
+    std::lock_guard lk(mutex_);
+    if (stopped_)
+        return false;
+    sources_[deviceId] = request;
+    // Sources added before the partial file is checked are asked once it is
+    if (loaded_ && !scheduler_.isActive(deviceId))
+        requestRange(deviceId);
+    return true;
+}
+
+void
+ChunkedFile::requestRange(const std::string& deviceId)
+{
+    auto range = scheduler_.assign(deviceId, ChunkScheduler::clock::now());
+    if (!range)
+        return;
+    auto [offset, length] = scheduler_.byteRange(range->first, range->second);
+    dht::ThreadPool::io().run([w = weak_from_this(),
+                               request = sources_[deviceId],
+                               deviceId,
+                               first = range->first,
+                               offset = offset,
+                               length = length] {
+        request(deviceId, offset, length, [w, deviceId, first, offset, length](const auto& channel) {
+            if (auto shared = w.lock())
+                shared->onChannel(deviceId, first, offset, length, channel);
+            else if (channel)
+                channel->shutdown();
+        });
+    });
+}
+
+void
+ChunkedFile::onChannel(const std::string& deviceId,
+                       size_t first,
+                       uint64_t offset,
+                       uint64_t length,
+                       const std::shared_ptr<dhtnet::ChannelSocket>& channel)
+{
+    auto range = std::make_shared<Range>();
+    {
+        std::lock_guard lk(mutex_);
+        if (channel && !stopped_) {
+            range->stream.open(path_, std::ios::binary | std::ios::in | std::ios::out);
+            range->stream.seekp(static_cast<std::streamoff>(offset), std::ios::beg);
+        }
+        if (!channel || stopped_ || !range->stream) {
+            if (channel)
+                dht::ThreadPool::io().run([channel] { channel->shutdown(); });
+            scheduler_.release(deviceId);
+            checkSources();
+            return;
+        }
+        range->deviceId = deviceId;
+        range->channel = channel;
+        range->pos = offset;
+        range->end = offset + length;
+        range->chunk = first;
+        ranges_.emplace(range);
+    }
+    // Buffered data may be delivered right away
+    channel->setOnRecv([w = weak_from_this(), range](const uint8_t* buf, size_t len) {
+        if (auto shared = w.lock()) {
+            shared->onData(range, buf, len);
+            return static_cast<int>(len);
+        }
+        return -1;
+    });
+    channel->onShutdown([w = weak_from_this(), range](const std::error_code&) {
+        if (auto shared = w.lock())
+            shared->onRangeEnd(range);
+    });
+}
+
+void
+ChunkedFile::onData(const std::shared_ptr<Range>& range, const uint8_t* buf, size_t len)
+{
+    std::vector<std::pair<size_t, std::string>> chunks;
+    auto ended = false;
+    // Written with the file locked: once a chunk is received from any range
+    // and hashed, a late range overlapping it does not write to it anymore
+    std::lock_guard lk(mutex_);
+    {
+        std::lock_guard lkRange(range->mutex);
+        if (range->closed)
+            return;
+        // Peers that do not know the length send until the end of the file
+        while (len > 0 && range->pos < range->end && range->stream) {
+            auto chunkEnd = std::min(range->end, (range->chunk + 1) * scheduler_.chunkSize());
+            auto size = static_cast<size_t>(std::min<uint64_t>(len, chunkEnd - range->pos));
+            if (!scheduler_.isDone(range->chunk)) {
+                range->stream.seekp(static_cast<std::streamoff>(range->pos), std::ios::beg);
+                range->stream.write(reinterpret_cast<const char*>(buf), static_cast<std::streamsize>(size));
+                range->hash.update(buf, size);
+            }
+            range->pos += size;
+            buf += size;
+            len -= size;
+            if (range->pos == chunkEnd) {
+                range->stream.flush();
+                chunks.emplace_back(range->chunk++, range->hash.digest());
+            }
+        }
+        ended = range->pos == range->end || !range->stream;
+    }
+    // Chunks already received from another range are only counted for the
+    // throughput of this one
+    for (const auto& [chunk, digest] : chunks)
+        onChunk(range->deviceId, chunk, digest);
+    if (ended)
+        dht::ThreadPool::io().run([channel = range->channel] { channel->shutdown(); });
+}
+
+void
+ChunkedFile::onChunk(const std::string& deviceId, size_t chunk, const std::string& digest)
+{
+    if (stopped_ || !scheduler_.received(deviceId, chunk, ChunkScheduler::clock::now()))
+        return;
+    journal_->put(std::to_string(chunk), digest);
+    info_.bytesProgress = static_cast<int64_t>(scheduler_.doneBytes());
+    hashPrefix();
+    if (scheduler_.complete())
+        finish();
+}
+
+void
+ChunkedFile::onRangeEnd(const std::shared_ptr<Range>& range)
+{
+    bool complete;
+    {
+        std::lock_guard lk(range->mutex);
+        range->stream.close();
+        complete = range->pos == range->end;
+    }
+    std::lock_guard lk(mutex_);
+    if (ranges_.erase(range) == 0 || stopped_)
+        return;
+    if (complete)
+        requestRange(range->deviceId);
+    else
+        scheduler_.release(range->deviceId);
+    checkSources();
+}
+
+void
+ChunkedFile::hashPrefix()
+{
+    if (hashed_ == scheduler_.chunkCount() || !scheduler_.isDone(hashed_))
+        return;
+    std::ifstream file(path_, std::ios::binary);
+    std::vector<uint8_t> buffer;
+    while (hashed_ < scheduler_.chunkCount() && scheduler_.isDone(hashed_)) {
+        auto [offset, length] = scheduler_.byteRange(hashed_, hashed_ + 1);
+        if (!readChunk(file, offset, length, buffer))
+            return;
+        hash_.update(buffer.data(), buffer.size());
+        ++hashed_;
+    }
+}
+
+void
+ChunkedFile::checkSources()
+{
+    if (!loaded_ || stopped_ || scheduler_.complete() || scheduler_.activeCount() != 0)
+        return;
+    // Received chunks are kept, the download resumes with the next devices
+    JAMI_WARNING("No device left to download {} from ({}/{} chunks)",
+                 info_.path,
+                 scheduler_.doneCount(),
+                 scheduler_.chunkCount());
+    stopped_ = true;
+    journal_.reset();
+    emit(libjami::DataTransferEventCode::closed_by_host);
+}
+
+void
+ChunkedFile::closeRanges()
+{
+    for (const auto& range : ranges_) {
+        {
+            // Waits for a write in progress
+            std::lock_guard lk(range->mutex);
+            range->closed = true;
+            range->stream.close();
+        }
+        dht::ThreadPool::io().run([channel = range->channel] { channel->shutdown(); });
+    }
+    ranges_.clear();
+}
+
+void
+ChunkedFile::finish()
+{
+    stopped_ = true;
+    // No stream may write to the file once it is checked and renamed
+    closeRanges();
+    journal_.reset();
+
+    // Chunks are not written to anymore once hashed, see onData()
+    auto sha3Sum = hashed_ == scheduler_.chunkCount() ? hash_.digest() : fileutils::sha3File(path_);
+    auto correct = sha3Sum == sha3Sum_;
+    std::error_code ec;
+    if (correct) {
+        std::filesystem::rename(path_, info_.path, ec);
+        if (ec) {
+            JAMI_ERROR("Failed to rename file from {} to {}: {}", path_, info_.path, ec.message());
+            correct = false;
+        } else {
+            JAMI_LOG("New file received: {}", info_.path);
+            FileDigestCache::instance().set(info_.path, sha3Sum_);
+        }
+    } else {
+        JAMI_WARNING("Removing {} with invalid sha3sum (expected: {}, actual: {})", path_, sha3Sum_, sha3Sum);
+        std::filesystem::remove(path_, ec);
+    }
+    std::filesystem::remove(journalPath_, ec);
+    emit(correct ? libjami::DataTransferEventCode::finished : libjami::DataTransferEventCode::closed_by_host);
+}
+
+void
+ChunkedFile::cancel()
+{
+    isUserCancelled_ = true;
+    emit(libjami::DataTransferEventCode::closed_by_peer);
+    std::lock_guard lk(mutex_);
+    stopped_ = true;
+    closeRanges();
+    journal_.reset();
+    std::error_code ec;
+    std::filesystem::remove(path_, ec);
+    std::filesystem::remove(journalPath_, ec);
+}
+
+//==============================================================================
+
 class TransferManager::Impl
 {
 public:
@@ -295,6 +823,7 @@ public:
         }
         outgoings_.clear();
         incomings_.clear();
+        downloads_.clear();
         vcards_.clear();
     }
 
@@ -311,6 +840,28 @@ public:
             return;
         }
     }
+    libjami::DataTransferInfo incomingInfo(const std::string& fileId, const WaitingRequest& request) const
+    {
+        libjami::DataTransferInfo info;
+        info.accountId = accountId_;
+        info.conversationId = to_;
+        info.path = request.path;
+        info.totalSize = static_cast<int64_t>(request.totalSize);
+
+        // Generate the file path within the conversation data directory
+        // using the file id if no path has been specified, otherwise create
+        // a symlink(Note: this will not work on Windows).
+        auto filePath = conversationDataPath_ / fileId;
+        if (info.path.empty()) {
+            info.path = filePath.string();
+        } else {
+            // We don't need to check if this is an existing symlink here, as
+            // the attempt to create one should report the error string correctly.
+            fileutils::createFileLink(filePath, info.path);
+        }
+        return info;
+    }
+
     void saveWaiting()
     {
         std::ofstream file(waitingPath_, std::ios::trunc | std::ios::binary);
@@ -329,6 +880,7 @@ public:
     std::map<std::string, WaitingRequest> waitingIds_ {};
     std::map<std::shared_ptr<dhtnet::ChannelSocket>, std::shared_ptr<OutgoingFile>> outgoings_ {};
     std::map<std::string, std::shared_ptr<IncomingFile>> incomings_ {};
+    std::map<std::string, std::shared_ptr<ChunkedFile>> downloads_ {};
     std::map<std::pair<std::string, std::string>, std::shared_ptr<IncomingFile>> vcards_ {};
 
     std::mt19937_64 rand_;
@@ -393,6 +945,11 @@ TransferManager::cancel(const std::string& fileId)
         JAMI_LOG("Cancel {}", fileId);
         pimpl_->saveWaiting();
     }
+    auto itD = pimpl_->downloads_.find(fileId);
+    if (itD != pimpl_->downloads_.end()) {
+        itD->second->cancel();
+        return true;
+    }
     auto itC = pimpl_->incomings_.find(fileId);
     if (itC == pimpl_->incomings_.end())
         return false;
@@ -423,6 +980,12 @@ TransferManager::info(const std::string& fileId, std::string& path, int64_t& tot
         progress = itI->second->info().bytesProgress;
         return true;
     }
+    auto itD = pimpl_->downloads_.find(fileId);
+    if (itD != pimpl_->downloads_.end()) {
+        total = itD->second->info().totalSize;
+        progress = itD->second->info().bytesProgress;
+        return true;
+    }
 
     std::error_code ec;
     if (std::filesystem::is_regular_file(transferPath, ec)) {
@@ -470,6 +1033,54 @@ TransferManager::waitForTransfer(const std::string& fileId,
     pimpl_->saveWaiting();
 }
 
+bool
+TransferManager::fromStore(const std::string& fileId,
+                           const std::string& interactionId,
+                           const std::string& sha3sum,
+                           const std::string& path)
+{
+    auto& store = FileStore::instance();
+    if (pimpl_->to_.empty() || !store.has(sha3sum))
+        return false;
+    {
+        std::lock_guard lk(pimpl_->mapMutex_);
+        if (pimpl_->incomings_.find(fileId) != pimpl_->incomings_.end()
+            || pimpl_->downloads_.find(fileId) != pimpl_->downloads_.end())
+            return false;
+    }
+    auto filePath = this->path(fileId);
+    if (path.empty()) {
+        if (!store.link(sha3sum, filePath))
+            return false;
+    } else {
+        // Copied: the file chosen by the user must not change with the stored one
+        if (!store.intact(sha3sum))
+            return false;
+        std::error_code ec;
+        std::filesystem::copy_file(store.objectPath(sha3sum),
+                                   path,
+                                   std::filesystem::copy_options::overwrite_existing,
+                                   ec);
+        if (ec) {
+            JAMI_WARNING("Unable to copy stored file to {}: {}", path, ec.message());
+            return false;
+        }
+        FileDigestCache::instance().set(path, sha3sum);
+        fileutils::createFileLink(filePath, path);
+    }
+    JAMI_LOG("[Account {}] File {} already received, not transferring it", pimpl_->accountId_, fileId);
+    {
+        std::lock_guard lk(pimpl_->mapMutex_);
+        if (pimpl_->waitingIds_.erase(fileId))
+            pimpl_->saveWaiting();
+    }
+    runOnMainThread([accountId = pimpl_->accountId_, conversationId = pimpl_->to_, interactionId, fileId] {
+        emitSignal<libjami::DataTransferSignal::DataTransferEvent>(
+            accountId, conversationId, interactionId, fileId, uint32_t(libjami::DataTransferEventCode::finished));
+    });
+    return true;
+}
+
 void
 TransferManager::onIncomingFileTransfer(const std::string& fileId,
                                         const std::shared_ptr<dhtnet::ChannelSocket>& channel,
@@ -483,42 +1094,30 @@ TransferManager::onIncomingFileTransfer(const std::string& fileId,
         return;
     }
     auto itW = pimpl_->waitingIds_.find(fileId);
-    if (itW == pimpl_->waitingIds_.end()) {
+    if (itW == pimpl_->waitingIds_.end() || pimpl_->downloads_.find(fileId) != pimpl_->downloads_.end()) {
         dht::ThreadPool().io().run([channel] { channel->shutdown(); });
         return;
     }
 
-    libjami::DataTransferInfo info;
-    info.accountId = pimpl_->accountId_;
-    info.conversationId = pimpl_->to_;
-    info.path = itW->second.path;
-    info.totalSize = static_cast<int64_t>(itW->second.totalSize);
+    auto info = pimpl_->incomingInfo(fileId, itW->second);
     info.bytesProgress = static_cast<int64_t>(start);
 
-    // Generate the file path within the conversation data directory
-    // using the file id if no path has been specified, otherwise create
-    // a symlink(Note: this will not work on Windows).
-    auto filePath = path(fileId);
-    if (info.path.empty()) {
-        info.path = filePath.string();
-    } else {
-        // We don't need to check if this is an existing symlink here, as
-        // the attempt to create one should report the error string correctly.
-        fileutils::createFileLink(filePath, info.path);
-    }
-
     auto ifile = std::make_shared<IncomingFile>(std::move(channel),
                                                 info,
                                                 fileId,
                                                 itW->second.interactionId,
                                                 itW->second.sha3sum);
+    // Files downloaded to a path chosen by the user are theirs, not shared
+    auto storedSha3 = itW->second.path.empty() ? itW->second.sha3sum : "";
     auto res = pimpl_->incomings_.emplace(fileId, std::move(ifile));
     if (res.second) {
-        res.first->second->onFinished([w = weak(), fileId](uint32_t code) {
+        res.first->second->onFinished([w = weak(), fileId, storedSha3](uint32_t code) {
             // schedule destroy transfer as not needed
-            dht::ThreadPool().computation().run([w, fileId, code] {
+            dht::ThreadPool().computation().run([w, fileId, storedSha3, code] {
                 if (auto sthis_ = w.lock()) {
                     auto& pimpl = sthis_->pimpl_;
+                    if (code == uint32_t(libjami::DataTransferEventCode::finished) && !storedSha3.empty())
+                        FileStore::instance().adopt(sthis_->path(fileId), storedSha3);
                     std::lock_guard lk {pimpl->mapMutex_};
                     auto itO = pimpl->incomings_.find(fileId);
                     if (itO != pimpl->incomings_.end())
@@ -537,6 +1136,55 @@ TransferManager::onIncomingFileTransfer(const std::string& fileId,
     }
 }
 
+bool
+TransferManager::downloadFromDevice(const std::string& fileId,
+                                    const std::string& deviceId,
+                                    const ChunkedFile::RangeRequest& request)
+{
+    std::lock_guard lk(pimpl_->mapMutex_);
+    auto itD = pimpl_->downloads_.find(fileId);
+    if (itD != pimpl_->downloads_.end()) {
+        if (itD->second->addSource(deviceId, request))
+            return true;
+        // Stopped for lack of devices, resumed by a new download
+        pimpl_->downloads_.erase(itD);
+    }
+    auto itW = pimpl_->waitingIds_.find(fileId);
+    if (itW == pimpl_->waitingIds_.end() || itW->second.totalSize < ChunkedFile::MIN_SIZE
+        || pimpl_->incomings_.find(fileId) != pimpl_->incomings_.end())
+        return false;
+    auto file = std::make_shared<ChunkedFile>(pimpl_->incomingInfo(fileId, itW->second),
+                                              fileId,
+                                              itW->second.interactionId,
+                                              itW->second.sha3sum);
+    auto storedSha3 = itW->second.path.empty() ? itW->second.sha3sum : "";
+    file->onFinished([w = weak(), fileId, storedSha3, wf = std::weak_ptr<ChunkedFile>(file)](uint32_t code) {
+        // schedule destroy transfer as not needed
+        dht::ThreadPool().computation().run([w, fileId, storedSha3, wf, code] {
+            if (auto sthis_ = w.lock()) {
+                auto& pimpl = sthis_->pimpl_;
+                if (code == uint32_t(libjami::DataTransferEventCode::finished) && !storedSha3.empty())
+                    FileStore::instance().adopt(sthis_->path(fileId), storedSha3);
+                std::lock_guard lk {pimpl->mapMutex_};
+                auto itO = pimpl->downloads_.find(fileId);
+                if (itO != pimpl->downloads_.end() && itO->second == wf.lock())
+                    pimpl->downloads_.erase(itO);
+                if (code == uint32_t(libjami::DataTransferEventCode::finished)) {
+                    auto itW = pimpl->waitingIds_.find(fileId);
+                    if (itW != pimpl->waitingIds_.end()) {
+                        pimpl->waitingIds_.erase(itW);
+                        pimpl->saveWaiting();
+                    }
+                }
+            }
+        });
+    });
+    file->process();
+    file->addSource(deviceId, request);
+    pimpl_->downloads_.emplace(fileId, std::move(file));
+    return true;
+}
+
 std::filesystem::path
 TransferManager::path(const std::string& fileId) const
 {
@@ -17,14 +17,20 @@
 #pragma once
 
 #include "jami/datatransfer_interface.h"
+#include "fileutils.h"
 #include "noncopyable.h"
 
 #include <dhtnet/multiplexed_socket.h>
 
+#include <chrono>
 #include <fstream>
 #include <functional>
+#include <map>
 #include <memory>
+#include <optional>
+#include <set>
 #include <string>
+#include <vector>
 
 namespace jami {
 
@@ -32,6 +38,7 @@ libjami::DataTransferId generateUID(std::mt19937_64& engine);
 std::string getFileId(const std::string& commitId, const std::string& tid, const std::string& displayName);
 
 class Stream;
+class JournalStore;
 
 struct IncomingFileInfo
 {
@@ -92,6 +99,8 @@ private:
     std::mutex streamMtx_;
     std::ofstream stream_;
     std::string sha3Sum_ {};
+    // Digest of what was written so far, checked against sha3Sum_ once complete
+    fileutils::Sha3Stream hash_;
     std::filesystem::path path_;
 };
 
@@ -109,11 +118,160 @@ public:
     void cancel() override;
 
 private:
-    std::ifstream stream_;
+    std::unique_ptr<fileutils::FileReader> reader_;
     size_t start_ {0};
     size_t end_ {0};
 };
 
+/**
+ * Decides which chunks of a file to ask each device for.
+ *
+ * A device is given one range of contiguous chunks at a time, sized to last
+ * about RANGE_DURATION at the throughput it showed so far. Faster devices get
+ * larger ranges and come back for more sooner, so they serve a larger part of
+ * the file. Once every missing chunk is requested, an idle device is given a
+ * copy of the last chunk another device still has to send, and the first copy
+ * received wins.
+ * Not thread-safe.
+ */
+class ChunkScheduler
+{
+public:
+    using clock = std::chrono::steady_clock;
+    static constexpr uint64_t CHUNK_SIZE {4 * 1024 * 1024};
+    static constexpr size_t MAX_RANGE_CHUNKS {16};
+    static constexpr std::chrono::seconds RANGE_DURATION {5};
+
+    explicit ChunkScheduler(uint64_t totalSize, uint64_t chunkSize = CHUNK_SIZE);
+
+    size_t chunkCount() const { return done_.size(); }
+    uint64_t chunkSize() const { return chunkSize_; }
+    /**
+     * @return offset and size in bytes of chunks [first, last)
+     */
+    std::pair<uint64_t, uint64_t> byteRange(size_t first, size_t last) const;
+
+    bool isDone(size_t chunk) const { return done_[chunk]; }
+    void setDone(size_t chunk);
+    size_t doneCount() const { return doneCount_; }
+    uint64_t doneBytes() const;
+    bool complete() const { return doneCount_ == done_.size(); }
+
+    /**
+     * Chunks [first, last) to ask device for next, replacing its current range
+     * @return nullopt if there is nothing left to ask it
+     */
+    std::optional<std::pair<size_t, size_t>> assign(const std::string& device, clock::time_point now);
+    /**
+     * A chunk of the range of device was received
+     * @return false if it was already received from another device
+     */
+    bool received(const std::string& device, size_t chunk, clock::time_point now);
+    /**
+     * The device stopped sending its range, its missing chunks may be given to others
+     */
+    void release(const std::string& device);
+
+    bool isActive(const std::string& device) const;
+    size_t activeCount() const;
+    /**
+     * @return bytes per second received from device, 0 if unknown
+     */
+    double throughput(const std::string& device) const;
+
+private:
+    struct Source
+    {
+        size_t first {0};
+        size_t last {0};
+        bool active {false};
+        clock::time_point since {};
+        double throughput {0};
+    };
+    std::optional<std::pair<size_t, size_t>> start(Source& source, size_t first, size_t last, clock::time_point now);
+
+    uint64_t totalSize_ {0};
+    uint64_t chunkSize_ {CHUNK_SIZE};
+    std::vector<bool> done_;
+    size_t doneCount_ {0};
+    // Number of devices each chunk is requested from
+    std::vector<uint8_t> requested_;
+    std::map<std::string, Source> sources_;
+};
+
+/**
+ * File downloaded by chunks from several devices at once, as planned by a
+ * ChunkScheduler. Each range is received through its own channel and written
+ * at its offset in the partial file.
+ *
+ * Received chunks and their digest are recorded next to the partial file: an
+ * interrupted download resumes with the chunks it lacks, once the others are
+ * checked against their digest. The complete file is checked against the
+ * digest of its commit.
+ */
+class ChunkedFile : public FileInfo, public std::enable_shared_from_this<ChunkedFile>
+{
+public:
+    // Below this size, files are received through a single channel
+    static constexpr uint64_t MIN_SIZE {4 * ChunkScheduler::CHUNK_SIZE};
+
+    using ChannelCb = std::function<void(const std::shared_ptr<dhtnet::ChannelSocket>&)>;
+    /**
+     * Open a channel to a device for a range of the file
+     * cb is called with nullptr if the device is unable to send it
+     */
+    using RangeRequest
+        = std::function<void(const std::string& deviceId, uint64_t start, uint64_t length, ChannelCb&& cb)>;
+
+    ChunkedFile(const libjami::DataTransferInfo& info,
+                const std::string& fileId,
+                const std::string& interactionId,
+                const std::string& sha3Sum,
+                uint64_t chunkSize = ChunkScheduler::CHUNK_SIZE);
+    ~ChunkedFile();
+    void process() override;
+    void cancel() override;
+
+    /**
+     * Download from deviceId too, if it is not already sending a range
+     * @return false if the download stopped
+     */
+    bool addSource(const std::string& deviceId, const RangeRequest& request);
+
+private:
+    struct Range;
+
+    void load();
+    void requestRange(const std::string& deviceId);
+    void onChannel(const std::string& deviceId,
+                   size_t first,
+                   uint64_t offset,
+                   uint64_t length,
+                   const std::shared_ptr<dhtnet::ChannelSocket>& channel);
+    void onData(const std::shared_ptr<Range>& range, const uint8_t* buf, size_t len);
+    // mutex_ must be locked
+    void onChunk(const std::string& deviceId, size_t chunk, const std::string& digest);
+    void onRangeEnd(const std::shared_ptr<Range>& range);
+    void hashPrefix();
+    void checkSources();
+    void closeRanges();
+    void finish();
+
+    std::mutex mutex_;
+    std::string sha3Sum_;
+    std::filesystem::path path_;
+    std::filesystem::path journalPath_;
+    ChunkScheduler scheduler_;
+    std::unique_ptr<JournalStore> journal_;
+    std::map<std::string, RangeRequest> sources_;
+    std::set<std::shared_ptr<Range>> ranges_;
+    // Digest of the chunks received in order so far
+    fileutils::Sha3Stream hash_;
+    size_t hashed_ {0};
+    bool loaded_ {false};
+    bool stopped_ {false};
+};
+
 class TransferManager : public std::enable_shared_from_this<TransferManager>
 {
 public:
@@ -170,6 +328,17 @@ public:
                          const std::string& path,
                          std::size_t total);
 
+    /**
+     * Provide a file from the local file store instead of transferring it, if a
+     * file with the same content was already received
+     * @param path      where the file is to be downloaded, empty for the conversation data
+     * @return true if the file is available and the transfer finished
+     */
+    bool fromStore(const std::string& fileId,
+                   const std::string& interactionId,
+                   const std::string& sha3sum,
+                   const std::string& path);
+
     /**
      * Handle incoming transfer
      * @param id        Related id
@@ -180,6 +349,17 @@ public:
                                 const std::shared_ptr<dhtnet::ChannelSocket>& channel,
                                 size_t start);
 
+    /**
+     * Download a waited file by chunks, from deviceId alongside the other devices
+     * it is already downloaded from
+     * @param request   opens the channels to deviceId
+     * @return false if the file is not waited or too small to be split, in which case
+     *         it is to be received through a single channel
+     */
+    bool downloadFromDevice(const std::string& fileId,
+                            const std::string& deviceId,
+                            const ChunkedFile::RangeRequest& request);
+
     /**
      * Retrieve path of a file
      * @param id
@@ -76,6 +76,7 @@
 #include <stdexcept>
 #include <limits>
 #include <array>
+#include <algorithm>
 
 #include <cstdlib>
 #include <cstring>
@@ -755,21 +756,32 @@ remove(const std::filesystem::path& path, bool erase)
     return std::remove(path.string().c_str());
 }
 
-std::string
-sha3File(const std::filesystem::path& path)
+Sha3Stream::Sha3Stream()
+    : ctx_(std::make_unique<sha3_512_ctx>())
 {
-    sha3_512_ctx ctx;
-    sha3_512_init(&ctx);
+    sha3_512_init(ctx_.get());
+}
+
+Sha3Stream::~Sha3Stream() = default;
 
+void
+Sha3Stream::update(const uint8_t* data, size_t size)
+{
+    sha3_512_update(ctx_.get(), size, data);
+}
+
+bool
+Sha3Stream::updateFile(const std::filesystem::path& path)
+{
     try {
         if (not std::filesystem::is_regular_file(path)) {
             JAMI_ERROR("Unable to compute sha3sum of {}: not a regular file", path);
-            return {};
+            return false;
         }
         std::ifstream file(path, std::ios::binary | std::ios::in);
         if (!file) {
             JAMI_ERROR("Unable to compute sha3sum of {}: failed to open file", path);
-            return {};
+            return false;
         }
         constexpr size_t BUFFER_SIZE = 64 * 1024ul;
         std::vector<char> buffer(BUFFER_SIZE);
@@ -778,22 +790,107 @@ sha3File(const std::filesystem::path& path)
             const auto bytesRead = file.gcount();
             if (bytesRead == 0)
                 break;
-            sha3_512_update(&ctx, static_cast<size_t>(bytesRead), (const uint8_t*) buffer.data());
+            update((const uint8_t*) buffer.data(), static_cast<size_t>(bytesRead));
         }
     } catch (const std::exception& e) {
         JAMI_ERROR("Unable to compute sha3sum of {}: {}", path, e.what());
-        return {};
+        return false;
     }
+    return true;
+}
 
+std::string
+Sha3Stream::digest()
+{
     unsigned char digest[SHA3_512_DIGEST_SIZE];
 #if NETTLE_VERSION_MAJOR >= 4
-    sha3_512_digest(&ctx, digest);
+    sha3_512_digest(ctx_.get(), digest);
 #else
-    sha3_512_digest(&ctx, SHA3_512_DIGEST_SIZE, digest);
+    sha3_512_digest(ctx_.get(), SHA3_512_DIGEST_SIZE, digest);
 #endif
     return dht::toHex(digest, SHA3_512_DIGEST_SIZE);
 }
 
+FileReader::FileReader(const std::filesystem::path& path)
+{
+#ifdef _WIN32
+    stream_ = std::make_unique<std::ifstream>(path, std::ios::binary | std::ios::in);
+#else
+    fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+#ifdef POSIX_FADV_SEQUENTIAL
+    if (fd_ >= 0)
+        posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+#endif
+}
+
+FileReader::~FileReader()
+{
+#ifndef _WIN32
+    if (fd_ >= 0)
+        ::close(fd_);
+#endif
+}
+
+bool
+FileReader::isOpen() const
+{
+#ifdef _WIN32
+    return stream_ && stream_->is_open();
+#else
+    return fd_ >= 0;
+#endif
+}
+
+int64_t
+FileReader::read(uint64_t offset, uint8_t* data, size_t size)
+{
+    if (!isOpen())
+        return -1;
+    // Ask for the next window before the current one runs out
+    if (aheadEnd_ < offset + size + READ_AHEAD / 2)
+        readAhead(std::max(offset, aheadEnd_), offset + size + READ_AHEAD);
+#ifdef _WIN32
+    stream_->clear();
+    stream_->seekg(static_cast<std::streamoff>(offset), std::ios::beg);
+    stream_->read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(size));
+    if (stream_->bad())
+        return -1;
+    return static_cast<int64_t>(stream_->gcount());
+#else
+    ssize_t n;
+    do {
+        n = ::pread(fd_, data, size, static_cast<off_t>(offset));
+    } while (n < 0 && errno == EINTR);
+    return static_cast<int64_t>(n);
+#endif
+}
+
+void
+FileReader::readAhead(uint64_t offset, uint64_t end)
+{
+    aheadEnd_ = end;
+#if defined(POSIX_FADV_WILLNEED)
+    posix_fadvise(fd_, static_cast<off_t>(offset), static_cast<off_t>(end - offset), POSIX_FADV_WILLNEED);
+#elif defined(F_RDADVISE)
+    struct radvisory advice;
+    advice.ra_offset = static_cast<off_t>(offset);
+    advice.ra_count = static_cast<int>(end - offset);
+    fcntl(fd_, F_RDADVISE, &advice);
+#else
+    (void) offset;
+#endif
+}
+
+std::string
+sha3File(const std::filesystem::path& path)
+{
+    Sha3Stream stream;
+    if (not stream.updateFile(path))
+        return {};
+    return stream.digest();
+}
+
 std::string
 sha3sum(const std::vector<uint8_t>& buffer)
 {
@@ -25,7 +25,9 @@
 #include <mutex>
 #include <cstdio>
 #include <ios>
+#include <iosfwd>
 #include <filesystem>
+#include <memory>
 #include <string_view>
 
 #ifndef _WIN32
@@ -40,6 +42,8 @@
 #define DIR_SEPARATOR_STR_ESC "//*" // Escaped directory separator string
 #endif
 
+struct sha3_512_ctx;
+
 namespace jami {
 namespace fileutils {
 
@@ -131,6 +135,66 @@ bool writeArchive(const std::string& data,
 std::string sha3File(const std::filesystem::path& path);
 std::string sha3sum(const std::vector<uint8_t>& buffer);
 
+/**
+ * SHA3-512 of data given in several parts, as returned by sha3File
+ */
+class Sha3Stream
+{
+public:
+    Sha3Stream();
+    ~Sha3Stream();
+
+    void update(const uint8_t* data, size_t size);
+    /**
+     * Add the content of a file
+     * @return false if the file is unable to be read
+     */
+    bool updateFile(const std::filesystem::path& path);
+    /**
+     * Hexadecimal digest of everything added so far, then start over
+     */
+    std::string digest();
+
+private:
+    std::unique_ptr<sha3_512_ctx> ctx_;
+};
+
+/**
+ * Reads a file sequentially, to send it.
+ *
+ * Reads go straight to the caller's buffer, and the kernel is asked to read
+ * the next READ_AHEAD bytes in the background, so that disk reads overlap
+ * with sending the data already read.
+ */
+class FileReader
+{
+public:
+    static constexpr uint64_t READ_AHEAD {1024 * 1024};
+
+    explicit FileReader(const std::filesystem::path& path);
+    ~FileReader();
+    FileReader(const FileReader&) = delete;
+    FileReader& operator=(const FileReader&) = delete;
+
+    bool isOpen() const;
+    /**
+     * Read up to size bytes at offset
+     * @return number of bytes read, 0 at the end of the file, -1 on error
+     */
+    int64_t read(uint64_t offset, uint8_t* data, size_t size);
+
+private:
+    void readAhead(uint64_t offset, uint64_t end);
+
+#ifdef _WIN32
+    std::unique_ptr<std::ifstream> stream_;
+#else
+    int fd_ {-1};
+#endif
+    // End of what the kernel was asked to read ahead
+    uint64_t aheadEnd_ {0};
+};
+
 /**
  * Windows compatibility wrapper for checking read-only attribute
  */
@@ -21,12 +21,19 @@
 #include <dhtnet/multiplexed_socket.h>
 #include <dhtnet/connectionmanager.h>
 
+#include <algorithm>
+#include <charconv>
+
 using namespace std::string_view_literals;
 
 // Inactivity timeout for a git fetch. The read no longer runs with
 // ConversationRepository::opMtx_ held, so a peer that goes quiet costs this
 // fetch and nothing else on the conversation.
 constexpr auto P2P_READ_TIMEOUT = std::chrono::days(1);
+// The capabilities are on the first reference, never that far
+constexpr size_t MAX_ADVERTISEMENT_PEEK {64 * 1024};
+constexpr auto DEEPEN_CMD = "deepen"sv;
+constexpr auto FLUSH_PKT = "0000"sv;
 
 // NOTE: THIS MUST BE IN THE ROOT NAMESPACE FOR LIBGIT2
 
@@ -114,6 +121,81 @@ sendCmd(P2PStream* s)
     return 0;
 }
 
+/**
+ * Size of the pkt-line at the start of data, 4 for a flush, 0 if incomplete
+ * or malformed.
+ */
+static size_t
+pktLineSize(std::string_view data)
+{
+    unsigned int len = 0;
+    if (data.size() < 4)
+        return 0;
+    auto [p, ec] = std::from_chars(data.data(), data.data() + 4, len, 16);
+    if (ec != std::errc() || p != data.data() + 4)
+        return 0;
+    if (len == 0)
+        return 4;
+    return len >= 4 && len <= data.size() ? len : 0;
+}
+
+/**
+ * Look for the capabilities of the server, after the NUL of its first
+ * reference, in what was read so far.
+ */
+static void
+parseCapabilities(P2PStream* s, std::string_view data)
+{
+    s->advertisement.append(data);
+    std::string_view buf = s->advertisement;
+    while (!s->capabilitiesParsed) {
+        auto size = pktLineSize(buf);
+        if (size == 0)
+            break;
+        auto line = buf.substr(4, size - 4);
+        buf.remove_prefix(size);
+        // A flush ends the references: no capabilities
+        s->capabilitiesParsed = size == 4;
+        auto nul = line.find('\0');
+        if (s->capabilitiesParsed || nul == std::string_view::npos || line.starts_with("version "sv))
+            continue;
+        auto caps = line.substr(nul + 1);
+        for (size_t pos = 0; pos < caps.size();) {
+            auto end = std::min(caps.find_first_of(" \n"sv, pos), caps.size());
+            s->serverDeepens |= caps.substr(pos, end - pos) == DEEPEN_CAPABILITY;
+            pos = end + 1;
+        }
+        s->capabilitiesParsed = true;
+    }
+    if (s->capabilitiesParsed || s->advertisement.size() > MAX_ADVERTISEMENT_PEEK) {
+        s->capabilitiesParsed = true;
+        s->advertisement = {};
+    }
+}
+
+/**
+ * Remove the "deepen" pkt-lines of a request. data is left unchanged if it
+ * is not a sequence of complete pkt-lines.
+ */
+static bool
+stripDeepen(std::string_view data, std::string& out)
+{
+    bool stripped = false;
+    out.clear();
+    for (auto buf = data; !buf.empty();) {
+        auto size = pktLineSize(buf);
+        if (size == 0)
+            return false;
+        auto line = buf.substr(0, size);
+        if (size > 4 && line.substr(4).starts_with(DEEPEN_CMD))
+            stripped = true;
+        else
+            out.append(line);
+        buf.remove_prefix(size);
+    }
+    return stripped;
+}
+
 int
 P2PStreamRead(git_smart_subtransport_stream* stream, char* buffer, size_t buflen, size_t* read)
 {
@@ -136,6 +218,15 @@ P2PStreamRead(git_smart_subtransport_stream* stream, char* buffer, size_t buflen
     if (!fs->sent_command && sendCmd(fs) < 0)
         return -1;
 
+    if (fs->pendingShallowFlush && buflen >= FLUSH_PKT.size()) {
+        // An empty shallow update: the depth is not changed and the server
+        // sends the whole history it is asked for
+        fs->pendingShallowFlush = false;
+        std::copy(FLUSH_PKT.begin(), FLUSH_PKT.end(), buffer);
+        *read = FLUSH_PKT.size();
+        return 0;
+    }
+
     std::error_code ec;
     auto datalen = sock->waitForData(P2P_READ_TIMEOUT, ec);
     if (ec && ec != asio::error::eof) {
@@ -151,6 +242,8 @@ P2PStreamRead(git_smart_subtransport_stream* stream, char* buffer, size_t buflen
         giterr_set_str(GITERR_NET, ec.message().c_str());
         return -1;
     }
+    if (!fs->capabilitiesParsed)
+        parseCapabilities(fs, std::string_view(buffer, *read));
 
     return 0;
 }
@@ -164,6 +257,15 @@ P2PStreamWrite(git_smart_subtransport_stream* stream, const char* buffer, size_t
         giterr_set_str(GITERR_NET, "unavailable socket");
         return -1;
     }
+    std::string request;
+    if (!fs->serverDeepens && stripDeepen(std::string_view(buffer, len), request)) {
+        // Peers predating shallow clones would never answer, fall back to a
+        // complete fetch
+        JAMI_DEBUG("[git] {}: server does not support deepen, fetching the whole history", fs->url);
+        fs->pendingShallowFlush = true;
+        buffer = request.data();
+        len = request.size();
+    }
     std::error_code ec;
     sock->write(reinterpret_cast<const unsigned char*>(buffer), len, ec);
     if (ec) {
@@ -44,6 +44,14 @@ struct P2PStream
     std::string cmd {};
     std::string url {};
     unsigned sent_command : 1;
+
+    // Start of the server's answer, until its capabilities are known
+    std::string advertisement {};
+    bool capabilitiesParsed {false};
+    bool serverDeepens {false};
+    // A "deepen" was dropped because the server does not support it: the
+    // shallow update libgit2 waits for is answered locally
+    bool pendingShallowFlush {false};
 };
 
 struct P2PSubTransport
@@ -56,6 +64,8 @@ struct P2PSubTransport
 using namespace std::string_view_literals;
 constexpr auto UPLOAD_PACK_CMD = "git-upload-pack"sv;
 constexpr auto HOST_TAG = "host="sv;
+// Advertised by servers able to answer "deepen" (shallow clones and their backfill)
+constexpr auto DEEPEN_CAPABILITY = "jami-deepen"sv;
 
 #ifdef LIBJAMI_TEST
 using P2PStallHook = std::function<void(std::string_view url)>;
@@ -17,6 +17,8 @@
 
 #include "message_engine.h"
 #include "sip/sipaccountbase.h"
+#include "jamidht/journal_store.h"
+#include "fileutils.h"
 #include "manager.h"
 
 #include "client/jami_signal.h"
@@ -26,20 +28,93 @@
 #include <opendht/thread_pool.h>
 #include <fmt/std.h>
 
-#include <fstream>
+#include <algorithm>
 
 namespace jami {
 namespace im {
 
+static constexpr std::string_view GIT_MESSAGE_ID {"application/im-gitmessage-id"};
+
+MessageEngine::Message*
+MessageEngine::Queue::find(MessageToken token)
+{
+    auto it = index.find(token);
+    return it == index.end() ? nullptr : &*it->second;
+}
+
+void
+MessageEngine::Queue::push(Message&& message)
+{
+    if (message.status == MessageStatus::IDLE)
+        ++idle;
+    auto it = messages.emplace(messages.end(), std::move(message));
+    index.emplace(it->token, it);
+}
+
+void
+MessageEngine::Queue::erase(MessageToken token)
+{
+    auto it = index.find(token);
+    if (it == index.end())
+        return;
+    if (it->second->status == MessageStatus::IDLE)
+        --idle;
+    messages.erase(it->second);
+    index.erase(it);
+}
+
+void
+MessageEngine::Queue::setStatus(Message& message, MessageStatus status)
+{
+    if (message.status == MessageStatus::IDLE)
+        --idle;
+    if (status == MessageStatus::IDLE)
+        ++idle;
+    message.status = status;
+}
+
 MessageEngine::MessageEngine(SIPAccountBase& acc, const std::filesystem::path& path)
     : account_(acc)
     , savePath_(path)
     , ioContext_(Manager::instance().ioContext())
     , saveTimer_(*ioContext_)
+    , retryTimer_(*ioContext_)
 {
     dhtnet::fileutils::check_dir(savePath_.parent_path());
+
+    std::error_code ec;
+    if (std::filesystem::is_regular_file(savePath_, ec) and not JournalStore::isJournal(savePath_)) {
+        // Written by a previous version as a single map of queues
+        std::map<std::string, std::string> values;
+        try {
+            std::map<std::string, std::list<Message>> root;
+            {
+                std::lock_guard lock(dhtnet::fileutils::getFileLock(savePath_));
+                auto file = fileutils::loadFile(savePath_);
+                msgpack::unpack((const char*) file.data(), file.size()).get().convert(root);
+            }
+            uint64_t seq = 0;
+            for (auto& [peer, messages] : root) {
+                for (auto& m : messages) {
+                    m.seq = seq++;
+                    msgpack::sbuffer buffer;
+                    msgpack::pack(buffer, m);
+                    values.emplace(std::to_string(m.token), std::string(buffer.data(), buffer.size()));
+                }
+            }
+        } catch (const std::exception& e) {
+            JAMI_WARNING("[Account {}] Unable to migrate messages from {}: {}",
+                         account_.getAccountID(),
+                         savePath_,
+                         e.what());
+        }
+        JournalStore::write(savePath_, values);
+    }
+    journal_ = std::make_unique<JournalStore>(savePath_);
 }
 
+MessageEngine::~MessageEngine() = default;
+
 MessageToken
 MessageEngine::sendMessage(const std::string& to,
                            const std::string& deviceId,
@@ -51,25 +126,23 @@ MessageEngine::sendMessage(const std::string& to,
     MessageToken token = 0;
     {
         std::lock_guard lock(messagesMutex_);
-        auto& peerMessages = deviceId.empty() ? messages_[to] : messagesDevices_[deviceId];
-        if (refreshToken != 0) {
-            for (auto& m : peerMessages) {
-                if (m.token == refreshToken) {
-                    token = refreshToken;
-                    m.to = to;
-                    m.payloads = payloads;
-                    m.status = MessageStatus::IDLE;
-                    break;
-                }
-            }
-        }
-        if (token == 0) {
+        auto& queue = deviceId.empty() ? messages_[to] : messagesDevices_[deviceId];
+        if (auto* m = refreshToken != 0 ? queue.find(refreshToken) : nullptr) {
+            token = refreshToken;
+            m->to = to;
+            m->payloads = payloads;
+            queue.setStatus(*m, MessageStatus::IDLE);
+        } else {
             token = std::uniform_int_distribution<MessageToken> {1, JAMI_ID_MAX_VAL}(account_.rand);
-            auto& m = peerMessages.emplace_back(Message {token});
-            m.to = to;
-            m.payloads = payloads;
+            Message message {token};
+            message.to = to;
+            message.payloads = payloads;
+            message.seq = nextSeq_++;
+            queue.push(std::move(message));
+            if (deviceId.empty())
+                peers_[token] = to;
         }
-        scheduleSave();
+        markDirty(deviceId, token);
     }
     asio::post(*ioContext_, [this, to, deviceId]() { retrySend(to, deviceId, true); });
     return token;
@@ -84,35 +157,40 @@ MessageEngine::onPeerOnline(const std::string& peer, const std::string& deviceId
 void
 MessageEngine::retrySend(const std::string& peer, const std::string& deviceId, bool retryOnTimeout)
 {
-    struct PendingMsg
-    {
-        MessageToken token;
-        std::string to;
-        std::map<std::string, std::string> payloads;
-    };
-    std::vector<PendingMsg> pending {};
+    std::vector<Message> pending {};
     auto now = clock::now();
     {
         std::lock_guard lock(messagesMutex_);
-        auto& m = deviceId.empty() ? messages_ : messagesDevices_;
-        auto p = m.find(deviceId.empty() ? peer : deviceId);
-        if (p == m.end())
+        auto& queues = deviceId.empty() ? messages_ : messagesDevices_;
+        auto p = queues.find(deviceId.empty() ? peer : deviceId);
+        if (p == queues.end() or p->second.idle == 0)
             return;
-        auto& messages = p->second;
-
-        for (auto& m : messages) {
-            if (m.status == MessageStatus::IDLE) {
-                m.status = MessageStatus::SENDING;
-                m.retried++;
-                m.last_op = now;
-                pending.emplace_back(PendingMsg {m.token, m.to, m.payloads});
-            }
+        auto& queue = p->second;
+
+        // Every idle message goes in one batch
+        pending.reserve(queue.idle);
+        for (auto& m : queue.messages) {
+            if (m.status != MessageStatus::IDLE)
+                continue;
+            queue.setStatus(m, MessageStatus::SENDING);
+            m.retried++;
+            m.last_op = now;
+            markDirty(deviceId, m.token);
+            pending.emplace_back(m);
+            if (queue.idle == 0)
+                break;
         }
     }
     // avoid locking while calling callback
+    send(deviceId, pending, retryOnTimeout);
+}
+
+void
+MessageEngine::send(const std::string& deviceId, const std::vector<Message>& pending, bool retryOnTimeout)
+{
     for (const auto& p : pending) {
         JAMI_DEBUG("[Account {:s}] [message {:d}] Reattempt sending", account_.getAccountID(), p.token);
-        if (p.payloads.find("application/im-gitmessage-id") == p.payloads.end())
+        if (p.payloads.find(std::string(GIT_MESSAGE_ID)) == p.payloads.end())
             emitSignal<libjami::ConfigurationSignal::AccountMessageStatusChanged>(
                 account_.getAccountID(),
                 "",
@@ -127,27 +205,44 @@ MessageStatus
 MessageEngine::getStatus(MessageToken t) const
 {
     std::lock_guard lock(messagesMutex_);
-    for (const auto& p : messages_) {
-        for (const auto& m : p.second) {
-            if (m.token == t)
-                return m.status;
-        }
-    }
-    return MessageStatus::UNKNOWN;
+    auto p = peers_.find(t);
+    if (p == peers_.end())
+        return MessageStatus::UNKNOWN;
+    auto q = messages_.find(p->second);
+    if (q == messages_.end())
+        return MessageStatus::UNKNOWN;
+    auto m = q->second.index.find(t);
+    return m == q->second.index.end() ? MessageStatus::UNKNOWN : m->second->status;
+}
+
+std::vector<MessageToken>
+MessageEngine::pending(const std::string& peer, const std::string& deviceId) const
+{
+    std::lock_guard lock(messagesMutex_);
+    const auto& queues = deviceId.empty() ? messages_ : messagesDevices_;
+    auto p = queues.find(deviceId.empty() ? peer : deviceId);
+    if (p == queues.end())
+        return {};
+    std::vector<MessageToken> tokens;
+    tokens.reserve(p->second.messages.size());
+    for (const auto& m : p->second.messages)
+        tokens.emplace_back(m.token);
+    return tokens;
 }
 
 void
-MessageEngine::onMessageSent(const std::string& peer, MessageToken token, bool ok, const std::string& deviceId)
+MessageEngine::onMessageSent(
+    const std::string& peer, MessageToken token, bool ok, const std::string& deviceId, bool retry)
 {
     JAMI_DEBUG("[Account {:s}] [message {:d}] Message sent: {:s}",
                account_.getAccountID(),
                token,
                ok ? "success"sv : "failure"sv);
     std::lock_guard lock(messagesMutex_);
-    auto& m = deviceId.empty() ? messages_ : messagesDevices_;
+    auto& queues = deviceId.empty() ? messages_ : messagesDevices_;
 
-    auto p = m.find(deviceId.empty() ? peer : deviceId);
-    if (p == m.end()) {
+    auto p = queues.find(deviceId.empty() ? peer : deviceId);
+    if (p == queues.end()) {
         JAMI_WARNING("[Account {:s}] onMessageSent: Peer not found: id:{} device:{}",
                      account_.getAccountID(),
                      peer,
@@ -155,77 +250,135 @@ MessageEngine::onMessageSent(const std::string& peer, MessageToken token, bool o
         return;
     }
 
-    auto f = std::find_if(p->second.begin(), p->second.end(), [&](const Message& m) { return m.token == token; });
-    if (f != p->second.end()) {
-        auto emit = f->payloads.find("application/im-gitmessage-id") == f->payloads.end();
-        if (f->status == MessageStatus::SENDING) {
-            if (ok) {
-                f->status = MessageStatus::SENT;
-                JAMI_LOG("[Account {:s}] [message {:d}] Status changed to SENT", account_.getAccountID(), token);
-                if (emit)
-                    emitSignal<libjami::ConfigurationSignal::AccountMessageStatusChanged>(
-                        account_.getAccountID(),
-                        "",
-                        f->to,
-                        std::to_string(token),
-                        static_cast<int>(libjami::Account::MessageStates::SENT));
-                p->second.erase(f);
-                scheduleSave();
-            } else if (f->retried >= MAX_RETRIES) {
-                f->status = MessageStatus::FAILURE;
-                JAMI_WARNING("[Account {:s}] [message {:d}] Status changed to FAILURE", account_.getAccountID(), token);
-                if (emit)
-                    emitSignal<libjami::ConfigurationSignal::AccountMessageStatusChanged>(
-                        account_.getAccountID(),
-                        "",
-                        f->to,
-                        std::to_string(token),
-                        static_cast<int>(libjami::Account::MessageStates::FAILURE));
-                p->second.erase(f);
-                scheduleSave();
-            } else {
-                f->status = MessageStatus::IDLE;
-                JAMI_DEBUG("[Account {:s}] [message {:d}] Status changed to IDLE", account_.getAccountID(), token);
-            }
-        } else {
-            JAMI_DEBUG("[Account {:s}] [message {:d}] State is not SENDING", account_.getAccountID(), token);
-        }
-    } else {
+    auto& queue = p->second;
+    auto* f = queue.find(token);
+    if (not f) {
         JAMI_DEBUG("[Account {:s}] [message {:d}] Unable to find message", account_.getAccountID(), token);
+        return;
     }
+    if (f->status != MessageStatus::SENDING) {
+        JAMI_DEBUG("[Account {:s}] [message {:d}] State is not SENDING", account_.getAccountID(), token);
+        return;
+    }
+
+    auto emit = f->payloads.find(std::string(GIT_MESSAGE_ID)) == f->payloads.end();
+    if (ok or f->retried >= MAX_RETRIES) {
+        if (ok)
+            JAMI_LOG("[Account {:s}] [message {:d}] Status changed to SENT", account_.getAccountID(), token);
+        else
+            JAMI_WARNING("[Account {:s}] [message {:d}] Status changed to FAILURE", account_.getAccountID(), token);
+        if (emit)
+            emitSignal<libjami::ConfigurationSignal::AccountMessageStatusChanged>(
+                account_.getAccountID(),
+                "",
+                f->to,
+                std::to_string(token),
+                static_cast<int>(ok ? libjami::Account::MessageStates::SENT
+                                    : libjami::Account::MessageStates::FAILURE));
+        queue.erase(token);
+        if (deviceId.empty())
+            peers_.erase(token);
+    } else {
+        queue.setStatus(*f, MessageStatus::IDLE);
+        JAMI_DEBUG("[Account {:s}] [message {:d}] Status changed to IDLE", account_.getAccountID(), token);
+        if (retry)
+            scheduleRetry(peer, deviceId, *f);
+    }
+    markDirty(deviceId, token);
+}
+
+std::chrono::seconds
+MessageEngine::retryDelay(unsigned retried)
+{
+    auto shift = std::min(retried > 0 ? retried - 1 : 0u, 16u);
+    return std::min(RETRY_DELAY * (1 << shift), MAX_RETRY_DELAY);
 }
 
 void
-MessageEngine::load()
+MessageEngine::scheduleRetry(const std::string& peer, const std::string& deviceId, const Message& message)
 {
-    try {
-        decltype(messages_) root;
-        {
-            std::lock_guard lock(dhtnet::fileutils::getFileLock(savePath_));
-            std::ifstream file;
-            file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-            file.open(savePath_);
-            if (file.is_open()) {
-                msgpack::unpacker up;
-                up.reserve_buffer(UINT16_MAX);
-                while (file.read(up.buffer(), UINT16_MAX)) {
-                    up.buffer_consumed(file.gcount());
-                    msgpack::object_handle oh;
-                    if (up.next(oh)) {
-                        root = oh.get().as<std::map<std::string, std::list<Message>>>();
-                        break;
-                    }
-                    up.reserve_buffer(UINT16_MAX);
-                }
+    wheel_.schedule(Retry {peer, deviceId, message.token},
+                    static_cast<size_t>(retryDelay(message.retried) / WHEEL_TICK));
+    if (wheel_.size() == 1)
+        scheduleWheelTick();
+}
+
+void
+MessageEngine::scheduleWheelTick()
+{
+    retryTimer_.expires_after(WHEEL_TICK);
+    retryTimer_.async_wait([this, w = account_.weak_from_this()](const std::error_code& ec) {
+        if (!ec)
+            if (auto acc = w.lock())
+                onWheelTick();
+    });
+}
+
+void
+MessageEngine::onWheelTick()
+{
+    // Due messages, by device (empty for peers)
+    std::map<std::string, std::vector<Message>> due;
+    auto now = clock::now();
+    {
+        std::lock_guard lock(messagesMutex_);
+        for (const auto& retry : wheel_.advance()) {
+            // Skip messages that were sent or retried since
+            auto& queues = retry.deviceId.empty() ? messages_ : messagesDevices_;
+            auto p = queues.find(retry.deviceId.empty() ? retry.peer : retry.deviceId);
+            if (p == queues.end())
+                continue;
+            auto* m = p->second.find(retry.token);
+            if (m and m->status == MessageStatus::IDLE) {
+                p->second.setStatus(*m, MessageStatus::SENDING);
+                m->retried++;
+                m->last_op = now;
+                markDirty(retry.deviceId, m->token);
+                due[retry.deviceId].emplace_back(*m);
             }
         }
-        std::lock_guard lock(messagesMutex_);
-        messages_ = std::move(root);
-        if (not messages_.empty()) {
-            JAMI_LOG("[Account {}] Loaded {} messages from {}", account_.getAccountID(), messages_.size(), savePath_);
+        if (not wheel_.empty())
+            scheduleWheelTick();
+    }
+    for (const auto& [deviceId, pending] : due)
+        send(deviceId, pending, true);
+}
+
+void
+MessageEngine::load()
+{
+    std::lock_guard lock(messagesMutex_);
+    // Changes made before loading are kept
+    save_();
+
+    std::vector<Message> loaded;
+    for (const auto& [key, data] : journal_->values()) {
+        try {
+            auto oh = msgpack::unpack(data.data(), data.size());
+            loaded.emplace_back(oh.get().as<Message>());
+        } catch (const std::exception& e) {
+            JAMI_WARNING("[Account {}] Ignoring invalid message {} from {}: {}",
+                         account_.getAccountID(),
+                         key,
+                         savePath_,
+                         e.what());
         }
-    } catch (const std::exception& e) {
-        JAMI_LOG("[Account {}] Unable to load messages from {}: {}", account_.getAccountID(), savePath_, e.what());
+    }
+    std::sort(loaded.begin(), loaded.end(), [](const Message& a, const Message& b) { return a.seq < b.seq; });
+
+    messages_.clear();
+    peers_.clear();
+    for (auto& m : loaded) {
+        nextSeq_ = std::max(nextSeq_, m.seq + 1);
+        // Attempts in progress when the messages were saved are lost
+        if (m.status == MessageStatus::SENDING)
+            m.status = MessageStatus::IDLE;
+        peers_[m.token] = m.to;
+        auto& queue = messages_[m.to];
+        queue.push(std::move(m));
+    }
+    if (not loaded.empty()) {
+        JAMI_LOG("[Account {}] Loaded {} messages from {}", account_.getAccountID(), loaded.size(), savePath_);
     }
 }
 
@@ -236,6 +389,16 @@ MessageEngine::save() const
     save_();
 }
 
+void
+MessageEngine::markDirty(const std::string& deviceId, MessageToken token)
+{
+    if (not deviceId.empty())
+        return;
+    // The first change arms the timer, later ones are saved with it
+    if (dirty_.emplace(token).second and dirty_.size() == 1)
+        scheduleSave();
+}
+
 void
 MessageEngine::scheduleSave()
 {
@@ -250,15 +413,26 @@ MessageEngine::scheduleSave()
 void
 MessageEngine::save_() const
 {
-    try {
-        std::ofstream file;
-        file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-        file.open(savePath_, std::ios::trunc);
-        if (file.is_open())
-            msgpack::pack(file, messages_);
-    } catch (const std::exception& e) {
-        JAMI_ERROR("[Account {}] Unable to serialize pending messages: {}", account_.getAccountID(), e.what());
+    if (dirty_.empty())
+        return;
+    std::map<std::string, std::optional<std::string>> changes;
+    for (auto token : dirty_) {
+        auto& change = changes[std::to_string(token)];
+        auto p = peers_.find(token);
+        if (p == peers_.end())
+            continue;
+        auto q = messages_.find(p->second);
+        if (q == messages_.end())
+            continue;
+        auto m = q->second.index.find(token);
+        if (m == q->second.index.end())
+            continue;
+        msgpack::sbuffer buffer;
+        msgpack::pack(buffer, *m->second);
+        change = std::string(buffer.data(), buffer.size());
     }
+    dirty_.clear();
+    journal_->update(changes);
 }
 
 } // namespace im
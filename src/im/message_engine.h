@@ -16,12 +16,18 @@
  */
 #pragma once
 
+#include "timer_wheel.h"
+
 #include <string>
 #include <map>
+#include <list>
+#include <memory>
 #include <chrono>
 #include <mutex>
 #include <cstdint>
 #include <filesystem>
+#include <set>
+#include <vector>
 
 #include <msgpack.hpp>
 #include <asio/steady_timer.hpp>
@@ -29,6 +35,7 @@
 namespace jami {
 
 class SIPAccountBase;
+class JournalStore;
 
 namespace im {
 
@@ -36,10 +43,21 @@ using MessageToken = uint64_t;
 
 enum class MessageStatus : std::int8_t { UNKNOWN = 0, IDLE, SENDING, SENT, FAILURE };
 
+/**
+ * Queue of the messages to send to each peer, or device, until they are
+ * acknowledged.
+ *
+ * Messages of a destination are kept in sending order and indexed by token.
+ * A failed attempt is retried with an exponential backoff, scheduled on a
+ * timer wheel, and every idle message of a peer is sent when it comes online.
+ * Messages to peers are persisted in a journal where only the entries that
+ * changed since the last save are written.
+ */
 class MessageEngine
 {
 public:
     MessageEngine(SIPAccountBase&, const std::filesystem::path& path);
+    ~MessageEngine();
 
     /**
      * Add a message to the engine and try to send it
@@ -55,7 +73,20 @@ public:
 
     MessageStatus getStatus(MessageToken t) const;
 
-    void onMessageSent(const std::string& peer, MessageToken t, bool success, const std::string& deviceId = {});
+    /**
+     * @return the tokens of the messages queued for peer, or its device, in sending order
+     */
+    std::vector<MessageToken> pending(const std::string& peer, const std::string& deviceId = {}) const;
+
+    /**
+     * @param retry  if the message failed, try again after retryDelay(). It was
+     *               sent again at once before.
+     */
+    void onMessageSent(const std::string& peer,
+                       MessageToken t,
+                       bool success,
+                       const std::string& deviceId = {},
+                       bool retry = false);
 
     /**
      * @TODO change MessageEngine by a queue,
@@ -73,14 +104,21 @@ public:
      */
     void save() const;
 
-private:
     static const constexpr unsigned MAX_RETRIES = 20;
-    using clock = std::chrono::system_clock;
+    static constexpr std::chrono::seconds RETRY_DELAY {1};
+    static constexpr std::chrono::seconds MAX_RETRY_DELAY {10 * 60};
 
-    void retrySend(const std::string& peer, const std::string& deviceId, bool retryOnTimeout);
+    /**
+     * Delay before a message that failed after its retried-th attempt is sent
+     * again: doubles with each attempt, up to MAX_RETRY_DELAY
+     */
+    static std::chrono::seconds retryDelay(unsigned retried);
 
-    void save_() const;
-    void scheduleSave();
+private:
+    // One slot per tick, later deadlines take several turns of the wheel
+    static constexpr std::chrono::seconds WHEEL_TICK {1};
+    static constexpr size_t WHEEL_SLOTS {256};
+    using clock = std::chrono::system_clock;
 
     struct Message
     {
@@ -90,17 +128,62 @@ private:
         MessageStatus status {MessageStatus::IDLE};
         unsigned retried {0};
         clock::time_point last_op {};
+        // Position in the queue, kept across restarts
+        uint64_t seq {0};
+
+        MSGPACK_DEFINE_MAP(token, to, payloads, status, retried, last_op, seq)
+    };
+
+    struct Queue
+    {
+        std::list<Message> messages;
+        std::map<MessageToken, std::list<Message>::iterator> index;
+        size_t idle {0};
+
+        Message* find(MessageToken token);
+        void push(Message&& message);
+        void erase(MessageToken token);
+        void setStatus(Message& message, MessageStatus status);
+    };
 
-        MSGPACK_DEFINE_MAP(token, to, payloads, status, retried, last_op)
+    struct Retry
+    {
+        std::string peer;
+        std::string deviceId;
+        MessageToken token;
     };
 
+    using Queues = std::map<std::string, Queue>;
+
+    void retrySend(const std::string& peer, const std::string& deviceId, bool retryOnTimeout);
+    void send(const std::string& deviceId, const std::vector<Message>& pending, bool retryOnTimeout);
+
+    void scheduleRetry(const std::string& peer, const std::string& deviceId, const Message& message);
+    void scheduleWheelTick();
+    void onWheelTick();
+
+    // Only messages to peers are persisted
+    void markDirty(const std::string& deviceId, MessageToken token);
+    void save_() const;
+    void scheduleSave();
+
     SIPAccountBase& account_;
     const std::filesystem::path savePath_;
     std::shared_ptr<asio::io_context> ioContext_;
     asio::steady_timer saveTimer_;
+    asio::steady_timer retryTimer_;
+
+    Queues messages_;
+    Queues messagesDevices_;
+    // Queue of each message to a peer
+    std::map<MessageToken, std::string> peers_;
+    uint64_t nextSeq_ {0};
+
+    TimerWheel<Retry> wheel_ {WHEEL_SLOTS};
 
-    std::map<std::string, std::list<Message>> messages_;
-    std::map<std::string, std::list<Message>> messagesDevices_;
+    std::unique_ptr<JournalStore> journal_;
+    // Messages to peers changed since the last save
+    mutable std::set<MessageToken> dirty_;
 
     mutable std::mutex messagesMutex_ {};
 };
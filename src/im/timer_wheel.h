@@ -0,0 +1,90 @@
+/*
+ *  Copyright (C) 2004-2026 Savoir-faire Linux Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace jami {
+namespace im {
+
+/**
+ * Hashed timer wheel: items are due after a number of ticks, which the owner
+ * drives by calling advance() once per tick. An item due later than one turn
+ * of the wheel waits in its slot for the following turns.
+ */
+template<typename T>
+class TimerWheel
+{
+public:
+    explicit TimerWheel(size_t slots)
+        : slots_(slots)
+    {}
+
+    /**
+     * Make item due after ticks, at least one
+     */
+    void schedule(T item, size_t ticks)
+    {
+        ticks = std::max<size_t>(ticks, 1);
+        slots_[(pos_ + ticks) % slots_.size()].emplace_back(Entry {std::move(item), (ticks - 1) / slots_.size()});
+        ++size_;
+    }
+
+    /**
+     * Move to the next tick
+     * @return the items that are due
+     */
+    std::vector<T> advance()
+    {
+        std::vector<T> due;
+        pos_ = (pos_ + 1) % slots_.size();
+        auto& slot = slots_[pos_];
+        for (size_t i = 0; i < slot.size();) {
+            if (slot[i].rounds > 0) {
+                --slot[i].rounds;
+                ++i;
+                continue;
+            }
+            due.emplace_back(std::move(slot[i].item));
+            if (i + 1 < slot.size())
+                slot[i] = std::move(slot.back());
+            slot.pop_back();
+        }
+        size_ -= due.size();
+        return due;
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+private:
+    struct Entry
+    {
+        T item;
+        // Turns of the wheel left before it is due
+        size_t rounds;
+    };
+
+    std::vector<std::vector<Entry>> slots_;
+    size_t pos_ {0};
+    size_t size_ {0};
+};
+
+} // namespace im
+} // namespace jami
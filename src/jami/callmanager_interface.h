@@ -172,6 +172,15 @@ LIBJAMI_PUBLIC void startTone(int32_t start, int32_t type);
 
 LIBJAMI_PUBLIC bool switchInput(const std::string& accountId, const std::string& callId, const std::string& resource);
 
+/* Media statistics */
+/**
+ * Per stream and per pipeline stage statistics of a call: one map per
+ * (stream, stage) with keys "stream", "stage", "count", "bytes", "drops",
+ * "meanUs", "p50Us", "p90Us", "p99Us" and "maxUs".
+ */
+LIBJAMI_PUBLIC std::vector<std::map<std::string, std::string>> getCallMediaStats(const std::string& accountId,
+                                                                                   const std::string& callId);
+
 /* Instant messaging */
 LIBJAMI_PUBLIC void sendTextMessage(const std::string& accountId,
                                     const std::string& callId,
@@ -303,6 +312,14 @@ struct LIBJAMI_PUBLIC CallSignal
                              const std::string&,
                              const std::vector<std::map<std::string, std::string>>&);
     };
+    // Periodic sample of getCallMediaStats() for active calls
+    struct LIBJAMI_PUBLIC MediaStatsUpdated
+    {
+        constexpr static const char* name = "MediaStatsUpdated";
+        using cb_type = void(const std::string&,
+                             const std::string&,
+                             const std::vector<std::map<std::string, std::string>>&);
+    };
 };
 
 } // namespace libjami
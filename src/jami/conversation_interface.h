@@ -69,11 +69,18 @@ LIBJAMI_PUBLIC void updateConversationInfos(const std::string& accountId,
                                             const std::map<std::string, std::string>& infos);
 LIBJAMI_PUBLIC std::map<std::string, std::string> conversationInfos(const std::string& accountId,
                                                                     const std::string& conversationId);
+/**
+ * What is known of a conversation without opening its repository: mode,
+ * lastMessageId, lastMessageTimestamp and infosHash. Empty if unknown.
+ */
+LIBJAMI_PUBLIC std::map<std::string, std::string> conversationSummary(const std::string& accountId,
+                                                                      const std::string& conversationId);
 LIBJAMI_PUBLIC void setConversationPreferences(const std::string& accountId,
                                                const std::string& conversationId,
                                                const std::map<std::string, std::string>& prefs);
 LIBJAMI_PUBLIC std::map<std::string, std::string> getConversationPreferences(const std::string& accountId,
                                                                              const std::string& conversationId);
+LIBJAMI_PUBLIC std::map<std::string, std::string> getConversationMaintenanceStats(const std::string& accountId);
 
 // Member management
 LIBJAMI_PUBLIC void addConversationMember(const std::string& accountId,
@@ -41,6 +41,9 @@ LIBJAMI_PUBLIC std::string openServiceTunnel(const std::string& accountId,
                                              const std::string& serviceName,
                                              uint16_t localPort);
 LIBJAMI_PUBLIC bool closeServiceTunnel(const std::string& accountId, const std::string& tunnelId);
+LIBJAMI_PUBLIC bool setServiceTunnelPoolSize(const std::string& accountId,
+                                             const std::string& tunnelId,
+                                             uint32_t poolSize);
 LIBJAMI_PUBLIC std::vector<std::map<std::string, std::string>> getActiveTunnels(const std::string& accountId);
 
 // Service-exposure signal type definitions
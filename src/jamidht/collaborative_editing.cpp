@@ -47,6 +47,27 @@ static constexpr size_t CHECKPOINT_MAX_PENDING {200};
 /// Ceiling for a session that has no repository to drain into.
 static constexpr size_t PENDING_HARD_CAP {CHECKPOINT_MAX_PENDING * 50};
 
+// Real-time batching. The first local update after a pause goes out at once, so
+// an isolated keystroke is never delayed; the ones that follow within the
+// window are merged and sent as a single frame when it closes. The window
+// widens while updates keep coming faster than it lets them out and narrows
+// back once they thin out, never past the latency target: a burst of typing
+// then costs a frame every few dozen milliseconds per peer instead of one per
+// keystroke, for a delay no editor shows as lag.
+static constexpr std::chrono::milliseconds BROADCAST_WINDOW_MIN {5};
+static constexpr std::chrono::milliseconds BROADCAST_WINDOW_MAX {40};
+
+// Snapshot policy. Rebuilding a document takes its latest snapshot and the
+// checkpoints after it, so this bounds the replay on open to a few thousand
+// updates whatever the age of the document, for the price of one full state
+// stored every so many checkpoints. Not before every device of the members
+// declared it reads them (DocumentFormat::SNAPSHOTS).
+static constexpr size_t SNAPSHOT_INTERVAL {20};
+/// Past states kept decoded for documentStateAt(). A client browsing the
+/// history asks for the same few versions over and over, each of which is
+/// immutable once committed.
+static constexpr size_t STATE_CACHE_SIZE {8};
+
 // What a document holds when its creator did not say: the simplest thing an
 // editor can be pointed at.
 static constexpr const char DEFAULT_DOC_MIME_TYPE[] = "text/plain";
@@ -201,6 +222,17 @@ struct CollaborativeEditing::Session
     std::unique_ptr<asio::steady_timer> checkpointTimer;
     // Set once the repository's stored updates have been replayed into this session.
     bool persistedLoaded {false};
+    // The snapshot already merged into the replica, which a synchronization
+    // bringing only checkpoints on top of it does not need to merge again.
+    // Guarded by mutex_.
+    std::string appliedSnapshot;
+    // Checkpoints the repository holds past its latest snapshot, as of the last
+    // replay or local checkpoint.
+    std::atomic<size_t> checkpointsSinceSnapshot {0};
+    std::atomic_bool snapshotting {false};
+    // Whether this device declared the document format it reads, or is about
+    // to: once per document, so that the others know they may write it.
+    std::atomic_bool formatDeclared {false};
     // Attachment ids the local clients already know about, so a synchronization
     // only announces what it actually brought. Seeded on open with what the
     // repository already holds: a client reads those itself, and re-announcing
@@ -208,11 +240,22 @@ struct CollaborativeEditing::Session
     // mutex_.
     std::set<std::string> knownAttachments;
 
-    // Local updates produced since the last checkpoint, base64-encoded. Guarded by
-    // its own mutex: it is filled from a YrsDocument callback, which already holds
-    // the document's lock, so it must not reach for the manager-wide mutex.
+    // Local updates produced since the last checkpoint, merged into one when it
+    // is written. Guarded by its own mutex: it is filled from a YrsDocument
+    // callback, which already holds the document's lock, so it must not reach
+    // for the manager-wide mutex.
     std::mutex pendingMutex;
-    std::vector<std::string> pending;
+    std::vector<YrsDocument::Bytes> pending;
+
+    // Local updates held back until the real-time window closes, and that
+    // window. Guarded by outgoingMutex, the timer included: it is armed both
+    // from the thread producing the edits and from the io thread.
+    std::mutex outgoingMutex;
+    std::vector<YrsDocument::Bytes> outgoing;
+    std::unique_ptr<asio::steady_timer> broadcastTimer;
+    std::chrono::milliseconds broadcastWindow {BROADCAST_WINDOW_MIN};
+    // Whether a window is open: an update arriving meanwhile waits for it.
+    bool broadcastPending {false};
 
     // The timer is rearmed both from the thread producing the edits and from the
     // io thread retrying a failed checkpoint; asio timers are not thread-safe.
@@ -328,6 +371,7 @@ CollaborativeEditing::ensureSession(const std::string& conversationId, const std
     session->documentId = documentId;
     session->doc = std::make_unique<YrsDocument>(replicaId());
     session->checkpointTimer = std::make_unique<asio::steady_timer>(*ioContext_);
+    session->broadcastTimer = std::make_unique<asio::steady_timer>(*ioContext_);
     session->awarenessTimer = std::make_unique<asio::steady_timer>(*ioContext_);
     sessions_.emplace(k, session);
     return session;
@@ -364,8 +408,10 @@ CollaborativeEditing::createDocument(const std::string& conversationId,
     const auto stored = truncatedName(name);
     if (!stored.empty())
         cm->updateConversationInfos(documentId, {{"title", stored}}, false);
+    cm->createCommit(documentId, CommitMessage::formatCheckpoint(DocumentFormat::CURRENT), false);
 
     auto session = ensureSession(conversationId, documentId);
+    session->formatDeclared = true;
     {
         std::lock_guard<std::mutex> lk(mutex_);
         session->persistedLoaded = true; // the repository is newborn: nothing to replay
@@ -661,8 +707,21 @@ CollaborativeEditing::dropLocalReplica(const std::string& conversationId, const
         std::lock_guard<std::mutex> lk(session->timerMutex);
         session->checkpointTimer->cancel();
     }
+    if (session && session->broadcastTimer) {
+        std::lock_guard<std::mutex> lk(session->outgoingMutex);
+        session->broadcastTimer->cancel();
+    }
     if (session)
         closeRealtimeChannels(session);
+    std::lock_guard<std::mutex> lk(stateCacheMtx_);
+    for (auto it = stateCache_.begin(); it != stateCache_.end();) {
+        if (it->first.starts_with(documentId + '/')) {
+            stateCacheIndex_.erase(it->first);
+            it = stateCache_.erase(it);
+        } else {
+            ++it;
+        }
+    }
 }
 
 YrsDocument::Bytes
@@ -807,6 +866,9 @@ CollaborativeEditing::closeDocument(const std::string& conversationId, const std
     // for the other members. Done explicitly rather than left to expire so that
     // closing an editor is seen at once instead of a timeout later.
     publishAwareness(session, {});
+    // What the real-time window still holds goes out first: the members would
+    // otherwise only see it with the checkpoint.
+    flushBroadcast(session);
     // The channels only exist between devices that are editing, and this one no
     // longer is. A reopen starts them over.
     closeRealtimeChannels(session);
@@ -1300,30 +1362,166 @@ CollaborativeEditing::awarenessUpkeep(const std::shared_ptr<Session>& session)
 void
 CollaborativeEditing::onLocalUpdate(const std::shared_ptr<Session>& session, const YrsDocument::Bytes& update)
 {
-    // Real-time path: hand the incremental update to the devices editing along.
-    broadcastFrame(session, FRAME_UPDATE, update);
+    // Real-time path: hand the incremental update to the devices editing along,
+    // at once after a pause, merged with the next ones while a burst goes on.
+    bool sendNow = false;
+    {
+        std::lock_guard<std::mutex> lk(session->outgoingMutex);
+        if (session->broadcastPending) {
+            session->outgoing.emplace_back(update);
+        } else {
+            session->broadcastPending = true;
+            sendNow = true;
+            scheduleBroadcast(session);
+        }
+    }
+    if (sendNow)
+        broadcastFrame(session, FRAME_UPDATE, update);
     // Durable path: accumulate the update for the next checkpoint.
     queueUpdate(session, update);
 }
 
+void
+CollaborativeEditing::scheduleBroadcast(const std::shared_ptr<Session>& session)
+{
+    if (!session->broadcastTimer)
+        return;
+    std::weak_ptr<CollaborativeEditing> wthis = weak_from_this();
+    std::weak_ptr<Session> wsession = session;
+    session->broadcastTimer->expires_after(session->broadcastWindow);
+    session->broadcastTimer->async_wait([wthis, wsession](const asio::error_code& ec) {
+        if (ec)
+            return;
+        auto sthis = wthis.lock();
+        auto session = wsession.lock();
+        if (sthis && session)
+            sthis->flushBroadcast(session);
+    });
+}
+
+void
+CollaborativeEditing::flushBroadcast(const std::shared_ptr<Session>& session)
+{
+    std::vector<YrsDocument::Bytes> batch;
+    {
+        std::lock_guard<std::mutex> lk(session->outgoingMutex);
+        batch.swap(session->outgoing);
+        if (batch.empty()) {
+            // A whole window without an update: the burst is over, and the
+            // next update goes out at once.
+            session->broadcastWindow = std::max(BROADCAST_WINDOW_MIN, session->broadcastWindow / 2);
+            session->broadcastPending = false;
+            return;
+        }
+        if (batch.size() > 1)
+            session->broadcastWindow = std::min(BROADCAST_WINDOW_MAX, session->broadcastWindow * 2);
+        scheduleBroadcast(session);
+    }
+    auto merged = YrsDocument::mergeUpdates(batch);
+    if (!merged.empty()) {
+        broadcastFrame(session, FRAME_UPDATE, merged);
+        return;
+    }
+    // Not expected from updates the replica accepted, but nothing is lost for
+    // it: they go out one by one.
+    for (const auto& update : batch)
+        broadcastFrame(session, FRAME_UPDATE, update);
+}
+
+bool
+CollaborativeEditing::snapshotHolds(const DocumentSnapshot& snapshot)
+{
+    // A snapshot is a peer's claim about what hundreds of updates merge to.
+    // Checked in a replica of its own, so that one holding less than it claims
+    // is caught before it stands in for the history it replaces.
+    YrsDocument check {replicaId()};
+    return check.applyUpdate(snapshot.state) && check.encodeStateVector() == snapshot.stateVector;
+}
+
+std::unique_ptr<YrsDocument>
+CollaborativeEditing::rebuild(const Conversation& conversation, const std::string& commitId, std::string* head)
+{
+    auto replay = conversation.documentReplay(commitId);
+    if (!replay)
+        return nullptr;
+    if (head)
+        *head = replay->head;
+    auto doc = std::make_unique<YrsDocument>(replicaId());
+    if (replay->snapshot
+        && (!doc->applyUpdate(replay->snapshot->state)
+            || doc->encodeStateVector() != replay->snapshot->stateVector)) {
+        JAMI_WARNING("[Account {}] [Document {}] Snapshot {} does not hold what it claims, replaying the whole history",
+                     accountId_,
+                     conversation.id(),
+                     replay->snapshotId);
+        replay = conversation.documentReplay(replay->head, false);
+        if (!replay)
+            return nullptr;
+        doc = std::make_unique<YrsDocument>(replicaId());
+    }
+    for (const auto& update : replay->updates)
+        doc->applyUpdate(update);
+    return doc;
+}
+
 void
 CollaborativeEditing::replayStoredUpdates(const std::shared_ptr<Session>& session)
 {
     auto conversation = documentConversation(session->documentId);
     if (!conversation)
         return;
-    // The updates come from peers' commits, so their content is not ours to
-    // trust: a malformed one must cost that one update, not the whole replay.
-    for (const auto& encoded : conversation->documentUpdates()) {
-        try {
-            session->doc->applyUpdate(base64::decode(encoded));
-        } catch (const std::exception& e) {
-            JAMI_WARNING("[Account {}] [Document {}] Skipping unreadable stored update: {}",
+    declareFormat(session, *conversation);
+    auto replay = conversation->documentReplay();
+    if (!replay)
+        return;
+    std::string applied;
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        applied = session->appliedSnapshot;
+    }
+    if (replay->snapshot && replay->snapshotId != applied) {
+        if (snapshotHolds(*replay->snapshot)) {
+            session->doc->applyUpdate(replay->snapshot->state);
+        } else {
+            JAMI_WARNING("[Account {}] [Document {}] Snapshot {} does not hold what it claims, replaying the whole "
+                         "history",
                          accountId_,
                          session->documentId,
-                         e.what());
+                         replay->snapshotId);
+            replay = conversation->documentReplay({}, false);
+            if (!replay)
+                return;
         }
     }
+    for (const auto& update : replay->updates)
+        session->doc->applyUpdate(update);
+    // A history that was replayed whole counts all of its checkpoints, so the
+    // next local checkpoint snapshots a document that never had one, or whose
+    // snapshot was refused.
+    session->checkpointsSinceSnapshot = replay->checkpoints;
+    std::lock_guard<std::mutex> lk(mutex_);
+    session->appliedSnapshot = replay->snapshotId;
+}
+
+void
+CollaborativeEditing::declareFormat(const std::shared_ptr<Session>& session, const Conversation& conversation)
+{
+#ifdef LIBJAMI_TEST
+    if (!declaresFormatTest_)
+        return;
+#endif
+    if (session->formatDeclared.exchange(true))
+        return;
+    auto account = account_.lock();
+    if (!account || conversation.declaredFormat(std::string(account->currentDeviceId())) >= DocumentFormat::CURRENT)
+        return;
+    // From another thread: a replay may run while the module holds the
+    // document's lock, which committing takes too.
+    dht::ThreadPool::io().run([w = account_, documentId = session->documentId] {
+        if (auto account = w.lock())
+            if (auto* cm = account->convModule())
+                cm->createCommit(documentId, CommitMessage::formatCheckpoint(DocumentFormat::CURRENT), true);
+    });
 }
 
 void
@@ -1334,9 +1532,10 @@ CollaborativeEditing::loadPersistedState(const std::shared_ptr<Session>& session
         if (session->persistedLoaded)
             return;
     }
-    // Replay the updates stored in the document's repository. Nothing is
-    // signalled: the caller encodes the converged state and hands it to the
-    // client that asked to open the document.
+    // Replay the latest snapshot stored in the document's repository and the
+    // updates checkpointed after it. Nothing is signalled: the caller encodes
+    // the converged state and hands it to the client that asked to open the
+    // document.
     replayStoredUpdates(session);
     // What is already stored is not news: the client resolves the attachments
     // of the state it is being handed. Only what arrives afterwards is signalled.
@@ -1369,7 +1568,7 @@ CollaborativeEditing::queueUpdate(const std::shared_ptr<Session>& session, const
         // rest rather than growing without bound.
         if (!held && session->pending.size() >= PENDING_HARD_CAP)
             session->pending.erase(session->pending.begin(), session->pending.begin() + CHECKPOINT_MAX_PENDING);
-        session->pending.emplace_back(base64::encode(update));
+        session->pending.emplace_back(update);
         capReached = session->pending.size() >= CHECKPOINT_MAX_PENDING;
     }
     // Checkpointing reads the document back, so it must never run inline on the
@@ -1417,7 +1616,7 @@ CollaborativeEditing::checkpointNow(const std::shared_ptr<Session>& session)
     // being opened, which is what clones it -- still saves recent work.
     if (!documentConversation(session->documentId))
         return;
-    std::vector<std::string> batch;
+    std::vector<YrsDocument::Bytes> batch;
     {
         std::lock_guard<std::mutex> lk(session->pendingMutex);
         batch.swap(session->pending);
@@ -1425,31 +1624,108 @@ CollaborativeEditing::checkpointNow(const std::shared_ptr<Session>& session)
     if (batch.empty())
         return;
 
+    // One update per checkpoint, whatever the batch: merged, it weighs little
+    // more than what it inserts and replays as a single update.
+    auto update = YrsDocument::mergeUpdates(batch);
+    if (update.empty()) {
+        // Not expected from updates the replica accepted. Written the way older
+        // versions did rather than dropped: every version still reads it.
+        JAMI_WARNING("[Account {}] [Document {}] Unable to merge {} updates, checkpointing them separately",
+                     accountId_,
+                     session->documentId,
+                     batch.size());
+        std::vector<std::string> encoded;
+        encoded.reserve(batch.size());
+        for (const auto& u : batch)
+            encoded.emplace_back(base64::encode(u));
+        cm->createCommit(session->documentId, CommitMessage::checkpoint(encoded), true);
+        return;
+    }
+
     // The checkpoint is a commit in the document's own swarm: committing it is
     // also what announces it, so the other holders fetch it through the same
     // pipeline that moves conversation messages. Nothing else needs sending.
-    cm->createCommit(session->documentId,
-                     CommitMessage::checkpoint(batch),
-                     true,
-                     {},
-                     [w = weak_from_this(), wsession = std::weak_ptr<Session>(session), batch](bool ok,
-                                                                                               const std::string&) {
-                         if (ok)
-                             return;
-                         // Keep the updates queued so the next checkpoint retries
-                         // them rather than silently losing the edits they carry,
-                         // and make sure a retry is actually scheduled even if the
-                         // user has stopped typing.
-                         auto sthis = w.lock();
-                         auto session = wsession.lock();
-                         if (!sthis || !session)
-                             return;
-                         {
-                             std::lock_guard<std::mutex> lk(session->pendingMutex);
-                             session->pending.insert(session->pending.begin(), batch.begin(), batch.end());
-                         }
-                         sthis->scheduleCheckpoint(session, CHECKPOINT_IDLE);
-                     });
+    dht::ThreadPool::io().run([w = weak_from_this(), wsession = std::weak_ptr<Session>(session), update] {
+        auto sthis = w.lock();
+        auto session = wsession.lock();
+        if (!sthis || !session)
+            return;
+        auto account = sthis->account_.lock();
+        auto* cm = account ? account->convModule() : nullptr;
+        auto conversation = sthis->documentConversation(session->documentId);
+        auto format = conversation ? conversation->documentFormat() : DocumentFormat::LEGACY;
+        if (cm && format < DocumentFormat::UPDATE_BLOBS) {
+            // Some member's device does not read batches from the tree yet
+            cm->createCommit(session->documentId,
+                             CommitMessage::checkpoint({base64::encode(update)}),
+                             true,
+                             {},
+                             [w = sthis->weak_from_this(), wsession, update, format](bool ok, const std::string&) {
+                                 auto sthis = w.lock();
+                                 auto session = wsession.lock();
+                                 if (sthis && session)
+                                     sthis->onCheckpointWritten(session, update, format, ok);
+                             });
+            return;
+        }
+        sthis->onCheckpointWritten(session,
+                                   update,
+                                   format,
+                                   cm && cm->addDocumentUpdate(session->documentId, update));
+    });
+}
+
+void
+CollaborativeEditing::onCheckpointWritten(const std::shared_ptr<Session>& session,
+                                          const YrsDocument::Bytes& update,
+                                          int format,
+                                          bool written)
+{
+    if (written) {
+        // Until every member's devices read snapshots, rebuilds replay the
+        // whole history
+        if (++session->checkpointsSinceSnapshot >= SNAPSHOT_INTERVAL && format >= DocumentFormat::SNAPSHOTS)
+            snapshotNow(session);
+        return;
+    }
+    // Keep the batch queued so the next checkpoint retries it rather than
+    // silently losing the edits it carries, and make sure a retry is
+    // actually scheduled even if the user has stopped typing.
+    {
+        std::lock_guard<std::mutex> lk(session->pendingMutex);
+        session->pending.insert(session->pending.begin(), update);
+    }
+    scheduleCheckpoint(session, CHECKPOINT_IDLE);
+}
+
+void
+CollaborativeEditing::snapshotNow(const std::shared_ptr<Session>& session)
+{
+    if (session->snapshotting.exchange(true))
+        return;
+    auto account = account_.lock();
+    auto* cm = account ? account->convModule() : nullptr;
+    auto conversation = documentConversation(session->documentId);
+    if (cm && conversation) {
+        // Rebuilt from the repository rather than read from the live replica:
+        // that one also holds what peers sent in real time and did not commit
+        // yet, and a snapshot must hold exactly the history it is committed on,
+        // or the commits after it would not show what they held.
+        std::string head;
+        if (auto doc = rebuild(*conversation, {}, &head)) {
+            DocumentSnapshot snapshot {doc->encodeStateVector(), doc->encodeStateAsUpdate()};
+            // Refused when a commit landed since the rebuild; the next
+            // checkpoint tries again.
+            if (cm->addDocumentSnapshot(session->documentId, snapshot, head)) {
+                session->checkpointsSinceSnapshot = 0;
+                JAMI_DEBUG("[Account {}] [Document {}] Snapshot of {} bytes committed",
+                           accountId_,
+                           session->documentId,
+                           snapshot.state.size());
+            }
+        }
+    }
+    session->snapshotting = false;
 }
 
 std::vector<std::map<std::string, std::string>>
@@ -1468,30 +1744,39 @@ CollaborativeEditing::documentStateAt(const std::string& /*conversationId*/,
     if (!conversation)
         return {};
 
+    const auto cacheKey = key(documentId, commitId);
+    {
+        std::lock_guard<std::mutex> lk(stateCacheMtx_);
+        if (auto it = stateCacheIndex_.find(cacheKey); it != stateCacheIndex_.end()) {
+            stateCache_.splice(stateCache_.begin(), stateCache_, it->second);
+            return it->second->second;
+        }
+    }
+
     // Nothing at all when the checkpoint is unknown, which is what the public
     // contract promises. It has to be told apart from a checkpoint that exists
     // and holds nothing: the two would otherwise be the same answer, and a
     // client restoring an early, legitimately empty version could not tell
     // whether it was allowed to.
-    const auto stored = conversation->documentUpdatesAt(commitId);
-    if (!stored)
-        return {};
-
-    // Replay into a throwaway replica: the live document must not be touched.
+    //
+    // Rebuilt in a throwaway replica: the live document must not be touched.
     // What the client does with that state -- show it, restore it, diff it -- is
     // its own business, and depends on a document type the daemon ignores.
-    YrsDocument snapshot {replicaId()};
-    for (const auto& encoded : *stored) {
-        try {
-            snapshot.applyUpdate(base64::decode(encoded));
-        } catch (const std::exception& e) {
-            JAMI_WARNING("[Account {}] [Document {}] Skipping unreadable stored update: {}",
-                         accountId_,
-                         documentId,
-                         e.what());
+    auto snapshot = rebuild(*conversation, commitId);
+    if (!snapshot)
+        return {};
+    auto state = snapshot->encodeStateAsUpdate();
+
+    std::lock_guard<std::mutex> lk(stateCacheMtx_);
+    if (stateCacheIndex_.find(cacheKey) == stateCacheIndex_.end()) {
+        stateCache_.emplace_front(cacheKey, state);
+        stateCacheIndex_.emplace(cacheKey, stateCache_.begin());
+        if (stateCache_.size() > STATE_CACHE_SIZE) {
+            stateCacheIndex_.erase(stateCache_.back().first);
+            stateCache_.pop_back();
         }
     }
-    return snapshot.encodeStateAsUpdate();
+    return state;
 }
 
 void
@@ -1559,7 +1844,8 @@ CollaborativeEditing::onRepositoryUpdated(const std::string& conversationId, con
     const auto before = session->doc->encodeStateVector();
     session->doc->takeChanged();
     // Applying an update the replica already knows is a no-op for a CRDT, so
-    // replaying the whole set is correct, just more work than strictly needed.
+    // replaying everything since the latest snapshot is correct, just more work
+    // than strictly needed.
     replayStoredUpdates(session);
     // Nothing at all when the replay taught us nothing -- a rename-only commit,
     // or updates the real-time path had already delivered -- or every client
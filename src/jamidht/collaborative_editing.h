@@ -19,7 +19,9 @@
 #include "yrs_document.h"
 
 #include <asio.hpp>
+#include <atomic>
 #include <cstdint>
+#include <list>
 #include <map>
 #include <optional>
 #include <memory>
@@ -36,6 +38,7 @@ namespace jami {
 
 class JamiAccount;
 class Conversation;
+struct DocumentSnapshot;
 
 /**
  * Per-account manager for real-time collaborative documents shared inside swarm
@@ -50,18 +53,20 @@ class Conversation;
  *
  * Real-time path: devices that have a document open hold a dedicated binary
  * channel ("ydoc://") per peer device, over which updates travel raw as they
- * are produced, alongside awareness states -- who is editing and where. There
- * is no handshake and no per-peer protocol state: a CRDT update commutes and
- * repeats harmlessly, so convergence needs nothing more than every update
- * eventually reaching every replica -- live over these channels, or with the
- * next checkpoint for whatever a device missed while its channels were down.
+ * are produced -- those of a burst merged over a few milliseconds -- alongside
+ * awareness states: who is editing and where. There is no handshake and no
+ * per-peer protocol state: a CRDT update commutes and repeats harmlessly, so
+ * convergence needs nothing more than every update eventually reaching every
+ * replica -- live over these channels, or with the next checkpoint for
+ * whatever a device missed while its channels were down.
  *
  * Durable path: each document is a swarm repository of its own (a conversation
  * in mode DOCUMENT, held by ConversationModule), where batches of updates are
- * appended as checkpoint commits. It replicates through the very pipeline the
- * conversations use -- same membership, same validation, same git transport --
- * so offline peers and late joiners converge and the history stays browsable,
- * without adding anything to the conversation history itself.
+ * appended as checkpoint commits, each merged into a single update. It
+ * replicates through the very pipeline the conversations use -- same
+ * membership, same validation, same git transport -- so offline peers and late
+ * joiners converge and the history stays browsable, without adding anything to
+ * the conversation history itself.
  */
 class CollaborativeEditing : public std::enable_shared_from_this<CollaborativeEditing>
 {
@@ -184,7 +189,8 @@ public:
 
     /// Checkpoints of a document, newest first (@c max == 0 means no limit).
     /// One map per checkpoint commit, with keys "id", "author", "device",
-    /// "timestamp" and "deltas" (how many updates the checkpoint carries).
+    /// "timestamp" and "deltas" (how many updates the checkpoint carries: one
+    /// for a batch stored merged).
     std::vector<std::map<std::string, std::string>> history(const std::string& conversationId,
                                                             const std::string& documentId,
                                                             size_t max = 0);
@@ -206,6 +212,11 @@ public:
     /// Flush every pending checkpoint (called before the account goes away).
     void flush();
 
+#ifdef LIBJAMI_TEST
+    /// Behave like a version that declares no document format.
+    void setDeclaresFormat(bool declares) { declaresFormatTest_ = declares; }
+#endif
+
 private:
     struct Session;
 
@@ -222,6 +233,11 @@ private:
 
     /// Broadcast an update to the members and queue it for the next checkpoint.
     void onLocalUpdate(const std::shared_ptr<Session>& session, const YrsDocument::Bytes& update);
+    /// Arm the real-time window. Called with the session's outgoingMutex held.
+    void scheduleBroadcast(const std::shared_ptr<Session>& session);
+    /// Send what the real-time window held back as a single frame, adapting
+    /// the window to how fast updates come, or close it if nothing came.
+    void flushBroadcast(const std::shared_ptr<Session>& session);
     /// Whether a COLLAB_DOC commit in @c conversationId announced this document.
     bool isAnnouncedDocument(const std::string& conversationId, const std::string& documentId);
     /// Whether the author of this document has retired its announcement.
@@ -255,8 +271,23 @@ private:
     /// session, so opening a document always yields its full state, even after a
     /// daemon restart.
     void loadPersistedState(const std::shared_ptr<Session>& session);
-    /// Apply every update stored in the repository, skipping unreadable ones.
+    /// Apply the latest snapshot stored in the repository and the updates
+    /// checkpointed after it, skipping unreadable ones.
     void replayStoredUpdates(const std::shared_ptr<Session>& session);
+    /// Tell the other holders which document format this device reads, unless
+    /// it already did.
+    void declareFormat(const std::shared_ptr<Session>& session, const Conversation& conversation);
+    /// Whether applying @p snapshot yields the state vector it claims.
+    bool snapshotHolds(const DocumentSnapshot& snapshot);
+    /// The document as the repository holds it at @p commitId (HEAD if empty),
+    /// in a replica of its own, or nullptr if that commit is unknown. @p head is
+    /// set to the commit it was rebuilt at.
+    std::unique_ptr<YrsDocument> rebuild(const Conversation& conversation,
+                                         const std::string& commitId,
+                                         std::string* head = nullptr);
+    /// Store the merged state of the repository as a snapshot, so that the
+    /// next rebuild starts from there.
+    void snapshotNow(const std::shared_ptr<Session>& session);
 
     /// Open real-time channels towards the document's member devices that have
     /// none yet. Called on open and again after every synchronization: a member
@@ -293,6 +324,12 @@ private:
     void scheduleCheckpoint(const std::shared_ptr<Session>& session, std::chrono::seconds delay);
     /// Drain the pending updates into a checkpoint commit now.
     void checkpointNow(const std::shared_ptr<Session>& session);
+    /// A checkpoint of @p update in @p format was committed, or failed to be
+    /// and is queued again.
+    void onCheckpointWritten(const std::shared_ptr<Session>& session,
+                             const YrsDocument::Bytes& update,
+                             int format,
+                             bool written);
     /// Hand an update to the local clients, so they merge it into their replica.
     void emitUpdate(const std::string& conversationId, const std::string& documentId, const YrsDocument::Bytes& update);
     void emitRename(const std::string& conversationId, const std::string& documentId, const std::string& name);
@@ -300,6 +337,10 @@ private:
     /// an editor showing a placeholder for one can finally draw it.
     void emitNewAttachments(const std::shared_ptr<Session>& session);
 
+#ifdef LIBJAMI_TEST
+    std::atomic_bool declaresFormatTest_ {true};
+#endif
+
     std::weak_ptr<JamiAccount> account_;
     std::string accountId_;
     uint64_t clientId_ {0};
@@ -307,6 +348,12 @@ private:
 
     std::mutex mutex_;
     std::map<std::string, std::shared_ptr<Session>> sessions_;
+
+    /// Past states handed out by documentStateAt(), most recently used first,
+    /// keyed by document and commit.
+    std::mutex stateCacheMtx_;
+    std::list<std::pair<std::string, YrsDocument::Bytes>> stateCache_;
+    std::map<std::string, std::list<std::pair<std::string, YrsDocument::Bytes>>::iterator> stateCacheIndex_;
 };
 
 } // namespace jami
@@ -0,0 +1,174 @@
+/*
+ *  Copyright (C) 2004-2026 Savoir-faire Linux Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "commit_index.h"
+
+#include "fileutils.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <fstream>
+
+namespace jami {
+
+bool
+CommitIndex::load()
+{
+    if (loaded_)
+        return true;
+    loaded_ = true;
+    entries_.clear();
+    offsets_.clear();
+
+    std::error_code ec;
+    if (not std::filesystem::is_regular_file(path_, ec))
+        return false;
+    try {
+        auto data = fileutils::loadFile(path_);
+        msgpack::unpacker pac;
+        pac.reserve_buffer(data.size());
+        std::copy(data.begin(), data.end(), pac.buffer());
+        pac.buffer_consumed(data.size());
+
+        msgpack::object_handle oh;
+        if (not pac.next(oh) or oh.get().as<uint32_t>() != VERSION)
+            throw std::runtime_error("unsupported version");
+        while (pac.next(oh)) {
+            auto entry = oh.get().as<CommitIndexEntry>();
+            offsets_[entry.id] = entries_.size();
+            entries_.emplace_back(std::move(entry));
+        }
+        // An interrupted append leaves a partial entry
+        if (pac.nonparsed_size() != 0)
+            throw std::runtime_error("truncated file");
+        return true;
+    } catch (const std::exception& e) {
+        JAMI_WARNING("Ignoring invalid commit index {}: {}", path_, e.what());
+    }
+    entries_.clear();
+    offsets_.clear();
+    return false;
+}
+
+std::optional<size_t>
+CommitIndex::position(const std::string& id) const
+{
+    auto it = offsets_.find(id);
+    if (it == offsets_.end())
+        return std::nullopt;
+    return entries_.size() - 1 - it->second;
+}
+
+const CommitIndexEntry*
+CommitIndex::find(const std::string& id) const
+{
+    auto it = offsets_.find(id);
+    return it == offsets_.end() ? nullptr : &entries_[it->second];
+}
+
+std::vector<std::string>
+CommitIndex::ids(size_t position, size_t count) const
+{
+    std::vector<std::string> ret;
+    for (; position < entries_.size() and ret.size() < count; ++position)
+        ret.emplace_back(at(position).id);
+    return ret;
+}
+
+std::optional<std::string>
+CommitIndex::linearizedParent(const std::string& id) const
+{
+    auto pos = position(id);
+    if (not pos or *pos + 1 >= entries_.size())
+        return std::nullopt;
+    return at(*pos + 1).id;
+}
+
+bool
+CommitIndex::append(std::vector<CommitIndexEntry>&& entries)
+{
+    if (entries.empty())
+        return true;
+    if (entries_.empty()) {
+        std::reverse(entries.begin(), entries.end());
+        return reset(std::move(entries));
+    }
+
+    std::ofstream file(path_, std::ios::binary | std::ios::app);
+    for (auto& entry : entries) {
+        msgpack::pack(file, entry);
+        offsets_[entry.id] = entries_.size();
+        entries_.emplace_back(std::move(entry));
+    }
+    file.flush();
+    if (not file) {
+        JAMI_WARNING("Unable to append to commit index {}", path_);
+        clear();
+        return false;
+    }
+    return true;
+}
+
+bool
+CommitIndex::reset(std::vector<CommitIndexEntry>&& entries)
+{
+    loaded_ = true;
+    entries_.clear();
+    offsets_.clear();
+    entries_.reserve(entries.size());
+    for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+        offsets_[it->id] = entries_.size();
+        entries_.emplace_back(std::move(*it));
+    }
+    if (not write()) {
+        JAMI_WARNING("Unable to write commit index {}", path_);
+        clear();
+        return false;
+    }
+    return true;
+}
+
+bool
+CommitIndex::write() const
+{
+    std::error_code ec;
+    std::filesystem::create_directories(path_.parent_path(), ec);
+    auto tmpPath = path_;
+    tmpPath += ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::trunc | std::ios::binary);
+        msgpack::pack(file, VERSION);
+        for (const auto& entry : entries_)
+            msgpack::pack(file, entry);
+        file.flush();
+        if (not file)
+            return false;
+    }
+    std::filesystem::rename(tmpPath, path_, ec);
+    return not ec;
+}
+
+void
+CommitIndex::clear()
+{
+    entries_.clear();
+    offsets_.clear();
+    std::error_code ec;
+    std::filesystem::remove(path_, ec);
+}
+
+} // namespace jami
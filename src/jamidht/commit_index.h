@@ -0,0 +1,114 @@
+/*
+ *  Copyright (C) 2004-2026 Savoir-faire Linux Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <msgpack.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace jami {
+
+struct CommitIndexEntry
+{
+    std::string id {};
+    std::vector<std::string> parents {};
+    int64_t timestamp {0};
+    std::string authorUri {};
+    std::string type {};
+
+    MSGPACK_DEFINE_MAP(id, parents, timestamp, authorUri, type)
+};
+
+/**
+ * Sidecar index of the linearized history of a conversation, in the order a
+ * topological and time sorted revwalk from HEAD gives it.
+ *
+ * Positions are counted from the head: 0 is the head, size() - 1 the initial
+ * commit. Entries are stored oldest first on disk so commits made on top of
+ * the indexed head are appended to the file instead of rewriting it.
+ * @note not thread safe, the owner must serialize accesses
+ */
+class CommitIndex
+{
+public:
+    static constexpr uint32_t VERSION {1};
+
+    explicit CommitIndex(std::filesystem::path path)
+        : path_(std::move(path))
+    {}
+
+    /**
+     * Load the index from disk, once
+     * @return false if the file is missing, truncated or from another version
+     */
+    bool load();
+    bool loaded() const { return loaded_; }
+
+    bool empty() const { return entries_.empty(); }
+    size_t size() const { return entries_.size(); }
+
+    /**
+     * Id of the most recent indexed commit, empty if the index is empty
+     */
+    std::string head() const { return entries_.empty() ? std::string {} : entries_.back().id; }
+
+    std::optional<size_t> position(const std::string& id) const;
+    const CommitIndexEntry& at(size_t position) const { return entries_[entries_.size() - 1 - position]; }
+    const CommitIndexEntry* find(const std::string& id) const;
+
+    /**
+     * Ids of up to count commits, starting at position
+     */
+    std::vector<std::string> ids(size_t position, size_t count) const;
+
+    /**
+     * Commit that comes right before id in the linearized history
+     */
+    std::optional<std::string> linearizedParent(const std::string& id) const;
+
+    /**
+     * Index commits made on top of head(), oldest first
+     */
+    bool append(std::vector<CommitIndexEntry>&& entries);
+
+    /**
+     * Replace the whole index
+     * @param entries   commits, newest first (revwalk order)
+     */
+    bool reset(std::vector<CommitIndexEntry>&& entries);
+
+    /**
+     * Forget everything, including the file on disk
+     */
+    void clear();
+
+private:
+    bool write() const;
+
+    std::filesystem::path path_;
+    // Oldest first
+    std::vector<CommitIndexEntry> entries_;
+    std::unordered_map<std::string, size_t> offsets_;
+    bool loaded_ {false};
+};
+
+} // namespace jami
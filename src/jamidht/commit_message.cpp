@@ -19,73 +19,104 @@
 
 #include "string_utils.h"
 
+#include <type_traits>
+
 namespace jami {
 
-Json::Value
-CommitMessage::toJson() const
+template<typename Fn>
+void
+CommitMessage::forEachField(Fn&& fn) const
 {
-    Json::Value value;
-    value[CommitKey::TYPE] = type;
+    fn(CommitKey::TYPE, type);
     if (type == CommitType::TEXT || type == CommitType::EDITED_MESSAGE || type == CommitType::CHECKPOINT) {
-        value[CommitKey::BODY] = body;
+        fn(CommitKey::BODY, body);
     }
     if (!replyTo.empty()) {
-        value[CommitKey::REPLY_TO] = replyTo;
+        fn(CommitKey::REPLY_TO, replyTo);
     }
     if (!reactTo.empty()) {
-        value[CommitKey::REACT_TO] = reactTo;
+        fn(CommitKey::REACT_TO, reactTo);
     }
     if (!editedId.empty()) {
-        value[CommitKey::EDIT] = editedId;
+        fn(CommitKey::EDIT, editedId);
     }
     if (!action.empty()) {
-        value[CommitKey::ACTION] = action;
+        fn(CommitKey::ACTION, action);
     }
     if (!uri.empty()) {
-        value[CommitKey::URI] = uri;
+        fn(CommitKey::URI, uri);
     }
     if (!device.empty()) {
-        value[CommitKey::DEVICE] = device;
+        fn(CommitKey::DEVICE, device);
     }
     if (!confId.empty()) {
-        value[CommitKey::CONF_ID] = confId;
+        fn(CommitKey::CONF_ID, confId);
     }
     if (!to.empty()) {
-        value[CommitKey::TO] = to;
+        fn(CommitKey::TO, to);
     }
     if (!reason.empty()) {
-        value[CommitKey::REASON] = reason;
+        fn(CommitKey::REASON, reason);
     }
     if (!duration.empty()) {
-        value[CommitKey::DURATION] = duration;
+        fn(CommitKey::DURATION, duration);
     }
     if (type == CommitType::DATA_TRANSFER) {
-        value[CommitKey::TID] = tid;
+        fn(CommitKey::TID, tid);
     }
     if (!displayName.empty()) {
-        value[CommitKey::DISPLAY_NAME] = displayName;
+        fn(CommitKey::DISPLAY_NAME, displayName);
     }
     if (totalSize >= 0) {
-        value[CommitKey::TOTAL_SIZE] = std::to_string(totalSize);
+        fn(CommitKey::TOTAL_SIZE, std::to_string(totalSize));
     }
     if (!sha3sum.empty()) {
-        value[CommitKey::SHA3SUM] = sha3sum;
+        fn(CommitKey::SHA3SUM, sha3sum);
     }
     if (mode >= 0) {
-        value[CommitKey::MODE] = mode;
+        fn(CommitKey::MODE, mode);
     }
     if (!invited.empty()) {
-        value[CommitKey::INVITED] = invited;
+        fn(CommitKey::INVITED, invited);
     }
     if (!mimeType.empty()) {
-        value[CommitKey::MIME_TYPE] = mimeType;
+        fn(CommitKey::MIME_TYPE, mimeType);
     }
     if (!parent.empty()) {
-        value[CommitKey::PARENT] = parent;
+        fn(CommitKey::PARENT, parent);
     }
+    if (!snapshot.empty()) {
+        fn(CommitKey::SNAPSHOT, snapshot);
+    }
+    if (!update.empty()) {
+        fn(CommitKey::UPDATE, update);
+    }
+    if (format >= 0) {
+        fn(CommitKey::FORMAT, format);
+    }
+}
+
+Json::Value
+CommitMessage::toJson() const
+{
+    Json::Value value;
+    forEachField([&](const char* key, const auto& field) { value[key] = field; });
     return value;
 }
 
+std::map<std::string, std::string>
+CommitMessage::toMap() const
+{
+    std::map<std::string, std::string> map;
+    forEachField([&](const char* key, const auto& field) {
+        if constexpr (std::is_integral_v<std::decay_t<decltype(field)>>)
+            map.emplace(key, std::to_string(field));
+        else
+            map.emplace(key, field);
+    });
+    return map;
+}
+
 std::string
 CommitMessage::toString() const
 {
@@ -131,6 +162,9 @@ CommitMessage::fromString(const std::string& str)
         msg.invited = value.get(CommitKey::INVITED, "").asString();
         msg.mimeType = value.get(CommitKey::MIME_TYPE, "").asString();
         msg.parent = value.get(CommitKey::PARENT, "").asString();
+        msg.snapshot = value.get(CommitKey::SNAPSHOT, "").asString();
+        msg.update = value.get(CommitKey::UPDATE, "").asString();
+        msg.format = value.get(CommitKey::FORMAT, -1).asInt();
     } catch (const std::exception& e) {
         JAMI_ERROR("Exception while parsing commit message '{}': {}", str, e.what());
         return std::nullopt;
@@ -19,6 +19,7 @@
 
 #include "json_utils.h"
 
+#include <map>
 #include <optional>
 #include <string>
 
@@ -45,6 +46,9 @@ constexpr const char* const MODE {"mode"};
 constexpr const char* const INVITED {"invited"};
 constexpr const char* const MIME_TYPE {"mimeType"};
 constexpr const char* const PARENT {"parent"};
+constexpr const char* const SNAPSHOT {"snapshot"};
+constexpr const char* const UPDATE {"update"};
+constexpr const char* const FORMAT {"format"};
 } // namespace CommitKey
 
 namespace CommitType {
@@ -61,12 +65,16 @@ constexpr const char* const MERGE {"merge"};
 // commit only makes the document appear in the history and binds its id to this
 // conversation.
 constexpr const char* const COLLAB_DOC {"application/collab-doc+json"};
-// Batch of CRDT updates in a collaborative document repository. The updates
-// travel in the commit message itself (base64, one per line in the "body"
-// field); the tree is carried over untouched, so a checkpoint costs one
-// commit object and nothing else. The exception is a checkpoint adding an
-// attachment: the file enters the tree and the "body" is empty. Only valid
-// in document repositories.
+// Batch of CRDT updates in a collaborative document repository. The batch is
+// merged into a single update, stored raw in the tree and named in the
+// "update" field; it replaces the previous batch there, so the tree never
+// holds more than the latest one. Checkpoints written by older versions carry
+// their updates in the commit message instead (base64, one per line in the
+// "body" field). A checkpoint adding an attachment carries no update: the file
+// enters the tree and the "body" is empty. A snapshot is another exception:
+// the merged state of the document enters the tree, named in the "snapshot"
+// field. A device declaring the document format it reads carries nothing but the
+// "format" field. Only valid in document repositories.
 constexpr const char* const CHECKPOINT {"application/checkpoint"};
 // Jami no longer creates messages of type "application/edited-message", but we
 // still need to be able to parse them for backward compatibility.
@@ -81,6 +89,20 @@ constexpr const char* const BAN {"ban"};
 constexpr const char* const UNBAN {"unban"};
 } // namespace CommitAction
 
+// Formats of a document repository. Each device declares the newest format it reads
+// (see CommitMessage::formatCheckpoint), and a format is only written once every device
+// of the document's members declared it: peers reject the commits of formats they do not
+// know.
+namespace DocumentFormat {
+// Updates base64-encoded in the checkpoint messages
+constexpr int LEGACY {1};
+// Snapshots of the merged state in the tree
+constexpr int SNAPSHOTS {2};
+// Batches of updates merged into one, in the tree
+constexpr int UPDATE_BLOBS {3};
+constexpr int CURRENT {UPDATE_BLOBS};
+} // namespace DocumentFormat
+
 enum class ConversationMode : int { ONE_TO_ONE = 0, ADMIN_INVITES_ONLY, INVITES_ONLY, PUBLIC, DOCUMENT };
 
 /*
@@ -112,6 +134,9 @@ struct CommitMessage
     std::string invited {};
     std::string mimeType {};
     std::string parent {};
+    std::string snapshot {};
+    std::string update {};
+    int format {-1};
 
     // User messages are stored as commits of type "text/plain". The message text is in the "body"
     // field. For example:
@@ -363,8 +388,25 @@ struct CommitMessage
         return msg;
     }
 
-    // A checkpoint persists a batch of CRDT updates in a document repository. The updates are
-    // base64-encoded, one per line, in the "body" field:
+    // A checkpoint persists a batch of CRDT updates in a document repository. The batch is
+    // merged into a single update stored as a blob of the tree, updates/<oid>, named after its
+    // own git oid, which the "update" field repeats:
+    //
+    //     {"body":"","type":"application/checkpoint","update":"5b1f2ab0c3cb3bb6e4bc1ad3b7cf6cc0a5f1c0d9"}
+    //
+    // The same commit drops the previous batch from the tree; it remains readable through the
+    // commit that added it.
+    static CommitMessage updateCheckpoint(const std::string& updateId)
+    {
+        CommitMessage msg;
+        msg.type = CommitType::CHECKPOINT;
+        msg.update = updateId;
+        return msg;
+    }
+
+    // Older versions stored the updates of a checkpoint base64-encoded, one per line, in the
+    // "body" field, which is still how they are written until every device of the members
+    // declared DocumentFormat::UPDATE_BLOBS:
     //
     //     {"body":"AQHZ...\nAQLa...","type":"application/checkpoint"}
     //
@@ -384,6 +426,36 @@ struct CommitMessage
         return msg;
     }
 
+    // A snapshot is a checkpoint storing the merged state of the document, so that rebuilding it
+    // does not take replaying every update ever checkpointed. The state is a blob of the tree,
+    // snapshots/<oid>, named after its own git oid, which the "snapshot" field repeats:
+    //
+    //     {"body":"","snapshot":"d670460b4b4aece5915caf5c68d12f560a9fe3e4","type":"application/checkpoint"}
+    //
+    // The same commit drops the snapshots it supersedes from the tree; they remain readable
+    // through the commits that added them.
+    static CommitMessage snapshotCheckpoint(const std::string& snapshotId)
+    {
+        CommitMessage msg;
+        msg.type = CommitType::CHECKPOINT;
+        msg.snapshot = snapshotId;
+        return msg;
+    }
+
+    // A device declares the newest document format it reads (see DocumentFormat) with a
+    // checkpoint that carries nothing else, once per document, in the "format" field:
+    //
+    //     {"body":"","format":3,"type":"application/checkpoint"}
+    //
+    // Older versions take it for a checkpoint without any update.
+    static CommitMessage formatCheckpoint(int format)
+    {
+        CommitMessage msg;
+        msg.type = CommitType::CHECKPOINT;
+        msg.format = format;
+        return msg;
+    }
+
     // Commits of type "vote" are created by admins when voting to ban or unban a user from a
     // conversation. They have a "uri" field with the Jami ID of the user being voted on, e.g.:
     //
@@ -409,8 +481,17 @@ struct CommitMessage
     }
 
     Json::Value toJson() const;
+    /**
+     * Same fields as toJson(), as strings, without going through Json::Value
+     */
+    std::map<std::string, std::string> toMap() const;
     std::string toString() const;
     static std::optional<CommitMessage> fromString(const std::string& str);
+
+private:
+    // Call fn(key, value) for each field that toJson() writes
+    template<typename Fn>
+    void forEachField(Fn&& fn) const;
 };
 
 } // namespace jami
@@ -18,11 +18,15 @@
 #include "conversation.h"
 
 #include "account_const.h"
+#include "base64.h"
 #include "jamiaccount.h"
 #include "jamidht/collaborative_editing.h"
+#include "jamidht/file_digest_cache.h"
+#include "jamidht/file_store.h"
 #include "client/jami_signal.h"
 #include "swarm/swarm_manager.h"
 #include "conversationrepository.h"
+#include "message_search_index.h"
 #include "timestamp.h"
 
 #ifdef ENABLE_PLUGIN
@@ -63,6 +67,12 @@
 namespace jami {
 
 static const char* const LAST_MODIFIED = "lastModified";
+// Number of search results sent in each MessagesFound signal
+static constexpr size_t SEARCH_PAGE_SIZE {50};
+// Older commits fetched at once for a shallow history
+static constexpr unsigned BACKFILL_COMMITS {500};
+// Queued with the commit ids to pull, for a backfill
+static constexpr std::string_view BACKFILL_REQUEST {"backfill"};
 
 namespace {
 
@@ -394,7 +404,8 @@ private:
                       acc->findCertificate(deviceId, std::move(cb));
                   else
                       cb(nullptr);
-              }))
+              },
+              account->certificateLookups()))
         , transferManager_(std::make_shared<TransferManager>(accountId_,
                                                              "",
                                                              repository_->id(),
@@ -408,6 +419,7 @@ private:
         , mobileNodesPath_(conversationDataPath_ / ConversationDirectories::MOBILE_NODES)
         , hostedCallsPath_(conversationDataPath_ / ConversationDirectories::HOSTED_CALLS)
         , activeCallsPath_(conversationDataPath_ / ConversationDirectories::ACTIVE_CALLS)
+        , searchIndex_(conversationDataPath_ / ConversationDirectories::SEARCH_INDEX)
         , ioContext_(Manager::instance().ioContext())
         , typers_(std::make_shared<Typers>(account, repository_->id()))
     {
@@ -444,8 +456,11 @@ public:
         : Impl(std::make_unique<ConversationRepository>(account, conversationId), account)
     {}
 
-    Impl(const std::shared_ptr<JamiAccount>& account, const std::string& remoteDevice, const std::string& conversationId)
-        : Impl(ConversationRepository::cloneConversation(account, remoteDevice, conversationId), account)
+    Impl(const std::shared_ptr<JamiAccount>& account,
+         const std::string& remoteDevice,
+         const std::string& conversationId,
+         bool shallow)
+        : Impl(ConversationRepository::cloneConversation(account, remoteDevice, conversationId, shallow), account)
     {}
 
     std::string toString() const
@@ -958,6 +973,17 @@ public:
 #endif
 
     std::mutex writeMtx_ {};
+    // For a document, the newest format each device declared, walked up to
+    // formatsHead_ so that only the new commits are read
+    std::mutex formatsMtx_ {};
+    std::string formatsHead_ {};
+    std::map<std::string, int> declaredFormats_ {};
+    /**
+     * Read the format declarations committed since the last call
+     * @note formatsMtx_ should be locked
+     */
+    void refreshDeclaredFormats();
+
     const std::unique_ptr<ConversationRepository> repository_;
     const std::weak_ptr<JamiAccount> account_;
     const std::string accountId_;
@@ -983,6 +1009,8 @@ public:
     std::mutex pullcbsMtx_ {};
     // store current remote in fetch
     std::map<std::string, std::deque<std::pair<std::string, OnPullCb>>> fetchingRemotes_ {};
+    // Fetched commits to merge again once older history is backfilled
+    std::set<std::string> unmergedCommits_ {};
     const std::shared_ptr<TransferManager> transferManager_ {};
     const std::filesystem::path repoPath_ {};
     const std::filesystem::path conversationDataPath_ {};
@@ -1026,6 +1054,11 @@ public:
     mutable std::mutex gitSocketMtx_ {};
     GitSocketList gitSocketList_ {};
 
+    // Full-text index of the messages, brought up to date by each search
+    mutable std::mutex searchIndexMtx_ {};
+    mutable MessageSearchIndex searchIndex_;
+    bool syncSearchIndex() const;
+
     // Bootstrap
     const std::shared_ptr<asio::io_context> ioContext_;
 
@@ -1940,8 +1973,9 @@ Conversation::Conversation(const std::shared_ptr<JamiAccount>& account, const st
 
 Conversation::Conversation(const std::shared_ptr<JamiAccount>& account,
                            const std::string& remoteDevice,
-                           const std::string& conversationId)
-    : pimpl_ {new Impl {account, remoteDevice, conversationId}}
+                           const std::string& conversationId,
+                           bool shallow)
+    : pimpl_ {new Impl {account, remoteDevice, conversationId, shallow}}
 {}
 
 Conversation::~Conversation() {}
@@ -2402,6 +2436,10 @@ Conversation::loadMessages(const OnLoadMessages& cb, const LogOptions& options)
             std::unique_lock lk(sthis->pimpl_->loadedHistory_.mutex);
             auto result = sthis->pimpl_->loadMessages(options);
             lk.unlock();
+            // Reached the start of a shallow history: get what comes before
+            // for the next load
+            if (options.nbOfCommits == 0 || result.size() < options.nbOfCommits)
+                sthis->backfill();
             cb(std::move(result));
         }
     });
@@ -2623,6 +2661,7 @@ Conversation::Impl::pull(const std::string& deviceId)
 
     std::string commitId;
     OnPullCb cb;
+    bool unmerged = false;
     while (true) {
         {
             std::lock_guard lk(pullcbsMtx_);
@@ -2640,9 +2679,21 @@ Conversation::Impl::pull(const std::string& deviceId)
             commitId = std::move(std::get<0>(elem));
             cb = std::move(std::get<1>(elem));
             pullcbs.pop_front();
+            unmerged = unmergedCommits_.erase(commitId) != 0;
+        }
+        if (commitId == BACKFILL_REQUEST) {
+            auto status = repo->backfill(deviceId, BACKFILL_COMMITS);
+            if (status == BackfillStatus::ADDED) {
+                // Older messages are to be indexed
+                std::lock_guard lk(searchIndexMtx_);
+                searchIndex_.clear();
+            }
+            if (cb)
+                cb(status == BackfillStatus::ADDED);
+            continue;
         }
         // If recently fetched, the commit can already be there, so no need to do complex operations
-        if (commitId != "" && repo->hasCommit(commitId)) {
+        if (commitId != "" && !unmerged && repo->hasCommit(commitId)) {
             cb(true);
             continue;
         }
@@ -2677,6 +2728,24 @@ Conversation::Impl::pull(const std::string& deviceId)
         } else {
             commitFound = true;
         }
+        if (!commitFound && repo->isShallow() && repo->hasCommit(commitId)) {
+            // Received but not merged: the merge base can be older than the
+            // shallow history. Get what comes before, then merge again
+            JAMI_LOG("{} [device {}] Backfilling to merge {:s}", toString(), deviceId, commitId);
+            std::lock_guard lkPull(pullcbsMtx_);
+            auto& pullcbs = fetchingRemotes_[deviceId];
+            auto retry = [this, deviceId, commitId, cb](bool added) {
+                if (added) {
+                    std::lock_guard lk(pullcbsMtx_);
+                    unmergedCommits_.emplace(commitId);
+                    fetchingRemotes_[deviceId].emplace_front(commitId, cb);
+                } else if (cb) {
+                    cb(false);
+                }
+            };
+            pullcbs.emplace_front(std::string(BACKFILL_REQUEST), std::move(retry));
+            continue;
+        }
         if (!commitFound)
             JAMI_WARNING("Successfully fetched from device {} but didn't receive expected commit {}",
                          deviceId,
@@ -2717,6 +2786,27 @@ Conversation::sync(const std::string& member, const std::string& deviceId, OnPul
     });
 }
 
+void
+Conversation::backfill(const std::string& deviceId)
+{
+    if (!isShallow())
+        return;
+    auto device = deviceId;
+    if (device.empty()) {
+        std::lock_guard lk(pimpl_->gitSocketMtx_);
+        if (pimpl_->gitSocketList_.empty())
+            return;
+        device = pimpl_->gitSocketList_.begin()->first.toString();
+    }
+    pull(device, [](bool) {}, std::string(BACKFILL_REQUEST));
+}
+
+bool
+Conversation::isShallow() const
+{
+    return pimpl_->repository_->isShallow();
+}
+
 std::map<std::string, std::string>
 Conversation::generateInvitation(TimePoint sent) const
 {
@@ -2759,8 +2849,10 @@ Conversation::isRemoving()
 void
 Conversation::erase()
 {
-    if (pimpl_->conversationDataPath_ != "")
+    if (pimpl_->conversationDataPath_ != "") {
         dhtnet::fileutils::removeAll(pimpl_->conversationDataPath_, true);
+        FileStore::instance().releaseAll(pimpl_->conversationDataPath_);
+    }
     if (!pimpl_->repository_)
         return;
     std::lock_guard lk(pimpl_->writeMtx_);
@@ -2786,40 +2878,140 @@ Conversation::documentMimeType() const
 }
 
 namespace {
-// The base64 update lines of every checkpoint commit in a document log,
-// oldest first, i.e. in the order the updates must be replayed.
-std::vector<std::string>
-collectUpdates(const std::vector<ConversationCommit>& commits)
+std::optional<DocumentSnapshot>
+unpackSnapshot(const std::vector<uint8_t>& data)
 {
-    std::vector<std::string> updates;
-    for (auto it = commits.rbegin(); it != commits.rend(); ++it) {
-        if (it->commitMsg.type != CommitType::CHECKPOINT)
-            continue;
-        for (const auto& line : split_string(it->commitMsg.body, '\n'))
-            if (!line.empty())
-                updates.emplace_back(line);
+    if (data.empty())
+        return std::nullopt;
+    try {
+        auto oh = msgpack::unpack(reinterpret_cast<const char*>(data.data()), data.size());
+        return oh.get().as<DocumentSnapshot>();
+    } catch (const std::exception&) {
+        return std::nullopt;
     }
-    return updates;
 }
 } // namespace
 
-std::vector<std::string>
-Conversation::documentUpdates() const
+std::optional<DocumentReplay>
+Conversation::documentReplay(const std::string& commitId, bool fromSnapshot) const
 {
-    LogOptions options;
-    options.skipMerge = true;
-    return collectUpdates(pimpl_->repository_->log(options));
+    if (!commitId.empty() && !getCommit(commitId))
+        return std::nullopt;
+    DocumentReplay replay;
+    // Pinned, so that both walks below see the same history even if a commit
+    // lands in between.
+    replay.head = commitId.empty() ? pimpl_->repository_->getHead() : commitId;
+    // Newest first, down to the most recent snapshot that can be read: on a
+    // document that was snapshotted, that is only the last few checkpoints.
+    std::vector<ConversationCommit> commits;
+    std::string snapshotCommit;
+    pimpl_->repository_->log(
+        [](const auto&, const auto&, const auto&) { return CallbackResult::Ok; },
+        [&](auto&& cc) { commits.emplace_back(std::move(cc)); },
+        [&](const std::string& id, const auto&, ConversationCommit& cc) {
+            if (!fromSnapshot || cc.commitMsg.type != CommitType::CHECKPOINT || cc.commitMsg.snapshot.empty())
+                return false;
+            replay.snapshot = unpackSnapshot(pimpl_->repository_->blob(cc.commitMsg.snapshot));
+            if (!replay.snapshot) {
+                JAMI_WARNING("{} Ignoring unreadable snapshot {}", pimpl_->toString(), cc.commitMsg.snapshot);
+                return false;
+            }
+            replay.snapshotId = cc.commitMsg.snapshot;
+            snapshotCommit = id;
+            return true;
+        },
+        replay.head);
+    if (!snapshotCommit.empty()) {
+        // Walked again, hiding the snapshot's ancestry: the walk above stopped at
+        // the snapshot, but a branch merged after it can hold checkpoints the
+        // snapshot never saw and that sort after it.
+        commits.clear();
+        pimpl_->repository_->logSince(
+            snapshotCommit,
+            [&](auto&& cc) { commits.emplace_back(std::move(cc)); },
+            replay.head);
+        std::reverse(commits.begin(), commits.end());
+    }
+    // The updates come from peers' commits, so their content is not ours to
+    // trust: a malformed one must cost that one update, not the whole replay.
+    for (auto it = commits.rbegin(); it != commits.rend(); ++it) {
+        if (it->commitMsg.type != CommitType::CHECKPOINT)
+            continue;
+        ++replay.checkpoints;
+        if (!it->commitMsg.update.empty()) {
+            auto update = pimpl_->repository_->blob(it->commitMsg.update);
+            if (!update.empty())
+                replay.updates.emplace_back(std::move(update));
+            else
+                JAMI_WARNING("{} Skipping unreadable update {}", pimpl_->toString(), it->commitMsg.update);
+        }
+        // Checkpoints from older versions carry their updates in the message.
+        for (const auto& line : split_string(it->commitMsg.body, '\n')) {
+            if (line.empty())
+                continue;
+            try {
+                replay.updates.emplace_back(base64::decode(line));
+            } catch (const std::exception& e) {
+                JAMI_WARNING("{} Skipping unreadable update in {}: {}", pimpl_->toString(), it->id, e.what());
+            }
+        }
+        // A snapshot taken on another branch: its state merges like an update.
+        if (!snapshotCommit.empty() && !it->commitMsg.snapshot.empty())
+            if (auto concurrent = unpackSnapshot(pimpl_->repository_->blob(it->commitMsg.snapshot)))
+                replay.updates.emplace_back(std::move(concurrent->state));
+    }
+    return replay;
 }
 
-std::optional<std::vector<std::string>>
-Conversation::documentUpdatesAt(const std::string& commitId) const
+void
+Conversation::Impl::refreshDeclaredFormats()
 {
-    if (!getCommit(commitId))
-        return std::nullopt;
-    LogOptions options;
-    options.from = commitId;
-    options.skipMerge = true;
-    return collectUpdates(pimpl_->repository_->log(options));
+    auto onCommit = [&](ConversationCommit&& cc) {
+        if (cc.commitMsg.type != CommitType::CHECKPOINT || cc.commitMsg.format < 0)
+            return;
+        auto& declared = declaredFormats_[cc.author.email];
+        declared = std::max(declared, cc.commitMsg.format);
+    };
+    auto head = repository_->logSince(formatsHead_, onCommit);
+    if (!head && !formatsHead_.empty()) {
+        // The last head walked is gone (e.g. the repository was cloned again)
+        declaredFormats_.clear();
+        head = repository_->logSince({}, onCommit);
+    }
+    if (head)
+        formatsHead_ = std::move(*head);
+}
+
+int
+Conversation::declaredFormat(const std::string& deviceId) const
+{
+    std::lock_guard lk(pimpl_->formatsMtx_);
+    pimpl_->refreshDeclaredFormats();
+    auto it = pimpl_->declaredFormats_.find(deviceId);
+    return it != pimpl_->declaredFormats_.end() ? it->second : DocumentFormat::LEGACY;
+}
+
+int
+Conversation::documentFormat() const
+{
+    if (mode() != ConversationMode::DOCUMENT)
+        return DocumentFormat::LEGACY;
+    auto members = memberUris("", {MemberRole::INVITED, MemberRole::BANNED, MemberRole::LEFT});
+    auto devices = pimpl_->repository_->devices();
+    std::lock_guard lk(pimpl_->formatsMtx_);
+    pimpl_->refreshDeclaredFormats();
+    // Every device that committed to the document has its certificate in the
+    // tree: one that did not declare anything runs an older version.
+    auto format = DocumentFormat::CURRENT;
+    for (const auto& [uri, memberDevices] : devices) {
+        if (members.find(uri) == members.end())
+            continue;
+        for (const auto& device : memberDevices) {
+            auto it = pimpl_->declaredFormats_.find(device.toString());
+            format = std::min(format, it != pimpl_->declaredFormats_.end() ? it->second : DocumentFormat::LEGACY);
+        }
+    }
+    return format;
 }
 
 std::vector<std::map<std::string, std::string>>
@@ -2830,9 +3022,10 @@ Conversation::documentHistory(size_t max) const
     auto commits = pimpl_->repository_->log(options);
     std::vector<std::map<std::string, std::string>> result;
     for (const auto& commit : commits) {
-        if (commit.commitMsg.type != CommitType::CHECKPOINT)
+        // A format declaration changes nothing in the document
+        if (commit.commitMsg.type != CommitType::CHECKPOINT || commit.commitMsg.format >= 0)
             continue;
-        size_t deltas = 0;
+        size_t deltas = commit.commitMsg.update.empty() ? 0 : 1;
         for (const auto& line : split_string(commit.commitMsg.body, '\n'))
             if (!line.empty())
                 ++deltas;
@@ -2864,6 +3057,34 @@ Conversation::addDocumentAttachment(const std::vector<uint8_t>& data)
     return {attachmentId, head};
 }
 
+std::pair<std::string, std::string>
+Conversation::addDocumentUpdate(const std::vector<uint8_t>& update)
+{
+    std::unique_lock lk(pimpl_->writeMtx_);
+    auto headBefore = pimpl_->repository_->getHead();
+    auto updateId = pimpl_->repository_->addUpdate(update);
+    if (updateId.empty())
+        return {};
+    auto head = pimpl_->repository_->getHead();
+    if (head == headBefore)
+        return {updateId, {}}; // Same batch already checkpointed, nothing new to announce
+    pimpl_->announce(head, true);
+    return {updateId, head};
+}
+
+std::string
+Conversation::addDocumentSnapshot(const DocumentSnapshot& snapshot, const std::string& parentId)
+{
+    msgpack::sbuffer buffer;
+    msgpack::pack(buffer, snapshot);
+    const auto* data = reinterpret_cast<const uint8_t*>(buffer.data());
+    std::unique_lock lk(pimpl_->writeMtx_);
+    auto commitId = pimpl_->repository_->addSnapshot({data, data + buffer.size()}, parentId);
+    if (!commitId.empty())
+        pimpl_->announce(commitId, true);
+    return commitId;
+}
+
 std::vector<uint8_t>
 Conversation::documentAttachment(const std::string& attachmentId) const
 {
@@ -3036,12 +3257,16 @@ Conversation::downloadFile(const std::string& interactionId,
 
             std::error_code ec;
             if (std::filesystem::file_size(filePath, ec) == static_cast<size_t>(totalSize)) {
-                if (fileutils::sha3File(filePath) == sha3sum) {
+                if (FileDigestCache::instance().sha3(filePath) == sha3sum) {
                     JAMI_WARNING("Ignoring request to download existing file: {}", filePath);
                     return;
                 }
             }
 
+            // Already received, in this conversation or another one
+            if (shared->dataTransfer()->fromStore(fileId, interactionId, sha3sum, path))
+                return;
+
             std::filesystem::path tempFilePath(filePath);
             tempFilePath += ".tmp";
             auto start = std::filesystem::file_size(tempFilePath, ec);
@@ -3398,89 +3623,82 @@ Conversation::countInteractions(const std::string& toId, const std::string& from
     return res.size();
 }
 
+bool
+Conversation::Impl::syncSearchIndex() const
+{
+    searchIndex_.load();
+    auto addCommit = [&](ConversationCommit&& commit) { searchIndex_.add(commit); };
+    auto head = repository_->logSince(searchIndex_.head(), addCommit);
+    if (not head and not searchIndex_.head().empty()) {
+        // The indexed head is not part of the history anymore
+        JAMI_WARNING("{}Search index out of date, rebuilding it", toString());
+        searchIndex_.clear();
+        head = repository_->logSince("", addCommit);
+    }
+    if (not head) {
+        searchIndex_.clear();
+        return false;
+    }
+    return searchIndex_.flush(*head);
+}
+
 void
 Conversation::search(uint32_t req, const Filter& filter, const std::shared_ptr<std::atomic_int>& flag) const
 {
-    // Because logging a conversation can take quite some time,
-    // do it asynchronously
+    // Indexing the commits received since the last search can take
+    // quite some time, do it asynchronously
     dht::ThreadPool::io().run([w = weak(), req, filter, flag] {
         if (auto sthis = w.lock()) {
-            History history;
-            std::vector<std::map<std::string, std::string>> commits {};
-            // std::regex_constants::ECMAScript is the default flag.
-            auto re = std::regex(filter.regexSearch,
-                                 filter.caseSensitive ? std::regex_constants::ECMAScript : std::regex_constants::icase);
-            sthis->pimpl_->repository_->log(
-                [&](const std::string& /*id*/, const GitAuthor& author, const GitCommit& commit) {
-                    if (!filter.author.empty() && filter.author != sthis->uriFromDevice(author.email)) {
-                        // Filter author
-                        return CallbackResult::Skip;
-                    }
-                    auto commitTime = git_commit_time(commit.get());
-                    if (filter.before && filter.before < commitTime) {
-                        // Only get commits before this date
-                        return CallbackResult::Skip;
-                    }
-                    if (filter.after && filter.after > commitTime) {
-                        // Only get commits before this date
-                        if (git_commit_parentcount(commit.get()) <= 1)
-                            return CallbackResult::Break;
-                        else
-                            return CallbackResult::Skip; // Because we are sorting it with
-                                                         // GIT_SORT_TOPOLOGICAL | GIT_SORT_TIME
+            const auto& impl = *sthis->pimpl_;
+            std::vector<SearchHit> hits;
+            {
+                std::lock_guard lk(impl.searchIndexMtx_);
+                if (impl.syncSearchIndex()) {
+                    try {
+                        hits = impl.searchIndex_.search(filter);
+                    } catch (const std::regex_error& e) {
+                        JAMI_WARNING("{}Invalid search pattern '{}': {}", impl.toString(), filter.regexSearch, e.what());
                     }
+                }
+            }
 
-                    return CallbackResult::Ok; // Continue
-                },
-                [&](ConversationCommit&& cc) {
-                    if (auto optMessage = sthis->pimpl_->repository_->convCommitToMap(cc))
-                        sthis->pimpl_->addToHistory(history, {optMessage.value()}, false, false);
-                },
-                [&](const std::string& id, const GitAuthor&, ConversationCommit&) {
-                    if (id == filter.lastId)
-                        return true;
-                    return false;
-                },
-                "",
-                false);
-            // Search on generated history
-            for (auto& message : history.messageList) {
-                auto contentType = message->type;
-                auto isSearchable = contentType == CommitType::TEXT || contentType == CommitType::DATA_TRANSFER;
-                if (filter.type.empty() && !isSearchable) {
-                    // Not searchable, at least for now
+            // Stream the results, newest first, a page at a time
+            // Resolve every parent from the commit index at once rather than per hit
+            std::vector<std::string> ids;
+            ids.reserve(hits.size());
+            for (const auto& hit : hits)
+                ids.emplace_back(hit.id);
+            auto parents = impl.repository_->linearizedParents(ids);
+
+            std::vector<std::map<std::string, std::string>> commits;
+            for (const auto& hit : hits) {
+                auto commit = impl.repository_->getCommit(hit.id);
+                if (not commit)
                     continue;
-                } else if (contentType == filter.type || filter.type.empty()) {
-                    if (isSearchable) {
-                        // If it's a text match the body, else the display name
-                        auto body = contentType == CommitType::TEXT ? message->body.at(CommitKey::BODY)
-                                                                    : message->body.at(CommitKey::DISPLAY_NAME);
-                        std::smatch body_match;
-                        if (std::regex_search(body, body_match, re)) {
-                            auto commit = message->body;
-                            commit["id"] = message->id;
-                            commit[CommitKey::TYPE] = message->type;
-                            commits.emplace_back(commit);
-                        }
-                    } else {
-                        // Matching type, just add it to the results
-                        commits.emplace_back(message->body);
-                    }
-
-                    if (filter.maxResult != 0 && commits.size() == filter.maxResult)
-                        break;
+                auto parent = parents.find(hit.id);
+                if (parent != parents.end())
+                    commit->linearized_parent = std::move(parent->second);
+                auto message = impl.repository_->convCommitToMap(*commit);
+                if (not message)
+                    continue;
+                // Show the latest edition
+                if (hit.type == CommitType::TEXT)
+                    (*message)[CommitKey::BODY] = hit.text;
+                commits.emplace_back(std::move(*message));
+                if (commits.size() == SEARCH_PAGE_SIZE) {
+                    emitSignal<libjami::ConversationSignal::MessagesFound>(req, impl.accountId_, sthis->id(), commits);
+                    commits.clear();
                 }
             }
-
             if (commits.size() > 0)
                 emitSignal<libjami::ConversationSignal::MessagesFound>(req,
-                                                                       sthis->pimpl_->accountId_,
+                                                                       impl.accountId_,
                                                                        sthis->id(),
                                                                        std::move(commits));
             // If we're the latest thread, inform client that the search is finished
             if ((*flag)-- == 1 /* decrement return the old value */) {
                 emitSignal<libjami::ConversationSignal::MessagesFound>(
-                    req, sthis->pimpl_->accountId_, std::string {}, std::vector<std::map<std::string, std::string>> {});
+                    req, impl.accountId_, std::string {}, std::vector<std::map<std::string, std::string>> {});
             }
         }
     });
@@ -36,6 +36,7 @@
 #include <vector>
 #include <map>
 #include <memory>
+#include <optional>
 #include <set>
 
 #include <asio.hpp>
@@ -78,6 +79,7 @@ static constexpr std::string_view ACTIVE_CALLS {"activeCalls"};
 static constexpr std::string_view HOSTED_CALLS {"hostedCalls"};
 static constexpr std::string_view CACHED {"cached"};
 static constexpr std::string_view MOBILE_NODES {"mobileNodes"};
+static constexpr std::string_view SEARCH_INDEX {"searchIndex"};
 } // namespace ConversationDirectories
 
 namespace ConversationPreferences {
@@ -242,6 +244,37 @@ struct ConvInfo
     void msgpack_object(msgpack::object* o, msgpack::zone& z) const;
 };
 
+/**
+ * Merged state of a collaborative document, stored in its repository so that
+ * rebuilding it takes this plus the updates checkpointed since, rather than
+ * every update ever checkpointed.
+ */
+struct DocumentSnapshot
+{
+    /// What the state covers, to check that applying it rebuilt what it should.
+    std::vector<uint8_t> stateVector;
+    std::vector<uint8_t> state;
+    MSGPACK_DEFINE_MAP(stateVector, state)
+};
+
+/**
+ * What rebuilding a collaborative document at a given commit takes: its most
+ * recent snapshot, then the updates of the checkpoints it does not cover.
+ */
+struct DocumentReplay
+{
+    std::optional<DocumentSnapshot> snapshot;
+    /// Blob id of the snapshot above, empty without one.
+    std::string snapshotId;
+    /// Oldest first. Includes the state of snapshots taken concurrently with
+    /// the one above, which merge like any other update.
+    std::vector<std::vector<uint8_t>> updates;
+    /// Checkpoint commits not covered by the snapshot.
+    size_t checkpoints {0};
+    /// The commit this was read at.
+    std::string head;
+};
+
 using OnPullCb = std::function<void(bool fetchOk)>;
 using OnLoadMessages = std::function<void(std::vector<libjami::SwarmMessage>&& messages)>;
 using OnCommitCb = std::function<void(const std::string&)>;
@@ -262,7 +295,8 @@ public:
     Conversation(const std::shared_ptr<JamiAccount>& account, const std::string& conversationId = "");
     Conversation(const std::shared_ptr<JamiAccount>& account,
                  const std::string& remoteDevice,
-                 const std::string& conversationId);
+                 const std::string& conversationId,
+                 bool shallow = false);
     ~Conversation();
 
     /**
@@ -509,6 +543,17 @@ public:
      * @param commitId  cf pull()
      */
     void sync(const std::string& member, const std::string& deviceId, OnPullCb&& cb, std::string commitId = "");
+    /**
+     * Fetch older commits of a shallow history, queued with the pulls of the device.
+     * Done when the history is loaded up to its start, or to merge commits based on
+     * older ones
+     * @param deviceId  Peer device, any device with a git channel if empty
+     */
+    void backfill(const std::string& deviceId = {});
+    /**
+     * @return if older history is still to be backfilled
+     */
+    bool isShallow() const;
 
     /**
      * Generate an invitation to send to new contacts
@@ -564,28 +609,42 @@ public:
     std::string documentMimeType() const;
 
     /**
-     * For a collaborative document, every CRDT update persisted in the
-     * repository, oldest first: the base64-encoded lines of the body of each
-     * checkpoint commit, in the order they must be replayed.
-     */
-    std::vector<std::string> documentUpdates() const;
-
-    /**
-     * Same as documentUpdates() but only up to (and including) the given
-     * commit, to rebuild the document as it was at that point.
+     * For a collaborative document, what its state is rebuilt from: the most
+     * recent snapshot reachable from the given commit and the CRDT updates
+     * checkpointed since, decoded.
+     * @param commitId      rebuild the document as it was at that commit, HEAD
+     *                      if empty
+     * @param fromSnapshot  false to ignore snapshots and replay every update
+     *                      ever checkpointed, should a snapshot not hold what
+     *                      it claims
      * @return std::nullopt when the commit is unknown, as opposed to an empty
      *         document at a known commit
      */
-    std::optional<std::vector<std::string>> documentUpdatesAt(const std::string& commitId) const;
+    std::optional<DocumentReplay> documentReplay(const std::string& commitId = {}, bool fromSnapshot = true) const;
 
     /**
      * For a collaborative document, its persisted history: one map per
      * checkpoint commit, newest first, with keys "id", "author", "device",
-     * "timestamp" and "deltas" (the number of updates the checkpoint carries).
+     * "timestamp" and "deltas" (the number of updates the checkpoint carries,
+     * one for a batch stored merged).
      * @param max  stop after this many entries; 0 for no limit
      */
     std::vector<std::map<std::string, std::string>> documentHistory(size_t max) const;
 
+    /**
+     * For a collaborative document, the newest format (see DocumentFormat) that
+     * every device of its members declared, which is the newest one that may
+     * be written to it.
+     * @return DocumentFormat::LEGACY for any other mode
+     */
+    int documentFormat() const;
+
+    /**
+     * For a collaborative document, the newest format deviceId declared,
+     * DocumentFormat::LEGACY if none
+     */
+    int declaredFormat(const std::string& deviceId) const;
+
     /**
      * For a collaborative document, store an attachment and announce the
      * commit to the swarm.
@@ -595,6 +654,24 @@ public:
      */
     std::pair<std::string, std::string> addDocumentAttachment(const std::vector<uint8_t>& data);
 
+    /**
+     * For a collaborative document, checkpoint a batch of CRDT updates merged
+     * into one and announce the commit to the swarm.
+     * @return {updateId, commitId}; commitId is empty when the same batch was
+     *         already the latest one (nothing new to announce) and both are
+     *         empty on failure
+     */
+    std::pair<std::string, std::string> addDocumentUpdate(const std::vector<uint8_t>& update);
+
+    /**
+     * For a collaborative document, store a snapshot of its merged state and
+     * announce the commit to the swarm.
+     * @param parentId  the commit the state was rebuilt at
+     * @return the commit id, empty on failure, when HEAD moved past parentId
+     *         or when the same state is already the latest snapshot
+     */
+    std::string addDocumentSnapshot(const DocumentSnapshot& snapshot, const std::string& parentId);
+
     /**
      * For a collaborative document, read an attachment's content at HEAD.
      */
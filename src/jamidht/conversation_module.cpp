@@ -25,6 +25,10 @@
 #include "jamidht/commit_message.h"
 #include "jamidht/jamiaccount.h"
 #include "jamidht/collaborative_editing.h"
+#include "jamidht/file_digest_cache.h"
+#include "jamidht/file_store.h"
+#include "jamidht/git_maintenance.h"
+#include "jamidht/journal_store.h"
 #include "jamidht/presence_manager.h"
 #include "manager.h"
 #ifdef ENABLE_PLUGIN
@@ -38,7 +42,9 @@
 #include <dhtnet/certstore.h>
 
 #include <algorithm>
+#include <condition_variable>
 #include <fstream>
+#include <optional>
 
 namespace jami {
 
@@ -71,6 +77,199 @@ constexpr std::chrono::seconds MAX_FALLBACK {12 * 3600s};
 // immutable), so retrying is wasted work; the counter is kept in-memory only,
 // so a restart allows a new bounded round of attempts.
 constexpr unsigned MAX_VALIDATION_FAILURES {3};
+// Conversations are opened on first use. Once more than this many are loaded,
+// the ones idle for long enough are unloaded, least recently used first.
+constexpr size_t MAX_LOADED_CONVERSATIONS {64};
+constexpr std::chrono::minutes MIN_IDLE_BEFORE_UNLOAD {10};
+// Commits announced to the same target within this delay are announced once,
+// with the last one
+constexpr std::chrono::milliseconds ANNOUNCE_DELAY {100};
+// Repositories of idle conversations are repacked in the background, one at a
+// time, at most once per MAINTENANCE_INTERVAL each
+constexpr std::chrono::minutes MAINTENANCE_START_DELAY {10};
+constexpr std::chrono::hours MAINTENANCE_INTERVAL {24};
+// Between two repositories that did not need maintenance
+constexpr std::chrono::seconds MAINTENANCE_CHECK_DELAY {10};
+// Minimum pause after a repository was maintained
+constexpr std::chrono::minutes MAINTENANCE_MIN_DELAY {1};
+// When every conversation is busy or was maintained recently
+constexpr std::chrono::hours MAINTENANCE_IDLE_DELAY {1};
+// Bytes written per second at most while repacking
+constexpr uint64_t MAINTENANCE_IO_BUDGET {4 * 1024 * 1024};
+
+/**
+ * What the conversation list needs to know about a conversation, kept in the
+ * manifest of the account so that conversations are listed at startup
+ * without opening their repository.
+ */
+struct ConvSummary
+{
+    ConversationMode mode {0};
+    // Members in the repository, ourselves excluded
+    std::set<std::string> members {};
+    std::string lastMessageId {};
+    int64_t lastMessageTimestamp {0};
+    std::string infosHash {};
+    // Role of every member, ourselves included, as listed to clients.
+    // Empty in manifests written before it was added.
+    std::map<std::string, std::string> roles {};
+
+    bool operator==(const ConvSummary&) const = default;
+
+    MSGPACK_DEFINE_MAP(mode, members, lastMessageId, lastMessageTimestamp, infosHash, roles)
+};
+
+static std::string
+hashInfos(const std::map<std::string, std::string>& infos)
+{
+    std::string data;
+    for (const auto& [key, value] : infos) {
+        data += key;
+        data += '\0';
+        data += value;
+        data += '\0';
+    }
+    return dht::InfoHash::get(data).toString();
+}
+
+static bool
+hasHostedCalls(const std::filesystem::path& conversationDataPath)
+{
+    std::error_code ec;
+    // An empty map is packed in a single byte
+    auto size = std::filesystem::file_size(conversationDataPath / ConversationDirectories::HOSTED_CALLS, ec);
+    return not ec and size > 1;
+}
+
+// convInfo and convRequests are journals of one msgpack value per conversation.
+// The other stores of the account (contacts, trust requests) and of each
+// conversation (message statuses, calls, mobile nodes, preferences) are still
+// whole msgpack files.
+static constexpr std::string_view JOURNAL_EXTENSION {".journal"};
+
+/**
+ * Journal replacing the whole msgpack map written at path by previous versions
+ */
+static std::filesystem::path
+journalPath(const std::filesystem::path& path)
+{
+    auto journal = path;
+    journal += JOURNAL_EXTENSION;
+    return journal;
+}
+
+template<typename T>
+static std::string
+packValue(const T& value)
+{
+    msgpack::sbuffer buffer;
+    msgpack::pack(buffer, value);
+    return std::string(buffer.data(), buffer.size());
+}
+
+template<typename T>
+static std::map<std::string, std::string>
+packValues(const std::map<std::string, T>& values)
+{
+    std::map<std::string, std::string> packed;
+    for (const auto& [key, value] : values)
+        packed.emplace(key, packValue(value));
+    return packed;
+}
+
+template<typename T>
+static std::map<std::string, T>
+unpackValues(const std::map<std::string, std::string>& packed)
+{
+    std::map<std::string, T> values;
+    for (const auto& [key, data] : packed) {
+        try {
+            auto oh = msgpack::unpack(data.data(), data.size());
+            values.emplace(key, oh.get().as<T>());
+        } catch (const std::exception& e) {
+            JAMI_WARNING("Ignoring invalid entry {}: {}", key, e.what());
+        }
+    }
+    return values;
+}
+
+/**
+ * Read the journal of path, or the whole msgpack map written there by
+ * previous versions
+ */
+template<typename T>
+static std::map<std::string, T>
+readValues(const std::filesystem::path& path)
+{
+    std::map<std::string, T> values;
+    std::error_code ec;
+    auto journal = journalPath(path);
+    if (std::filesystem::is_regular_file(journal, ec))
+        return unpackValues<T>(JournalStore::read(journal));
+    if (!std::filesystem::is_regular_file(path, ec))
+        return values;
+    try {
+        std::lock_guard lock(dhtnet::fileutils::getFileLock(path));
+        auto file = fileutils::loadFile(path);
+        msgpack::unpacked result;
+        msgpack::unpack(result, (const char*) file.data(), file.size());
+        result.get().convert(values);
+    } catch (const std::exception& e) {
+        JAMI_WARNING("Error loading {}: {}", path, e.what());
+    }
+    return values;
+}
+
+/**
+ * Write the values of keys, erasing those that are not in values anymore.
+ * The changes are only staged: callers hold the lock of values, the io pool
+ * writes them together with the ones staged meanwhile.
+ */
+template<typename T>
+static void
+saveEntries(const std::shared_ptr<JournalStore>& store,
+            const std::map<std::string, T>& values,
+            const std::set<std::string>& keys)
+{
+    std::map<std::string, std::optional<std::string>> changes;
+    for (const auto& key : keys) {
+        auto it = values.find(key);
+        changes.emplace(key, it != values.end() ? std::optional(packValue(it->second)) : std::nullopt);
+    }
+    if (auto ticket = store->stage(changes))
+        dht::ThreadPool::io().run([store, ticket] { store->sync(ticket); });
+}
+
+/**
+ * Open the journal of path, migrating the file written there by previous
+ * versions. That file is kept, for previous versions and in case the
+ * migration is interrupted, until the journal is compacted once.
+ */
+template<typename T>
+static std::shared_ptr<JournalStore>
+openJournal(const std::filesystem::path& path)
+{
+    std::error_code ec;
+    auto journal = journalPath(path);
+    std::map<std::string, std::string> migrated;
+    auto migrating = !std::filesystem::is_regular_file(journal, ec) && std::filesystem::is_regular_file(path, ec);
+    if (migrating) {
+        JAMI_LOG("Migrating {} to a journal", path);
+        migrated = packValues(readValues<T>(path));
+        if (!JournalStore::write(journal, migrated))
+            JAMI_ERROR("Unable to migrate {} to a journal", path);
+    }
+    auto store = std::make_shared<JournalStore>(journal);
+    // Written with the next changes if the migration failed
+    if (migrating)
+        store->assign(migrated);
+    if (std::filesystem::is_regular_file(path, ec))
+        store->onCompacted([path] {
+            std::error_code ec;
+            std::filesystem::remove(path, ec);
+        });
+    return store;
+}
 
 struct SyncedConversation
 {
@@ -88,10 +287,24 @@ struct SyncedConversation
     // triggers calling cloneConversation() directly honour the same backoff as the timer.
     std::chrono::steady_clock::time_point nextCloneAttempt {};
     unsigned validationFailures {0};
+    // Member whose invitation was accepted. With our own devices, the only
+    // ones trusted to send a shallow history. mtx must be locked.
+    std::string inviter;
     ConvInfo info;
     std::unique_ptr<PendingConversationFetch> pending;
     std::map<std::string, DeferredFetch> deferredFetches;
     std::shared_ptr<Conversation> conversation;
+    // The repository exists but is not opened, see ConversationModule::Impl::loadConversation.
+    // Written with both conversationsMtx_ and mtx locked.
+    bool unloaded {false};
+    // The repository is being opened, without holding any lock. mtx must be locked.
+    bool loading {false};
+    std::condition_variable loadedCv;
+    // conversationsMtx_ must be locked
+    std::chrono::steady_clock::time_point lastUsed {};
+    // Earliest time the repository is checked for maintenance again.
+    // conversationsMtx_ must be locked
+    std::chrono::steady_clock::time_point nextMaintenance {};
 
     bool isUnrecoverable() const { return validationFailures >= MAX_VALIDATION_FAILURES; }
 
@@ -302,6 +515,21 @@ public:
                                  const std::string& commitId = "",
                                  const std::string& deviceId = "");
 
+    /**
+     * Queue the announcement of a conversation's head to target (a member or a
+     * device), replacing the one not sent yet for that conversation
+     */
+    void queueAnnouncement(const std::string& target,
+                           const std::string& uri,
+                           const DeviceId& device,
+                           const std::string& conversationId,
+                           const std::string& text);
+    void flushAnnouncements();
+    /**
+     * Forget what is left to announce for a removed conversation
+     */
+    void forgetAnnouncements(const std::string& conversationId);
+
     /**
      * @return if a convId is a valid conversation (repository cloned & usable)
      */
@@ -329,20 +557,35 @@ public:
     {
         std::lock_guard lk(convInfosMtx_);
         convInfos_[info.id] = info;
-        saveConvInfos();
+        saveConvInfos({info.id});
     }
 
     std::string getOneToOneConversation(const std::string& uri) const noexcept;
 
     bool updateConvForContact(const std::string& uri, const std::string& oldConv, const std::string& newConv);
 
+    /**
+     * Get a conversation, opening its repository if it was not loaded yet
+     */
     std::shared_ptr<SyncedConversation> getConversation(std::string_view convId) const
     {
-        std::lock_guard lk(conversationsMtx_);
-        auto c = conversations_.find(convId);
-        return c != conversations_.end() ? c->second : nullptr;
+        std::shared_ptr<SyncedConversation> sconv;
+        {
+            std::lock_guard lk(conversationsMtx_);
+            auto c = conversations_.find(convId);
+            if (c == conversations_.end())
+                return nullptr;
+            sconv = c->second;
+            if (!useConversation(*sconv))
+                return sconv;
+        }
+        loadConversation(sconv);
+        return sconv;
     }
-    std::shared_ptr<SyncedConversation> getConversation(std::string_view convId)
+    /**
+     * Get a conversation as it is, loaded or not
+     */
+    std::shared_ptr<SyncedConversation> findConversation(std::string_view convId) const
     {
         std::lock_guard lk(conversationsMtx_);
         auto c = conversations_.find(convId);
@@ -350,20 +593,75 @@ public:
     }
     std::shared_ptr<SyncedConversation> startConversation(const std::string& convId)
     {
-        std::lock_guard lk(conversationsMtx_);
-        auto& c = conversations_[convId];
-        if (!c)
-            c = std::make_shared<SyncedConversation>(convId);
-        return c;
+        std::shared_ptr<SyncedConversation> sconv;
+        {
+            std::lock_guard lk(conversationsMtx_);
+            auto& c = conversations_[convId];
+            if (!c)
+                c = std::make_shared<SyncedConversation>(convId);
+            sconv = c;
+            if (!useConversation(*sconv))
+                return sconv;
+        }
+        loadConversation(sconv);
+        return sconv;
     }
     std::shared_ptr<SyncedConversation> startConversation(const ConvInfo& info)
     {
-        std::lock_guard lk(conversationsMtx_);
-        auto& c = conversations_[info.id];
-        if (!c)
-            c = std::make_shared<SyncedConversation>(info);
-        return c;
+        std::shared_ptr<SyncedConversation> sconv;
+        {
+            std::lock_guard lk(conversationsMtx_);
+            auto& c = conversations_[info.id];
+            if (!c)
+                c = std::make_shared<SyncedConversation>(info);
+            sconv = c;
+            if (!useConversation(*sconv))
+                return sconv;
+        }
+        loadConversation(sconv);
+        return sconv;
     }
+
+    /**
+     * Open the repository of a conversation
+     * @throw std::logic_error if the repository is invalid
+     */
+    std::shared_ptr<Conversation> openConversation(const std::shared_ptr<JamiAccount>& acc,
+                                                   const std::string& convId) const;
+    /**
+     * Mark sconv as used
+     * @return true if its repository must be loaded
+     * @note conversationsMtx_ must be locked
+     */
+    bool useConversation(SyncedConversation& sconv) const
+    {
+        sconv.lastUsed = std::chrono::steady_clock::now();
+        return sconv.unloaded;
+    }
+    /**
+     * Open the repository of sconv if it was not loaded yet, or wait for the
+     * load in progress, then unload idle conversations if too many are loaded.
+     * The repository is opened without holding any lock.
+     * @note neither conversationsMtx_ nor the mtx of sconv must be locked
+     */
+    void loadConversation(const std::shared_ptr<SyncedConversation>& sconv) const;
+    void unloadIdleConversations(std::vector<std::shared_ptr<Conversation>>& unloaded) const;
+
+    // Manifest
+    void loadManifest();
+    void saveManifest() const;
+    void scheduleManifestSave() const;
+    void updateSummary(const Conversation& conversation) const;
+    void updateLastMessage(const Conversation& conversation) const;
+    /**
+     * What clients are given for a conversation that is not loaded
+     * @return empty if it is loaded or not summarized enough
+     */
+    std::map<std::string, std::string> unloadedInfos(SyncedConversation& sconv) const;
+    std::optional<std::vector<std::map<std::string, std::string>>> unloadedMembers(SyncedConversation& sconv,
+                                                                                   bool includeBanned) const;
+    void removeSummary(const std::string& convId) const;
+
     std::vector<std::shared_ptr<SyncedConversation>> getSyncedConversations() const
     {
         std::lock_guard lk(conversationsMtx_);
@@ -405,13 +703,38 @@ public:
 
     // The following methods modify what is stored on the disk
     /**
+     * Write the infos of the conversations that changed, erasing the removed ones
      * @note convInfosMtx_ should be locked
      */
-    void saveConvInfos() const { ConversationModule::saveConvInfos(accountId_, convInfos_); }
+    void saveConvInfos(const std::set<std::string>& convIds) const
+    {
+        saveEntries(convInfosStore_, convInfos_, convIds);
+    }
     /**
      * @note conversationsRequestsMtx_ should be locked
      */
-    void saveConvRequests() const { ConversationModule::saveConvRequests(accountId_, conversationsRequests_); }
+    void saveConvRequests(const std::set<std::string>& convIds) const
+    {
+        saveEntries(convRequestsStore_, conversationsRequests_, convIds);
+    }
+    /**
+     * Reopen the journals and reload what they hold
+     * @note convInfosMtx_ (resp. conversationsRequestsMtx_) should be locked
+     */
+    void loadConvInfos()
+    {
+        if (convInfosStore_)
+            convInfosStore_->flush();
+        convInfosStore_ = openJournal<ConvInfo>(fileutils::get_data_dir() / accountId_ / "convInfo");
+        convInfos_ = unpackValues<ConvInfo>(convInfosStore_->values());
+    }
+    void loadConvRequests()
+    {
+        if (convRequestsStore_)
+            convRequestsStore_->flush();
+        convRequestsStore_ = openJournal<ConversationRequest>(fileutils::get_data_dir() / accountId_ / "convRequests");
+        conversationsRequests_ = unpackValues<ConversationRequest>(convRequestsStore_->values());
+    }
     void declineOtherConversationWith(const std::string& uri);
     bool addConversationRequest(const std::string& id, const ConversationRequest& req)
     {
@@ -427,7 +750,7 @@ public:
                 if (req.declined <= it->second.declined)
                     return false;
                 conversationsRequests_[id] = req;
-                saveConvRequests();
+                saveConvRequests({id});
                 return false;
             } else if (incomingDeclined) {
                 // Accept a decline only if it is newer than the active request.
@@ -448,7 +771,7 @@ public:
         }
         JAMI_DEBUG("[Account {}] [Conversation {}] Adding conversation request from {}", accountId_, id, req.from);
         conversationsRequests_[id] = req;
-        saveConvRequests();
+        saveConvRequests({id});
         return true;
     }
     void rmConversationRequest(const std::string& id)
@@ -463,7 +786,7 @@ public:
         }
         saveMetadata();
         conversationsRequests_.erase(id);
-        saveConvRequests();
+        saveConvRequests({id});
     }
 
     std::weak_ptr<JamiAccount> account_;
@@ -481,6 +804,7 @@ public:
     // Requests
     mutable std::mutex conversationsRequestsMtx_;
     std::map<std::string, ConversationRequest> conversationsRequests_;
+    std::shared_ptr<JournalStore> convRequestsStore_;
 
     // Conversations
     mutable std::mutex conversationsMtx_ {};
@@ -489,6 +813,7 @@ public:
     // The following information are stored on the disk
     mutable std::mutex convInfosMtx_; // Note, should be locked after conversationsMtx_ if needed
     std::map<std::string, ConvInfo> convInfos_;
+    std::shared_ptr<JournalStore> convInfosStore_;
 
     // When sending a new message, we need to send the notification to some peers of the
     // conversation However, the conversation may be not bootstrapped, so the list will be empty.
@@ -497,15 +822,60 @@ public:
     std::mutex notSyncedNotificationMtx_;
     std::map<std::string, std::string> notSyncedNotification_;
 
-    std::weak_ptr<Impl> weak() { return std::static_pointer_cast<Impl>(shared_from_this()); }
+    std::weak_ptr<Impl> weak() const { return std::const_pointer_cast<Impl>(shared_from_this()); }
+
+    // Summary of every conversation, persisted in "convManifest"
+    mutable std::mutex manifestMtx_;
+    mutable std::map<std::string, ConvSummary> manifest_;
+    mutable std::atomic_bool manifestSaveScheduled_ {false};
 
     std::mutex refreshMtx_;
-    std::map<std::string, uint64_t> refreshMessage;
+    // Conversation -> target -> token of the last announcement queued in the message engine
+    std::map<std::string, std::map<std::string, uint64_t>> refreshMessage;
+
+    struct Announcement
+    {
+        std::string uri;
+        DeviceId device;
+        std::string text;
+    };
+    std::mutex announcementsMtx_;
+    // Target (member or device) -> conversation -> last announcement not sent yet
+    std::map<std::string, std::map<std::string, Announcement>> pendingAnnouncements_;
+    asio::steady_timer announceTimer_ {*Manager::instance().ioContext()};
+    bool announceScheduled_ {false};
+
+    // Background maintenance of the repositories, see maintainNextConversation()
+    struct MaintenanceStats
+    {
+        uint64_t checked {0};
+        uint64_t maintained {0};
+        uint64_t failures {0};
+        uint64_t packedObjects {0};
+        uint64_t prunedObjects {0};
+        uint64_t removedPacks {0};
+        uint64_t reclaimedBytes {0};
+        int64_t lastRun {0};
+        // Last known state of each repository checked
+        std::map<std::string, git_maintenance::ObjectStats> objects;
+    };
+    asio::steady_timer maintenanceTimer_ {*Manager::instance().ioContext()};
+    mutable std::mutex maintenanceMtx_;
+    MaintenanceStats maintenanceStats_;
+    void scheduleMaintenance(std::chrono::steady_clock::duration delay);
+    /**
+     * Pick a conversation that is not in use and was not checked recently,
+     * and repack its repository if needed, then schedule the next one.
+     */
+    void maintainNextConversation();
+    std::map<std::string, std::string> maintenanceStats() const;
     std::atomic_int syncCnt {0};
 
 #ifdef LIBJAMI_TEST
     std::function<void(std::string, Conversation::BootstrapStatus)> bootstrapCbTest_;
     std::function<void(const std::string&, const std::string&, bool)> fetchCompletedCbTest_;
+    std::function<void()> manifestSavedCbTest_;
+    std::function<void(const std::string&, const std::string&)> announcementSentCbTest_;
 #endif
 
     uint64_t presenceListenerToken_ {0};
@@ -594,7 +964,9 @@ ConversationModule::Impl::Impl(std::shared_ptr<JamiAccount>&& account,
             deviceId_ = info->deviceId;
             username_ = info->accountId;
         }
-    conversationsRequests_ = convRequests(accountId_);
+    loadConvRequests();
+    // convInfos_ is filled by loadConversations()
+    convInfosStore_ = openJournal<ConvInfo>(fileutils::get_data_dir() / accountId_ / "convInfo");
     loadMetadata();
 }
 
@@ -714,7 +1086,7 @@ ConversationModule::Impl::fetchNewCommits(const std::string& peer,
                         conv->info.created = nowMs();
                         conv->info.erased = TimePoint {};
                         convInfos_[conversationId] = conv->info;
-                        saveConvInfos();
+                        saveConvInfos({conversationId});
                         needReclone = true;
                     }
                 }
@@ -863,6 +1235,8 @@ ConversationModule::Impl::fetchNewCommits(const std::string& peer,
                             // Notify peers that a new commit is there (DRT)
                             if (not commitId.empty() && ok) {
                                 shared->sendMessageNotification(*conv->conversation, false, commitId, deviceId);
+                            } else if (ok && conv->conversation) {
+                                shared->updateLastMessage(*conv->conversation);
                             }
                         }
                         if (deferred)
@@ -936,7 +1310,17 @@ ConversationModule::Impl::handlePendingConversation(const std::string& conversat
         lk.unlock();
     };
     try {
-        auto conversation = std::make_shared<Conversation>(acc, deviceId, conversationId);
+        // Until it is backfilled, a shallow history is validated with the
+        // members its sender chose
+        std::string inviter;
+        {
+            std::lock_guard lkInviter(conv->mtx);
+            inviter = conv->inviter;
+        }
+        auto cert = acc->certStore().getCertificate(deviceId);
+        auto owner = cert && cert->issuer ? cert->issuer->getId().toString() : std::string {};
+        auto shallow = !owner.empty() && (owner == username_ || owner == inviter);
+        auto conversation = std::make_shared<Conversation>(acc, deviceId, conversationId, shallow);
         conversation->onMembersChanged([w = weak_from_this(), conversationId](const auto& members) {
             // Delay in another thread to avoid deadlocks
             dht::ThreadPool::io().run([w, conversationId, members = std::move(members)] {
@@ -1005,6 +1389,7 @@ ConversationModule::Impl::handlePendingConversation(const std::string& conversat
         auto commitId = conversation->join();
         if (!commitId.empty())
             sendMessageNotification(*conversation, false, commitId);
+        updateSummary(*conversation);
         erasePending(); // Will unlock
 
 #ifdef LIBJAMI_TEST
@@ -1165,6 +1550,9 @@ ConversationModule::Impl::declineOtherConversationWith(const std::string& uri)
 std::vector<std::map<std::string, std::string>>
 ConversationModule::Impl::getConversationMembers(const std::string& conversationId, bool includeBanned) const
 {
+    if (auto conv = findConversation(conversationId))
+        if (auto members = unloadedMembers(*conv, includeBanned))
+            return *members;
     return withConv(conversationId, [&](const auto& conv) { return conv.getMembers(true, includeBanned); });
 }
 
@@ -1206,6 +1594,12 @@ ConversationModule::Impl::removeRepositoryImpl(SyncedConversation& conv, bool sy
         }
         conv.conversation->erase();
         conv.conversation.reset();
+        removeSummary(conv.info.id);
+        forgetAnnouncements(conv.info.id);
+        {
+            std::lock_guard lk(maintenanceMtx_);
+            maintenanceStats_.objects.erase(conv.info.id);
+        }
 
         if (!sync)
             return;
@@ -1348,6 +1742,7 @@ ConversationModule::Impl::sendMessageNotification(Conversation& conversation,
     auto acc = account_.lock();
     if (!acc)
         return;
+    updateLastMessage(conversation);
     auto commit = commitId == "" ? conversation.lastCommitId() : commitId;
     Json::Value message;
     message["id"] = conversation.id();
@@ -1356,15 +1751,12 @@ ConversationModule::Impl::sendMessageNotification(Conversation& conversation,
     const auto text = json::toString(message);
 
     // Send message notification will announce the new commit in 3 steps.
-    const auto messageMap = std::map<std::string, std::string> {{MIME_TYPE_GIT, text}};
+    // Announcements are queued and sent shortly after, so that a burst of
+    // commits is announced once per target.
 
     // First, because our account can have several devices, announce to other devices
-    if (sync) {
-        // Announce to our devices
-        std::lock_guard lk(refreshMtx_);
-        auto& refresh = refreshMessage[username_];
-        refresh = sendMsgCb_(username_, {}, messageMap, refresh);
-    }
+    if (sync)
+        queueAnnouncement(username_, username_, {}, conversation.id(), text);
 
     // Then, we announce to 2 random members in the conversation that aren't in the DRT
     // This allow new devices without the ability to sync to their other devices to sync with us.
@@ -1399,11 +1791,8 @@ ConversationModule::Impl::sendMessageNotification(Conversation& conversation,
         }
     }
 
-    std::lock_guard lk(refreshMtx_);
-    for (const auto& member : nonConnectedMembers) {
-        auto& refresh = refreshMessage[member];
-        refresh = sendMsgCb_(member, {}, messageMap, refresh);
-    }
+    for (const auto& member : nonConnectedMembers)
+        queueAnnouncement(member, member, {}, conversation.id(), text);
 
     // Finally we send to devices that the DRT choose.
     for (const auto& device : devices) {
@@ -1411,8 +1800,7 @@ ConversationModule::Impl::sendMessageNotification(Conversation& conversation,
         auto memberUri = conversation.uriFromDevice(deviceIdStr);
         if (memberUri.empty() || deviceIdStr == deviceId)
             continue;
-        auto& refresh = refreshMessage[deviceIdStr];
-        refresh = sendMsgCb_(memberUri, device, messageMap, refresh);
+        queueAnnouncement(deviceIdStr, memberUri, device, conversation.id(), text);
     }
 
     // And we wake up the mobile devices we are responsible for (i.e. closer
@@ -1427,11 +1815,208 @@ ConversationModule::Impl::sendMessageNotification(Conversation& conversation,
         auto deviceIdStr = device.toString();
         if (deviceIdStr == deviceId)
             continue;
-        auto& refresh = refreshMessage[deviceIdStr];
-        refresh = sendMsgCb_(target.uri, device, messageMap, refresh);
+        queueAnnouncement(deviceIdStr, target.uri, device, conversation.id(), text);
     }
 }
 
+void
+ConversationModule::Impl::queueAnnouncement(const std::string& target,
+                                            const std::string& uri,
+                                            const DeviceId& device,
+                                            const std::string& conversationId,
+                                            const std::string& text)
+{
+    std::lock_guard lk(announcementsMtx_);
+    pendingAnnouncements_[target].insert_or_assign(conversationId, Announcement {uri, device, text});
+    if (announceScheduled_)
+        return;
+    announceScheduled_ = true;
+    announceTimer_.expires_after(ANNOUNCE_DELAY);
+    announceTimer_.async_wait([w = weak()](const asio::error_code& ec) {
+        if (ec == asio::error::operation_aborted)
+            return;
+        if (auto sthis = w.lock())
+            sthis->flushAnnouncements();
+    });
+}
+
+void
+ConversationModule::Impl::flushAnnouncements()
+{
+    std::map<std::string, std::map<std::string, Announcement>> announcements;
+    {
+        std::lock_guard lk(announcementsMtx_);
+        announcements = std::move(pendingAnnouncements_);
+        pendingAnnouncements_.clear();
+        announceScheduled_ = false;
+    }
+    // Everything announced to a target goes out together. Once in the message
+    // engine, announcements are persisted and retried until the peer gets them.
+    std::lock_guard lk(refreshMtx_);
+    for (const auto& [target, byConversation] : announcements) {
+        for (const auto& [conversationId, announcement] : byConversation) {
+            auto& refresh = refreshMessage[conversationId][target];
+            refresh = sendMsgCb_(announcement.uri,
+                                 announcement.device,
+                                 std::map<std::string, std::string> {{MIME_TYPE_GIT, announcement.text}},
+                                 refresh);
+#ifdef LIBJAMI_TEST
+            if (announcementSentCbTest_)
+                announcementSentCbTest_(target, conversationId);
+#endif
+        }
+    }
+}
+
+void
+ConversationModule::Impl::forgetAnnouncements(const std::string& conversationId)
+{
+    {
+        std::lock_guard lk(announcementsMtx_);
+        for (auto it = pendingAnnouncements_.begin(); it != pendingAnnouncements_.end();) {
+            it->second.erase(conversationId);
+            if (it->second.empty())
+                it = pendingAnnouncements_.erase(it);
+            else
+                ++it;
+        }
+    }
+    {
+        std::lock_guard lk(refreshMtx_);
+        refreshMessage.erase(conversationId);
+    }
+    std::lock_guard lk(notSyncedNotificationMtx_);
+    notSyncedNotification_.erase(conversationId);
+}
+
+void
+ConversationModule::Impl::scheduleMaintenance(std::chrono::steady_clock::duration delay)
+{
+    maintenanceTimer_.expires_after(delay);
+    maintenanceTimer_.async_wait([w = weak()](const asio::error_code& ec) {
+        if (ec == asio::error::operation_aborted)
+            return;
+        if (auto sthis = w.lock())
+            sthis->maintainNextConversation();
+    });
+}
+
+void
+ConversationModule::Impl::maintainNextConversation()
+{
+    auto now = std::chrono::steady_clock::now();
+    std::string convId;
+    {
+        std::lock_guard lk(conversationsMtx_);
+        for (const auto& [id, sconv] : conversations_) {
+            if (now < sconv->nextMaintenance || now - sconv->lastUsed < MIN_IDLE_BEFORE_UNLOAD)
+                continue;
+            std::unique_lock lkc(sconv->mtx, std::try_to_lock);
+            if (!lkc.owns_lock())
+                continue;
+            // Same conditions as for unloading: nobody holds the conversation
+            // and nothing is in progress
+            const auto& conv = sconv->conversation;
+            bool idle = conv ? conv.use_count() == 1 && !conv->isRemoving() && conv->currentCalls().empty()
+                             : sconv->unloaded;
+            if (idle && !sconv->pending && sconv->deferredFetches.empty() && !sconv->info.isRemoved()) {
+                sconv->nextMaintenance = now + MAINTENANCE_INTERVAL;
+                convId = id;
+                break;
+            }
+        }
+    }
+    if (convId.empty()) {
+        scheduleMaintenance(MAINTENANCE_IDLE_DELAY);
+        return;
+    }
+
+    // The conversation may be used again while its repository is repacked:
+    // objects are only removed once they are in the new pack, so that is safe,
+    // like running "git gc" next to other git commands.
+    git_maintenance::post([w = weak(), convId] {
+        auto sthis = w.lock();
+        if (!sthis)
+            return;
+        auto path = fileutils::get_data_dir() / sthis->accountId_ / "conversations" / convId;
+        auto objects = git_maintenance::inspect(path);
+        std::optional<git_maintenance::Result> result;
+        if (git_maintenance::needed(objects)) {
+            JAMI_DEBUG("[Account {}] [Conversation {}] Repacking {} loose objects and {} packs",
+                       sthis->accountId_,
+                       convId,
+                       objects.looseObjects,
+                       objects.packs);
+            result = git_maintenance::run(path, MAINTENANCE_IO_BUDGET);
+        }
+
+        std::chrono::steady_clock::duration next = MAINTENANCE_CHECK_DELAY;
+        {
+            std::lock_guard lk(sthis->maintenanceMtx_);
+            auto& stats = sthis->maintenanceStats_;
+            stats.checked++;
+            if (result) {
+                objects = result->after;
+                stats.maintained++;
+                stats.packedObjects += result->packedObjects;
+                stats.prunedObjects += result->prunedObjects;
+                stats.removedPacks += result->removedPacks;
+                stats.reclaimedBytes += result->reclaimedBytes();
+                stats.lastRun = std::chrono::duration_cast<std::chrono::seconds>(
+                                    std::chrono::system_clock::now().time_since_epoch())
+                                    .count();
+                // Leave the disk alone for at least as long as it was written to
+                next = std::max<std::chrono::steady_clock::duration>(
+                    MAINTENANCE_MIN_DELAY, std::chrono::seconds(result->writtenBytes / MAINTENANCE_IO_BUDGET));
+            } else if (git_maintenance::needed(objects)) {
+                stats.failures++;
+            }
+            // Unless removed in the meantime
+            std::error_code ec;
+            if (std::filesystem::is_directory(path, ec))
+                stats.objects[convId] = objects;
+        }
+        if (result)
+            JAMI_LOG("[Account {}] [Conversation {}] Repository maintained: {} objects packed, {} pruned, "
+                     "{} packs removed, {} bytes reclaimed",
+                     sthis->accountId_,
+                     convId,
+                     result->packedObjects,
+                     result->prunedObjects,
+                     result->removedPacks,
+                     result->reclaimedBytes());
+        sthis->scheduleMaintenance(next);
+    });
+}
+
+std::map<std::string, std::string>
+ConversationModule::Impl::maintenanceStats() const
+{
+    std::lock_guard lk(maintenanceMtx_);
+    const auto& stats = maintenanceStats_;
+    git_maintenance::ObjectStats total;
+    for (const auto& [_, objects] : stats.objects) {
+        total.looseObjects += objects.looseObjects;
+        total.looseBytes += objects.looseBytes;
+        total.packs += objects.packs;
+        total.packBytes += objects.packBytes;
+    }
+    return {
+        {"checkedRepositories", std::to_string(stats.checked)},
+        {"maintainedRepositories", std::to_string(stats.maintained)},
+        {"failures", std::to_string(stats.failures)},
+        {"packedObjects", std::to_string(stats.packedObjects)},
+        {"prunedObjects", std::to_string(stats.prunedObjects)},
+        {"removedPacks", std::to_string(stats.removedPacks)},
+        {"reclaimedBytes", std::to_string(stats.reclaimedBytes)},
+        {"lastRun", std::to_string(stats.lastRun)},
+        {"looseObjects", std::to_string(total.looseObjects)},
+        {"looseBytes", std::to_string(total.looseBytes)},
+        {"packs", std::to_string(total.packs)},
+        {"packBytes", std::to_string(total.packBytes)},
+    };
+}
+
 void
 ConversationModule::Impl::sendMessage(const std::string& conversationId,
                                       std::string message,
@@ -1503,6 +2088,7 @@ ConversationModule::Impl::editMessage(const std::string& conversationId,
         // Remove file!
         auto path = fileutils::get_data_dir() / accountId_ / "conversation_data" / conversationId / fileId;
         dhtnet::fileutils::remove(path, true);
+        FileStore::instance().release(path);
         message = CommitMessage::fileDeleted(editedId);
     } else if (type == CommitType::COLLAB_DOC) {
         // A document is retired by editing its announcement, like a file. What it
@@ -1562,17 +2148,18 @@ ConversationModule::Impl::fixStructures(
                 }
             }
         }
-        auto requestRemoved = false;
+        std::set<std::string> removedRequests;
         for (auto it = conversationsRequests_.begin(); it != conversationsRequests_.end();) {
             if (it->second.from == username_) {
                 JAMI_WARNING("Detected request from ourself, this makes no sense. Remove {}", it->first);
+                removedRequests.emplace(it->first);
                 it = conversationsRequests_.erase(it);
             } else {
                 ++it;
             }
         }
-        if (requestRemoved) {
-            saveConvRequests();
+        if (!removedRequests.empty()) {
+            saveConvRequests(removedRequests);
         }
     }
     for (const auto& invalidPendingRequest : invalidPendingRequests)
@@ -1677,12 +2264,15 @@ ConversationModule::Impl::bootstrap(const std::string& convId)
         {
             std::lock_guard lk(convInfosMtx_);
             for (const auto& [conversationId, convInfo] : convInfos_) {
-                if (auto conv = getConversation(conversationId))
+                // Conversations that are not loaded join their swarm once loaded
+                if (auto conv = findConversation(conversationId))
                     convs.emplace_back(std::move(conv));
             }
         }
         for (auto& conv : convs) {
             std::lock_guard lk(conv->mtx);
+            if (conv->unloaded)
+                continue;
             if (!conv->conversation && !conv->info.isRemoved()) {
                 // we need to ask to clone requests when bootstrapping all conversations
                 // otherwise it can stay syncing
@@ -1735,6 +2325,7 @@ ConversationModule::Impl::cloneConversationFrom(const ConversationRequest& reque
     // Explicit (or auto-accepted) request: the peer just told us to clone, don't sit on a
     // backoff armed by earlier failures.
     conv->resetCloneRetry();
+    conv->inviter = request.from;
     if (conv->info.created == TimePoint {}) {
         conv->info = {request.conversationId};
         conv->info.created = request.received;
@@ -1777,6 +2368,345 @@ ConversationModule::Impl::cloneConversationFrom(const std::string& conversationI
                                    });
 }
 
+std::shared_ptr<Conversation>
+ConversationModule::Impl::openConversation(const std::shared_ptr<JamiAccount>& acc, const std::string& convId) const
+{
+    auto conv = std::make_shared<Conversation>(acc, convId);
+    conv->onMessageStatusChanged([this, convId](const auto& status) {
+        auto msg = std::make_shared<SyncMsg>();
+        msg->ms = {{convId, status}};
+        needsSyncingCb_(std::move(msg));
+    });
+    conv->onMembersChanged([w = weak(), convId](const auto& members) {
+        // Delay in another thread to avoid deadlocks
+        dht::ThreadPool::io().run([w, convId, members = std::move(members)] {
+            if (auto sthis = w.lock())
+                sthis->setConversationMembers(convId, members);
+        });
+    });
+    conv->onNeedSocket(onNeedSwarmSocket_);
+    return conv;
+}
+
+void
+ConversationModule::Impl::loadConversation(const std::shared_ptr<SyncedConversation>& sconv) const
+{
+    std::string convId;
+    {
+        std::unique_lock lk(sconv->mtx);
+        if (sconv->loading) {
+            sconv->loadedCv.wait(lk, [&] { return !sconv->loading; });
+            return;
+        }
+        if (!sconv->unloaded)
+            return;
+        // Stays unloaded for the others until it is opened
+        sconv->loading = true;
+        convId = sconv->info.id;
+    }
+    auto acc = account_.lock();
+    std::shared_ptr<Conversation> conversation;
+    if (acc) {
+        try {
+            conversation = openConversation(acc, convId);
+        } catch (const std::logic_error& e) {
+            // Handled like a conversation that is not cloned yet
+            JAMI_WARNING("[Account {}] [Conversation {}] Unable to load conversation: {}", accountId_, convId, e.what());
+        }
+    }
+    auto loaded = conversation != nullptr;
+    std::vector<std::shared_ptr<Conversation>> unloaded; // Released after conversationsMtx_
+    {
+        std::lock_guard lk(conversationsMtx_);
+        {
+            std::lock_guard lkc(sconv->mtx);
+            sconv->loading = false;
+            if (acc)
+                sconv->unloaded = false;
+            if (conversation) {
+                if (sconv->info.isRemoved())
+                    conversation->setRemovingFlag();
+                sconv->conversation = std::move(conversation);
+            }
+        }
+        sconv->loadedCv.notify_all();
+        if (loaded)
+            unloadIdleConversations(unloaded);
+    }
+    if (!loaded)
+        return;
+    JAMI_DEBUG("[Account {}] [Conversation {}] Conversation loaded", accountId_, convId);
+    // The swarm of a conversation is joined when it is loaded
+    dht::ThreadPool::io().run([w = weak(), convId] {
+        if (auto sthis = w.lock()) {
+            if (auto conv = sthis->getConversation(convId)) {
+                std::unique_lock lk(conv->mtx);
+                if (auto conversation = conv->conversation) {
+                    lk.unlock();
+                    sthis->updateSummary(*conversation);
+                }
+            }
+            sthis->bootstrap(convId);
+        }
+    });
+}
+
+void
+ConversationModule::Impl::unloadIdleConversations(std::vector<std::shared_ptr<Conversation>>& unloaded) const
+{
+    // conversationsMtx_ must be locked
+    auto now = std::chrono::steady_clock::now();
+    auto isIdle = [&](const SyncedConversation& sconv) {
+        // conversation mtx must be locked. Only conversations nobody else
+        // holds and without anything in progress are unloaded.
+        return sconv.conversation && sconv.conversation.use_count() == 1 && now - sconv.lastUsed >= MIN_IDLE_BEFORE_UNLOAD
+               && !sconv.pending && sconv.deferredFetches.empty() && sconv.info.mode != ConversationMode::DOCUMENT
+               && !sconv.conversation->isRemoving() && sconv.conversation->currentCalls().empty();
+    };
+
+    size_t loaded = 0;
+    std::vector<std::shared_ptr<SyncedConversation>> idle;
+    for (const auto& [id, sconv] : conversations_) {
+        std::unique_lock lk(sconv->mtx, std::try_to_lock);
+        if (!lk.owns_lock()) {
+            // In use
+            ++loaded;
+            continue;
+        }
+        if (!sconv->conversation)
+            continue;
+        ++loaded;
+        if (isIdle(*sconv))
+            idle.emplace_back(sconv);
+    }
+    if (loaded <= MAX_LOADED_CONVERSATIONS)
+        return;
+
+    std::sort(idle.begin(), idle.end(), [](const auto& a, const auto& b) { return a->lastUsed < b->lastUsed; });
+    for (const auto& sconv : idle) {
+        if (loaded <= MAX_LOADED_CONVERSATIONS)
+            break;
+        std::unique_lock lk(sconv->mtx, std::try_to_lock);
+        if (!lk.owns_lock() || !isIdle(*sconv))
+            continue;
+        JAMI_DEBUG("[Account {}] [Conversation {}] Unloading idle conversation", accountId_, sconv->info.id);
+        sconv->conversation->shutdownConnections();
+        unloaded.emplace_back(std::move(sconv->conversation));
+        sconv->unloaded = true;
+        --loaded;
+    }
+}
+
+void
+ConversationModule::Impl::loadManifest()
+{
+    std::map<std::string, ConvSummary> manifest;
+    try {
+        auto path = fileutils::get_data_dir() / accountId_;
+        std::lock_guard lock(dhtnet::fileutils::getFileLock(path / "convManifest"));
+        auto file = fileutils::loadFile("convManifest", path);
+        msgpack::unpacked result;
+        msgpack::unpack(result, (const char*) file.data(), file.size(), 0);
+        result.get().convert(manifest);
+    } catch (const std::exception& e) {
+        JAMI_WARNING("[Account {}] [ConversationModule] Unable to load conversation manifest: {}", accountId_, e.what());
+    }
+    std::lock_guard lk(manifestMtx_);
+    manifest_ = std::move(manifest);
+}
+
+void
+ConversationModule::Impl::scheduleManifestSave() const
+{
+    // Changes are coalesced, the manifest is written once per burst
+    if (!manifestSaveScheduled_.exchange(true))
+        dht::ThreadPool::io().run([w = weak()] {
+            if (auto sthis = w.lock())
+                sthis->saveManifest();
+        });
+}
+
+void
+ConversationModule::Impl::saveManifest() const
+{
+    manifestSaveScheduled_ = false;
+    std::map<std::string, ConvSummary> manifest;
+    {
+        std::lock_guard lk(manifestMtx_);
+        manifest = manifest_;
+    }
+    auto path = fileutils::get_data_dir() / accountId_ / "convManifest";
+    auto tmpPath = path;
+    tmpPath += ".tmp";
+    std::lock_guard lock(dhtnet::fileutils::getFileLock(path));
+    {
+        std::ofstream file(tmpPath, std::ios::trunc | std::ios::binary);
+        msgpack::pack(file, manifest);
+        file.flush();
+        if (!file) {
+            JAMI_WARNING("[Account {}] [ConversationModule] Unable to write conversation manifest", accountId_);
+            return;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        JAMI_WARNING("[Account {}] [ConversationModule] Unable to replace conversation manifest: {}",
+                     accountId_,
+                     ec.message());
+        return;
+    }
+#ifdef LIBJAMI_TEST
+    if (manifestSavedCbTest_)
+        manifestSavedCbTest_();
+#endif
+}
+
+void
+ConversationModule::Impl::updateSummary(const Conversation& conversation) const
+{
+    ConvSummary summary;
+    try {
+        summary.mode = conversation.mode();
+        summary.members = conversation.memberUris(username_, {});
+        summary.lastMessageId = conversation.lastCommitId();
+        if (auto commit = conversation.getCommit(summary.lastMessageId))
+            summary.lastMessageTimestamp = commit->timestamp;
+        summary.infosHash = hashInfos(conversation.infos());
+        for (const auto& member : conversation.getMembers(true, true, true))
+            summary.roles.emplace(member.at("uri"), member.at("role"));
+    } catch (const std::exception& e) {
+        JAMI_WARNING("[Account {}] [Conversation {}] Unable to summarize conversation: {}",
+                     accountId_,
+                     conversation.id(),
+                     e.what());
+        return;
+    }
+    {
+        std::lock_guard lk(manifestMtx_);
+        auto& current = manifest_[conversation.id()];
+        if (current == summary)
+            return;
+        current = std::move(summary);
+    }
+    scheduleManifestSave();
+}
+
+void
+ConversationModule::Impl::updateLastMessage(const Conversation& conversation) const
+{
+    auto lastMessageId = conversation.lastCommitId();
+    {
+        std::lock_guard lk(manifestMtx_);
+        auto it = manifest_.find(conversation.id());
+        // Conversations missing from the manifest are summarized when loaded
+        if (it == manifest_.end() || it->second.lastMessageId == lastMessageId)
+            return;
+    }
+    auto commit = conversation.getCommit(lastMessageId);
+    if (!commit)
+        return;
+    std::string infosHash;
+    if (commit->commitMsg.type == CommitType::UPDATE_PROFILE)
+        infosHash = hashInfos(conversation.infos());
+    {
+        std::lock_guard lk(manifestMtx_);
+        auto it = manifest_.find(conversation.id());
+        if (it == manifest_.end())
+            return;
+        it->second.lastMessageId = std::move(lastMessageId);
+        it->second.lastMessageTimestamp = commit->timestamp;
+        if (!infosHash.empty())
+            it->second.infosHash = std::move(infosHash);
+    }
+    scheduleManifestSave();
+}
+
+std::map<std::string, std::string>
+ConversationModule::Impl::unloadedInfos(SyncedConversation& sconv) const
+{
+    {
+        std::lock_guard lk(sconv.mtx);
+        if (!sconv.unloaded || sconv.loading)
+            return {};
+    }
+    ConversationMode mode;
+    {
+        std::lock_guard lk(manifestMtx_);
+        auto it = manifest_.find(sconv.info.id);
+        if (it == manifest_.end())
+            return {};
+        mode = it->second.mode;
+    }
+    // Like ConversationRepository::infos(), from the working directory
+    std::map<std::string, std::string> infos;
+    auto profilePath = fileutils::get_data_dir() / accountId_ / "conversations" / sconv.info.id / "profile.vcf";
+    std::error_code ec;
+    if (std::filesystem::is_regular_file(profilePath, ec)) {
+        try {
+            auto content = fileutils::loadFile(profilePath);
+            infos = ConversationRepository::infosFromVCard(
+                vCard::utils::toMap(std::string_view {(const char*) content.data(), content.size()}));
+        } catch (const std::exception& e) {
+            return {};
+        }
+    }
+    infos["mode"] = std::to_string(static_cast<int>(mode));
+    return infos;
+}
+
+std::optional<std::vector<std::map<std::string, std::string>>>
+ConversationModule::Impl::unloadedMembers(SyncedConversation& sconv, bool includeBanned) const
+{
+    {
+        std::lock_guard lk(sconv.mtx);
+        if (!sconv.unloaded || sconv.loading)
+            return std::nullopt;
+    }
+    std::map<std::string, std::string> roles;
+    {
+        std::lock_guard lk(manifestMtx_);
+        auto it = manifest_.find(sconv.info.id);
+        if (it == manifest_.end() || it->second.roles.empty())
+            return std::nullopt;
+        roles = it->second.roles;
+    }
+    // Same as Conversation::getMembers(true, includeBanned)
+    std::map<std::string, std::map<std::string, std::string>> status;
+    try {
+        auto file = fileutils::loadFile(fileutils::get_data_dir() / accountId_ / "conversation_data" / sconv.info.id
+                                        / ConversationDirectories::STATUS);
+        auto oh = msgpack::unpack((const char*) file.data(), file.size());
+        oh.get().convert(status);
+    } catch (const std::exception&) {
+    }
+    std::vector<std::map<std::string, std::string>> members;
+    for (const auto& [uri, role] : roles) {
+        if (role == "banned" || (role == "left" && !includeBanned))
+            continue;
+        std::map<std::string, std::string> member {{"uri", uri}, {"role", role}};
+        auto it = status.find(uri);
+        if (it != status.end()) {
+            auto readIt = it->second.find("read");
+            if (readIt != it->second.end())
+                member[ConversationMapKeys::LAST_DISPLAYED] = readIt->second;
+        }
+        members.emplace_back(std::move(member));
+    }
+    return members;
+}
+
+void
+ConversationModule::Impl::removeSummary(const std::string& convId) const
+{
+    {
+        std::lock_guard lk(manifestMtx_);
+        if (manifest_.erase(convId) == 0)
+            return;
+    }
+    scheduleManifestSave();
+}
+
 ////////////////////////////////////////////////////////////////
 
 void
@@ -1791,10 +2721,7 @@ void
 ConversationModule::saveConvRequestsToPath(const std::filesystem::path& path,
                                            const std::map<std::string, ConversationRequest>& conversationsRequests)
 {
-    auto p = path / "convRequests";
-    std::lock_guard lock(dhtnet::fileutils::getFileLock(p));
-    std::ofstream file(p, std::ios::trunc | std::ios::binary);
-    msgpack::pack(file, conversationsRequests);
+    JournalStore::write(journalPath(path / "convRequests"), packValues(conversationsRequests));
 }
 
 void
@@ -1807,9 +2734,7 @@ ConversationModule::saveConvInfos(const std::string& accountId, const ConvInfoMa
 void
 ConversationModule::saveConvInfosToPath(const std::filesystem::path& path, const ConvInfoMap& conversations)
 {
-    std::lock_guard lock(dhtnet::fileutils::getFileLock(path / "convInfo"));
-    std::ofstream file(path / "convInfo", std::ios::trunc | std::ios::binary);
-    msgpack::pack(file, conversations);
+    JournalStore::write(journalPath(path / "convInfo"), packValues(conversations));
 }
 
 ////////////////////////////////////////////////////////////////
@@ -1833,6 +2758,7 @@ ConversationModule::ConversationModule(std::shared_ptr<JamiAccount> account,
     if (autoLoadConversations) {
         loadConversations();
     }
+    pimpl_->scheduleMaintenance(MAINTENANCE_START_DELAY);
 }
 
 void
@@ -1855,6 +2781,16 @@ ConversationModule::onFetchCompleted(const std::function<void(const std::string&
 {
     pimpl_->fetchCompletedCbTest_ = cb;
 }
+void
+ConversationModule::onManifestSaved(const std::function<void()>& cb)
+{
+    pimpl_->manifestSavedCbTest_ = cb;
+}
+void
+ConversationModule::onAnnouncementSent(const std::function<void(const std::string&, const std::string&)>& cb)
+{
+    pimpl_->announcementSentCbTest_ = cb;
+}
 #endif
 
 void
@@ -1870,8 +2806,17 @@ ConversationModule::loadConversations()
     auto contacts = pimpl_->accountManager_->getContacts(
         true); // Avoid to lock configurationMtx while conv Mtx is locked
     std::unique_lock ilk(pimpl_->convInfosMtx_);
-    pimpl_->convInfos_ = convInfos(pimpl_->accountId_);
+    pimpl_->loadConvInfos();
     pimpl_->conversations_.clear();
+    // Changes not written yet are more recent than the file
+    if (pimpl_->manifestSaveScheduled_)
+        pimpl_->saveManifest();
+    pimpl_->loadManifest();
+    std::map<std::string, ConvSummary> manifest;
+    {
+        std::lock_guard lkManifest(pimpl_->manifestMtx_);
+        manifest = pimpl_->manifest_;
+    }
 
     struct Ctx
     {
@@ -1904,64 +2849,77 @@ ConversationModule::loadConversations()
     ctx->convNb = 0;
     ctx->contacts = std::move(contacts);
 
+    // NOTE: This is here to protect against any incorrect state that can be introduced.
+    // Return false if the conversation must be ignored.
+    auto checkOneToOne = [ctx](const std::string& repository,
+                               ConversationMode mode,
+                               const std::set<std::string>& members) {
+        if (mode != ConversationMode::ONE_TO_ONE || members.size() != 1)
+            return true;
+        // If we got a 1:1 conversation, but not in the contact details, it's rather a
+        // duplicate or a weird state
+        auto otherUri = *members.begin();
+        auto itContact = ctx->contacts.find(dht::InfoHash(otherUri));
+        if (itContact == ctx->contacts.end()) {
+            JAMI_WARNING("Contact {} not found", otherUri);
+            return false;
+        }
+        const std::string& convFromDetails = itContact->second.conversationId;
+        auto isRemoved = !itContact->second.isActive();
+        if (convFromDetails != repository) {
+            if (convFromDetails.empty()) {
+                if (isRemoved) {
+                    // If details is empty, contact is removed and not banned.
+                    JAMI_ERROR("Conversation {} detected for {} and should be removed", repository, otherUri);
+                    std::lock_guard lkMtx {ctx->toRmMtx};
+                    ctx->toRm.insert(repository);
+                } else {
+                    JAMI_ERROR("No conversation detected for {} but one exists ({}). Update details",
+                               otherUri,
+                               repository);
+                    std::lock_guard lkMtx {ctx->toRmMtx};
+                    ctx->updateContactConv.emplace_back(std::make_tuple(otherUri, convFromDetails, repository));
+                }
+            }
+        }
+        return true;
+    };
+
     std::error_code ec;
     for (const auto& convIt : std::filesystem::directory_iterator(conversationPath, ec)) {
         // ignore if not regular file or hidden
         auto name = convIt.path().filename().string();
         if (!convIt.is_directory() || name[0] == '.')
             continue;
+        {
+            // Conversations summarized in the manifest are opened on first use. Those with
+            // work to do at startup (removal, calls hosted when the daemon stopped) and
+            // documents are loaded now, as are the ones missing from the manifest.
+            std::lock_guard lkMtx {ctx->convMtx};
+            auto summary = manifest.find(name);
+            auto convInfo = pimpl_->convInfos_.find(name);
+            if (summary != manifest.end() && convInfo != pimpl_->convInfos_.end() && !convInfo->second.isRemoved()
+                && summary->second.mode != ConversationMode::DOCUMENT
+                && !hasHostedCalls(fileutils::get_data_dir() / pimpl_->accountId_ / "conversation_data" / name)) {
+                if (!checkOneToOne(name, summary->second.mode, summary->second.members))
+                    continue;
+                auto sconv = std::make_shared<SyncedConversation>(convInfo->second);
+                sconv->unloaded = true;
+                sconv->info.members = summary->second.members;
+                sconv->info.members.emplace(acc->getUsername());
+                convInfo->second = sconv->info;
+                pimpl_->conversations_.emplace(name, std::move(sconv));
+                continue;
+            }
+        }
         dht::ThreadPool::io().run(
-            [this, ctx, repository = std::move(name), acc, _ = std::make_shared<PendingConvCounter>(ctx)] {
+            [this, ctx, checkOneToOne, repository = std::move(name), acc, _ = std::make_shared<PendingConvCounter>(ctx)] {
                 try {
                     auto sconv = std::make_shared<SyncedConversation>(repository);
-                    auto conv = std::make_shared<Conversation>(acc, repository);
-                    conv->onMessageStatusChanged([this, repository](const auto& status) {
-                        auto msg = std::make_shared<SyncMsg>();
-                        msg->ms = {{repository, status}};
-                        pimpl_->needsSyncingCb_(std::move(msg));
-                    });
-                    conv->onMembersChanged([w = pimpl_->weak_from_this(), repository](const auto& members) {
-                        // Delay in another thread to avoid deadlocks
-                        dht::ThreadPool::io().run([w, repository, members = std::move(members)] {
-                            if (auto sthis = w.lock())
-                                sthis->setConversationMembers(repository, members);
-                        });
-                    });
-                    conv->onNeedSocket(pimpl_->onNeedSwarmSocket_);
+                    auto conv = pimpl_->openConversation(acc, repository);
                     auto members = conv->memberUris(acc->getUsername(), {});
-                    // NOTE: The following if is here to protect against any incorrect state
-                    // that can be introduced
-                    if (conv->mode() == ConversationMode::ONE_TO_ONE && members.size() == 1) {
-                        // If we got a 1:1 conversation, but not in the contact details, it's rather a
-                        // duplicate or a weird state
-                        auto otherUri = *members.begin();
-                        auto itContact = ctx->contacts.find(dht::InfoHash(otherUri));
-                        if (itContact == ctx->contacts.end()) {
-                            JAMI_WARNING("Contact {} not found", otherUri);
-                            return;
-                        }
-                        const std::string& convFromDetails = itContact->second.conversationId;
-                        auto isRemoved = !itContact->second.isActive();
-                        if (convFromDetails != repository) {
-                            if (convFromDetails.empty()) {
-                                if (isRemoved) {
-                                    // If details is empty, contact is removed and not banned.
-                                    JAMI_ERROR("Conversation {} detected for {} and should be removed",
-                                               repository,
-                                               otherUri);
-                                    std::lock_guard lkMtx {ctx->toRmMtx};
-                                    ctx->toRm.insert(repository);
-                                } else {
-                                    JAMI_ERROR("No conversation detected for {} but one exists ({}). Update details",
-                                               otherUri,
-                                               repository);
-                                    std::lock_guard lkMtx {ctx->toRmMtx};
-                                    ctx->updateContactConv.emplace_back(
-                                        std::make_tuple(otherUri, convFromDetails, repository));
-                                }
-                            }
-                        }
-                    }
+                    if (!checkOneToOne(repository, conv->mode(), members))
+                        return;
                     {
                         std::lock_guard lkMtx {ctx->convMtx};
                         auto convInfo = pimpl_->convInfos_.find(repository);
@@ -1996,6 +2954,7 @@ ConversationModule::loadConversations()
                         // Notify other in the conversation that the call is finished
                         pimpl_->sendMessageNotification(*conv, true, *commits.rbegin());
                     }
+                    pimpl_->updateSummary(*conv);
                     sconv->conversation = conv;
                     std::lock_guard lkMtx {ctx->convMtx};
                     pimpl_->conversations_.emplace(repository, std::move(sconv));
@@ -2041,11 +3000,20 @@ ConversationModule::loadConversations()
         }
         ++itInfo;
     }
+    {
+        std::lock_guard lkManifest(pimpl_->manifestMtx_);
+        auto pruned = std::erase_if(pimpl_->manifest_, [&](const auto& summary) {
+            return pimpl_->conversations_.find(summary.first) == pimpl_->conversations_.end();
+        });
+        if (pruned)
+            pimpl_->scheduleManifestSave();
+    }
     // On oldest version, removeConversation didn't update "appdata/contacts"
     // causing a potential incorrect state between "appdata/contacts" and "appdata/convInfos"
     if (!removed.empty())
         acc->unlinkConversations(removed);
 
+    std::set<std::string> addedInfos;
     for (const auto& [contactId, contact] : ctx->contacts) {
         if (contact.conversationId.empty())
             continue;
@@ -2060,9 +3028,11 @@ ConversationModule::loadConversations()
         newInfo.members.emplace(contactId.toString());
         pimpl_->conversations_.emplace(contact.conversationId, std::make_shared<SyncedConversation>(newInfo));
         pimpl_->convInfos_.emplace(contact.conversationId, std::move(newInfo));
+        addedInfos.emplace(contact.conversationId);
     }
 
-    pimpl_->saveConvInfos();
+    if (!addedInfos.empty())
+        pimpl_->saveConvInfos(addedInfos);
 
     ilk.unlock();
     lk.unlock();
@@ -2086,7 +3056,7 @@ ConversationModule::loadSingleConversation(const std::string& convId)
     std::unique_lock lk(pimpl_->conversationsMtx_);
     std::unique_lock ilk(pimpl_->convInfosMtx_);
     // Load convInfos to retrieve requests that have been accepted but not yet synchronized.
-    pimpl_->convInfos_ = convInfos(pimpl_->accountId_);
+    pimpl_->loadConvInfos();
     pimpl_->conversations_.clear();
 
     try {
@@ -2169,7 +3139,7 @@ ConversationModule::clearPendingFetch()
 void
 ConversationModule::reloadRequests()
 {
-    pimpl_->conversationsRequests_ = convRequests(pimpl_->accountId_);
+    pimpl_->loadConvRequests();
 }
 
 std::vector<std::string>
@@ -2353,7 +3323,7 @@ ConversationModule::onNeedConversationRequest(const std::string& from, const std
         // convInfosMtx_ must not be taken while conv->mtx is held.
         std::lock_guard lkInfos(pimpl_->convInfosMtx_);
         pimpl_->convInfos_[conversationId] = std::move(info);
-        pimpl_->saveConvInfos();
+        pimpl_->saveConvInfos({conversationId});
     }
     pimpl_->sendMsgCb_(from, {}, std::move(invite), 0);
 }
@@ -2392,7 +3362,7 @@ ConversationModule::declineConversationRequest(const std::string& conversationId
     auto it = pimpl_->conversationsRequests_.find(conversationId);
     if (it != pimpl_->conversationsRequests_.end()) {
         it->second.declined = nowMs();
-        pimpl_->saveConvRequests();
+        pimpl_->saveConvRequests({conversationId});
     }
     pimpl_->syncingMetadatas_.erase(conversationId);
     pimpl_->saveMetadata();
@@ -2451,6 +3421,7 @@ ConversationModule::startConversation(ConversationMode mode, const dht::InfoHash
     conv->conversation = conversation;
     addConvInfo(conv->info);
     lk.unlock();
+    pimpl_->updateSummary(*conversation);
 
     pimpl_->needsSyncingCb_({});
     emitSignal<libjami::ConversationSignal::ConversationReady>(pimpl_->accountId_, convId);
@@ -2564,6 +3535,47 @@ ConversationModule::addDocumentAttachment(const std::string& documentId, const s
     return attachmentId;
 }
 
+bool
+ConversationModule::addDocumentUpdate(const std::string& documentId, const std::vector<uint8_t>& update)
+{
+    auto conv = pimpl_->getConversation(documentId);
+    if (!conv)
+        return false;
+    std::shared_ptr<Conversation> conversation;
+    {
+        std::lock_guard lk(conv->mtx);
+        conversation = conv->conversation;
+    }
+    if (!conversation || conversation->mode() != ConversationMode::DOCUMENT)
+        return false;
+    auto [updateId, commitId] = conversation->addDocumentUpdate(update);
+    if (!commitId.empty())
+        pimpl_->sendMessageNotification(documentId, true, commitId);
+    return !updateId.empty();
+}
+
+bool
+ConversationModule::addDocumentSnapshot(const std::string& documentId,
+                                        const DocumentSnapshot& snapshot,
+                                        const std::string& parentId)
+{
+    auto conv = pimpl_->getConversation(documentId);
+    if (!conv)
+        return false;
+    std::shared_ptr<Conversation> conversation;
+    {
+        std::lock_guard lk(conv->mtx);
+        conversation = conv->conversation;
+    }
+    if (!conversation || conversation->mode() != ConversationMode::DOCUMENT)
+        return false;
+    auto commitId = conversation->addDocumentSnapshot(snapshot, parentId);
+    if (commitId.empty())
+        return false;
+    pimpl_->sendMessageNotification(documentId, true, commitId);
+    return true;
+}
+
 void
 ConversationModule::cloneConversationFrom(const std::string& conversationId, const std::string& uri)
 {
@@ -2746,8 +3758,10 @@ ConversationModule::onFileChannelRequest(const std::string& conversationId,
                          fileId);
             return false;
         }
-        // Check that our file is correct before sending
-        if (verifyShaSum && sha3sum != fileutils::sha3File(path)) {
+        // Check that our file is correct before sending. Always for a stored
+        // file, which is written to by every account that received it.
+        if ((verifyShaSum || FileStore::instance().stores(path))
+            && sha3sum != FileDigestCache::instance().sha3(path)) {
             JAMI_WARNING("[Account {:s}] [Conversation {}] {:s} asked for file {:s}, but our version is not "
                          "complete or corrupted",
                          pimpl_->accountId_,
@@ -2787,6 +3801,10 @@ ConversationModule::syncConversations(const std::string& peer, const std::string
             if (!conv->conversation->isRemoving() && conv->conversation->isMember(peer, false)) {
                 toFetch.emplace(conv->info.id);
             }
+        } else if (conv->unloaded) {
+            // Loaded by the fetch, which gets the commits missed while offline
+            if (!conv->info.isRemoved() && conv->info.members.find(peer) != conv->info.members.end())
+                toFetch.emplace(conv->info.id);
         } else if (!conv->info.isRemoved()
                    && std::find(conv->info.members.begin(), conv->info.members.end(), peer)
                           != conv->info.members.end()) {
@@ -3002,6 +4020,8 @@ ConversationModule::needsSyncingWith(const std::string& memberUri) const
     std::lock_guard lk(pimpl_->conversationsMtx_);
     for (const auto& [key, ci] : pimpl_->conversations_) {
         std::lock_guard lk(ci->mtx);
+        if (ci->unloaded)
+            continue;
         if (ci->conversation) {
             if (ci->conversation->isRemoving() && ci->conversation->isMember(memberUri, false))
                 return true;
@@ -3066,7 +4086,7 @@ ConversationModule::addConversationMember(const std::string& conversationId,
         {
             std::lock_guard lkInfos(pimpl_->convInfosMtx_);
             pimpl_->convInfos_[conversationId] = std::move(info);
-            pimpl_->saveConvInfos();
+            pimpl_->saveConvInfos({conversationId});
         }
         pimpl_->sendMsgCb_(contactUriStr, {}, std::move(invite), 0);
         return;
@@ -3090,7 +4110,7 @@ ConversationModule::addConversationMember(const std::string& conversationId,
                                               {
                                                   std::lock_guard lkInfos(pimpl_->convInfosMtx_);
                                                   pimpl_->convInfos_[conversationId] = std::move(info);
-                                                  pimpl_->saveConvInfos();
+                                                  pimpl_->saveConvInfos({conversationId});
                                               }
                                               pimpl_->sendMsgCb_(contactUriStr, {}, std::move(invite), 0);
                                           }
@@ -3187,7 +4207,11 @@ ConversationModule::conversationInfos(const std::string& conversationId) const
         if (itReq != pimpl_->conversationsRequests_.end())
             return itReq->second.metadatas;
     }
-    if (auto conv = pimpl_->getConversation(conversationId)) {
+    if (auto conv = pimpl_->findConversation(conversationId)) {
+        auto infos = pimpl_->unloadedInfos(*conv);
+        if (!infos.empty())
+            return infos;
+        pimpl_->loadConversation(conv);
         std::lock_guard lk(conv->mtx);
         std::map<std::string, std::string> md;
         {
@@ -3384,19 +4408,19 @@ ConversationModule::removeContact(const std::string& uri, bool banned)
     // Remove linked conversation's requests
     {
         std::lock_guard lk(pimpl_->conversationsRequestsMtx_);
-        auto update = false;
+        std::set<std::string> declined;
         for (auto it = pimpl_->conversationsRequests_.begin(); it != pimpl_->conversationsRequests_.end(); ++it) {
             if (it->second.from == uri && it->second.declined == TimePoint {}) {
                 JAMI_DEBUG("Declining conversation request {:s} from {:s}", it->first, uri);
                 pimpl_->syncingMetadatas_.erase(it->first);
                 pimpl_->saveMetadata();
                 emitSignal<libjami::ConversationSignal::ConversationRequestDeclined>(pimpl_->accountId_, it->first);
-                update = true;
+                declined.emplace(it->first);
                 it->second.declined = nowMs();
             }
         }
-        if (update) {
-            pimpl_->saveConvRequests();
+        if (!declined.empty()) {
+            pimpl_->saveConvRequests(declined);
             pimpl_->needsSyncingCb_({});
         }
     }
@@ -3441,6 +4465,10 @@ ConversationModule::removeContact(const std::string& uri, bool banned)
                 } catch (const std::exception& e) {
                     JAMI_WARNING("{}", e.what());
                 }
+            } else if (conv->unloaded) {
+                // Removed once loaded
+                if (conv->info.mode == ConversationMode::ONE_TO_ONE && removeConvInfo(conv, conv->info.members))
+                    toRm.emplace_back(convId);
             } else {
                 removeConvInfo(conv, conv->info.members);
             }
@@ -3562,10 +4590,22 @@ std::string
 ConversationModule::findMatchingOneToOneConversation(const std::string& excludedConversationId,
                                                      const std::set<std::string>& targetUris) const
 {
-    std::lock_guard lk(pimpl_->conversationsMtx_);
-    for (const auto& [otherConvId, otherConvPtr] : pimpl_->conversations_) {
-        if (otherConvId == excludedConversationId)
-            continue;
+    // One-to-one conversations are loaded to be compared, outside of conversationsMtx_
+    std::vector<std::pair<std::string, std::shared_ptr<SyncedConversation>>> conversations;
+    {
+        std::lock_guard lk(pimpl_->conversationsMtx_);
+        conversations.reserve(pimpl_->conversations_.size());
+        for (const auto& [otherConvId, otherConvPtr] : pimpl_->conversations_) {
+            if (otherConvId == excludedConversationId)
+                continue;
+            if (otherConvPtr->unloaded && otherConvPtr->info.mode == ConversationMode::ONE_TO_ONE)
+                pimpl_->useConversation(*otherConvPtr);
+            conversations.emplace_back(otherConvId, otherConvPtr);
+        }
+    }
+    for (const auto& [otherConvId, otherConvPtr] : conversations) {
+        if (otherConvPtr->info.mode == ConversationMode::ONE_TO_ONE)
+            pimpl_->loadConversation(otherConvPtr);
 
         std::lock_guard lk(otherConvPtr->mtx);
         if (!otherConvPtr->conversation || otherConvPtr->conversation->mode() != ConversationMode::ONE_TO_ONE)
@@ -3821,19 +4861,7 @@ ConversationModule::convInfos(const std::string& accountId)
 std::map<std::string, ConvInfo>
 ConversationModule::convInfosFromPath(const std::filesystem::path& path)
 {
-    std::map<std::string, ConvInfo> convInfos;
-    try {
-        // read file
-        std::lock_guard lock(dhtnet::fileutils::getFileLock(path / "convInfo"));
-        auto file = fileutils::loadFile("convInfo", path);
-        // load values
-        msgpack::unpacked result;
-        msgpack::unpack(result, (const char*) file.data(), file.size());
-        result.get().convert(convInfos);
-    } catch (const std::exception& e) {
-        JAMI_WARNING("[convInfo] error loading convInfo: {}", e.what());
-    }
-    return convInfos;
+    return readValues<ConvInfo>(path / "convInfo");
 }
 
 std::map<std::string, ConversationRequest>
@@ -3845,19 +4873,7 @@ ConversationModule::convRequests(const std::string& accountId)
 std::map<std::string, ConversationRequest>
 ConversationModule::convRequestsFromPath(const std::filesystem::path& path)
 {
-    std::map<std::string, ConversationRequest> convRequests;
-    try {
-        // read file
-        std::lock_guard lock(dhtnet::fileutils::getFileLock(path / "convRequests"));
-        auto file = fileutils::loadFile("convRequests", path);
-        // load values
-        msgpack::unpacked result;
-        msgpack::unpack(result, (const char*) file.data(), file.size(), 0);
-        result.get().convert(convRequests);
-    } catch (const std::exception& e) {
-        JAMI_WARNING("[convInfo] error loading convInfo: {}", e.what());
-    }
-    return convRequests;
+    return readValues<ConversationRequest>(path / "convRequests");
 }
 
 void
@@ -3869,11 +4885,15 @@ ConversationModule::addConvInfo(const ConvInfo& info)
 void
 ConversationModule::Impl::setConversationMembers(const std::string& convId, const std::set<std::string>& members)
 {
+    std::shared_ptr<Conversation> conversation;
     if (auto conv = getConversation(convId)) {
         std::lock_guard lk(conv->mtx);
         conv->info.members = members;
         addConvInfo(conv->info);
+        conversation = conv->conversation;
     }
+    if (conversation)
+        updateSummary(*conversation);
 }
 
 std::shared_ptr<Conversation>
@@ -3886,6 +4906,30 @@ ConversationModule::getConversation(const std::string& convId)
     return nullptr;
 }
 
+bool
+ConversationModule::isConversationLoaded(const std::string& convId) const
+{
+    if (auto conv = pimpl_->findConversation(convId)) {
+        std::lock_guard lk(conv->mtx);
+        return conv->conversation != nullptr;
+    }
+    return false;
+}
+
+std::map<std::string, std::string>
+ConversationModule::conversationSummary(const std::string& convId) const
+{
+    std::lock_guard lk(pimpl_->manifestMtx_);
+    auto it = pimpl_->manifest_.find(convId);
+    if (it == pimpl_->manifest_.end())
+        return {};
+    const auto& summary = it->second;
+    return {{ConversationMapKeys::MODE, std::to_string(static_cast<int>(summary.mode))},
+            {"lastMessageId", summary.lastMessageId},
+            {"lastMessageTimestamp", std::to_string(summary.lastMessageTimestamp)},
+            {"infosHash", summary.infosHash}};
+}
+
 std::shared_ptr<dhtnet::ChannelSocket>
 ConversationModule::gitSocket(std::string_view deviceId, std::string_view convId) const
 {
@@ -3907,9 +4951,17 @@ ConversationModule::removeGitSocket(std::string_view deviceId,
     pimpl_->withConversation(convId, [&](auto& conv) { conv.removeGitSocket(DeviceId(deviceId), expected); });
 }
 
+std::map<std::string, std::string>
+ConversationModule::maintenanceStats() const
+{
+    return pimpl_->maintenanceStats();
+}
+
 void
 ConversationModule::shutdownConnections()
 {
+    // Hand queued announcements to the message engine, which keeps them across restarts
+    pimpl_->flushAnnouncements();
     for (const auto& c : pimpl_->getSyncedConversations()) {
         std::lock_guard lkc(c->mtx);
         if (c->conversation)
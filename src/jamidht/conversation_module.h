@@ -105,6 +105,8 @@ public:
 #ifdef LIBJAMI_TEST
     void onBootstrapStatus(const std::function<void(std::string, Conversation::BootstrapStatus)>& cb);
     void onFetchCompleted(const std::function<void(const std::string&, const std::string&, bool)>& cb);
+    void onManifestSaved(const std::function<void()>& cb);
+    void onAnnouncementSent(const std::function<void(const std::string&, const std::string&)>& cb);
 #endif
 
     void monitor();
@@ -258,6 +260,27 @@ public:
      */
     std::string addDocumentAttachment(const std::string& documentId, const std::vector<uint8_t>& data);
 
+    /**
+     * Checkpoint a batch of updates of a held collaborative document, merged
+     * into a single update, and notify the swarm of the commit that carries it.
+     * @param documentId  the document's repository id
+     * @param update      the merged update
+     * @return true if the batch is stored, whether or not it took a new commit
+     */
+    bool addDocumentUpdate(const std::string& documentId, const std::vector<uint8_t>& update);
+
+    /**
+     * Store a snapshot of a held collaborative document's merged state and
+     * notify the swarm of the commit that carries it.
+     * @param documentId  the document's repository id
+     * @param snapshot    the state and its state vector
+     * @param parentId    the commit the state was rebuilt at
+     * @return true if a snapshot was committed
+     */
+    bool addDocumentSnapshot(const std::string& documentId,
+                             const DocumentSnapshot& snapshot,
+                             const std::string& parentId);
+
     void createCommit(const std::string& conversationId,
                       CommitMessage&& commitMessage,
                       bool announce = true,
@@ -541,6 +564,8 @@ public:
                         const std::vector<libjami::MediaMap>& mediaList = {});
 
     // The following methods modify what is stored on the disk
+    // convInfo and convRequests are written as journals, that versions before
+    // 16.0.0 are unable to read: the migration of their files is one-way
     static void saveConvInfos(const std::string& accountId, const std::map<std::string, ConvInfo>& conversations);
     static void saveConvInfosToPath(const std::filesystem::path& path,
                                     const std::map<std::string, ConvInfo>& conversations);
@@ -556,10 +581,20 @@ public:
     void addConvInfo(const ConvInfo& info);
 
     /**
-     * Get a conversation
+     * Get a conversation, loading it if needed
      * @param convId
      */
     std::shared_ptr<Conversation> getConversation(const std::string& convId);
+    /**
+     * Conversations are loaded on first use
+     * @return true if the repository of the conversation is opened
+     */
+    bool isConversationLoaded(const std::string& convId) const;
+    /**
+     * What is known of a conversation without loading it
+     * @return mode, lastMessageId, lastMessageTimestamp and infosHash, empty if unknown
+     */
+    std::map<std::string, std::string> conversationSummary(const std::string& convId) const;
     /**
      * Return current git socket used for a conversation
      * @param deviceId          Related device
@@ -601,6 +636,13 @@ public:
      */
     std::shared_ptr<Typers> getTypers(const std::string& convId);
 
+    /**
+     * Statistics of the background maintenance of the repositories: number of
+     * repositories checked and maintained, objects packed and pruned, packs
+     * removed, bytes reclaimed, and the objects of the repositories checked
+     */
+    std::map<std::string, std::string> maintenanceStats() const;
+
 private:
     class Impl;
     std::shared_ptr<Impl> pimpl_;
@@ -16,6 +16,7 @@
  */
 
 #include "conversationrepository.h"
+#include "commit_index.h"
 
 #include "account_const.h"
 #include "base64.h"
@@ -43,7 +44,11 @@
 #include <git2/merge.h>
 #include <git2/diff.h>
 
+#include <opendht/thread_pool.h>
+
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <iterator>
 #include <ctime>
 #include <fstream>
@@ -51,14 +56,24 @@
 #include <json/json.h>
 #include <regex>
 #include <exception>
+#include <shared_mutex>
 #include <optional>
 #include <memory>
 #include <cstdint>
+#include <thread>
 #include <utility>
 
 using namespace std::string_view_literals;
 constexpr auto DIFF_REGEX = " +\\| +[0-9]+.*"sv;
 constexpr size_t MAX_FETCH_SIZE {256 * 1024 * 1024}; // 256Mb
+// Commits followed from HEAD to find the indexed head before rebuilding the commit index
+constexpr size_t MAX_INCREMENTAL_INDEX {256};
+// Commit ids copied from the commit index at once when walking it
+constexpr size_t INDEX_CHUNK {64};
+// Parsed certificates kept by blob id, the cache is emptied when full
+constexpr size_t MAX_CACHED_CERTIFICATES {256};
+// Below this many commits to validate, signatures are checked on the calling thread
+constexpr size_t MIN_PARALLEL_SIGNATURES {16};
 
 namespace jami {
 
@@ -89,6 +104,7 @@ public:
         , accountId_(account->getAccountID())
         , userId_(account->getUsername())
         , deviceId_(account->currentDeviceId())
+        , commitIndex_(fileutils::get_data_dir() / accountId_ / "conversation_data" / id_ / "commit_index")
     {
         conversationDataPath_ = fileutils::get_data_dir() / accountId_ / "conversation_data" / id_;
         membersCache_ = conversationDataPath_ / "members";
@@ -229,13 +245,47 @@ public:
                             const std::string& parentId) const;
     bool checkValidCheckpoint(const std::string& userDevice,
                               const std::string& commitId,
-                              const std::string& parentId) const;
+                              const std::string& parentId,
+                              const std::string& snapshotId,
+                              const std::string& updateId) const;
     bool checkVote(const std::string& userDevice, const std::string& commitId, const std::string& parentId) const;
     bool checkEdit(const std::string& userDevice, const ConversationCommit& commit) const;
     bool isValidUserAtCommit(const std::string& userDevice,
                              const std::string& commitId,
                              const git_buf& sig,
                              const git_buf& sig_data) const;
+
+    /**
+     * What is left to check for a commit once its author was found in the tree:
+     * the signature, the only expensive part.
+     */
+    struct SignatureCheck
+    {
+        std::string commitId;
+        std::string userDevice;
+        std::shared_ptr<dht::crypto::PublicKey> key;
+        std::vector<uint8_t> signature;
+        std::string signedData;
+        // Certificates to pin once the signature is verified
+        std::shared_ptr<dht::crypto::Certificate> deviceCert;
+        std::shared_ptr<dht::crypto::Certificate> parentCert;
+    };
+    /**
+     * Check that the device and its member are in the tree of commitId,
+     * with certificates valid at the commit time
+     */
+    std::optional<SignatureCheck> userAtCommit(const std::string& userDevice,
+                                               const std::string& commitId,
+                                               const git_buf& sig,
+                                               const git_buf& sig_data) const;
+    static bool checkSignature(const SignatureCheck& check);
+    /**
+     * Verify signatures, on the computation pool if there are many of them
+     * @return index of the first invalid signature, checks.size() if all are valid
+     */
+    size_t checkSignatures(std::vector<SignatureCheck>&& checks) const;
+    void pinSigner(const SignatureCheck& check) const;
+    std::shared_ptr<dht::crypto::Certificate> certificate(const GitObject& blob) const;
     bool checkInitialCommit(const std::string& userDevice,
                             const std::string& commitId,
                             const CommitMessage& commitMsg) const;
@@ -282,8 +332,23 @@ public:
                        PostConditionCb&& postCondition,
                        const std::string& from = "",
                        bool logIfNotFound = true) const;
+    bool forEachIndexedCommit(git_repository* repo,
+                              PreConditionCb& preCondition,
+                              std::function<void(ConversationCommit&&)>& emplaceCb,
+                              PostConditionCb& postCondition,
+                              const std::string& from) const;
     std::vector<ConversationCommit> log(const LogOptions& options) const;
 
+    /**
+     * Bring the commit index up to date with HEAD. Commits made on top of the
+     * indexed head are appended, any other change (merge, amend) rebuilds it
+     * from a single walk, reusing the entries already known.
+     * @note commitIndexMtx_ must be locked
+     * @return false if the index is unusable
+     */
+    bool syncCommitIndex(git_repository* repo) const;
+    CommitIndexEntry indexEntry(const git_commit* commit) const;
+
     GitObject fileAtTree(const std::string& path, const GitTree& tree) const;
     GitObject memberCertificate(std::string_view memberUri, const GitTree& tree) const;
     // NOTE! GitDiff needs to be deleted before repo
@@ -314,6 +379,14 @@ public:
     std::filesystem::path conversationDataPath_ {};
     std::filesystem::path membersCache_ {};
 
+    // Linearized history of main, loaded on first use
+    mutable std::mutex commitIndexMtx_ {};
+    mutable CommitIndex commitIndex_;
+
+    // Parsed certificates by blob id: most commits share the same few ones
+    mutable std::mutex certificatesMtx_ {};
+    mutable std::map<std::string, std::shared_ptr<dht::crypto::Certificate>> certificates_ {};
+
     std::map<std::string, std::vector<DeviceId>> devices(bool ignoreExpired = true) const
     {
         auto acc = account_.lock();
@@ -479,8 +552,7 @@ public:
             JAMI_ERROR("{} announced but not found", deviceId);
             return {};
         }
-        auto deviceCert = dht::crypto::Certificate(as_view(blob_device));
-        return deviceCert.getIssuerUID();
+        return certificate(blob_device)->getIssuerUID();
     }
 
     /**
@@ -542,6 +614,14 @@ public:
     }
 
     std::mutex opMtx_; // Mutex for operations
+    // A fetch rewrites .git/shallow with the roots it started with: fetches
+    // share it, a backfill takes it exclusively so that none undoes it
+    std::shared_mutex shallowMtx_;
+
+    std::vector<std::string> shallowRoots() const
+    {
+        return ConversationRepository::shallowRoots(fileutils::get_data_dir() / accountId_ / "conversations" / id_);
+    }
 };
 
 /////////////////////////////////////////////////////////////////////////////////
@@ -1109,15 +1189,20 @@ ConversationRepository::Impl::checkValidUserDiff(const std::string& userDevice,
 bool
 ConversationRepository::Impl::checkValidCheckpoint(const std::string& userDevice,
                                                    const std::string& commitId,
-                                                   const std::string& parentId) const
+                                                   const std::string& parentId,
+                                                   const std::string& snapshotId,
+                                                   const std::string& updateId) const
 {
-    // Checkpoints carry CRDT updates in the commit message and exist only in
-    // document repositories. The author's membership is verified afterwards by
-    // isValidUserAtCommit(), like for any other commit; what is checked here is
-    // that the tree is either untouched or only adds content-addressed
-    // attachments, so a checkpoint can never alter certificates or metadata.
-    // The one exception is the author's own device certificate, which is added
-    // alongside a device's first commit exactly as for any other commit type.
+    // Checkpoints carry CRDT updates and exist only in document repositories.
+    // The author's membership is verified afterwards by isValidUserAtCommit(),
+    // like for any other commit; what is checked here is that the tree is
+    // either untouched or only adds content-addressed attachments, so a
+    // checkpoint can never alter certificates or metadata. The one exception is
+    // the author's own device certificate, which is added alongside a device's
+    // first commit exactly as for any other commit type. A batch of updates or
+    // a snapshot also adds the blob it names and may drop the ones it
+    // supersedes: they are content-addressed too, and nothing but a rebuild
+    // ever reads them.
     if (mode() != ConversationMode::DOCUMENT) {
         JAMI_ERROR("Checkpoint commit {} in a non-document repository", commitId);
         return false;
@@ -1126,7 +1211,7 @@ ConversationRepository::Impl::checkValidCheckpoint(const std::string& userDevice
     if (!repo)
         return false;
     auto changedFiles = ConversationRepository::changedFiles(diffStats(commitId, parentId));
-    if (changedFiles.empty())
+    if (changedFiles.empty() && snapshotId.empty() && updateId.empty())
         return true;
     auto userUri = uriFromDevice(userDevice, commitId);
     if (userUri.empty())
@@ -1136,7 +1221,49 @@ ConversationRepository::Impl::checkValidCheckpoint(const std::string& userDevice
     auto treeOld = treeAtCommit(repo.get(), parentId);
     if (not treeNew or not treeOld)
         return false;
+    if (!snapshotId.empty()) {
+        // The state must travel with the commit: a snapshot naming a blob
+        // nobody fetched would make the document unreadable from there on.
+        auto blob = fileAtTree("snapshots/" + snapshotId, treeNew);
+        if (!blob || snapshotId != git_oid_tostr_s(git_object_id(blob.get()))) {
+            JAMI_ERROR("Snapshot {} missing from commit {}", snapshotId, commitId);
+            return false;
+        }
+    }
+    if (!updateId.empty()) {
+        auto blob = fileAtTree("updates/" + updateId, treeNew);
+        if (!blob || updateId != git_oid_tostr_s(git_object_id(blob.get()))) {
+            JAMI_ERROR("Update {} missing from commit {}", updateId, commitId);
+            return false;
+        }
+    }
     for (const auto& changedFile : changedFiles) {
+        if (changedFile.starts_with("updates/")) {
+            if (updateId.empty()) {
+                JAMI_ERROR("Update changed in non-update commit {}: {}", commitId, changedFile);
+                return false;
+            }
+            // Either the batch this commit names, checked above, or a previous
+            // one it drops from the tree.
+            if (changedFile != "updates/" + updateId && fileAtTree(changedFile, treeNew)) {
+                JAMI_ERROR("Unexpected update in commit {}: {}", commitId, changedFile);
+                return false;
+            }
+            continue;
+        }
+        if (changedFile.starts_with("snapshots/")) {
+            if (snapshotId.empty()) {
+                JAMI_ERROR("Snapshot changed in non-snapshot commit {}: {}", commitId, changedFile);
+                return false;
+            }
+            // Either the snapshot this commit names, checked above, or one it
+            // supersedes and drops from the tree.
+            if (changedFile != "snapshots/" + snapshotId && fileAtTree(changedFile, treeNew)) {
+                JAMI_ERROR("Unexpected snapshot in commit {}: {}", commitId, changedFile);
+                return false;
+            }
+            continue;
+        }
         if (changedFile.starts_with("attachments/")) {
             // The entry's name must be the git oid of its own content: two
             // admissible attachments sharing a name then necessarily hold the
@@ -1480,14 +1607,14 @@ ConversationRepository::Impl::checkValidJoins(const std::string& userDevice,
         JAMI_ERROR("{} announced but not found", deviceFile);
         return false;
     }
-    auto deviceCert = dht::crypto::Certificate(as_view(blob_device));
+    auto deviceCert = certificate(blob_device);
     auto blob_member = fileAtTree(membersFile, treeNew);
     if (!blob_member) {
         JAMI_ERROR("{} announced but not found", userDevice);
         return false;
     }
-    auto memberCert = dht::crypto::Certificate(as_view(blob_member));
-    if (memberCert.getId().toString() != deviceCert.getIssuerUID() || deviceCert.getIssuerUID() != uriMember) {
+    auto memberCert = certificate(blob_member);
+    if (memberCert->getId().toString() != deviceCert->getIssuerUID() || deviceCert->getIssuerUID() != uriMember) {
         JAMI_ERROR("Incorrect device certificate {} for user {}", userDevice, uriMember);
         return false;
     }
@@ -1542,8 +1669,7 @@ ConversationRepository::Impl::checkValidRemove(const std::string& userDevice,
             JAMI_ERROR("Device not found added ({})", deviceFile);
             return false;
         }
-        auto deviceCert = dht::crypto::Certificate(as_view(blob_device));
-        auto userUri = deviceCert.getIssuerUID();
+        auto userUri = certificate(blob_device)->getIssuerUID();
 
         if (uriMember != userUri and uriMember != deviceUri /* If device is removed */) {
             JAMI_ERROR("Device removed but not for removed user ({})", deviceFile);
@@ -1853,34 +1979,47 @@ ConversationRepository::Impl::isValidUserAtCommit(const std::string& userDevice,
                                                   const std::string& commitId,
                                                   const git_buf& sig,
                                                   const git_buf& sig_data) const
+{
+    auto check = userAtCommit(userDevice, commitId, sig, sig_data);
+    if (not check or not checkSignature(*check))
+        return false;
+    pinSigner(*check);
+    return true;
+}
+
+std::optional<ConversationRepository::Impl::SignatureCheck>
+ConversationRepository::Impl::userAtCommit(const std::string& userDevice,
+                                           const std::string& commitId,
+                                           const git_buf& sig,
+                                           const git_buf& sig_data) const
 {
     auto acc = account_.lock();
     if (!acc)
-        return false;
+        return std::nullopt;
     auto cert = acc->certStore().getCertificate(userDevice);
     auto hasPinnedCert = cert and cert->issuer;
     auto repo = repository();
     if (not repo)
-        return false;
+        return std::nullopt;
 
     // Retrieve tree for commit
     auto tree = treeAtCommit(repo.get(), commitId);
     if (not tree)
-        return false;
+        return std::nullopt;
 
     // Check that /devices/userDevice.crt exists
     std::string deviceFile = fmt::format("devices/{}.crt", userDevice);
     auto blob_device = fileAtTree(deviceFile, tree);
     if (!blob_device) {
         JAMI_ERROR("{} announced but not found", deviceFile);
-        return false;
+        return std::nullopt;
     }
-    auto deviceCert = dht::crypto::Certificate(as_view(blob_device));
-    auto userUri = deviceCert.getIssuerUID();
+    auto deviceCert = certificate(blob_device);
+    auto userUri = deviceCert->getIssuerUID();
     if (userUri.empty()) {
         JAMI_ERROR("{} got no issuer UID", deviceFile);
         if (not hasPinnedCert) {
-            return false;
+            return std::nullopt;
         } else {
             // HACK: JAMS device's certificate does not contains any issuer
             // So, getIssuerUID() will be empty here, so there is no way
@@ -1894,48 +2033,135 @@ ConversationRepository::Impl::isValidUserAtCommit(const std::string& userDevice,
     auto blob_parent = memberCertificate(userUri, tree);
     if (not blob_parent) {
         JAMI_ERROR("Certificate not found for {}", userUri);
-        return false;
+        return std::nullopt;
     }
 
     // Check that certificates were still valid
-    auto parentCert = dht::crypto::Certificate(as_view(blob_parent));
+    auto parentCert = certificate(blob_parent);
 
     git_oid oid;
     git_commit* commit_ptr = nullptr;
     if (git_oid_fromstr(&oid, commitId.c_str()) < 0 || git_commit_lookup(&commit_ptr, repo.get(), &oid) < 0) {
         JAMI_WARNING("Failed to look up commit {}", commitId);
-        return false;
+        return std::nullopt;
     }
     GitCommit commit {commit_ptr};
 
     auto commitTime = std::chrono::system_clock::from_time_t(git_commit_time(commit.get()));
-    if (deviceCert.getExpiration() < commitTime) {
-        JAMI_ERROR("Certificate {} expired", deviceCert.getId().toString());
-        return false;
+    if (deviceCert->getExpiration() < commitTime) {
+        JAMI_ERROR("Certificate {} expired", deviceCert->getId().toString());
+        return std::nullopt;
     }
-    if (parentCert.getExpiration() < commitTime) {
-        JAMI_ERROR("Certificate {} expired", parentCert.getId().toString());
-        return false;
+    if (parentCert->getExpiration() < commitTime) {
+        JAMI_ERROR("Certificate {} expired", parentCert->getId().toString());
+        return std::nullopt;
     }
+    if (parentCert->getId().toString() != userUri)
+        return std::nullopt;
 
+    SignatureCheck check;
+    check.commitId = git_oid_tostr_s(&oid);
+    check.userDevice = userDevice;
+    check.key = deviceCert->getSharedPublicKey();
+    check.signature = base64::decode(std::string_view(sig.ptr, sig.size));
+    check.signedData.assign(sig_data.ptr, sig_data.size);
+    if (not hasPinnedCert) {
+        check.deviceCert = std::move(deviceCert);
+        check.parentCert = std::move(parentCert);
+    }
+    return check;
+}
+
+bool
+ConversationRepository::Impl::checkSignature(const SignatureCheck& check)
+{
     //  Verify the signature (git verify-commit)
-    auto pk = base64::decode(std::string_view(sig.ptr, sig.size));
-    bool valid_signature = deviceCert.getPublicKey().checkSignature(reinterpret_cast<const uint8_t*>(sig_data.ptr),
-                                                                    sig_data.size,
-                                                                    pk.data(),
-                                                                    pk.size());
-
-    if (!valid_signature) {
-        JAMI_WARNING("Commit {} not signed by device {}.", git_oid_tostr_s(&oid), userDevice);
+    if (not check.key
+        or not check.key->checkSignature(reinterpret_cast<const uint8_t*>(check.signedData.data()),
+                                         check.signedData.size(),
+                                         check.signature.data(),
+                                         check.signature.size())) {
+        JAMI_WARNING("Commit {} not signed by device {}.", check.commitId, check.userDevice);
         return false;
     }
+    return true;
+}
+
+size_t
+ConversationRepository::Impl::checkSignatures(std::vector<SignatureCheck>&& checks) const
+{
+    if (checks.size() < MIN_PARALLEL_SIGNATURES) {
+        size_t count = 0;
+        while (count < checks.size() and checkSignature(checks[count]))
+            pinSigner(checks[count++]);
+        return count;
+    }
 
-    auto res = parentCert.getId().toString() == userUri;
-    if (res && not hasPinnedCert) {
-        acc->certStore().pinCertificate(std::move(deviceCert));
-        acc->certStore().pinCertificate(std::move(parentCert));
+    // Shared with the helpers, which may only start once everything is done
+    struct Batch
+    {
+        std::vector<SignatureCheck> checks;
+        std::vector<uint8_t> valid;
+        std::atomic_size_t next {0};
+        std::mutex mutex;
+        std::condition_variable cv;
+        size_t done {0};
+    };
+    auto batch = std::make_shared<Batch>();
+    batch->checks = std::move(checks);
+    batch->valid.resize(batch->checks.size());
+    auto work = [](Batch& b) {
+        size_t i;
+        while ((i = b.next++) < b.checks.size()) {
+            auto valid = checkSignature(b.checks[i]);
+            std::lock_guard lk(b.mutex);
+            b.valid[i] = valid;
+            if (++b.done == b.checks.size())
+                b.cv.notify_all();
+        }
+    };
+    auto helpers = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 2u) - 1,
+                                    batch->checks.size() / MIN_PARALLEL_SIGNATURES);
+    for (size_t i = 0; i < helpers; ++i)
+        dht::ThreadPool::computation().run([batch, work] { work(*batch); });
+    // Take part instead of only waiting: this thread may itself be one of the
+    // pool's, and it never waits for a check no one has started
+    work(*batch);
+    std::unique_lock lk(batch->mutex);
+    batch->cv.wait(lk, [&] { return batch->done == batch->checks.size(); });
+
+    auto invalid = std::find(batch->valid.begin(), batch->valid.end(), 0);
+    auto count = static_cast<size_t>(invalid - batch->valid.begin());
+    // Pin only what was verified, in history order
+    for (size_t i = 0; i < count; ++i)
+        pinSigner(batch->checks[i]);
+    return count;
+}
+
+void
+ConversationRepository::Impl::pinSigner(const SignatureCheck& check) const
+{
+    if (not check.deviceCert or not check.parentCert)
+        return;
+    if (auto acc = account_.lock()) {
+        acc->certStore().pinCertificate(check.deviceCert);
+        acc->certStore().pinCertificate(check.parentCert);
     }
-    return res;
+}
+
+std::shared_ptr<dht::crypto::Certificate>
+ConversationRepository::Impl::certificate(const GitObject& blob) const
+{
+    std::string key = git_oid_tostr_s(git_object_id(blob.get()));
+    std::lock_guard lk(certificatesMtx_);
+    auto it = certificates_.find(key);
+    if (it != certificates_.end())
+        return it->second;
+    if (certificates_.size() >= MAX_CACHED_CERTIFICATES)
+        certificates_.clear();
+    auto cert = std::make_shared<dht::crypto::Certificate>(as_view(blob));
+    certificates_.emplace(std::move(key), cert);
+    return cert;
 }
 
 bool
@@ -2205,7 +2431,14 @@ ConversationRepository::Impl::commit(const std::string& msg, bool verifyDevice)
     if (commit_str) {
         JAMI_LOG("[Account {}] [Conversation {}] New message added with id: {}", accountId_, id_, commit_str);
     }
-    return commit_str ? commit_str : "";
+    std::string commitId = commit_str ? commit_str : "";
+    {
+        // Only keep the index in sync if it is in use, otherwise it will be at first read
+        std::lock_guard lk(commitIndexMtx_);
+        if (commitIndex_.loaded())
+            syncCommitIndex(repo.get());
+    }
+    return commitId;
 }
 
 ConversationMode
@@ -2386,6 +2619,9 @@ ConversationRepository::Impl::forEachCommit(PreConditionCb&& preCondition,
         if (!isMergeBase) {
             // We're logging a non merged branch, so, take this one instead of HEAD
             oid = oidFrom;
+        } else if (forEachIndexedCommit(repo.get(), preCondition, emplaceCb, postCondition, from)) {
+            // Seeked in the commit index instead of skipping every commit from HEAD
+            return;
         }
     }
 
@@ -2427,6 +2663,152 @@ ConversationRepository::Impl::forEachCommit(PreConditionCb&& preCondition,
     }
 }
 
+bool
+ConversationRepository::Impl::forEachIndexedCommit(git_repository* repo,
+                                                   PreConditionCb& preCondition,
+                                                   std::function<void(ConversationCommit&&)>& emplaceCb,
+                                                   PostConditionCb& postCondition,
+                                                   const std::string& from) const
+{
+    size_t position = 0;
+    {
+        std::lock_guard lk(commitIndexMtx_);
+        if (not syncCommitIndex(repo))
+            return false;
+        auto fromPosition = commitIndex_.position(from);
+        if (not fromPosition)
+            return false;
+        position = *fromPosition;
+    }
+
+    std::string last;
+    while (true) {
+        std::vector<std::string> ids;
+        {
+            std::lock_guard lk(commitIndexMtx_);
+            // New commits shift positions, and a merge may have rebuilt the index
+            if (not last.empty() and (position > commitIndex_.size() or commitIndex_.at(position - 1).id != last)) {
+                auto lastPosition = commitIndex_.position(last);
+                if (not lastPosition)
+                    return true;
+                position = *lastPosition + 1;
+            }
+            ids = commitIndex_.ids(position, INDEX_CHUNK);
+        }
+        if (ids.empty())
+            return true;
+
+        for (const auto& id : ids) {
+            git_oid oid;
+            git_commit* commit_ptr = nullptr;
+            if (git_oid_fromstr(&oid, id.c_str()) < 0 or git_commit_lookup(&commit_ptr, repo, &oid) < 0) {
+                JAMI_WARNING("[Account {}] [Conversation {}] Failed to look up commit {}", accountId_, id_, id);
+                return true;
+            }
+            GitCommit commit {commit_ptr};
+
+            ConversationCommit cc = parseCommit(repo, commit.get());
+
+            auto result = preCondition(id, cc.author, commit);
+            if (result == CallbackResult::Skip)
+                continue;
+            else if (result == CallbackResult::Break)
+                return true;
+
+            auto post = postCondition(id, cc.author, cc);
+            emplaceCb(std::move(cc));
+
+            if (post)
+                return true;
+        }
+        position += ids.size();
+        last = ids.back();
+    }
+}
+
+CommitIndexEntry
+ConversationRepository::Impl::indexEntry(const git_commit* commit) const
+{
+    CommitIndexEntry entry;
+    entry.id = git_oid_tostr_s(git_commit_id(commit));
+    auto parentsCount = git_commit_parentcount(commit);
+    for (unsigned int p = 0; p < parentsCount; ++p) {
+        if (const git_oid* pid = git_commit_parent_id(commit, p))
+            entry.parents.emplace_back(git_oid_tostr_s(pid));
+    }
+    entry.timestamp = git_commit_time(commit);
+    if (const git_signature* sig = git_commit_author(commit))
+        entry.authorUri = uriFromDevice(sig->email, entry.id);
+    if (parentsCount > 1) {
+        entry.type = CommitType::MERGE;
+    } else if (auto commitMsg = CommitMessage::fromString(git_commit_message(commit))) {
+        entry.type = commitMsg->type;
+    }
+    return entry;
+}
+
+bool
+ConversationRepository::Impl::syncCommitIndex(git_repository* repo) const
+{
+    git_oid headOid;
+    if (git_reference_name_to_id(&headOid, repo, "HEAD") < 0)
+        return false;
+    std::string head = git_oid_tostr_s(&headOid);
+    commitIndex_.load();
+    auto indexedHead = commitIndex_.head();
+    if (head == indexedHead)
+        return true;
+
+    // Usual case: new commits on top of the indexed head, they come first in the linearized history
+    if (not indexedHead.empty()) {
+        std::vector<CommitIndexEntry> added;
+        git_oid oid = headOid;
+        while (added.size() < MAX_INCREMENTAL_INDEX) {
+            git_commit* commit_ptr = nullptr;
+            if (git_commit_lookup(&commit_ptr, repo, &oid) < 0)
+                break;
+            GitCommit commit {commit_ptr};
+            if (git_commit_parentcount(commit.get()) != 1)
+                break;
+            added.emplace_back(indexEntry(commit.get()));
+            oid = *git_commit_parent_id(commit.get(), 0);
+            if (indexedHead == git_oid_tostr_s(&oid)) {
+                std::reverse(added.begin(), added.end());
+                return commitIndex_.append(std::move(added));
+            }
+        }
+    }
+
+    // A merge may interleave commits anywhere in the linearized history, walk it again
+    git_revwalk* walker_ptr = nullptr;
+    if (git_revwalk_new(&walker_ptr, repo) < 0 || git_revwalk_push(walker_ptr, &headOid) < 0) {
+        GitRevWalker walker {walker_ptr};
+        return false;
+    }
+    GitRevWalker walker {walker_ptr};
+    git_revwalk_sorting(walker.get(), GIT_SORT_TOPOLOGICAL | GIT_SORT_TIME);
+
+    std::vector<CommitIndexEntry> entries;
+    entries.reserve(commitIndex_.size() + 1);
+    git_oid oid;
+    while (!git_revwalk_next(&oid, walker.get())) {
+        std::string id = git_oid_tostr_s(&oid);
+        if (const auto* known = commitIndex_.find(id)) {
+            entries.emplace_back(*known);
+            continue;
+        }
+        git_commit* commit_ptr = nullptr;
+        if (git_commit_lookup(&commit_ptr, repo, &oid) < 0) {
+            JAMI_WARNING("[Account {}] [Conversation {}] Failed to look up commit {}", accountId_, id_, id);
+            return false;
+        }
+        GitCommit commit {commit_ptr};
+        entries.emplace_back(indexEntry(commit.get()));
+    }
+    JAMI_DEBUG("[Account {}] [Conversation {}] Commit index rebuilt ({} commits)", accountId_, id_, entries.size());
+    return commitIndex_.reset(std::move(entries));
+}
+
 std::vector<ConversationCommit>
 ConversationRepository::Impl::log(const LogOptions& options) const
 {
@@ -2667,17 +3049,11 @@ ConversationRepository::Impl::convCommitToMap(const ConversationCommit& commit)
     std::string type {};
     if (parentsSize > 1)
         type = CommitType::MERGE;
-    std::string body {};
     std::map<std::string, std::string> message;
     if (type.empty()) {
-        Json::Value cm = commit.commitMsg.toJson();
-        for (auto const& id : cm.getMemberNames()) {
-            if (id == CommitKey::TYPE) {
-                type = cm[id].asString();
-                continue;
-            }
-            message.insert({id, cm[id].asString()});
-        }
+        message = commit.commitMsg.toMap();
+        type = commit.commitMsg.type;
+        message.erase(CommitKey::TYPE);
     }
     if (type.empty()) {
         return std::nullopt;
@@ -2759,19 +3135,6 @@ ConversationRepository::Impl::parseCommit(git_repository* repo, const git_commit
     }
     convCommit.parents = std::move(parents);
 
-    git_buf signature = {}, signed_data = {};
-    if (git_commit_extract_signature(&signature, &signed_data, repo, &oid, "signature") < 0) {
-        JAMI_WARNING("[Account {}] [Conversation {}] Unable to extract signature for commit {}",
-                     accountId_,
-                     id_,
-                     convCommit.id);
-    } else {
-        convCommit.signature = base64::decode(std::string_view(signature.ptr, signature.size));
-        convCommit.signed_content = std::vector<uint8_t>(signed_data.ptr, signed_data.ptr + signed_data.size);
-    }
-    git_buf_dispose(&signature);
-    git_buf_dispose(&signed_data);
-
     return convCommit;
 }
 
@@ -2850,10 +3213,30 @@ ConversationRepository::createRepository(const std::shared_ptr<JamiAccount>& acc
     return std::make_unique<ConversationRepository>(account, id);
 }
 
+/**
+ * Only fetch the depth last commits of the history. Done for peers reached
+ * through a git channel: they fall back to the whole history if they do not
+ * support it, while the local transport rejects it.
+ */
+static void
+setFetchDepth(git_fetch_options& opts, unsigned depth, std::string_view url)
+{
+    // Shallow fetches appeared in libgit2 1.7
+#if LIBGIT2_VER_MAJOR > 1 || (LIBGIT2_VER_MAJOR == 1 && LIBGIT2_VER_MINOR >= 7)
+    if (depth != 0 && url.starts_with("git://"))
+        opts.depth = static_cast<int>(std::min<unsigned>(depth, GIT_FETCH_DEPTH_UNSHALLOW));
+#else
+    (void) opts;
+    (void) depth;
+    (void) url;
+#endif
+}
+
 std::pair<std::unique_ptr<ConversationRepository>, std::vector<ConversationCommit>>
 ConversationRepository::cloneConversation(const std::shared_ptr<JamiAccount>& account,
                                           const std::string& deviceId,
-                                          const std::string& conversationId)
+                                          const std::string& conversationId,
+                                          bool shallow)
 {
     // Verify conversationId is not empty to avoid deleting the entire conversations directory
     if (conversationId.empty()) {
@@ -2901,6 +3284,8 @@ ConversationRepository::cloneConversation(const std::shared_ptr<JamiAccount>& ac
         }
         return 0;
     };
+    if (shallow)
+        setFetchDepth(opts.fetch_opts, SHALLOW_CLONE_DEPTH, url);
 
     JAMI_DEBUG("[Account {}] [Conversation {}] Start clone of {:s} to {} (staging {})",
                account->getAccountID(),
@@ -3012,6 +3397,37 @@ ConversationRepository::Impl::validCommits(const std::vector<ConversationCommit>
 {
     auto repo = repository();
 
+    // First check membership and structure rules, in order. Signatures, the
+    // expensive part, are checked afterwards, all at once.
+    std::vector<SignatureCheck> checks;
+    std::vector<std::pair<const ConversationCommit*, const char*>> checked;
+    checks.reserve(commitsToValidate.size());
+    checked.reserve(commitsToValidate.size());
+    auto shallowRoots = this->shallowRoots();
+    auto checkUser = [&](const ConversationCommit& commit,
+                         const std::string& userDevice,
+                         const std::string& validUserAtCommit,
+                         const git_buf& sig,
+                         const git_buf& sig_data,
+                         const char* error) {
+        auto check = userAtCommit(userDevice, validUserAtCommit, sig, sig_data);
+        if (not check) {
+            JAMI_WARNING("[Account {}] [Conversation {}] Malformed commit {}. Please ensure "
+                         "that you are using the latest "
+                         "version of Jami, or that one of your contacts is not performing any "
+                         "unwanted actions. {}",
+                         accountId_,
+                         id_,
+                         validUserAtCommit,
+                         commit.commitMsg.toString());
+            emitSignal<libjami::ConversationSignal::OnConversationError>(accountId_, id_, EVALIDFETCH, error);
+            return false;
+        }
+        checks.emplace_back(std::move(*check));
+        checked.emplace_back(&commit, error);
+        return true;
+    };
+
     for (const auto& commit : commitsToValidate) {
         auto userDevice = commit.author.email;
         auto validUserAtCommit = commit.id;
@@ -3046,7 +3462,16 @@ ConversationRepository::Impl::validCommits(const std::vector<ConversationCommit>
             return false;
         }
 
-        if (commit.parents.size() == 0) {
+        if (commit.parents.size() == 0 && commit.id != id_
+            && std::find(shallowRoots.begin(), shallowRoots.end(), commit.id) != shallowRoots.end()) {
+            // Oldest commit of a shallow history, its parents are not there yet. It
+            // is the checkpoint the rest is validated from, as long as it is signed
+            // by a member at this commit. Shallow clones are only requested from a
+            // trusted device, which vouches for that tree until backfill()
+            // validates it like any commit, once its parents are fetched.
+            if (!checkUser(commit, userDevice, validUserAtCommit, *sig, *sig_data, "Malformed shallow root"))
+                return false;
+        } else if (commit.parents.size() == 0) {
             if (!checkInitialCommit(userDevice, commit.id, commit.commitMsg)) {
                 JAMI_WARNING("[Account {}] [Conversation {}] Malformed initial commit {}. Please "
                              "ensure that you are using the latest "
@@ -3209,7 +3634,11 @@ ConversationRepository::Impl::validCommits(const std::vector<ConversationCommit>
                     return false;
                 }
             } else if (type == CommitType::CHECKPOINT) {
-                if (!checkValidCheckpoint(userDevice, commit.id, commit.parents[0])) {
+                if (!checkValidCheckpoint(userDevice,
+                                          commit.id,
+                                          commit.parents[0],
+                                          commit.commitMsg.snapshot,
+                                          commit.commitMsg.update)) {
                     JAMI_WARNING("[Account {}] [Conversation {}] Malformed checkpoint commit {}. "
                                  "Please ensure that you are using the latest "
                                  "version of Jami, or that one of your contacts is not performing "
@@ -3276,40 +3705,14 @@ ConversationRepository::Impl::validCommits(const std::vector<ConversationCommit>
             // For all commits, check that the user is valid.
             // So, the user certificate MUST be in /members or /admins
             // and device cert MUST be in /devices
-            if (!isValidUserAtCommit(userDevice, validUserAtCommit, *sig, *sig_data)) {
-                JAMI_WARNING("[Account {}] [Conversation {}] Malformed commit {}. Please ensure "
-                             "that you are using the latest "
-                             "version of Jami, or that one of your contacts is not performing any "
-                             "unwanted actions. {}",
-                             accountId_,
-                             id_,
-                             validUserAtCommit,
-                             commit.commitMsg.toString());
-                emitSignal<libjami::ConversationSignal::OnConversationError>(accountId_,
-                                                                             id_,
-                                                                             EVALIDFETCH,
-                                                                             "Invalid user");
+            if (!checkUser(commit, userDevice, validUserAtCommit, *sig, *sig_data, "Invalid user"))
                 return false;
-            }
         } else {
             // For all commits, check that the user is valid.
             // So, the user certificate MUST be in /members or /admins
             // and device cert MUST be in /devices
-            if (!isValidUserAtCommit(userDevice, validUserAtCommit, *sig, *sig_data)) {
-                JAMI_WARNING("[Account {}] [Conversation {}] Malformed commit {}.Please ensure "
-                             "that you are using the latest "
-                             "version of Jami, or that one of your contacts is not performing any "
-                             "unwanted actions. {}",
-                             accountId_,
-                             id_,
-                             validUserAtCommit,
-                             commit.commitMsg.toString());
-                emitSignal<libjami::ConversationSignal::OnConversationError>(accountId_,
-                                                                             id_,
-                                                                             EVALIDFETCH,
-                                                                             "Malformed commit");
+            if (!checkUser(commit, userDevice, validUserAtCommit, *sig, *sig_data, "Malformed commit"))
                 return false;
-            }
 
             if (!checkValidMergeCommit(commit.id, commit.parents)) {
                 JAMI_WARNING("[Account {}] [Conversation {}] Malformed merge commit {}. Please "
@@ -3329,6 +3732,22 @@ ConversationRepository::Impl::validCommits(const std::vector<ConversationCommit>
         }
         JAMI_DEBUG("[Account {}] [Conversation {}] Validate commit {}", accountId_, id_, commit.id);
     }
+
+    auto count = checks.size();
+    auto valid = checkSignatures(std::move(checks));
+    if (valid != count) {
+        const auto& [commit, error] = checked[valid];
+        JAMI_WARNING("[Account {}] [Conversation {}] Invalid signature for commit {}. Please ensure "
+                     "that you are using the latest "
+                     "version of Jami, or that one of your contacts is not performing any "
+                     "unwanted actions. {}",
+                     accountId_,
+                     id_,
+                     commit->id,
+                     commit->commitMsg.toString());
+        emitSignal<libjami::ConversationSignal::OnConversationError>(accountId_, id_, EVALIDFETCH, error);
+        return false;
+    }
     return true;
 }
 
@@ -3443,7 +3862,7 @@ ConversationRepository::amend(const std::string& id, const std::string& msg)
 }
 
 bool
-ConversationRepository::fetch(const std::string& remoteDeviceId)
+ConversationRepository::fetch(const std::string& remoteDeviceId, unsigned depth)
 {
     git_fetch_options fetch_opts;
     git_fetch_options_init(&fetch_opts, GIT_FETCH_OPTIONS_VERSION);
@@ -3492,6 +3911,10 @@ ConversationRepository::fetch(const std::string& remoteDeviceId)
         }
     }
     GitRemote remote {remote_ptr};
+    setFetchDepth(fetch_opts, depth, git_remote_url(remote.get()));
+    std::shared_lock lkShallow(pimpl_->shallowMtx_, std::defer_lock);
+    if (depth == 0)
+        lkShallow.lock(); // else backfill() holds it
 
     // From here on the fetch waits on the peer, and it does so without opMtx_.
     // What it writes - the object database and refs/remotes/<device> - is either
@@ -3707,6 +4130,52 @@ ConversationRepository::log(PreConditionCb&& preCondition,
     pimpl_->forEachCommit(std::move(preCondition), std::move(emplaceCb), std::move(postCondition), from, logIfNotFound);
 }
 
+std::optional<std::string>
+ConversationRepository::logSince(const std::string& since,
+                                 std::function<void(ConversationCommit&&)>&& emplaceCb,
+                                 const std::string& from) const
+{
+    auto repo = pimpl_->repository();
+    git_oid oid;
+    if (!repo)
+        return std::nullopt;
+    if (from.empty() ? git_reference_name_to_id(&oid, repo.get(), "HEAD") < 0
+                     : git_oid_fromstr(&oid, from.c_str()) < 0)
+        return std::nullopt;
+    std::string head = git_oid_tostr_s(&oid);
+
+    git_revwalk* walker_ptr = nullptr;
+    if (git_revwalk_new(&walker_ptr, repo.get()) < 0 || git_revwalk_push(walker_ptr, &oid) < 0) {
+        GitRevWalker walker {walker_ptr};
+        return std::nullopt;
+    }
+    GitRevWalker walker {walker_ptr};
+    if (!since.empty()) {
+        git_oid sinceOid;
+        git_commit* commit_ptr = nullptr;
+        if (git_oid_fromstr(&sinceOid, since.c_str()) < 0 || git_commit_lookup(&commit_ptr, repo.get(), &sinceOid) < 0)
+            return std::nullopt;
+        GitCommit sinceCommit {commit_ptr};
+        if (git_revwalk_hide(walker.get(), &sinceOid) < 0)
+            return std::nullopt;
+    }
+    git_revwalk_sorting(walker.get(), GIT_SORT_TOPOLOGICAL | GIT_SORT_TIME | GIT_SORT_REVERSE);
+
+    while (!git_revwalk_next(&oid, walker.get())) {
+        git_commit* commit_ptr = nullptr;
+        if (git_commit_lookup(&commit_ptr, repo.get(), &oid) < 0) {
+            JAMI_WARNING("[Account {}] [Conversation {}] Failed to look up commit {}",
+                         pimpl_->accountId_,
+                         pimpl_->id_,
+                         git_oid_tostr_s(&oid));
+            return std::nullopt;
+        }
+        GitCommit commit {commit_ptr};
+        emplaceCb(pimpl_->parseCommit(repo.get(), commit.get()));
+    }
+    return head;
+}
+
 bool
 ConversationRepository::hasCommit(const std::string& commitId) const
 {
@@ -3719,6 +4188,35 @@ ConversationRepository::getCommit(const std::string& commitId) const
     return pimpl_->getCommit(commitId);
 }
 
+std::optional<std::string>
+ConversationRepository::linearizedParent(const std::string& commitId) const
+{
+    auto repo = pimpl_->repository();
+    if (!repo)
+        return std::nullopt;
+    std::lock_guard lk(pimpl_->commitIndexMtx_);
+    if (not pimpl_->syncCommitIndex(repo.get()))
+        return std::nullopt;
+    return pimpl_->commitIndex_.linearizedParent(commitId);
+}
+
+std::map<std::string, std::string>
+ConversationRepository::linearizedParents(const std::vector<std::string>& commitIds) const
+{
+    std::map<std::string, std::string> parents;
+    auto repo = pimpl_->repository();
+    if (!repo)
+        return parents;
+    std::lock_guard lk(pimpl_->commitIndexMtx_);
+    if (not pimpl_->syncCommitIndex(repo.get()))
+        return parents;
+    for (const auto& commitId : commitIds) {
+        if (auto parent = pimpl_->commitIndex_.linearizedParent(commitId))
+            parents.emplace(commitId, std::move(*parent));
+    }
+    return parents;
+}
+
 std::pair<bool, std::string>
 ConversationRepository::merge(const std::string& merge_id, bool force)
 {
@@ -4023,6 +4521,8 @@ ConversationRepository::erase()
         JAMI_LOG("Erasing {}", repoPath);
         dhtnet::fileutils::removeAll(repoPath, true);
     }
+    std::lock_guard lk(pimpl_->commitIndexMtx_);
+    pimpl_->commitIndex_.clear();
 }
 
 ConversationMode
@@ -4142,6 +4642,136 @@ ConversationRepository::attachmentIds() const
     return ids;
 }
 
+std::string
+ConversationRepository::addSnapshot(const std::vector<uint8_t>& data, const std::string& parentId)
+{
+    if (data.empty())
+        return {};
+    if (mode() != ConversationMode::DOCUMENT) {
+        JAMI_ERROR("[Account {}] [Conversation {}] Refusing to snapshot a non-document repository",
+                   pimpl_->accountId_,
+                   pimpl_->id_);
+        return {};
+    }
+    std::lock_guard lkOp(pimpl_->opMtx_);
+    pimpl_->resetHard();
+    auto repo = pimpl_->repository();
+    if (!repo)
+        return {};
+    // A snapshot covers its parent's whole ancestry, and anything committed
+    // since the state was built would be skipped by every rebuild from it.
+    if (getHead() != parentId)
+        return {};
+
+    // Named after its own content, like an attachment, so that two devices
+    // snapshotting the same state converge to a single entry.
+    git_oid blobId;
+    if (git_blob_create_from_buffer(&blobId, repo.get(), data.data(), data.size()) < 0) {
+        JAMI_ERROR("[Account {}] [Conversation {}] Unable to store snapshot blob", pimpl_->accountId_, pimpl_->id_);
+        return {};
+    }
+    std::string id = git_oid_tostr_s(&blobId);
+
+    std::filesystem::path repoPath = git_repository_workdir(repo.get());
+    auto snapshotsPath = repoPath / "snapshots";
+    if (std::filesystem::is_regular_file(snapshotsPath / id))
+        return {}; // Nothing changed since the last snapshot
+    if (!dhtnet::fileutils::recursive_mkdir(snapshotsPath, 0700)) {
+        JAMI_ERROR("Error when creating {}", snapshotsPath);
+        return {};
+    }
+    // The superseded snapshots leave the tree, which would otherwise grow by a
+    // whole document each time. They stay readable through their own commits.
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(snapshotsPath, ec))
+        std::filesystem::remove(entry.path(), ec);
+    auto snapshotPath = snapshotsPath / id;
+    std::ofstream file(snapshotPath, std::ios::trunc | std::ios::binary);
+    if (!file.is_open()) {
+        JAMI_ERROR("Unable to write data to {}", snapshotPath);
+        return {};
+    }
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    file.close();
+
+    if (!git_add_all(repo.get()))
+        return {};
+    return pimpl_->commitMessage(CommitMessage::snapshotCheckpoint(id).toString());
+}
+
+std::string
+ConversationRepository::addUpdate(const std::vector<uint8_t>& data)
+{
+    if (data.empty())
+        return {};
+    if (mode() != ConversationMode::DOCUMENT) {
+        JAMI_ERROR("[Account {}] [Conversation {}] Refusing to checkpoint a non-document repository",
+                   pimpl_->accountId_,
+                   pimpl_->id_);
+        return {};
+    }
+    std::lock_guard lkOp(pimpl_->opMtx_);
+    pimpl_->resetHard();
+    auto repo = pimpl_->repository();
+    if (!repo)
+        return {};
+
+    // Stored raw rather than base64 in the message, and named after its own
+    // content so that concurrent batches never conflict on merge.
+    git_oid blobId;
+    if (git_blob_create_from_buffer(&blobId, repo.get(), data.data(), data.size()) < 0) {
+        JAMI_ERROR("[Account {}] [Conversation {}] Unable to store update blob", pimpl_->accountId_, pimpl_->id_);
+        return {};
+    }
+    std::string id = git_oid_tostr_s(&blobId);
+
+    std::filesystem::path repoPath = git_repository_workdir(repo.get());
+    auto updatesPath = repoPath / "updates";
+    if (std::filesystem::is_regular_file(updatesPath / id))
+        return id; // Same batch already checkpointed
+    if (!dhtnet::fileutils::recursive_mkdir(updatesPath, 0700)) {
+        JAMI_ERROR("Error when creating {}", updatesPath);
+        return {};
+    }
+    // Only the latest batch stays in the tree, which would otherwise be
+    // rewritten with one more entry at every checkpoint. The previous ones
+    // stay readable through their own commits.
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(updatesPath, ec))
+        std::filesystem::remove(entry.path(), ec);
+    auto updatePath = updatesPath / id;
+    std::ofstream file(updatePath, std::ios::trunc | std::ios::binary);
+    if (!file.is_open()) {
+        JAMI_ERROR("Unable to write data to {}", updatePath);
+        return {};
+    }
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    file.close();
+
+    if (!git_add_all(repo.get()))
+        return {};
+    if (pimpl_->commitMessage(CommitMessage::updateCheckpoint(id).toString()).empty())
+        return {};
+    return id;
+}
+
+std::vector<uint8_t>
+ConversationRepository::blob(const std::string& blobId) const
+{
+    // Read by oid rather than from a tree: a later commit drops snapshots and
+    // batches from HEAD, but the commit that named each still references it.
+    auto repo = pimpl_->repository();
+    git_oid oid;
+    if (!repo || git_oid_fromstr(&oid, blobId.c_str()) < 0)
+        return {};
+    git_object* blob_ptr = nullptr;
+    if (git_object_lookup(&blob_ptr, repo.get(), &oid, GIT_OBJECT_BLOB) < 0)
+        return {};
+    GitObject blob {blob_ptr};
+    auto content = as_view(blob);
+    return std::vector<uint8_t>(content.begin(), content.end());
+}
+
 std::string
 ConversationRepository::voteKick(const std::string& uri, const std::string& type)
 {
@@ -4397,11 +5027,151 @@ std::pair<std::vector<ConversationCommit>, bool>
 ConversationRepository::validClone() const
 {
     auto commits = log({});
-    if (!pimpl_->validCommits(commits))
+    auto toValidate = commits;
+    if (isShallow()) {
+        // The initial commit is not part of a shallow history, but is sent
+        // with it as it holds the mode of the conversation
+        auto initialCommit = getCommit(pimpl_->id_);
+        if (!initialCommit) {
+            JAMI_WARNING("[Account {}] [Conversation {}] Initial commit missing from shallow clone",
+                         pimpl_->accountId_,
+                         pimpl_->id_);
+            return {{}, false};
+        }
+        toValidate.emplace_back(std::move(*initialCommit));
+    }
+    if (!pimpl_->validCommits(toValidate))
         return {{}, false};
     return {std::move(commits), true};
 }
 
+/**
+ * Replace the shallow roots of the repository at gitDir
+ */
+static bool
+writeShallowRoots(const std::filesystem::path& gitDir, const std::vector<std::string>& roots)
+{
+    std::error_code ec;
+    auto path = gitDir / "shallow";
+    if (roots.empty())
+        return std::filesystem::remove(path, ec) || !ec;
+    auto tmpPath = gitDir / "shallow.tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::trunc);
+        for (const auto& root : roots)
+            file << root << '\n';
+        if (!file)
+            return false;
+    }
+    std::filesystem::rename(tmpPath, path, ec);
+    return !ec;
+}
+
+BackfillStatus
+ConversationRepository::backfill(const std::string& remoteDeviceId, unsigned commits)
+{
+    std::unique_lock lkShallow(pimpl_->shallowMtx_);
+    auto boundary = pimpl_->shallowRoots();
+    if (boundary.empty())
+        return BackfillStatus::NOTHING_NEW;
+    LogOptions options;
+    options.fastLog = true;
+    auto depth = log(options).size() + commits;
+    if (!fetch(remoteDeviceId, static_cast<unsigned>(depth)))
+        return BackfillStatus::NOTHING_NEW;
+    auto roots = pimpl_->shallowRoots();
+    if (roots == boundary) {
+        JAMI_DEBUG("[Account {}] [Conversation {}] No older history from {}",
+                   pimpl_->accountId_,
+                   pimpl_->id_,
+                   remoteDeviceId);
+        return BackfillStatus::NOTHING_NEW;
+    }
+
+    // The new commits are the history of the old boundary, which was only
+    // validated as a checkpoint
+    auto repo = pimpl_->repository();
+    if (!repo)
+        return BackfillStatus::NOTHING_NEW;
+    std::vector<ConversationCommit> older;
+    bool valid = true;
+    git_revwalk* walker_ptr = nullptr;
+    if (git_revwalk_new(&walker_ptr, repo.get()) < 0)
+        return BackfillStatus::NOTHING_NEW;
+    GitRevWalker walker {walker_ptr};
+    git_revwalk_sorting(walker.get(), GIT_SORT_TOPOLOGICAL);
+    for (const auto& root : boundary) {
+        git_oid oid;
+        if (git_oid_fromstr(&oid, root.c_str()) < 0 || git_revwalk_push(walker.get(), &oid) < 0)
+            valid = false;
+    }
+    git_oid oid;
+    while (valid && git_revwalk_next(&oid, walker.get()) == 0) {
+        auto commit = getCommit(git_oid_tostr_s(&oid));
+        if (!commit)
+            valid = false;
+        // Besides the new shallow roots, the history must start with the conversation itself
+        else if (commit->parents.empty() && commit->id != pimpl_->id_
+                 && !std::binary_search(roots.begin(), roots.end(), commit->id)) {
+            emitSignal<libjami::ConversationSignal::OnConversationError>(pimpl_->accountId_,
+                                                                         pimpl_->id_,
+                                                                         EVALIDFETCH,
+                                                                         "History not starting with the conversation");
+            valid = false;
+        } else
+            older.emplace_back(std::move(*commit));
+    }
+    valid = valid && pimpl_->validCommits(older);
+    if (!valid) {
+        JAMI_WARNING("[Account {}] [Conversation {}] Invalid history received from {}",
+                     pimpl_->accountId_,
+                     pimpl_->id_,
+                     remoteDeviceId);
+        if (!writeShallowRoots(git_repository_path(repo.get()), boundary))
+            JAMI_ERROR("[Account {}] [Conversation {}] Unable to restore shallow roots",
+                       pimpl_->accountId_,
+                       pimpl_->id_);
+        return BackfillStatus::INVALID;
+    }
+
+    JAMI_LOG("[Account {}] [Conversation {}] {} older commits from {}{}",
+             pimpl_->accountId_,
+             pimpl_->id_,
+             older.size(),
+             remoteDeviceId,
+             roots.empty() ? ", history complete" : "");
+    // Written by the maintenance before, with the old boundary as parentless commits
+    std::error_code ec;
+    auto infoDir = std::filesystem::path(git_repository_path(repo.get())) / "objects" / "info";
+    std::filesystem::remove(infoDir / "commit-graph", ec);
+    std::filesystem::remove_all(infoDir / "commit-graphs", ec);
+    // The linearized history changed below the indexed part
+    std::lock_guard lk(pimpl_->commitIndexMtx_);
+    pimpl_->commitIndex_.clear();
+    return BackfillStatus::ADDED;
+}
+
+bool
+ConversationRepository::isShallow() const
+{
+    return !pimpl_->shallowRoots().empty();
+}
+
+std::vector<std::string>
+ConversationRepository::shallowRoots(const std::filesystem::path& path)
+{
+    std::error_code ec;
+    auto gitDir = std::filesystem::is_directory(path / ".git", ec) ? path / ".git" : path;
+    std::vector<std::string> roots;
+    std::ifstream file(gitDir / "shallow");
+    std::string line;
+    while (std::getline(file, line))
+        if (line.size() >= GIT_OID_HEXSZ)
+            roots.emplace_back(line.substr(0, GIT_OID_HEXSZ));
+    std::sort(roots.begin(), roots.end());
+    return roots;
+}
+
 bool
 ConversationRepository::isValidUserAtCommit(const std::string& userDevice,
                                             const std::string& commitId,
@@ -91,8 +91,6 @@ struct ConversationCommit
     std::string id {};
     std::vector<std::string> parents {};
     GitAuthor author {};
-    std::vector<uint8_t> signed_content {};
-    std::vector<uint8_t> signature {};
     CommitMessage commitMsg {};
     std::string linearized_parent {};
     std::string authorId {};
@@ -138,6 +136,13 @@ struct ConversationMember
 
 enum class CallbackResult { Skip, Break, Ok };
 
+/// Result of ConversationRepository::backfill()
+enum class BackfillStatus {
+    ADDED,       // Older commits were validated and added
+    NOTHING_NEW, // The peer has no older history, or it was unable to be fetched
+    INVALID      // The older history does not validate the shallow history
+};
+
 using PreConditionCb = std::function<CallbackResult(const std::string&, const GitAuthor&, const GitCommit&)>;
 using PostConditionCb = std::function<bool(const std::string&, const GitAuthor&, ConversationCommit&)>;
 using OnMembersChanged = std::function<void(const std::set<std::string>&)>;
@@ -155,6 +160,9 @@ public:
     // avoiding the need for setting up a GitServer and a DHTNet connection.
     static bool FETCH_FROM_LOCAL_REPOS;
 #endif
+    /// Commits fetched by a clone, from peers able to send part of the history
+    static constexpr unsigned SHALLOW_CLONE_DEPTH {500};
+
     /**
      * Creates a new repository, with initial files, where the first commit hash is the conversation id
      * @param account       The related account
@@ -182,11 +190,17 @@ public:
 
     /**
      * Clones a conversation on a remote device
+     * If shallow, peers that support it only send the last SHALLOW_CLONE_DEPTH
+     * commits and the initial commit: the oldest commit received is then a
+     * shallow root, and backfill() fetches the rest when it is needed. Until
+     * it reaches the initial commit, the remote device chose the members the
+     * history is validated with: only ask it to a trusted device.
      * @note This will use the socket registered for the conversation with
      * Conversation::addGitSocket()
      * @param account           The account getting the conversation
      * @param deviceId          Remote device
      * @param conversationId    Conversation to clone
+     * @param shallow           If the remote device is trusted to send a shallow history
      * @throws InvalidRepositoryError if the cloned repository fails commit validation. This is a
      *         permanent failure (the remote history is immutable); transient network errors do not
      *         throw but return an empty repository instead. The sole caller,
@@ -196,7 +210,8 @@ public:
     static LIBJAMI_TEST_EXPORT std::pair<std::unique_ptr<ConversationRepository>, std::vector<ConversationCommit>>
     cloneConversation(const std::shared_ptr<JamiAccount>& account,
                       const std::string& deviceId,
-                      const std::string& conversationId);
+                      const std::string& conversationId,
+                      bool shallow = false);
 
     /**
      * Open a conversation repository for an account and an id
@@ -219,9 +234,33 @@ public:
      * Conversation::addGitSocket()
      * @note will create a remote identified by the deviceId
      * @param remoteDeviceId    Remote device id to fetch
+     * @param depth             If not 0, deepen a shallow history to this many commits
      * @return if the operation was successful
      */
-    bool fetch(const std::string& remoteDeviceId);
+    bool fetch(const std::string& remoteDeviceId, unsigned depth = 0);
+
+    /**
+     * Fetch up to commits older commits of a shallow history and validate
+     * them. If they are invalid, the history is cut back where it was and
+     * stays shallow: the older messages are not loaded.
+     * @param remoteDeviceId    Remote device id to fetch
+     * @param commits           Number of commits to add to the history
+     */
+    BackfillStatus backfill(const std::string& remoteDeviceId, unsigned commits);
+
+    /**
+     * A shallow history starts from checkpoints sent by a trusted device
+     * instead of the initial commit. It is used like any history, but only
+     * served to devices asking for the commits it has.
+     * @return if the history does not go back to the initial commit yet
+     */
+    bool isShallow() const;
+
+    /**
+     * Commits whose parents are missing from a shallow repository
+     * @param path      Work tree or git directory of the repository
+     */
+    static std::vector<std::string> shallowRoots(const std::filesystem::path& path);
 
     /**
      * Merge the history of the conversation with another peer
@@ -274,6 +313,17 @@ public:
              const std::string& from = "",
              bool logIfNotFound = true) const;
 
+    /**
+     * Walk commits reachable from HEAD but not from since, oldest first
+     * @param since     a commit of the history, empty to walk all of it
+     * @param emplaceCb called for each commit
+     * @param from      walk from this commit instead of HEAD
+     * @return the HEAD walked from, std::nullopt if since is not known
+     */
+    std::optional<std::string> logSince(const std::string& since,
+                                        std::function<void(ConversationCommit&&)>&& emplaceCb,
+                                        const std::string& from = {}) const;
+
     /**
      * Check if a commit exists in the repository
      * @param commitId The commit id to check
@@ -287,6 +337,12 @@ public:
      * @param commitId      id to choice
      */
     std::optional<std::string> linearizedParent(const std::string& commitId) const;
+    /**
+     * Get the linearized parents of several commits, syncing the commit index once
+     * @param commitIds     ids to choice
+     * @return parent of each indexed commit, by commit id
+     */
+    std::map<std::string, std::string> linearizedParents(const std::vector<std::string>& commitIds) const;
 
     /**
      * Merge another branch into the main branch
@@ -364,6 +420,30 @@ public:
      */
     std::vector<std::string> attachmentIds() const;
 
+    /**
+     * Document repositories only. Store the merged state of the document as
+     * snapshots/<oid>, dropping the snapshots it supersedes from the tree, and
+     * commit it
+     * @param data      The snapshot content
+     * @param parentId  The commit the state was built at. Nothing is committed
+     *                  if HEAD moved since.
+     * @return the commit id, empty on failure, if HEAD moved or if the same
+     *         state is already the latest snapshot
+     */
+    std::string addSnapshot(const std::vector<uint8_t>& data, const std::string& parentId);
+    /**
+     * Document repositories only. Store a batch of updates, merged into one,
+     * as updates/<oid>, dropping the previous batch from the tree, and commit it
+     * @param data  The merged update
+     * @return the update id (blob oid) or empty on failure. Nothing is
+     *         committed if the same batch is already the latest one.
+     */
+    std::string addUpdate(const std::vector<uint8_t>& data);
+    /**
+     * Read a snapshot or a batch of updates by id, even once it left the tree
+     */
+    std::vector<uint8_t> blob(const std::string& blobId) const;
+
     /**
      * The voting system is divided in two parts. The voting phase where
      * admins can decide an action (such as kicking someone)
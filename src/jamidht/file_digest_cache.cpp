@@ -0,0 +1,198 @@
+/*
+ *  Copyright (C) 2004-2026 Savoir-faire Linux Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "file_digest_cache.h"
+
+#include "fileutils.h"
+#include "logger.h"
+
+#include <msgpack.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+namespace jami {
+
+struct DigestEntry
+{
+    uint64_t size {0};
+    int64_t mtime {0};
+    int64_t ctime {0};
+    std::string digest;
+    // Last path the file was hashed at, to forget files that were removed
+    std::string path;
+    // When the digest was stored, to forget the oldest ones first
+    int64_t stored {0};
+
+    MSGPACK_DEFINE(size, mtime, ctime, digest, path, stored)
+};
+
+static std::optional<DigestEntry>
+unpackEntry(const std::string& data)
+{
+    try {
+        auto oh = msgpack::unpack(data.data(), data.size());
+        return oh.get().as<DigestEntry>();
+    } catch (const std::exception&) {
+        return std::nullopt;
+    }
+}
+
+FileDigestCache&
+FileDigestCache::instance()
+{
+    static FileDigestCache cache(fileutils::get_cache_dir() / "file_digests");
+    return cache;
+}
+
+FileDigestCache::FileDigestCache(const std::filesystem::path& path, size_t maxEntries)
+    : store_(path)
+    , maxEntries_(maxEntries)
+{}
+
+std::optional<FileDigestCache::Identity>
+FileDigestCache::identify(const std::filesystem::path& path)
+{
+    std::error_code ec;
+    if (path.empty() or not std::filesystem::is_regular_file(path, ec))
+        return std::nullopt;
+    Identity identity;
+    identity.size = std::filesystem::file_size(path, ec);
+    if (ec)
+        return std::nullopt;
+    auto lastWrite = std::filesystem::last_write_time(path, ec);
+    if (ec)
+        return std::nullopt;
+    identity.mtime = static_cast<int64_t>(lastWrite.time_since_epoch().count());
+#ifndef _WIN32
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0)
+        return std::nullopt;
+    identity.key = fmt::format("{}:{}", st.st_dev, st.st_ino);
+    identity.ctime = static_cast<int64_t>(st.st_ctime);
+#else
+    // No stable inode: files are known by their path
+    identity.key = std::filesystem::weakly_canonical(path, ec).string();
+    if (ec)
+        return std::nullopt;
+#endif
+    return identity;
+}
+
+std::optional<std::string>
+FileDigestCache::lookup(const Identity& identity) const
+{
+    auto data = store_.get(identity.key);
+    if (not data)
+        return std::nullopt;
+    auto entry = unpackEntry(*data);
+    if (not entry or entry->size != identity.size or entry->mtime != identity.mtime or entry->ctime != identity.ctime)
+        return std::nullopt;
+    return entry->digest;
+}
+
+std::string
+FileDigestCache::sha3(const std::filesystem::path& path)
+{
+    auto identity = identify(path);
+    if (not identity) {
+        JAMI_ERROR("Unable to compute sha3sum of {}: not a regular file", path);
+        return {};
+    }
+    if (auto digest = lookup(*identity))
+        return *digest;
+
+    std::promise<std::string> promise;
+    std::shared_future<std::string> computing;
+    {
+        std::lock_guard lk(mutex_);
+        auto [it, inserted] = computing_.try_emplace(identity->key);
+        if (inserted)
+            it->second = promise.get_future().share();
+        else
+            computing = it->second;
+    }
+    // Another request is hashing the same file
+    if (computing.valid())
+        return computing.get();
+
+    auto digest = fileutils::sha3File(path);
+    // Not kept if the file was written while being read
+    if (not digest.empty() and identify(path) == identity)
+        set(path, *identity, digest);
+    {
+        std::lock_guard lk(mutex_);
+        computing_.erase(identity->key);
+    }
+    promise.set_value(digest);
+    return digest;
+}
+
+void
+FileDigestCache::set(const std::filesystem::path& path, const std::string& digest)
+{
+    if (auto identity = identify(path))
+        set(path, *identity, digest);
+}
+
+void
+FileDigestCache::set(const std::filesystem::path& path, const Identity& identity, const std::string& digest)
+{
+    auto stored = std::chrono::system_clock::now().time_since_epoch().count();
+    msgpack::sbuffer buffer;
+    msgpack::pack(buffer,
+                  DigestEntry {identity.size, identity.mtime, identity.ctime, digest, path.string(), stored});
+    store_.put(identity.key, std::string(buffer.data(), buffer.size()));
+    if (store_.size() > maxEntries_)
+        prune();
+}
+
+void
+FileDigestCache::prune()
+{
+    // Another thread is already at it
+    std::unique_lock lk(pruneMutex_, std::try_to_lock);
+    if (not lk.owns_lock())
+        return;
+    // Files removed or modified since they were hashed go first
+    std::map<std::string, std::optional<std::string>> removed;
+    std::vector<std::pair<int64_t, std::string>> kept;
+    for (const auto& [key, data] : store_.values()) {
+        auto entry = unpackEntry(data);
+        auto identity = entry ? identify(entry->path) : std::nullopt;
+        if (not identity or identity->key != key or identity->size != entry->size or identity->mtime != entry->mtime
+            or identity->ctime != entry->ctime)
+            removed.emplace(key, std::nullopt);
+        else
+            kept.emplace_back(entry->stored, key);
+    }
+    // Then the oldest ones, leaving room for the next digests
+    auto target = maxEntries_ * 3 / 4;
+    if (kept.size() > target) {
+        std::sort(kept.begin(), kept.end());
+        for (size_t i = 0; i < kept.size() - target; ++i)
+            removed.emplace(kept[i].second, std::nullopt);
+    }
+    JAMI_DEBUG("Forgetting {} of {} file digests", removed.size(), removed.size() + kept.size());
+    store_.update(removed);
+}
+
+} // namespace jami
@@ -0,0 +1,98 @@
+/*
+ *  Copyright (C) 2004-2026 Savoir-faire Linux Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "jamidht/journal_store.h"
+#include "noncopyable.h"
+
+#include <filesystem>
+#include <future>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+
+namespace jami {
+
+/**
+ * Persistent cache of the SHA3-512 of shared files.
+ *
+ * Entries are keyed by the identity of the file (device and inode, or the
+ * path where there is none) and hold the size, modification and status
+ * change times the digest was computed for: any write to the file
+ * invalidates it. A digest is only stored if the file did not change while
+ * it was hashed, and concurrent requests for the same file share a single
+ * computation.
+ *
+ * Outdated entries are only found when they are looked up, or when the cache
+ * grows above its maximum size: the files that were removed or modified are
+ * then forgotten first, followed by the oldest digests.
+ */
+class FileDigestCache
+{
+public:
+    /**
+     * Process-wide cache, stored in the cache directory
+     */
+    static FileDigestCache& instance();
+
+    static constexpr size_t MAX_ENTRIES {4096};
+
+    explicit FileDigestCache(const std::filesystem::path& path, size_t maxEntries = MAX_ENTRIES);
+
+    /**
+     * SHA3-512 of the file at path, only computed if it changed since it was
+     * last hashed
+     * @return empty if the file is unable to be read
+     */
+    std::string sha3(const std::filesystem::path& path);
+
+    /**
+     * Remember the digest of a file that was hashed by other means,
+     * such as while it was received
+     */
+    void set(const std::filesystem::path& path, const std::string& digest);
+
+    // Number of digests stored
+    size_t size() const { return store_.size(); }
+
+private:
+    NON_COPYABLE(FileDigestCache);
+
+    struct Identity
+    {
+        std::string key;
+        uint64_t size {0};
+        int64_t mtime {0};
+        int64_t ctime {0};
+
+        bool operator==(const Identity&) const = default;
+    };
+
+    static std::optional<Identity> identify(const std::filesystem::path& path);
+    std::optional<std::string> lookup(const Identity& identity) const;
+    void set(const std::filesystem::path& path, const Identity& identity, const std::string& digest);
+    void prune();
+
+    JournalStore store_;
+    const size_t maxEntries_;
+    std::mutex mutex_;
+    std::map<std::string, std::shared_future<std::string>> computing_;
+    std::mutex pruneMutex_;
+};
+
+} // namespace jami
@@ -0,0 +1,301 @@
+/*
+ *  Copyright (C) 2004-2026 Savoir-faire Linux Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "file_store.h"
+
+#include "file_digest_cache.h"
+#include "fileutils.h"
+#include "logger.h"
+
+#include <msgpack.hpp>
+
+#include <vector>
+
+namespace jami {
+
+namespace fs = std::filesystem;
+
+// Hexadecimal SHA3-512
+static constexpr size_t DIGEST_SIZE {128};
+
+static std::set<std::string>
+unpackReferences(const std::string& data)
+{
+    try {
+        auto oh = msgpack::unpack(data.data(), data.size());
+        return oh.get().as<std::set<std::string>>();
+    } catch (const std::exception&) {
+        return {};
+    }
+}
+
+/// Whether path is one of the names of object
+static bool
+isLinkOf(const fs::path& path, const fs::path& object)
+{
+    std::error_code ec;
+    return fs::is_regular_file(path, ec) and not fs::is_symlink(path, ec) and fs::equivalent(path, object, ec)
+           and not ec;
+}
+
+/// Make path a hard link to object, atomically replacing what may be there
+static bool
+linkAt(const fs::path& object, const fs::path& path)
+{
+    std::error_code ec;
+    fs::create_directories(path.parent_path(), ec);
+    auto tmp = fs::path(path).concat(".store");
+    fs::remove(tmp, ec);
+    fs::create_hard_link(object, tmp, ec);
+    if (not ec)
+        fs::rename(tmp, path, ec);
+    if (ec) {
+        JAMI_WARNING("Unable to link {} to {}: {}", path, object, ec.message());
+        fs::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
+
+FileStore&
+FileStore::instance()
+{
+    static FileStore store(fileutils::get_data_dir() / "file_store");
+    return store;
+}
+
+FileStore::FileStore(const fs::path& path)
+    : root_(path)
+    , index_(path / "index")
+{
+    std::error_code ec;
+    fs::create_directories(root_, ec);
+
+    // Forget the references that were removed or replaced since they were
+    // made, then the objects that are left without any
+    std::map<std::string, std::optional<std::string>> changes;
+    for (const auto& [sha3, data] : index_.values()) {
+        auto object = objectPath(sha3);
+        auto references = unpackReferences(data);
+        auto count = references.size();
+        std::erase_if(references, [&](const auto& ref) { return not isLinkOf(ref, object); });
+        if (references.empty()) {
+            changes.emplace(sha3, std::nullopt);
+            continue;
+        }
+        for (const auto& ref : references)
+            objects_.emplace(ref, sha3);
+        references_.emplace(sha3, std::move(references));
+        if (references_[sha3].size() != count)
+            changes.emplace(sha3, packReferences(sha3));
+    }
+    if (not changes.empty())
+        index_.update(changes);
+
+    size_t removed = 0;
+    for (const auto& fanout : fs::directory_iterator(root_, ec)) {
+        if (fanout.path().filename().string().size() != 2 or not fanout.is_directory(ec))
+            continue;
+        for (const auto& entry : fs::directory_iterator(fanout.path(), ec)) {
+            // Also clears what an interrupted link left
+            if (references_.find(entry.path().filename().string()) == references_.end()) {
+                fs::remove(entry.path(), ec);
+                removed++;
+            }
+        }
+        // Only succeeds once the fan-out directory is empty
+        fs::remove(fanout.path(), ec);
+    }
+    if (removed != 0)
+        JAMI_DEBUG("Removed {} unreferenced files from {}", removed, root_);
+}
+
+bool
+FileStore::isDigest(const std::string& sha3)
+{
+    // Digests come from commits written by peers: they name files
+    return sha3.size() == DIGEST_SIZE and sha3.find_first_not_of("0123456789abcdef") == std::string::npos;
+}
+
+fs::path
+FileStore::objectPath(const std::string& sha3) const
+{
+    return root_ / sha3.substr(0, 2) / sha3;
+}
+
+bool
+FileStore::has(const std::string& sha3) const
+{
+    if (not isDigest(sha3))
+        return false;
+    std::lock_guard lk(mutex_);
+    std::error_code ec;
+    return references_.find(sha3) != references_.end() and fs::is_regular_file(objectPath(sha3), ec);
+}
+
+bool
+FileStore::intact(const std::string& sha3) const
+{
+    // A reference may have been written to in place, which changed every
+    // other one. Usually served from the digest cache.
+    auto object = objectPath(sha3);
+    if (FileDigestCache::instance().sha3(object) == sha3)
+        return true;
+    JAMI_WARNING("Stored file {} was modified", object);
+    return false;
+}
+
+bool
+FileStore::stores(const fs::path& path) const
+{
+    std::lock_guard lk(mutex_);
+    return objects_.find(path.string()) != objects_.end();
+}
+
+size_t
+FileStore::references(const std::string& sha3) const
+{
+    std::lock_guard lk(mutex_);
+    auto it = references_.find(sha3);
+    return it == references_.end() ? 0 : it->second.size();
+}
+
+bool
+FileStore::adopt(const fs::path& path, const std::string& sha3)
+{
+    if (not isDigest(sha3))
+        return false;
+    // Hashed without the lock. A modified object is replaced by the file
+    // just received, its other references are forgotten when reopened.
+    auto stored = has(sha3) and intact(sha3);
+    std::lock_guard lk(mutex_);
+    auto object = objectPath(sha3);
+    std::error_code ec;
+    if (isLinkOf(path, object)) {
+        addReference(sha3, path);
+        return true;
+    }
+    if (stored and fs::is_regular_file(object, ec)) {
+        // Same content: the copy just received is replaced by the stored one
+        if (not linkAt(object, path))
+            return false;
+    } else {
+        fs::create_directories(object.parent_path(), ec);
+        fs::remove(object, ec);
+        fs::create_hard_link(path, object, ec);
+        if (ec) {
+            // e.g. the data directory spans several file systems
+            JAMI_WARNING("Unable to store {}: {}", path, ec.message());
+            return false;
+        }
+    }
+    addReference(sha3, path);
+    return true;
+}
+
+bool
+FileStore::link(const std::string& sha3, const fs::path& path)
+{
+    if (not has(sha3))
+        return false;
+    if (not intact(sha3))
+        return false;
+    auto object = objectPath(sha3);
+    std::lock_guard lk(mutex_);
+    if (not isLinkOf(path, object) and not linkAt(object, path))
+        return false;
+    addReference(sha3, path);
+    return true;
+}
+
+void
+FileStore::addReference(const std::string& sha3, const fs::path& path)
+{
+    std::map<std::string, std::optional<std::string>> changes;
+    auto ref = path.string();
+    auto it = objects_.find(ref);
+    if (it != objects_.end()) {
+        if (it->second == sha3)
+            return;
+        removeReference(ref, changes);
+    }
+    references_[sha3].emplace(ref);
+    objects_[ref] = sha3;
+    changes[sha3] = packReferences(sha3);
+    index_.update(changes);
+}
+
+void
+FileStore::removeReference(const std::string& path, std::map<std::string, std::optional<std::string>>& changes)
+{
+    auto it = objects_.find(path);
+    if (it == objects_.end())
+        return;
+    auto sha3 = std::move(it->second);
+    objects_.erase(it);
+    auto refs = references_.find(sha3);
+    if (refs == references_.end())
+        return;
+    refs->second.erase(path);
+    if (refs->second.empty()) {
+        references_.erase(refs);
+        auto object = objectPath(sha3);
+        std::error_code ec;
+        fs::remove(object, ec);
+        fs::remove(object.parent_path(), ec);
+        JAMI_DEBUG("Removed {} with its last reference", object);
+    }
+    changes[sha3] = packReferences(sha3);
+}
+
+std::optional<std::string>
+FileStore::packReferences(const std::string& sha3) const
+{
+    auto it = references_.find(sha3);
+    if (it == references_.end())
+        return std::nullopt;
+    msgpack::sbuffer buffer;
+    msgpack::pack(buffer, it->second);
+    return std::string(buffer.data(), buffer.size());
+}
+
+void
+FileStore::release(const fs::path& path)
+{
+    std::lock_guard lk(mutex_);
+    std::map<std::string, std::optional<std::string>> changes;
+    removeReference(path.string(), changes);
+    if (not changes.empty())
+        index_.update(changes);
+}
+
+void
+FileStore::releaseAll(const fs::path& dir)
+{
+    auto prefix = (dir / "").string();
+    std::lock_guard lk(mutex_);
+    std::vector<std::string> paths;
+    for (auto it = objects_.lower_bound(prefix); it != objects_.end() and it->first.starts_with(prefix); ++it)
+        paths.emplace_back(it->first);
+    std::map<std::string, std::optional<std::string>> changes;
+    for (const auto& path : paths)
+        removeReference(path, changes);
+    if (not changes.empty())
+        index_.update(changes);
+}
+
+} // namespace jami
@@ -0,0 +1,126 @@
+/*
+ *  Copyright (C) 2004-2026 Savoir-faire Linux Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "jamidht/journal_store.h"
+#include "noncopyable.h"
+
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+
+namespace jami {
+
+/**
+ * Content-addressed store of the files received in conversations.
+ *
+ * Each distinct content is kept once, under its SHA3-512, and the files of
+ * the conversations (conversation_data/<conversation>/<fileId>, for every
+ * account) are hard links to it. An index lists the references of each
+ * object: when the last one is released, the object is removed. A file
+ * already in the store is linked into a conversation instead of being
+ * transferred again.
+ *
+ * Files are only adopted once their digest was verified. References that
+ * were removed or replaced behind the store's back are forgotten when it is
+ * opened, along with the objects left without any.
+ *
+ * As the store is shared by every account of the data directory, the
+ * accounts are no longer isolated from each other for these files: an
+ * application that writes to one of them in place changes it in every
+ * conversation and account that received the same content. So the digest
+ * of a stored file is checked again before it is linked or sent to a peer
+ * (see intact()), which the digest cache keeps cheap while it is unchanged.
+ */
+class FileStore
+{
+public:
+    /**
+     * Process-wide store, shared by the accounts of the data directory, see
+     * above for what they share
+     */
+    static FileStore& instance();
+
+    explicit FileStore(const std::filesystem::path& path);
+
+    std::filesystem::path objectPath(const std::string& sha3) const;
+
+    /**
+     * @return whether a file with this digest is stored
+     */
+    bool has(const std::string& sha3) const;
+
+    /**
+     * @return whether the stored file with this digest still has it
+     */
+    bool intact(const std::string& sha3) const;
+
+    /**
+     * @return whether path is a reference to a stored file
+     */
+    bool stores(const std::filesystem::path& path) const;
+
+    /**
+     * Share the received file at path, whose digest is sha3: it becomes a
+     * link to the stored object, which it provides if it is new.
+     * @return false if the file is unable to be linked, in which case it is
+     * left untouched
+     */
+    bool adopt(const std::filesystem::path& path, const std::string& sha3);
+
+    /**
+     * Create a reference to the stored file with this digest at path,
+     * replacing what may be there
+     * @return false if it is not stored or unable to be linked
+     */
+    bool link(const std::string& sha3, const std::filesystem::path& path);
+
+    /**
+     * Forget the reference at path, which the caller removes. The object is
+     * removed with its last reference.
+     */
+    void release(const std::filesystem::path& path);
+
+    /**
+     * Forget every reference in the directory dir, such as the data of a
+     * removed conversation
+     */
+    void releaseAll(const std::filesystem::path& dir);
+
+    size_t references(const std::string& sha3) const;
+
+private:
+    NON_COPYABLE(FileStore);
+
+    static bool isDigest(const std::string& sha3);
+    void addReference(const std::string& sha3, const std::filesystem::path& path);
+    void removeReference(const std::string& path, std::map<std::string, std::optional<std::string>>& changes);
+    std::optional<std::string> packReferences(const std::string& sha3) const;
+
+    const std::filesystem::path root_;
+    JournalStore index_;
+    mutable std::mutex mutex_;
+    /// sha3 -> paths of its references
+    std::map<std::string, std::set<std::string>> references_;
+    /// path of a reference -> sha3
+    std::map<std::string, std::string> objects_;
+};
+
+} // namespace jami
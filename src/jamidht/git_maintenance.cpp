@@ -0,0 +1,438 @@
+/*
+ *  Copyright (C) 2004-2026 Savoir-faire Linux Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "git_maintenance.h"
+
+#include "git_def.h"
+#include "logger.h"
+
+#include <git2/sys/commit_graph.h>
+#include <git2/sys/midx.h>
+#include <git2/sys/odb_backend.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace jami::git_maintenance {
+
+namespace fs = std::filesystem;
+using ObjectSet = std::unordered_set<std::string>;
+
+// Files that may accompany a pack
+constexpr const char* PACK_EXTENSIONS[] = {".pack", ".idx", ".rev", ".bitmap", ".mtimes"};
+
+static const char*
+lastError()
+{
+    auto* err = git_error_last();
+    return err && err->message ? err->message : "unknown error";
+}
+
+static fs::path
+gitDir(const fs::path& path)
+{
+    std::error_code ec;
+    auto dotGit = path / ".git";
+    return fs::is_directory(dotGit, ec) ? dotGit : path;
+}
+
+static bool
+isHex(const std::string& s, size_t size)
+{
+    return s.size() == size && s.find_first_not_of("0123456789abcdef") == std::string::npos;
+}
+
+template<typename Fn>
+static void
+forEachLooseObject(const fs::path& objectsDir, Fn&& fn)
+{
+    std::error_code ec;
+    for (const auto& fanout : fs::directory_iterator(objectsDir, ec)) {
+        auto prefix = fanout.path().filename().string();
+        if (!isHex(prefix, 2) || !fanout.is_directory(ec))
+            continue;
+        for (const auto& object : fs::directory_iterator(fanout.path(), ec)) {
+            auto suffix = object.path().filename().string();
+            if (isHex(suffix, GIT_OID_HEXSZ - 2) && object.is_regular_file(ec))
+                fn(prefix + suffix, object);
+        }
+    }
+}
+
+/// Base paths (without extension) of the packs in packDir
+static std::vector<fs::path>
+listPacks(const fs::path& packDir)
+{
+    std::vector<fs::path> packs;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(packDir, ec)) {
+        const auto& p = entry.path();
+        if (p.extension() == ".pack" && fs::exists(fs::path(p).replace_extension(".idx"), ec))
+            packs.emplace_back(fs::path(p).replace_extension());
+    }
+    return packs;
+}
+
+static int
+collectObject(const git_oid* oid, void* payload)
+{
+    static_cast<ObjectSet*>(payload)->emplace(git_oid_tostr_s(oid));
+    return 0;
+}
+
+/// Objects of the pack whose index is at idx
+static std::optional<ObjectSet>
+packObjects(const fs::path& idx)
+{
+    git_odb* odbPtr = nullptr;
+    if (git_odb_new(&odbPtr) < 0)
+        return std::nullopt;
+    std::unique_ptr<git_odb, decltype(&git_odb_free)> odb(odbPtr, &git_odb_free);
+    git_odb_backend* backend = nullptr;
+    if (git_odb_backend_one_pack(&backend, idx.string().c_str()) < 0)
+        return std::nullopt;
+    // Owned by odb from now on
+    if (git_odb_add_backend(odb.get(), backend, 1) < 0) {
+        backend->free(backend);
+        return std::nullopt;
+    }
+    ObjectSet objects;
+    if (git_odb_foreach(odb.get(), &collectObject, &objects) < 0)
+        return std::nullopt;
+    return objects;
+}
+
+/// @return false if a file of the pack is unable to be removed, e.g. a pack
+/// still mapped on Windows, in which case its index is kept
+static bool
+removePack(const fs::path& base)
+{
+    std::error_code ec;
+    // The index last, as packs are found through it
+    for (const auto* ext : PACK_EXTENSIONS) {
+        if (std::string_view(ext) == ".idx")
+            continue;
+        auto file = fs::path(base).replace_extension(ext);
+        if (!fs::remove(file, ec) && ec) {
+            JAMI_DEBUG("Unable to remove {}: {}", file, ec.message());
+            return false;
+        }
+    }
+    fs::remove(fs::path(base).replace_extension(".idx"), ec);
+    return !ec;
+}
+
+static bool
+olderThan(const fs::path& path, std::chrono::seconds age)
+{
+    std::error_code ec;
+    auto mtime = fs::last_write_time(path, ec);
+    return !ec && fs::file_time_type::clock::now() - mtime >= age;
+}
+
+static void
+lowerThreadPriority()
+{
+#ifdef _WIN32
+    // Also lowers the I/O priority
+    SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+#elif defined(__APPLE__)
+    pthread_set_qos_class_self_np(QOS_CLASS_BACKGROUND, 0);
+#elif defined(SCHED_IDLE)
+    sched_param param {};
+    pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+#endif
+}
+
+/// Thread running the tasks given to post(), started on first use
+class Worker
+{
+public:
+    static Worker& instance()
+    {
+        static Worker worker;
+        return worker;
+    }
+
+    ~Worker()
+    {
+        std::deque<std::function<void()>> tasks;
+        {
+            std::lock_guard lk(mtx_);
+            stopping_ = true;
+            tasks.swap(tasks_);
+        }
+        cv_.notify_all();
+        if (thread_.joinable())
+            thread_.join();
+    }
+
+    void post(std::function<void()>&& task)
+    {
+        {
+            std::lock_guard lk(mtx_);
+            if (stopping_)
+                return;
+            tasks_.emplace_back(std::move(task));
+            if (!thread_.joinable())
+                thread_ = std::thread([this] { loop(); });
+        }
+        cv_.notify_all();
+    }
+
+    /// @return false if the process exits before time
+    bool sleepUntil(std::chrono::steady_clock::time_point time)
+    {
+        std::unique_lock lk(mtx_);
+        return !cv_.wait_until(lk, time, [this] { return stopping_; });
+    }
+
+private:
+    void loop()
+    {
+        lowerThreadPriority();
+        std::unique_lock lk(mtx_);
+        while (true) {
+            cv_.wait(lk, [this] { return stopping_ || !tasks_.empty(); });
+            if (stopping_)
+                return;
+            auto task = std::move(tasks_.front());
+            tasks_.pop_front();
+            lk.unlock();
+            try {
+                task();
+            } catch (const std::exception& e) {
+                JAMI_ERROR("[git maintenance] Unhandled exception in task: {}", e.what());
+            }
+            task = {};
+            lk.lock();
+        }
+    }
+
+    std::mutex mtx_;
+    // Shared by post() and sleepUntil(): always notify_all
+    std::condition_variable cv_;
+    std::deque<std::function<void()>> tasks_;
+    bool stopping_ {false};
+    std::thread thread_;
+};
+
+struct Throttle
+{
+    uint64_t budget;
+    std::chrono::steady_clock::time_point start {std::chrono::steady_clock::now()};
+};
+
+static int
+throttle(const git_indexer_progress* progress, void* payload)
+{
+    const auto& t = *static_cast<Throttle*>(payload);
+    if (t.budget == 0)
+        return 0;
+    // Sleep until what was written so far fits the budget
+    auto due = t.start + std::chrono::microseconds(progress->received_bytes * 1'000'000 / t.budget);
+    if (due > std::chrono::steady_clock::now() && !Worker::instance().sleepUntil(due))
+        return -1;
+    return 0;
+}
+
+ObjectStats
+inspect(const fs::path& path)
+{
+    ObjectStats stats;
+    auto objectsDir = gitDir(path) / "objects";
+    std::error_code ec;
+    forEachLooseObject(objectsDir, [&](const std::string&, const fs::directory_entry& entry) {
+        stats.looseObjects++;
+        stats.looseBytes += entry.file_size(ec);
+    });
+    for (const auto& base : listPacks(objectsDir / "pack")) {
+        stats.packs++;
+        stats.packBytes += fs::file_size(fs::path(base).replace_extension(".pack"), ec);
+        stats.packBytes += fs::file_size(fs::path(base).replace_extension(".idx"), ec);
+    }
+    return stats;
+}
+
+bool
+needed(const ObjectStats& stats)
+{
+    return stats.looseObjects >= LOOSE_OBJECTS_THRESHOLD || stats.packs >= PACKS_THRESHOLD;
+}
+
+std::optional<Result>
+run(const fs::path& path, uint64_t ioBudget, std::chrono::seconds pruneGrace)
+{
+    git_repository* repoPtr = nullptr;
+    if (git_repository_open(&repoPtr, path.string().c_str()) < 0) {
+        JAMI_WARNING("Unable to open repository {} for maintenance: {}", path, lastError());
+        return std::nullopt;
+    }
+    GitRepository repo {repoPtr};
+    auto objectsDir = fs::path(git_repository_path(repo.get())) / "objects";
+    auto packDir = objectsDir / "pack";
+
+    Result result;
+    result.before = inspect(path);
+    auto oldPacks = listPacks(packDir);
+
+    // Every object reachable from a reference
+    git_revwalk* walkPtr = nullptr;
+    if (git_revwalk_new(&walkPtr, repo.get()) < 0)
+        return std::nullopt;
+    GitRevWalker walk {walkPtr};
+    git_revwalk_push_glob(walk.get(), "*");
+    git_revwalk_push_head(walk.get());
+
+    git_packbuilder* pbPtr = nullptr;
+    if (git_packbuilder_new(&pbPtr, repo.get()) < 0)
+        return std::nullopt;
+    GitPackBuilder pb {pbPtr};
+    // Background work, one core is enough
+    git_packbuilder_set_threads(pb.get(), 1);
+    if (git_packbuilder_insert_walk(pb.get(), walk.get()) < 0) {
+        JAMI_WARNING("Unable to list objects of {}: {}", path, lastError());
+        return std::nullopt;
+    }
+    result.packedObjects = git_packbuilder_object_count(pb.get());
+    if (result.packedObjects == 0) {
+        result.after = result.before;
+        return result;
+    }
+    Throttle budget {ioBudget};
+    if (git_packbuilder_write(pb.get(), nullptr, 0, &throttle, &budget) < 0) {
+        JAMI_WARNING("Unable to repack {}: {}", path, lastError());
+        return std::nullopt;
+    }
+    result.writtenBytes = git_packbuilder_written(pb.get());
+    auto newPack = packDir / fmt::format("pack-{}", git_packbuilder_name(pb.get()));
+    auto packed = packObjects(fs::path(newPack).replace_extension(".idx"));
+    if (!packed) {
+        JAMI_WARNING("Unable to read new pack of {}: {}", path, lastError());
+        return std::nullopt;
+    }
+
+    // Objects are now in the new pack: everything else is either redundant
+    // or unreachable
+    std::error_code ec;
+    for (const auto& base : oldPacks) {
+        if (base == newPack || fs::exists(fs::path(base).replace_extension(".keep"), ec))
+            continue;
+        auto objects = packObjects(fs::path(base).replace_extension(".idx"));
+        if (!objects)
+            continue;
+        uint64_t unreachable = 0;
+        for (const auto& object : *objects)
+            if (!packed->count(object))
+                unreachable++;
+        if (unreachable != 0 && !olderThan(fs::path(base).replace_extension(".pack"), pruneGrace))
+            continue;
+        if (!removePack(base)) {
+            // The next run removes what is left
+            JAMI_WARNING("Unable to remove pack {} of {}, stopping", base.filename(), path);
+            break;
+        }
+        result.removedPacks++;
+        result.prunedObjects += unreachable;
+    }
+    std::vector<fs::path> loose;
+    forEachLooseObject(objectsDir, [&](const std::string& id, const fs::directory_entry& entry) {
+        if (packed->count(id)) {
+            loose.emplace_back(entry.path());
+        } else if (olderThan(entry.path(), pruneGrace)) {
+            loose.emplace_back(entry.path());
+            result.prunedObjects++;
+        }
+    });
+    for (const auto& object : loose) {
+        fs::remove(object, ec);
+        // Only succeeds once the fan-out directory is empty
+        fs::remove(object.parent_path(), ec);
+    }
+
+    // Indexes: the multi-pack-index listed the old packs
+    fs::remove(packDir / "multi-pack-index", ec);
+    auto packs = listPacks(packDir);
+    if (packs.size() > 1) {
+        git_midx_writer* midx = nullptr;
+        if (git_midx_writer_new(&midx, packDir.string().c_str()) == 0) {
+            bool ok = true;
+            for (const auto& base : packs) {
+                // Relative to packDir
+                auto idx = fs::path(base).replace_extension(".idx").filename().string();
+                ok = ok && git_midx_writer_add(midx, idx.c_str()) == 0;
+            }
+            result.multiPackIndex = ok && git_midx_writer_commit(midx) == 0;
+            git_midx_writer_free(midx);
+        }
+        if (!result.multiPackIndex)
+            JAMI_WARNING("Unable to write multi-pack-index of {}: {}", path, lastError());
+    }
+
+    auto infoDir = objectsDir / "info";
+    if (git_repository_is_shallow(repo.get()) == 1) {
+        // A graph would record the shallow roots without the parents a
+        // backfill gives them
+        fs::remove(infoDir / "commit-graph", ec);
+        result.after = inspect(path);
+        return result;
+    }
+    fs::create_directories(infoDir, ec);
+    git_revwalk_reset(walk.get());
+    git_revwalk_push_glob(walk.get(), "*");
+    git_revwalk_push_head(walk.get());
+    git_commit_graph_writer* graph = nullptr;
+    if (git_commit_graph_writer_new(&graph, infoDir.string().c_str()) == 0) {
+        git_commit_graph_writer_options opts = GIT_COMMIT_GRAPH_WRITER_OPTIONS_INIT;
+        result.commitGraph = git_commit_graph_writer_add_revwalk(graph, walk.get()) == 0
+                             && git_commit_graph_writer_commit(graph, &opts) == 0;
+        git_commit_graph_writer_free(graph);
+    }
+    if (result.commitGraph) {
+        git_config* config = nullptr;
+        if (git_repository_config(&config, repo.get()) == 0) {
+            int enabled = 0;
+            if (git_config_get_bool(&enabled, config, "core.commitGraph") < 0 || !enabled)
+                git_config_set_bool(config, "core.commitGraph", 1);
+            git_config_free(config);
+        }
+    } else {
+        JAMI_WARNING("Unable to write commit-graph of {}: {}", path, lastError());
+    }
+
+    result.after = inspect(path);
+    return result;
+}
+
+void
+post(std::function<void()>&& task)
+{
+    Worker::instance().post(std::move(task));
+}
+
+} // namespace jami::git_maintenance
@@ -0,0 +1,103 @@
+/*
+ *  Copyright (C) 2004-2026 Savoir-faire Linux Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+
+/**
+ * Housekeeping of the object database of a git repository, similar to
+ * "git gc": every reachable object is written to a single new pack, the
+ * packs and loose objects it makes redundant are removed, unreachable
+ * objects older than a grace period are pruned, a multi-pack-index is
+ * written if several packs remain, and a commit-graph unless the history is
+ * shallow.
+ *
+ * The new pack is complete before anything is removed, so readers with the
+ * repository open keep finding every object, either where it was or in the
+ * new pack.
+ */
+namespace jami::git_maintenance {
+
+struct ObjectStats
+{
+    uint64_t looseObjects {0};
+    uint64_t looseBytes {0};
+    uint64_t packs {0};
+    uint64_t packBytes {0};
+
+    uint64_t bytes() const { return looseBytes + packBytes; }
+};
+
+struct Result
+{
+    ObjectStats before;
+    ObjectStats after;
+    /// Objects in the new pack
+    uint64_t packedObjects {0};
+    /// Unreachable objects removed
+    uint64_t prunedObjects {0};
+    /// Packs replaced by the new one
+    uint64_t removedPacks {0};
+    /// Bytes written to the new pack
+    uint64_t writtenBytes {0};
+    bool commitGraph {false};
+    bool multiPackIndex {false};
+
+    uint64_t reclaimedBytes() const { return before.bytes() > after.bytes() ? before.bytes() - after.bytes() : 0; }
+};
+
+/// Loose objects above which a repository needs maintenance
+constexpr uint64_t LOOSE_OBJECTS_THRESHOLD {100};
+/// Packs above which a repository needs maintenance
+constexpr uint64_t PACKS_THRESHOLD {4};
+/// Unreachable objects more recent than this are kept, as they may be part
+/// of an operation in progress
+constexpr std::chrono::hours DEFAULT_PRUNE_GRACE {14 * 24};
+
+/**
+ * Count the objects of the repository at path (work tree or git directory)
+ */
+ObjectStats inspect(const std::filesystem::path& path);
+
+/**
+ * @return whether maintenance would be worth it
+ */
+bool needed(const ObjectStats& stats);
+
+/**
+ * Repack, prune and index the repository at path.
+ * @param ioBudget      Bytes per second written at most while packing, 0 for no limit
+ * @param pruneGrace    Minimum age of the unreachable objects removed
+ * @return empty if the repository could not be maintained
+ */
+std::optional<Result> run(const std::filesystem::path& path,
+                          uint64_t ioBudget,
+                          std::chrono::seconds pruneGrace = DEFAULT_PRUNE_GRACE);
+
+/**
+ * Run task on the maintenance thread, shared by every account: tasks run one
+ * at a time, at a low scheduling priority, and the pacing of run() never
+ * holds a thread of a shared pool. A repack paced there is aborted when the
+ * process exits.
+ */
+void post(std::function<void()>&& task);
+
+} // namespace jami::git_maintenance
@@ -24,11 +24,15 @@
 #include <dhtnet/multiplexed_socket.h>
 #include <fmt/compile.h>
 
+#include <algorithm>
 #include <charconv>
 #include <ctime>
+#include <deque>
 #include <fstream>
 #include <git2.h>
 #include <iomanip>
+#include <set>
+#include <utility>
 
 using namespace std::string_view_literals;
 constexpr auto FLUSH_PKT = "0000"sv;
@@ -36,10 +40,131 @@ constexpr auto NAK_PKT = "0008NAK\n"sv;
 constexpr auto DONE_CMD = "done\n"sv;
 constexpr auto WANT_CMD = "want"sv;
 constexpr auto HAVE_CMD = "have"sv;
-constexpr auto SERVER_CAPABILITIES = " HEAD\0side-band side-band-64k shallow no-progress include-tag"sv;
+constexpr auto SHALLOW_CMD = "shallow"sv;
+constexpr auto DEEPEN_CMD = "deepen"sv;
+// jami-deepen: DEEPEN_CAPABILITY, "shallow" alone was advertised before deepen was answered
+constexpr auto SERVER_CAPABILITIES
+    = " HEAD\0side-band side-band-64k shallow no-progress include-tag jami-deepen"sv;
 
 namespace jami {
 
+// Packs bigger than this are streamed to the peer without being cached
+constexpr size_t MAX_CACHED_PACK_SIZE {4 * 1024 * 1024};
+// cf https://github.com/git/git/blob/master/Documentation/technical/pack-protocol.txt#L166
+// In 'side-band-64k' mode it will send up to 65519 data bytes plus 1 control code, for a
+// total of up to 65520 bytes in a pkt-line.
+constexpr size_t MAX_SIDEBAND_DATA {65515};
+
+GitPackCache&
+GitPackCache::instance()
+{
+    static GitPackCache cache;
+    return cache;
+}
+
+GitPackCache::Pack
+GitPackCache::get(const Key& key, const std::function<Pack(const Publish&)>& build)
+{
+    std::promise<Pack> promise;
+    std::shared_future<Pack> pack;
+    {
+        std::lock_guard lk(mutex_);
+        auto now = clock::now();
+        evict(now);
+        auto [it, inserted] = entries_.try_emplace(key);
+        if (not inserted) {
+            it->second.lastUsed = now;
+            pack = it->second.pack;
+        } else {
+            it->second.pack = promise.get_future().share();
+            it->second.lastUsed = now;
+        }
+    }
+    if (pack.valid())
+        return pack.get();
+
+    auto published = false;
+    auto publish = [&](const Pack& built) {
+        if (std::exchange(published, true))
+            return;
+        promise.set_value(built);
+
+        std::lock_guard lk(mutex_);
+        auto it = entries_.find(key);
+        if (it == entries_.end())
+            return;
+        if (not built or built->empty() or built->size() > maxSize_) {
+            entries_.erase(it);
+        } else {
+            it->second.size = built->size();
+            size_ += built->size();
+            evict(clock::now());
+        }
+    };
+
+    Pack built;
+    try {
+        built = build(publish);
+    } catch (const std::exception& e) {
+        JAMI_WARNING("Unable to build pack for {}: {}", key.want, e.what());
+    }
+    publish(built);
+    return built;
+}
+
+void
+GitPackCache::evict(clock::time_point now)
+{
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        // Packs being built are never evicted, their size is not known yet
+        if (it->second.size != 0 and now - it->second.lastUsed > ttl_) {
+            size_ -= it->second.size;
+            it = entries_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    while (size_ > maxSize_) {
+        auto oldest = entries_.end();
+        for (auto it = entries_.begin(); it != entries_.end(); ++it)
+            if (it->second.size != 0 and (oldest == entries_.end() or it->second.lastUsed < oldest->second.lastUsed))
+                oldest = it;
+        if (oldest == entries_.end())
+            break;
+        size_ -= oldest->second.size;
+        entries_.erase(oldest);
+    }
+}
+
+void
+GitPackCache::clear()
+{
+    std::lock_guard lk(mutex_);
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        if (it->second.size != 0)
+            it = entries_.erase(it);
+        else
+            ++it;
+    }
+    size_ = 0;
+}
+
+size_t
+GitPackCache::size() const
+{
+    std::lock_guard lk(mutex_);
+    return size_;
+}
+
+size_t
+GitPackCache::count() const
+{
+    std::lock_guard lk(mutex_);
+    return entries_.size();
+}
+
+class SideBandWriter;
+
 class GitServer::Impl
 {
 public:
@@ -90,7 +215,14 @@ public:
     void notifyUpToDate();
     void ACKCommon();
     bool ACKFirst();
+    bool sendShallowUpdate();
     void sendPackData();
+    bool writePack(const std::string& want,
+                   SideBandWriter& writer,
+                   GitPackCache::Pack& pack,
+                   const GitPackCache::Publish& publish = {});
+    bool insertHistory(git_repository* repo, git_packbuilder* pb, const std::string& want);
+    bool insertWindow(git_repository* repo, git_packbuilder* pb);
     std::map<std::string, std::string> getParameters(std::string_view pkt_line);
 
     std::string accountId_ {};
@@ -105,6 +237,13 @@ public:
     bool upToDateNotified_ {false};
     std::string common_ {};
     std::vector<std::string> haveRefs_ {};
+    // Shallow fetch: commits the peer has without their parents, and how
+    // many commits deep its history must be after the fetch
+    std::set<std::string> peerShallows_ {};
+    unsigned depth_ {0};
+    bool shallowUpdateSent_ {false};
+    // Commits of the history of the want within depth_
+    std::set<std::string> window_ {};
     std::string cachedPkt_ {};
     std::atomic_bool isDestroying_ {false};
     onFetchedCb onFetchedCb_ {};
@@ -157,7 +296,14 @@ GitServer::Impl::parseOrder(std::string_view buf)
             sendPackData();
         return !cachedPkt_.empty();
     } else if (pack.empty()) {
-        if (!haveRefs_.empty()) {
+        if (depth_ != 0 && sawWant_ && !shallowUpdateSent_) {
+            // End of the wants of a shallow fetch, the peer waits for the
+            // new boundary of its history before negotiating
+            // Reference:
+            // https://github.com/git/git/blob/master/Documentation/gitprotocol-pack.txt#L282
+            if (!sendShallowUpdate())
+                dht::ThreadPool::io().run([socket = socket_] { socket->shutdown(); });
+        } else if (!haveRefs_.empty()) {
             // Reference:
             // https://github.com/git/git/blob/master/Documentation/technical/pack-protocol.txt#L390
             // Do not do multi-ack, just send ACK + pack file In case of no common base ACK
@@ -222,6 +368,20 @@ GitServer::Impl::parseOrder(std::string_view buf)
                  repositoryId_,
                  fmt::ptr(this),
                  wantedReference_);
+    } else if (cmd == SHALLOW_CMD) {
+        peerShallows_.emplace(dat.substr(0, 40));
+    } else if (cmd == DEEPEN_CMD) {
+        unsigned depth = 0;
+        auto [p, ec] = std::from_chars(dat.data(), dat.data() + dat.size(), depth);
+        if (ec == std::errc() && depth != 0) {
+            depth_ = depth;
+        } else {
+            JAMI_WARNING("[Account {}] [Conversation {}] [GitServer {}] Invalid depth: {}",
+                         accountId_,
+                         repositoryId_,
+                         fmt::ptr(this),
+                         dat);
+        }
     } else if (cmd == HAVE_CMD) {
         const auto& commit = haveRefs_.emplace_back(dat.substr(0, 40));
         if (common_.empty()) {
@@ -431,8 +591,64 @@ GitServer::Impl::NAK()
     return true;
 }
 
-void
-GitServer::Impl::sendPackData()
+/**
+ * Send pack data to the peer in side-band-64k pkt-lines of band 1, as it comes.
+ */
+class SideBandWriter
+{
+public:
+    explicit SideBandWriter(dhtnet::ChannelSocketInterface& socket)
+        : socket_(socket)
+    {
+        pkt_.reserve(MAX_SIDEBAND_DATA + 5);
+        pkt_.resize(5);
+        pkt_[4] = 0x1;
+    }
+
+    bool write(const uint8_t* data, std::size_t len)
+    {
+        while (len > 0 and not ec_) {
+            auto n = std::min(len, MAX_SIDEBAND_DATA + 5 - pkt_.size());
+            pkt_.insert(pkt_.end(), data, data + n);
+            data += n;
+            len -= n;
+            if (pkt_.size() == MAX_SIDEBAND_DATA + 5)
+                send();
+        }
+        return not ec_;
+    }
+
+    /**
+     * Send what is left of the pack
+     */
+    bool finish()
+    {
+        if (pkt_.size() > 5 and not ec_)
+            send();
+        return not ec_;
+    }
+
+    const std::error_code& error() const { return ec_; }
+
+private:
+    void send()
+    {
+        auto header = toGitHex(pkt_.size());
+        std::copy(header.begin(), header.end(), pkt_.begin());
+        socket_.write(pkt_.data(), pkt_.size(), ec_);
+        pkt_.resize(5);
+    }
+
+    dhtnet::ChannelSocketInterface& socket_;
+    std::vector<uint8_t> pkt_;
+    std::error_code ec_;
+};
+
+bool
+GitServer::Impl::writePack(const std::string& want,
+                           SideBandWriter& writer,
+                           GitPackCache::Pack& pack,
+                           const GitPackCache::Publish& publish)
 {
     git_repository* repo_ptr;
     if (git_repository_open(&repo_ptr, repository_.c_str()) != 0) {
@@ -441,7 +657,7 @@ GitServer::Impl::sendPackData()
                      repositoryId_,
                      fmt::ptr(this),
                      repository_);
-        return;
+        return false;
     }
     GitRepository repo {repo_ptr};
 
@@ -452,32 +668,188 @@ GitServer::Impl::sendPackData()
                      repositoryId_,
                      fmt::ptr(this),
                      repository_);
-        return;
+        return false;
     }
     GitPackBuilder pb {pb_ptr};
 
-    std::string fetched = wantedReference_;
+    if (!(depth_ != 0 ? insertWindow(repo.get(), pb.get()) : insertHistory(repo.get(), pb.get(), want)))
+        return false;
+
+    // Produce the pack in memory, without waiting for the peer, so that it
+    // can be cached and shared as soon as it is done. Once it is too big to
+    // be kept, concurrent requests stop waiting and it is streamed.
+    struct Sink
+    {
+        SideBandWriter& writer;
+        const GitPackCache::Publish& publish;
+        std::string data {};
+        bool keep {true};
+    } sink {writer, publish};
+    auto onChunk = [](void* buf, size_t size, void* payload) -> int {
+        auto& sink = *static_cast<Sink*>(payload);
+        if (sink.keep and sink.data.size() + size > MAX_CACHED_PACK_SIZE) {
+            sink.keep = false;
+            if (sink.publish)
+                sink.publish(nullptr);
+            sink.writer.write(reinterpret_cast<const uint8_t*>(sink.data.data()), sink.data.size());
+            sink.data = {};
+        }
+        if (sink.keep) {
+            sink.data.append(static_cast<const char*>(buf), size);
+            return 0;
+        }
+        // Nobody is left to receive the pack
+        return sink.writer.write(static_cast<const uint8_t*>(buf), size) ? 0 : -1;
+    };
+    if (git_packbuilder_foreach(pb.get(), onChunk, &sink) != 0) {
+        // Interrupted because the peer is gone, reported by the caller
+        if (writer.error())
+            return true;
+        JAMI_WARNING("[Account {}] [Conversation {}] [GitServer {}] Unable to write pack data for {}",
+                     accountId_,
+                     repositoryId_,
+                     fmt::ptr(this),
+                     repository_);
+        return false;
+    }
+    if (sink.keep) {
+        pack = std::make_shared<const std::string>(std::move(sink.data));
+        if (publish)
+            publish(pack);
+        writer.write(reinterpret_cast<const uint8_t*>(pack->data()), pack->size());
+    }
+    return true;
+}
+
+/**
+ * Commits of the history of want at most depth commits deep (want is at depth
+ * 1), and the ones of them whose parents are left out. Shallow roots of this
+ * repository have no parents here, so they end the history.
+ */
+static bool
+historyWindow(git_repository* repo,
+              const std::string& want,
+              unsigned depth,
+              const std::vector<std::string>& shallowRoots,
+              std::set<std::string>& window,
+              std::set<std::string>& boundary)
+{
     git_oid oid;
-    if (git_oid_fromstr(&oid, fetched.c_str()) < 0) {
+    if (git_oid_fromstr(&oid, want.c_str()) < 0)
+        return false;
+    // Breadth first, so that a commit gets its lowest depth
+    std::deque<std::pair<git_oid, unsigned>> queue {{oid, 1}};
+    window.emplace(want);
+    while (!queue.empty()) {
+        auto [current, currentDepth] = queue.front();
+        queue.pop_front();
+        std::string id = git_oid_tostr_s(&current);
+        if (std::find(shallowRoots.begin(), shallowRoots.end(), id) != shallowRoots.end()) {
+            boundary.emplace(std::move(id));
+            continue;
+        }
+        git_commit* commit_ptr;
+        if (git_commit_lookup(&commit_ptr, repo, &current) < 0)
+            return false;
+        GitCommit commit {commit_ptr};
+        auto parentsCount = git_commit_parentcount(commit.get());
+        if (parentsCount == 0)
+            continue;
+        if (currentDepth == depth) {
+            boundary.emplace(std::move(id));
+            continue;
+        }
+        for (unsigned int p = 0; p < parentsCount; ++p) {
+            const git_oid* pid = git_commit_parent_id(commit.get(), p);
+            if (pid && window.emplace(git_oid_tostr_s(pid)).second)
+                queue.emplace_back(*pid, currentDepth + 1);
+        }
+    }
+    return true;
+}
+
+bool
+GitServer::Impl::sendShallowUpdate()
+{
+    shallowUpdateSent_ = true;
+    git_repository* repo_ptr;
+    if (git_repository_open(&repo_ptr, repository_.c_str()) != 0) {
+        JAMI_WARNING("[Account {}] [Conversation {}] [GitServer {}] Unable to open {}",
+                     accountId_,
+                     repositoryId_,
+                     fmt::ptr(this),
+                     repository_);
+        return false;
+    }
+    GitRepository repo {repo_ptr};
+
+    std::set<std::string> boundary;
+    window_.clear();
+    if (!historyWindow(repo.get(),
+                       wantedReference_,
+                       depth_,
+                       ConversationRepository::shallowRoots(repository_),
+                       window_,
+                       boundary)) {
+        JAMI_WARNING("[Account {}] [Conversation {}] [GitServer {}] Unable to walk the history of {}",
+                     accountId_,
+                     repositoryId_,
+                     fmt::ptr(this),
+                     wantedReference_);
+        return false;
+    }
+
+    std::string update;
+    for (const auto& id : boundary)
+        if (!peerShallows_.contains(id))
+            update += fmt::format(FMT_COMPILE("{:04x}shallow {}\n"),
+                                  13 + id.size() /* size + shallow + space + \n */,
+                                  id);
+    for (const auto& id : peerShallows_)
+        if (window_.contains(id) && !boundary.contains(id))
+            update += fmt::format(FMT_COMPILE("{:04x}unshallow {}\n"),
+                                  15 + id.size() /* size + unshallow + space + \n */,
+                                  id);
+    update += FLUSH_PKT;
+    std::error_code ec;
+    socket_->write(reinterpret_cast<const unsigned char*>(update.data()), update.size(), ec);
+    if (ec) {
+        JAMI_WARNING("[Account {}] [Conversation {}] [GitServer {}] Unable to send data for {}: {}",
+                     accountId_,
+                     repositoryId_,
+                     fmt::ptr(this),
+                     repository_,
+                     ec.message());
+        return false;
+    }
+    return true;
+}
+
+bool
+GitServer::Impl::insertHistory(git_repository* repo, git_packbuilder* pb, const std::string& want)
+{
+    git_oid oid;
+    if (git_oid_fromstr(&oid, want.c_str()) < 0) {
         JAMI_ERROR("[Account {}] [Conversation {}] [GitServer {}] Unable to get reference for commit {}",
                    accountId_,
                    repositoryId_,
                    fmt::ptr(this),
-                   fetched);
-        return;
+                   want);
+        return false;
     }
 
     git_revwalk* walker_ptr = nullptr;
-    if (git_revwalk_new(&walker_ptr, repo.get()) < 0 || git_revwalk_push(walker_ptr, &oid) < 0) {
+    if (git_revwalk_new(&walker_ptr, repo) < 0 || git_revwalk_push(walker_ptr, &oid) < 0) {
         if (walker_ptr)
             git_revwalk_free(walker_ptr);
-        return;
+        return false;
     }
     GitRevWalker walker {walker_ptr};
     git_revwalk_sorting(walker.get(), GIT_SORT_TOPOLOGICAL);
     // Add first commit
     std::set<std::string> parents;
     auto haveCommit = false;
+    auto shallowRoots = ConversationRepository::shallowRoots(repository_);
 
     while (!git_revwalk_next(&oid, walker.get())) {
         // log until have refs
@@ -488,24 +860,35 @@ GitServer::Impl::sendPackData()
             parents.erase(itParents);
         if (haveCommit && parents.size() == 0 /* We are sure that all commits are there */)
             break;
-        if (git_packbuilder_insert_commit(pb.get(), &oid) != 0) {
+        if (!haveCommit && std::find(shallowRoots.begin(), shallowRoots.end(), id) != shallowRoots.end()) {
+            // Our history is cut here: the peer would get commits it is unable to validate
+            JAMI_WARNING("[Account {}] [Conversation {}] [GitServer {}] History of {} not available beyond {}",
+                         accountId_,
+                         repositoryId_,
+                         fmt::ptr(this),
+                         want,
+                         id);
+            dht::ThreadPool::io().run([socket = socket_] { socket->shutdown(); });
+            return false;
+        }
+        if (git_packbuilder_insert_commit(pb, &oid) != 0) {
             JAMI_WARNING("[Account {}] [Conversation {}] [GitServer {}] Unable to open insert commit {} for {}",
                          accountId_,
                          repositoryId_,
                          fmt::ptr(this),
                          git_oid_tostr_s(&oid),
                          repository_);
-            return;
+            return false;
         }
 
         // Get next commit to pack
         git_commit* commit_ptr;
-        if (git_commit_lookup(&commit_ptr, repo.get(), &oid) < 0) {
+        if (git_commit_lookup(&commit_ptr, repo, &oid) < 0) {
             JAMI_ERROR("[Account {}] [Conversation {}] [GitServer {}] Unable to look up current commit",
                        accountId_,
                        repositoryId_,
                        fmt::ptr(this));
-            return;
+            return false;
         }
         GitCommit commit {commit_ptr};
         auto parentsCount = git_commit_parentcount(commit.get());
@@ -516,48 +899,114 @@ GitServer::Impl::sendPackData()
                 parents.emplace(git_oid_tostr_s(pid));
         }
     }
+    return true;
+}
+
+bool
+GitServer::Impl::insertWindow(git_repository* repo, git_packbuilder* pb)
+{
+    // What the peer has: the history of its haves, down to its shallow commits
+    std::set<std::string> known;
+    std::deque<git_oid> queue;
+    for (const auto& have : haveRefs_) {
+        git_oid oid;
+        if (git_oid_fromstr(&oid, have.c_str()) == 0 && known.emplace(have).second)
+            queue.emplace_back(oid);
+    }
+    while (!queue.empty()) {
+        auto oid = queue.front();
+        queue.pop_front();
+        if (peerShallows_.contains(git_oid_tostr_s(&oid)))
+            continue;
+        git_commit* commit_ptr;
+        if (git_commit_lookup(&commit_ptr, repo, &oid) < 0)
+            continue;
+        GitCommit commit {commit_ptr};
+        auto parentsCount = git_commit_parentcount(commit.get());
+        for (unsigned int p = 0; p < parentsCount; ++p) {
+            const git_oid* pid = git_commit_parent_id(commit.get(), p);
+            if (pid && known.emplace(git_oid_tostr_s(pid)).second)
+                queue.emplace_back(*pid);
+        }
+    }
 
-    git_buf data = {};
-    if (git_packbuilder_write_buf(&data, pb.get()) != 0) {
-        JAMI_WARNING("[Account {}] [Conversation {}] [GitServer {}] Unable to write pack data for {}",
+    for (const auto& id : window_) {
+        git_oid oid;
+        if (known.contains(id) || git_oid_fromstr(&oid, id.c_str()) < 0)
+            continue;
+        if (git_packbuilder_insert_commit(pb, &oid) != 0) {
+            JAMI_WARNING("[Account {}] [Conversation {}] [GitServer {}] Unable to open insert commit {} for {}",
+                         accountId_,
+                         repositoryId_,
+                         fmt::ptr(this),
+                         id,
+                         repository_);
+            return false;
+        }
+    }
+
+    // A shallow clone also needs the initial commit, it holds the mode of the
+    // conversation. Shallow peers already have it.
+    git_oid initial;
+    git_commit* initial_ptr = nullptr;
+    if (!peerShallows_.empty() || known.contains(repositoryId_) || window_.contains(repositoryId_)
+        || git_oid_fromstr(&initial, repositoryId_.c_str()) < 0 || git_commit_lookup(&initial_ptr, repo, &initial) < 0)
+        return true;
+    GitCommit initialCommit {initial_ptr};
+    if (git_packbuilder_insert_commit(pb, &initial) != 0) {
+        JAMI_WARNING("[Account {}] [Conversation {}] [GitServer {}] Unable to insert initial commit for {}",
                      accountId_,
                      repositoryId_,
                      fmt::ptr(this),
                      repository_);
-        return;
+        return false;
     }
+    return true;
+}
 
-    std::size_t sent = 0;
-    std::size_t len = data.size;
-    std::error_code ec;
-    std::vector<uint8_t> toSendData;
-    do {
-        // cf https://github.com/git/git/blob/master/Documentation/technical/pack-protocol.txt#L166
-        // In 'side-band-64k' mode it will send up to 65519 data bytes plus 1 control code, for a
-        // total of up to 65520 bytes in a pkt-line.
-        std::size_t pkt_size = std::min(static_cast<std::size_t>(65515), len - sent);
-        std::string toSendHeader = toGitHex(pkt_size + 5);
-        toSendData.clear();
-        toSendData.reserve(pkt_size + 5);
-        toSendData.insert(toSendData.end(), toSendHeader.begin(), toSendHeader.end());
-        toSendData.push_back(0x1);
-        toSendData.insert(toSendData.end(), data.ptr + sent, data.ptr + sent + pkt_size);
-
-        socket_->write(reinterpret_cast<const unsigned char*>(toSendData.data()), toSendData.size(), ec);
-        if (ec) {
-            JAMI_WARNING("[Account {}] [Conversation {}] [GitServer {}] Unable to send data for {}: {}",
-                         accountId_,
-                         repositoryId_,
-                         fmt::ptr(this),
-                         repository_,
-                         ec.message());
-            git_buf_dispose(&data);
-            return;
+void
+GitServer::Impl::sendPackData()
+{
+    std::string fetched = wantedReference_;
+    GitPackCache::Key key {repository_, fetched, haveRefs_};
+    std::sort(key.haves.begin(), key.haves.end());
+    key.haves.erase(std::unique(key.haves.begin(), key.haves.end()), key.haves.end());
+    if (depth_ != 0) {
+        key.depth = depth_;
+        key.shallows.assign(peerShallows_.begin(), peerShallows_.end());
+    }
+
+    SideBandWriter writer(*socket_);
+    auto built = false;
+    auto packed = false;
+    auto pack = GitPackCache::instance().get(key, [&](const GitPackCache::Publish& publish) {
+        built = true;
+        GitPackCache::Pack pack;
+        packed = writePack(fetched, writer, pack, publish);
+        return pack;
+    });
+    if (not built) {
+        if (pack) {
+            packed = true;
+            writer.write(reinterpret_cast<const uint8_t*>(pack->data()), pack->size());
+        } else {
+            // The concurrent build failed or was too big to be shared
+            packed = writePack(fetched, writer, pack);
         }
-        sent += pkt_size;
-    } while (sent < len);
-    git_buf_dispose(&data);
-    toSendData = {};
+    }
+    if (not packed)
+        return;
+
+    std::error_code ec;
+    if (not writer.finish()) {
+        JAMI_WARNING("[Account {}] [Conversation {}] [GitServer {}] Unable to send data for {}: {}",
+                     accountId_,
+                     repositoryId_,
+                     fmt::ptr(this),
+                     repository_,
+                     writer.error().message());
+        return;
+    }
 
     // And finish by a little FLUSH
     socket_->write(reinterpret_cast<const uint8_t*>(FLUSH_PKT.data()), FLUSH_PKT.size(), ec);
@@ -574,6 +1023,10 @@ GitServer::Impl::sendPackData()
     haveRefs_.clear();
     wantedReference_.clear();
     common_.clear();
+    peerShallows_.clear();
+    depth_ = 0;
+    shallowUpdateSent_ = false;
+    window_.clear();
     if (onFetchedCb_)
         onFetchedCb_(fetched);
 }
@@ -16,11 +16,17 @@
  */
 #pragma once
 
+#include <chrono>
 #include <functional>
+#include <future>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include "def.h"
+#include "noncopyable.h"
 #include "jamidht/conversationrepository.h"
 
 namespace dhtnet {
@@ -31,6 +37,83 @@ namespace jami {
 
 using onFetchedCb = std::function<void(const std::string&)>;
 
+/**
+ * Packs recently sent by GitServers, shared by all of them.
+ *
+ * After a message is posted in a large swarm, most members fetch the same
+ * range within seconds. A pack only depends on the repository, the wanted
+ * commit and what the peer has, so it is built once and kept for a while.
+ * Requests for a pack being built wait for that build instead of starting
+ * their own.
+ */
+class LIBJAMI_TEST_EXPORT GitPackCache
+{
+public:
+    using clock = std::chrono::steady_clock;
+    using Pack = std::shared_ptr<const std::string>;
+
+    struct Key
+    {
+        std::string repository;
+        std::string want;
+        std::vector<std::string> haves;       // sorted, without duplicates
+        unsigned depth {0};                   // shallow fetch only
+        std::vector<std::string> shallows {}; // sorted, shallow fetch only
+
+        auto operator<=>(const Key&) const = default;
+    };
+
+    static constexpr size_t DEFAULT_MAX_SIZE {32 * 1024 * 1024};
+    static constexpr std::chrono::minutes DEFAULT_TTL {5};
+
+    explicit GitPackCache(size_t maxSize = DEFAULT_MAX_SIZE, clock::duration ttl = DEFAULT_TTL)
+        : maxSize_(maxSize)
+        , ttl_(ttl)
+    {}
+
+    static GitPackCache& instance();
+
+    // Hands the built pack to the concurrent requests, nullptr if it is not
+    // to be shared
+    using Publish = std::function<void(const Pack&)>;
+
+    /**
+     * Return the pack for key, calling build if it is neither cached nor
+     * being built. build runs on the calling thread and returns nullptr if
+     * the pack is not to be shared (failure, or too big to be kept); in that
+     * case concurrent requests for the same key also get nullptr.
+     * Concurrent requests wait until build returns or calls publish, which
+     * it may do before sending the pack to its own peer.
+     */
+    Pack get(const Key& key, const std::function<Pack(const Publish&)>& build);
+    Pack get(const Key& key, const std::function<Pack()>& build)
+    {
+        return get(key, [&](const Publish&) { return build(); });
+    }
+
+    void clear();
+    size_t size() const;
+    size_t count() const;
+
+private:
+    NON_COPYABLE(GitPackCache);
+
+    struct Entry
+    {
+        std::shared_future<Pack> pack;
+        size_t size {0}; // 0 while building
+        clock::time_point lastUsed {};
+    };
+
+    void evict(clock::time_point now);
+
+    const size_t maxSize_;
+    const clock::duration ttl_;
+    mutable std::mutex mutex_;
+    std::map<Key, Entry> entries_;
+    size_t size_ {0};
+};
+
 /**
  * This class offers to a ChannelSocket the possibility to interact with a Git repository
  */
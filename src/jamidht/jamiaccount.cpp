@@ -31,6 +31,8 @@
 #include "archive_account_manager.h"
 #include "server_account_manager.h"
 #include "jamidht/commit_message.h"
+#include "jamidht/file_digest_cache.h"
+#include "jamidht/file_store.h"
 #include "jamidht/channeled_transport.h"
 #include "jamidht/collaborative_editing.h"
 #include "conversation_channel_handler.h"
@@ -40,6 +42,7 @@
 #include "auth_channel_handler.h"
 #include "transfer_channel_handler.h"
 #include "swarm/swarm_channel_handler.h"
+#include "swarm/certificate_lookups.h"
 #include "service_manager.h"
 #include "svc_discovery_channel_handler.h"
 #include "svc_tunnel_channel_handler.h"
@@ -315,6 +318,7 @@ JamiAccount::JamiAccount(const std::string& accountId)
     , dataPath_(cachePath_ / "values")
     , logger_(Logger::dhtLogger(fmt::format("Account {}", accountId)))
     , certStore_ {std::make_shared<dhtnet::tls::CertificateStore>(idPath_, logger_)}
+    , certificateLookups_ {std::make_shared<CertificateLookups>()}
     , dht_(std::make_shared<dht::DhtRunner>())
     , treatedMessages_(cachePath_ / TREATED_PATH)
     , presenceManager_(std::make_unique<PresenceManager>(dht_))
@@ -3498,6 +3502,15 @@ JamiAccount::closeServiceTunnel(const std::string& tunnelId)
     return handler->closeTunnel(tunnelId);
 }
 
+bool
+JamiAccount::setServiceTunnelPoolSize(const std::string& tunnelId, uint32_t poolSize)
+{
+    auto* handler = static_cast<SvcTunnelChannelHandler*>(channelHandlers_[Uri::Scheme::SVC_TUNNEL].get());
+    if (!handler)
+        return false;
+    return handler->setPoolSize(tunnelId, poolSize);
+}
+
 void
 JamiAccount::closeServerTunnelsForService(const std::string& serviceId)
 {
@@ -3525,7 +3538,20 @@ JamiAccount::getActiveServiceTunnels() const
                        {"deviceId", t.peerDevice},
                        {"serviceId", t.serviceId},
                        {"serviceName", t.serviceName},
-                       {"localPort", std::to_string(t.localPort)}});
+                       {"localPort", std::to_string(t.localPort)},
+                       {"poolSize", std::to_string(t.poolSize)},
+                       {"pooledChannels", std::to_string(t.pooled)},
+                       {"connections", std::to_string(t.connections)},
+                       {"pooledConnections", std::to_string(t.pooledConnections)},
+                       {"lastSetupLatencyMs", std::to_string(t.lastSetupLatency.count())},
+                       {"averageSetupLatencyMs", std::to_string(t.averageSetupLatency.count())},
+                       {"bytesFromPeer", std::to_string(t.traffic.bytesFromPeer)},
+                       {"bytesToPeer", std::to_string(t.traffic.bytesToPeer)},
+                       {"rateFromPeer", std::to_string(t.traffic.rateFromPeer)},
+                       {"rateToPeer", std::to_string(t.traffic.rateToPeer)},
+                       {"queuedBytes", std::to_string(t.traffic.queuedBytes)},
+                       {"peakQueuedBytes", std::to_string(t.traffic.peakQueuedBytes)},
+                       {"flowPauses", std::to_string(t.traffic.pauses)}});
     }
     return out;
 }
@@ -3849,13 +3875,11 @@ void
 JamiAccount::onMessageSent(
     const std::string& to, uint64_t id, const std::string& deviceId, bool success, bool onlyConnected, bool retry)
 {
+    // The engine retries its own messages with a backoff
     if (!onlyConnected)
-        messageEngine_.onMessageSent(to, id, success, deviceId);
-
-    if (!success) {
-        if (retry)
-            messageEngine_.onPeerOnline(to, deviceId);
-    }
+        messageEngine_.onMessageSent(to, id, success, deviceId, retry);
+    else if (!success && retry)
+        messageEngine_.onPeerOnline(to, deviceId);
 }
 
 dhtnet::IceTransportOptions
@@ -4705,18 +4729,22 @@ JamiAccount::sendFile(const std::string& conversationId,
         if (auto shared = w.lock()) {
             auto tid = jami::generateUID(shared->rand);
             auto displayName = name.empty() ? path.filename().string() : name;
-            auto commitMessage = CommitMessage::fileSent(displayName, fileutils::sha3File(path), tid, fileSize, replyTo);
+            auto sha3sum = FileDigestCache::instance().sha3(path);
+            auto commitMessage = CommitMessage::fileSent(displayName, sha3sum, tid, fileSize, replyTo);
 
             shared->convModule()->createCommit(
                 conversationId,
                 std::move(commitMessage),
                 true,
-                [accId = shared->getAccountID(), conversationId, tid, displayName, path](const std::string& commitId) {
+                [accId = shared->getAccountID(), conversationId, tid, displayName, path, sha3sum](
+                    const std::string& commitId) {
                     // Create a symlink to answer to re-ask
                     auto filelinkPath = fileutils::get_data_dir() / accId / "conversation_data" / conversationId
                                         / getFileId(commitId, std::to_string(tid), displayName);
                     if (path != filelinkPath && !std::filesystem::is_symlink(filelinkPath)) {
-                        if (!fileutils::createFileLink(filelinkPath, path, true)) {
+                        // A received file forwarded to another conversation is shared with it
+                        if (!FileStore::instance().link(sha3sum, filelinkPath)
+                            && !fileutils::createFileLink(filelinkPath, path, true)) {
                             JAMI_WARNING("Unable to create symlink for file transfer {} - {}. Copy file",
                                          filelinkPath,
                                          path);
@@ -4818,7 +4846,39 @@ JamiAccount::askForFileChannel(const std::string& conversationId,
                                size_t start,
                                size_t end)
 {
+    auto requestRange = [w = weak(), conversationId, fileId](const std::string& deviceId,
+                                                             uint64_t start,
+                                                             uint64_t length,
+                                                             ChunkedFile::ChannelCb&& cb) {
+        auto shared = w.lock();
+        if (!shared)
+            return;
+        std::shared_lock lkCM(shared->connManagerMtx_);
+        if (!shared->connectionManager_) {
+            cb(nullptr);
+            return;
+        }
+        auto channelName = fmt::format("{}{}/{}/{}?start={}&length={}",
+                                       DATA_TRANSFER_SCHEME,
+                                       conversationId,
+                                       shared->currentDeviceId(),
+                                       fileId,
+                                       start,
+                                       length);
+        shared->connectionManager_->connectDevice(
+            DeviceId(deviceId),
+            channelName,
+            [cb = std::move(cb)](const std::shared_ptr<dhtnet::ChannelSocket>& channel, const DeviceId&) {
+                dht::ThreadPool::io().run([cb, channel] { cb(channel); });
+            },
+            false);
+    };
+    // Large files are downloaded by chunks from every device that has them
+    auto dt = interactionId.empty() || end != 0 ? nullptr : dataTransfer(conversationId);
+
     auto tryDevice = [=](const auto& did) {
+        if (dt && dt->downloadFromDevice(fileId, did.toString(), requestRange))
+            return;
         std::shared_lock lkCM(connManagerMtx_);
         if (!connectionManager_)
             return;
@@ -85,6 +85,7 @@ namespace test {
 class Account_factoryTest;
 }
 class CollaborativeEditing;
+class CertificateLookups;
 
 using SipConnectionKey = std::pair<std::string /* uri */, DeviceId>;
 
@@ -587,6 +588,9 @@ public:
 
     dhtnet::tls::CertificateStore& certStore() const { return *certStore_; }
 
+    /// Device certificate lookups of the swarm managers of the account's conversations
+    const std::shared_ptr<CertificateLookups>& certificateLookups() const { return certificateLookups_; }
+
     /// Returns true if `peerAccountUri` is an active
     /// contact of this account.
     bool isContact(const std::string& peerAccountUri) const;
@@ -616,6 +620,9 @@ public:
     /// Close a tunnel previously created with openServiceTunnel.
     bool closeServiceTunnel(const std::string& tunnelId);
 
+    /// Number of channels kept pre-opened for a tunnel (0 to disable).
+    bool setServiceTunnelPoolSize(const std::string& tunnelId, uint32_t poolSize);
+
     /// Server-side: shutdown every active inbound tunnel currently serving
     /// `serviceId`. Called when a local exposed service is removed or
     /// disabled so that already-established peer connections are torn down.
@@ -834,6 +841,7 @@ private:
 
     std::shared_ptr<dht::Logger> logger_;
     std::shared_ptr<dhtnet::tls::CertificateStore> certStore_;
+    std::shared_ptr<CertificateLookups> certificateLookups_;
 
     std::unique_ptr<class ServiceManager> serviceManager_;
 
@@ -0,0 +1,539 @@
+/*
+ *  Copyright (C) 2004-2026 Savoir-faire Linux Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "journal_store.h"
+
+#include "fileutils.h"
+#include "logger.h"
+
+#include <dhtnet/fileutils.h>
+#include <msgpack.hpp>
+#include <zlib.h>
+
+#include <cerrno>
+#include <fstream>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace jami {
+
+static constexpr std::string_view MAGIC {"JKVS"};
+static constexpr size_t HEADER_SIZE {8};
+// Size and checksum of a record
+static constexpr size_t RECORD_HEADER_SIZE {8};
+
+static void
+appendU32(std::string& out, uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+}
+
+static uint32_t
+readU32(const std::string& data, size_t pos)
+{
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i)
+        value |= static_cast<uint32_t>(static_cast<uint8_t>(data[pos + i])) << (8 * i);
+    return value;
+}
+
+static uint32_t
+checksum(const char* data, size_t size)
+{
+    return static_cast<uint32_t>(crc32(crc32(0L, Z_NULL, 0), reinterpret_cast<const Bytef*>(data), size));
+}
+
+static std::string
+header()
+{
+    std::string out(MAGIC);
+    appendU32(out, JournalStore::VERSION);
+    return out;
+}
+
+/**
+ * Write data to path, appended or replacing its content, and return once it
+ * is synced to disk
+ */
+static bool
+writeSynced(const std::filesystem::path& path, const std::string& data, bool append)
+{
+#ifdef _WIN32
+    int fd = _wopen(path.c_str(),
+                    _O_WRONLY | _O_CREAT | _O_BINARY | (append ? _O_APPEND : _O_TRUNC),
+                    _S_IREAD | _S_IWRITE);
+#else
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | (append ? O_APPEND : O_TRUNC), 0644);
+#endif
+    if (fd < 0)
+        return false;
+    size_t written = 0;
+    auto ok = true;
+    while (ok and written < data.size()) {
+#ifdef _WIN32
+        auto ret = _write(fd, data.data() + written, static_cast<unsigned>(data.size() - written));
+#else
+        auto ret = ::write(fd, data.data() + written, data.size() - written);
+#endif
+        if (ret > 0)
+            written += static_cast<size_t>(ret);
+        else if (ret < 0 and errno == EINTR)
+            continue;
+        else
+            ok = false;
+    }
+#ifdef _WIN32
+    ok = ok and _commit(fd) == 0;
+    ok = _close(fd) == 0 and ok;
+#else
+    ok = ok and ::fsync(fd) == 0;
+    ok = ::close(fd) == 0 and ok;
+#endif
+    return ok;
+}
+
+/**
+ * Sync the entries of a directory, for a file renamed into it to stay there
+ */
+static void
+syncDirectory(const std::filesystem::path& dir)
+{
+#ifndef _WIN32
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+        return;
+    ::fsync(fd);
+    ::close(fd);
+#else
+    (void) dir;
+#endif
+}
+
+// Approximate size of the record of a live value
+static size_t
+recordSize(const std::string& key, const std::string& value)
+{
+    return RECORD_HEADER_SIZE + key.size() + value.size() + 8;
+}
+
+JournalStore::JournalStore(std::filesystem::path path)
+    : path_(std::move(path))
+{
+    std::error_code ec;
+    std::string data;
+    if (std::filesystem::is_regular_file(path_, ec)) {
+        std::lock_guard lock(dhtnet::fileutils::getFileLock(path_));
+        try {
+            auto file = fileutils::loadFile(path_);
+            data.assign(file.begin(), file.end());
+        } catch (const std::exception& e) {
+            JAMI_WARNING("Unable to read journal {}: {}", path_, e.what());
+        }
+    }
+
+    size_t skipped = 0;
+    auto end = parse(data, values_, &skipped);
+    for (const auto& [key, value] : values_)
+        liveSize_ += recordSize(key, value);
+
+    if (end == 0) {
+        if (not data.empty())
+            JAMI_WARNING("Ignoring invalid journal {}", path_);
+        fileSize_ = rewrite(path_, values_);
+        return;
+    }
+    if (skipped != 0) {
+        // Not left for the next appends to follow
+        JAMI_WARNING("Skipped {} invalid bytes in journal {}", skipped, path_);
+        fileSize_ = rewrite(path_, values_);
+        return;
+    }
+    if (end < data.size()) {
+        // Interrupted while appending: drop the torn record
+        JAMI_WARNING("Dropping {} bytes at the end of journal {}", data.size() - end, path_);
+        std::lock_guard lock(dhtnet::fileutils::getFileLock(path_));
+        std::filesystem::resize_file(path_, end, ec);
+    }
+    fileSize_ = end;
+    if (fileSize_ > COMPACTION_THRESHOLD and fileSize_ > 2 * liveSize_)
+        fileSize_ = rewrite(path_, values_);
+}
+
+JournalStore::~JournalStore()
+{
+    flush();
+}
+
+bool
+JournalStore::isJournal(const std::filesystem::path& path)
+{
+    std::lock_guard lock(dhtnet::fileutils::getFileLock(path));
+    std::ifstream file(path, std::ios::binary);
+    std::string data(HEADER_SIZE, '\0');
+    if (not file.read(data.data(), static_cast<std::streamsize>(data.size())))
+        return false;
+    return data.compare(0, MAGIC.size(), MAGIC) == 0 and readU32(data, MAGIC.size()) == VERSION;
+}
+
+std::map<std::string, std::string>
+JournalStore::read(const std::filesystem::path& path)
+{
+    std::map<std::string, std::string> values;
+    std::string data;
+    {
+        std::lock_guard lock(dhtnet::fileutils::getFileLock(path));
+        auto file = fileutils::loadFile(path);
+        data.assign(file.begin(), file.end());
+    }
+    parse(data, values);
+    return values;
+}
+
+bool
+JournalStore::write(const std::filesystem::path& path, const std::map<std::string, std::string>& values)
+{
+    return rewrite(path, values) != 0;
+}
+
+std::optional<std::string>
+JournalStore::get(const std::string& key) const
+{
+    std::lock_guard lk(mutex_);
+    auto it = values_.find(key);
+    if (it == values_.end())
+        return std::nullopt;
+    return it->second;
+}
+
+std::map<std::string, std::string>
+JournalStore::values() const
+{
+    std::lock_guard lk(mutex_);
+    return values_;
+}
+
+size_t
+JournalStore::size() const
+{
+    std::lock_guard lk(mutex_);
+    return values_.size();
+}
+
+void
+JournalStore::put(const std::string& key, std::string value)
+{
+    std::unique_lock lk(mutex_);
+    auto [it, inserted] = values_.try_emplace(key);
+    if (not inserted) {
+        if (it->second == value)
+            return;
+        liveSize_ -= recordSize(key, it->second);
+    }
+    it->second = std::move(value);
+    liveSize_ += recordSize(key, it->second);
+    appendRecord(pending_, PUT, key, it->second);
+    commit(lk, ++queued_);
+}
+
+void
+JournalStore::erase(const std::string& key)
+{
+    std::unique_lock lk(mutex_);
+    auto it = values_.find(key);
+    if (it == values_.end())
+        return;
+    liveSize_ -= recordSize(key, it->second);
+    values_.erase(it);
+    appendRecord(pending_, ERASE, key, {});
+    commit(lk, ++queued_);
+}
+
+void
+JournalStore::update(const std::map<std::string, std::optional<std::string>>& changes)
+{
+    sync(stage(changes));
+}
+
+uint64_t
+JournalStore::stage(const std::map<std::string, std::optional<std::string>>& changes)
+{
+    std::lock_guard lk(mutex_);
+    auto changed = false;
+    for (const auto& [key, value] : changes) {
+        auto it = values_.find(key);
+        if (not value) {
+            if (it == values_.end())
+                continue;
+            liveSize_ -= recordSize(key, it->second);
+            values_.erase(it);
+            appendRecord(pending_, ERASE, key, {});
+        } else {
+            if (it != values_.end()) {
+                if (it->second == *value)
+                    continue;
+                liveSize_ -= recordSize(key, it->second);
+                it->second = *value;
+            } else {
+                values_.emplace(key, *value);
+            }
+            liveSize_ += recordSize(key, *value);
+            appendRecord(pending_, PUT, key, *value);
+        }
+        changed = true;
+    }
+    return changed ? ++queued_ : 0;
+}
+
+void
+JournalStore::sync(uint64_t ticket)
+{
+    if (ticket == 0)
+        return;
+    std::unique_lock lk(mutex_);
+    commit(lk, ticket);
+}
+
+void
+JournalStore::flush()
+{
+    std::unique_lock lk(mutex_);
+    commit(lk, queued_);
+}
+
+void
+JournalStore::assign(const std::map<std::string, std::string>& values)
+{
+    std::unique_lock lk(mutex_);
+    auto changed = false;
+    for (auto it = values_.begin(); it != values_.end();) {
+        if (values.find(it->first) != values.end()) {
+            ++it;
+            continue;
+        }
+        liveSize_ -= recordSize(it->first, it->second);
+        appendRecord(pending_, ERASE, it->first, {});
+        it = values_.erase(it);
+        changed = true;
+    }
+    for (const auto& [key, value] : values) {
+        auto [it, inserted] = values_.try_emplace(key);
+        if (not inserted) {
+            if (it->second == value)
+                continue;
+            liveSize_ -= recordSize(key, it->second);
+        }
+        it->second = value;
+        liveSize_ += recordSize(key, value);
+        appendRecord(pending_, PUT, key, value);
+        changed = true;
+    }
+    if (changed)
+        commit(lk, ++queued_);
+}
+
+size_t
+JournalStore::fileSize() const
+{
+    std::lock_guard lk(mutex_);
+    return fileSize_;
+}
+
+void
+JournalStore::compact()
+{
+    std::unique_lock lk(mutex_);
+    compactionRequested_ = true;
+    commit(lk, ++queued_);
+}
+
+void
+JournalStore::onCompacted(std::function<void()>&& cb)
+{
+    std::lock_guard lk(mutex_);
+    onCompacted_ = std::move(cb);
+}
+
+void
+JournalStore::appendRecord(std::string& out, Op op, const std::string& key, const std::string& value)
+{
+    msgpack::sbuffer buffer;
+    msgpack::packer<msgpack::sbuffer> pk(&buffer);
+    pk.pack_array(3);
+    pk.pack(static_cast<uint8_t>(op));
+    pk.pack(key);
+    pk.pack_bin(static_cast<uint32_t>(value.size()));
+    pk.pack_bin_body(value.data(), static_cast<uint32_t>(value.size()));
+    appendU32(out, static_cast<uint32_t>(buffer.size()));
+    appendU32(out, checksum(buffer.data(), buffer.size()));
+    out.append(buffer.data(), buffer.size());
+}
+
+bool
+JournalStore::parseRecord(const std::string& data, size_t pos, std::map<std::string, std::string>& values)
+{
+    if (data.size() - pos < RECORD_HEADER_SIZE)
+        return false;
+    auto size = readU32(data, pos);
+    auto crc = readU32(data, pos + 4);
+    if (data.size() - pos - RECORD_HEADER_SIZE < size)
+        return false;
+    const auto* payload = data.data() + pos + RECORD_HEADER_SIZE;
+    if (checksum(payload, size) != crc)
+        return false;
+    try {
+        auto oh = msgpack::unpack(payload, size);
+        const auto& record = oh.get();
+        if (record.type != msgpack::type::ARRAY or record.via.array.size != 3)
+            return false;
+        auto op = record.via.array.ptr[0].as<uint8_t>();
+        auto key = record.via.array.ptr[1].as<std::string>();
+        if (op == PUT) {
+            const auto& value = record.via.array.ptr[2];
+            if (value.type != msgpack::type::BIN)
+                return false;
+            values.insert_or_assign(std::move(key), std::string(value.via.bin.ptr, value.via.bin.size));
+        } else if (op == ERASE) {
+            values.erase(key);
+        } else {
+            return false;
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+    return true;
+}
+
+size_t
+JournalStore::parse(const std::string& data, std::map<std::string, std::string>& values, size_t* skipped)
+{
+    if (data.size() < HEADER_SIZE or data.compare(0, MAGIC.size(), MAGIC) != 0
+        or readU32(data, MAGIC.size()) != VERSION)
+        return 0;
+
+    size_t pos = HEADER_SIZE;
+    size_t end = pos;
+    size_t damaged = 0;
+    while (pos < data.size()) {
+        if (not parseRecord(data, pos, values)) {
+            // The records after a damaged one are still valid: look for the
+            // next one. Without any, this is the torn tail.
+            pos++;
+            continue;
+        }
+        damaged += pos - end;
+        pos += RECORD_HEADER_SIZE + readU32(data, pos);
+        end = pos;
+    }
+    if (skipped)
+        *skipped = damaged;
+    return end;
+}
+
+void
+JournalStore::commit(std::unique_lock<std::mutex>& lk, uint64_t ticket)
+{
+    while (committed_ < ticket) {
+        if (writing_) {
+            cv_.wait(lk);
+            continue;
+        }
+        // Write everything queued so far, ours included
+        writing_ = true;
+        auto upto = queued_;
+        auto records = std::move(pending_);
+        pending_.clear();
+        std::optional<std::map<std::string, std::string>> snapshot;
+        if (compactionRequested_
+            or (fileSize_ + records.size() > COMPACTION_THRESHOLD and fileSize_ + records.size() > 2 * liveSize_)) {
+            compactionRequested_ = false;
+            snapshot = values_;
+        }
+        std::function<void()> onCompacted;
+        lk.unlock();
+        size_t written = 0;
+        if (snapshot)
+            written = rewrite(path_, *snapshot);
+        else if (append(records, fileSize_))
+            written = fileSize_ + records.size();
+        lk.lock();
+        if (snapshot and written != 0)
+            onCompacted = std::move(onCompacted_);
+        if (written != 0)
+            fileSize_ = written;
+        else
+            // The records are only in memory: the file is rewritten with the next change
+            compactionRequested_ = true;
+        writing_ = false;
+        committed_ = upto;
+        cv_.notify_all();
+        if (onCompacted) {
+            lk.unlock();
+            onCompacted();
+            lk.lock();
+        }
+    }
+}
+
+bool
+JournalStore::append(const std::string& records, size_t offset)
+{
+    std::lock_guard lock(dhtnet::fileutils::getFileLock(path_));
+    if (writeSynced(path_, records, true))
+        return true;
+    // Drop what was written of the records, the next appends would follow it
+    JAMI_WARNING("Unable to write journal {}", path_);
+    std::error_code ec;
+    std::filesystem::resize_file(path_, offset, ec);
+    return false;
+}
+
+size_t
+JournalStore::rewrite(const std::filesystem::path& path, const std::map<std::string, std::string>& values)
+{
+    auto data = header();
+    for (const auto& [key, value] : values)
+        appendRecord(data, PUT, key, value);
+
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+    auto tmpPath = path;
+    tmpPath += ".tmp";
+    std::lock_guard lock(dhtnet::fileutils::getFileLock(path));
+    // Synced before the rename: a crash must not leave an empty journal
+    if (not writeSynced(tmpPath, data, false)) {
+        JAMI_WARNING("Unable to write journal {}", path);
+        std::filesystem::remove(tmpPath, ec);
+        return 0;
+    }
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        JAMI_WARNING("Unable to replace journal {}: {}", path, ec.message());
+        return 0;
+    }
+    syncDirectory(path.parent_path());
+    return data.size();
+}
+
+} // namespace jami
@@ -0,0 +1,173 @@
+/*
+ *  Copyright (C) 2004-2026 Savoir-faire Linux Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "noncopyable.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+
+namespace jami {
+
+/**
+ * Small key-value store persisted as an append-only journal.
+ *
+ * Every change appends a record (upsert or erase of one key) instead of
+ * rewriting the whole file. Records carry their size and a CRC32: a record
+ * torn by a crash is dropped when the journal is opened, and the valid
+ * records after a damaged one are still read. An append that fails is
+ * truncated away and the next change rewrites the whole file. Once
+ * superseded records weigh more than the live data, the journal is compacted
+ * by writing the live values to a new file that replaces it.
+ *
+ * Writes are group committed: the first writer to find no write in progress
+ * appends every record queued so far and syncs the file once, the others wait
+ * for it. put(), erase(), update() and assign() return once their change is
+ * synced to disk. Callers that must not wait, e.g. with a lock held, stage()
+ * their changes and sync() them later: the changes staged meanwhile are
+ * written together.
+ * Only one instance may write a given file, read() may be used concurrently.
+ */
+class JournalStore
+{
+public:
+    static constexpr uint32_t VERSION {1};
+    // Below this size, the journal is never compacted
+    static constexpr size_t COMPACTION_THRESHOLD {64 * 1024};
+
+    /**
+     * Open or create the journal at path, dropping any torn or damaged record
+     */
+    explicit JournalStore(std::filesystem::path path);
+    /**
+     * Write the changes still staged
+     */
+    ~JournalStore();
+
+    /**
+     * @return true if path holds a journal of this version
+     */
+    static bool isJournal(const std::filesystem::path& path);
+
+    /**
+     * Read the values of a journal without opening it for writing
+     */
+    static std::map<std::string, std::string> read(const std::filesystem::path& path);
+
+    /**
+     * Atomically replace the file at path by a journal holding values
+     */
+    static bool write(const std::filesystem::path& path, const std::map<std::string, std::string>& values);
+
+    std::optional<std::string> get(const std::string& key) const;
+    std::map<std::string, std::string> values() const;
+    // Number of keys
+    size_t size() const;
+
+    void put(const std::string& key, std::string value);
+    void erase(const std::string& key);
+
+    /**
+     * Put, or erase for nullopt, several keys with a single write
+     */
+    void update(const std::map<std::string, std::optional<std::string>>& changes);
+
+    /**
+     * Make the store hold exactly values. Only keys that changed are written.
+     */
+    void assign(const std::map<std::string, std::string>& values);
+
+    /**
+     * Apply changes like update(), without writing them
+     * @return the ticket to give to sync(), 0 if nothing changed
+     */
+    uint64_t stage(const std::map<std::string, std::optional<std::string>>& changes);
+    /**
+     * Return once the changes of ticket, and the ones staged before, are on disk
+     */
+    void sync(uint64_t ticket);
+    /**
+     * Return once every change staged is on disk
+     */
+    void flush();
+
+    /**
+     * Size of the journal on disk, superseded records included
+     */
+    size_t fileSize() const;
+
+    void compact();
+
+    /**
+     * Set the callback called once, after the next successful compaction
+     */
+    void onCompacted(std::function<void()>&& cb);
+
+private:
+    NON_COPYABLE(JournalStore);
+
+    enum Op : uint8_t { PUT = 0, ERASE };
+
+    static void appendRecord(std::string& out, Op op, const std::string& key, const std::string& value);
+    /**
+     * Apply the record of data at pos to values
+     * @return false if there is no valid record there
+     */
+    static bool parseRecord(const std::string& data, size_t pos, std::map<std::string, std::string>& values);
+    /**
+     * Apply the valid records of data to values, skipping the damaged ones
+     * @param skipped  Set to the size of the damaged records before the last valid one
+     * @return end of the last valid record, 0 if the header is invalid
+     */
+    static size_t parse(const std::string& data, std::map<std::string, std::string>& values, size_t* skipped = nullptr);
+
+    // @return size of the new file, 0 on failure
+    static size_t rewrite(const std::filesystem::path& path, const std::map<std::string, std::string>& values);
+
+    /**
+     * Write the records of pending_ until the ones of ticket are on disk
+     */
+    void commit(std::unique_lock<std::mutex>& lk, uint64_t ticket);
+    /**
+     * Append records to the file and sync it. It is truncated back to offset
+     * if they are unable to be written
+     */
+    bool append(const std::string& records, size_t offset);
+
+    const std::filesystem::path path_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::map<std::string, std::string> values_;
+    size_t liveSize_ {0};
+    size_t fileSize_ {0};
+
+    // Group commit
+    std::string pending_;
+    uint64_t queued_ {0};
+    uint64_t committed_ {0};
+    bool writing_ {false};
+    bool compactionRequested_ {false};
+    std::function<void()> onCompacted_;
+};
+
+} // namespace jami
@@ -0,0 +1,355 @@
+/*
+ *  Copyright (C) 2004-2026 Savoir-faire Linux Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "message_search_index.h"
+
+#include "conversationrepository.h"
+#include "fileutils.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <fstream>
+#include <optional>
+#include <regex>
+
+namespace jami {
+
+// Rewrite the journal on load once superseded records outnumber documents by this much
+static constexpr size_t COMPACTION_THRESHOLD {1024};
+
+static bool
+isSearchable(const std::string& type)
+{
+    return type == CommitType::TEXT || type == CommitType::DATA_TRANSFER;
+}
+
+static bool
+isLiteral(std::string_view pattern)
+{
+    return pattern.find_first_of("\\^$.|?*+()[]{}") == std::string_view::npos;
+}
+
+static bool
+isTokenChar(unsigned char c)
+{
+    return c >= 0x80 or (c >= '0' and c <= '9') or (c >= 'a' and c <= 'z') or (c >= 'A' and c <= 'Z');
+}
+
+std::vector<std::string>
+MessageSearchIndex::tokenize(std::string_view text)
+{
+    std::vector<std::string> tokens;
+    std::string token;
+    for (unsigned char c : text) {
+        if (isTokenChar(c)) {
+            token += static_cast<char>(c >= 'A' and c <= 'Z' ? c - 'A' + 'a' : c);
+        } else if (not token.empty()) {
+            tokens.emplace_back(std::move(token));
+            token.clear();
+        }
+    }
+    if (not token.empty())
+        tokens.emplace_back(std::move(token));
+    return tokens;
+}
+
+bool
+MessageSearchIndex::load()
+{
+    if (loaded_)
+        return true;
+    loaded_ = true;
+
+    std::error_code ec;
+    if (not std::filesystem::is_regular_file(path_, ec))
+        return false;
+    try {
+        auto data = fileutils::loadFile(path_);
+        msgpack::unpacker pac;
+        pac.reserve_buffer(data.size());
+        std::copy(data.begin(), data.end(), pac.buffer());
+        pac.buffer_consumed(data.size());
+
+        msgpack::object_handle oh;
+        if (not pac.next(oh) or oh.get().as<uint32_t>() != VERSION)
+            throw std::runtime_error("unsupported version");
+        while (pac.next(oh))
+            apply(oh.get().as<SearchIndexRecord>());
+        // An interrupted flush leaves a partial record
+        if (pac.nonparsed_size() != 0)
+            throw std::runtime_error("truncated file");
+        if (records_ > 2 * documents_.size() + COMPACTION_THRESHOLD and not write())
+            JAMI_WARNING("Unable to compact search index {}", path_);
+        return true;
+    } catch (const std::exception& e) {
+        JAMI_WARNING("Ignoring invalid search index {}: {}", path_, e.what());
+    }
+    clear();
+    return false;
+}
+
+void
+MessageSearchIndex::add(const ConversationCommit& commit)
+{
+    const auto& msg = commit.commitMsg;
+    // Merges carry no message and reactions are not searched
+    if (commit.parents.size() > 1 or msg.type.empty() or not msg.reactTo.empty())
+        return;
+
+    SearchIndexRecord record;
+    record.id = commit.id;
+    if (not msg.editedId.empty()) {
+        record.kind = SearchIndexRecord::EDIT;
+        record.target = msg.editedId;
+        record.text = msg.body;
+    } else {
+        record.kind = SearchIndexRecord::DOCUMENT;
+        record.author = commit.authorId;
+        record.type = msg.type;
+        record.timestamp = commit.timestamp;
+        if (msg.type == CommitType::TEXT)
+            record.text = msg.body;
+        else if (msg.type == CommitType::DATA_TRANSFER)
+            record.text = msg.displayName;
+    }
+    pending_.emplace_back(record);
+    apply(std::move(record));
+}
+
+bool
+MessageSearchIndex::flush(const std::string& head)
+{
+    if (pending_.empty() and head == head_)
+        return true;
+
+    SearchIndexRecord headRecord;
+    headRecord.kind = SearchIndexRecord::HEAD;
+    headRecord.id = head;
+    pending_.emplace_back(headRecord);
+    apply(std::move(headRecord));
+
+    std::error_code ec;
+    bool ok = false;
+    if (std::filesystem::is_regular_file(path_, ec)) {
+        std::ofstream file(path_, std::ios::binary | std::ios::app);
+        for (const auto& record : pending_)
+            msgpack::pack(file, record);
+        file.flush();
+        ok = static_cast<bool>(file);
+    } else {
+        ok = write();
+    }
+    pending_.clear();
+    if (not ok) {
+        // Will be rebuilt by the next search
+        JAMI_WARNING("Unable to write search index {}", path_);
+        clear();
+    }
+    return ok;
+}
+
+void
+MessageSearchIndex::clear()
+{
+    documents_.clear();
+    positions_.clear();
+    postings_.clear();
+    pending_.clear();
+    head_.clear();
+    records_ = 0;
+    std::error_code ec;
+    std::filesystem::remove(path_, ec);
+}
+
+std::vector<SearchHit>
+MessageSearchIndex::search(const Filter& filter) const
+{
+    // A type that has no text to match gives all messages of that type
+    auto matchText = filter.type.empty() or isSearchable(filter.type);
+    std::optional<std::regex> re;
+    if (matchText and not filter.regexSearch.empty())
+        re.emplace(filter.regexSearch,
+                   filter.caseSensitive ? std::regex_constants::ECMAScript : std::regex_constants::icase);
+
+    std::vector<uint32_t> selected;
+    if (matchText and isLiteral(filter.regexSearch)) {
+        selected = candidates(filter.regexSearch);
+    } else {
+        selected.resize(documents_.size());
+        for (uint32_t i = 0; i < selected.size(); ++i)
+            selected[i] = i;
+    }
+
+    std::erase_if(selected, [&](uint32_t position) {
+        const auto& doc = documents_[position];
+        if (filter.type.empty() ? not isSearchable(doc.type) : doc.type != filter.type)
+            return true;
+        if (not filter.author.empty() and filter.author != doc.author)
+            return true;
+        if (filter.before and filter.before < doc.timestamp)
+            return true;
+        return filter.after and filter.after > doc.timestamp;
+    });
+
+    // Newest first, in indexing order for messages of the same second
+    auto newer = [&](uint32_t a, uint32_t b) {
+        const auto& docA = documents_[a];
+        const auto& docB = documents_[b];
+        return docA.timestamp != docB.timestamp ? docA.timestamp > docB.timestamp : a > b;
+    };
+    std::sort(selected.begin(), selected.end(), newer);
+
+    std::optional<uint32_t> last;
+    if (not filter.lastId.empty()) {
+        auto it = positions_.find(filter.lastId);
+        if (it != positions_.end())
+            last = it->second;
+    }
+
+    std::vector<SearchHit> hits;
+    for (auto position : selected) {
+        // Stop at lastId, included
+        if (last and newer(*last, position))
+            break;
+        const auto& doc = documents_[position];
+        if (re and not std::regex_search(doc.text, *re))
+            continue;
+        hits.emplace_back(SearchHit {doc.id, doc.type, doc.text});
+        if (filter.maxResult != 0 and hits.size() == filter.maxResult)
+            break;
+    }
+    return hits;
+}
+
+void
+MessageSearchIndex::apply(SearchIndexRecord&& record)
+{
+    ++records_;
+    switch (record.kind) {
+    case SearchIndexRecord::DOCUMENT: {
+        // Records written before an interrupted flush are indexed again
+        if (positions_.find(record.id) != positions_.end())
+            return;
+        auto position = static_cast<uint32_t>(documents_.size());
+        positions_.emplace(record.id, position);
+        indexText(position, record.text);
+        documents_.emplace_back(Document {std::move(record.id),
+                                          std::move(record.author),
+                                          std::move(record.type),
+                                          record.timestamp,
+                                          std::move(record.text)});
+        break;
+    }
+    case SearchIndexRecord::EDIT: {
+        // Only text bodies are replaced: editing a file removes the file, not its name
+        auto it = positions_.find(record.target);
+        if (it == positions_.end() or documents_[it->second].type != CommitType::TEXT)
+            return;
+        indexText(it->second, record.text);
+        documents_[it->second].text = std::move(record.text);
+        break;
+    }
+    case SearchIndexRecord::HEAD:
+        head_ = std::move(record.id);
+        break;
+    }
+}
+
+void
+MessageSearchIndex::indexText(uint32_t position, std::string_view text)
+{
+    for (auto& token : tokenize(text)) {
+        auto& posting = postings_[std::move(token)];
+        if (posting.empty() or posting.back() != position)
+            posting.emplace_back(position);
+    }
+}
+
+std::vector<uint32_t>
+MessageSearchIndex::candidates(std::string_view literal) const
+{
+    auto tokens = tokenize(literal);
+    if (tokens.empty()) {
+        std::vector<uint32_t> all(documents_.size());
+        for (uint32_t i = 0; i < all.size(); ++i)
+            all[i] = i;
+        return all;
+    }
+
+    // Each token of the query is part of a token of a matching message, but
+    // not necessarily a whole one ("ell" finds "hello")
+    std::vector<uint32_t> result;
+    bool first = true;
+    for (const auto& token : tokens) {
+        std::vector<uint32_t> matching;
+        for (const auto& [word, posting] : postings_)
+            if (word.find(token) != std::string::npos)
+                matching.insert(matching.end(), posting.begin(), posting.end());
+        std::sort(matching.begin(), matching.end());
+        matching.erase(std::unique(matching.begin(), matching.end()), matching.end());
+        if (first) {
+            result = std::move(matching);
+            first = false;
+        } else {
+            std::vector<uint32_t> both;
+            std::set_intersection(result.begin(),
+                                  result.end(),
+                                  matching.begin(),
+                                  matching.end(),
+                                  std::back_inserter(both));
+            result = std::move(both);
+        }
+        if (result.empty())
+            break;
+    }
+    return result;
+}
+
+bool
+MessageSearchIndex::write() const
+{
+    std::error_code ec;
+    std::filesystem::create_directories(path_.parent_path(), ec);
+    auto tmpPath = path_;
+    tmpPath += ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::trunc | std::ios::binary);
+        msgpack::pack(file, VERSION);
+        SearchIndexRecord record;
+        for (const auto& doc : documents_) {
+            record.id = doc.id;
+            record.author = doc.author;
+            record.type = doc.type;
+            record.timestamp = doc.timestamp;
+            record.text = doc.text;
+            msgpack::pack(file, record);
+        }
+        if (not head_.empty()) {
+            SearchIndexRecord headRecord;
+            headRecord.kind = SearchIndexRecord::HEAD;
+            headRecord.id = head_;
+            msgpack::pack(file, headRecord);
+        }
+        file.flush();
+        if (not file)
+            return false;
+    }
+    std::filesystem::rename(tmpPath, path_, ec);
+    return not ec;
+}
+
+} // namespace jami
@@ -0,0 +1,144 @@
+/*
+ *  Copyright (C) 2004-2026 Savoir-faire Linux Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <msgpack.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace jami {
+
+struct ConversationCommit;
+struct Filter;
+
+struct SearchIndexRecord
+{
+    enum Kind : uint8_t { DOCUMENT = 0, EDIT, HEAD };
+
+    uint8_t kind {DOCUMENT};
+    std::string id {};
+    std::string target {}; // EDIT: the edited message
+    std::string author {};
+    std::string type {};
+    int64_t timestamp {0};
+    std::string text {};
+
+    MSGPACK_DEFINE_MAP(kind, id, target, author, type, timestamp, text)
+};
+
+struct SearchHit
+{
+    std::string id;
+    std::string type;
+    std::string text; // current searchable text, edits applied
+};
+
+/**
+ * Full-text index of the messages of a conversation.
+ *
+ * Every message is a document (author, type, timestamp and searchable text:
+ * the body of a text message, the name of a file). Bodies are split in
+ * ASCII case-folded tokens, bytes outside ASCII being kept as token
+ * characters, and each token points to the documents that contained it.
+ *
+ * The index is persisted as a journal: documents and edits are appended as
+ * commits are indexed, followed by the head they bring the index to.
+ * Postings are never removed when an edit rewrites a body, candidates are
+ * always matched against the current text.
+ * @note not thread safe, the owner must serialize accesses
+ */
+class MessageSearchIndex
+{
+public:
+    static constexpr uint32_t VERSION {1};
+
+    explicit MessageSearchIndex(std::filesystem::path path)
+        : path_(std::move(path))
+    {}
+
+    /**
+     * Load the journal from disk, once
+     * @return false if the file is missing, truncated or from another version
+     */
+    bool load();
+    bool loaded() const { return loaded_; }
+
+    size_t size() const { return documents_.size(); }
+
+    /**
+     * Most recent commit indexed, empty if nothing was
+     */
+    const std::string& head() const { return head_; }
+
+    /**
+     * Index a commit. Commits must come oldest first, so that an edit comes
+     * after the message it edits.
+     */
+    void add(const ConversationCommit& commit);
+
+    /**
+     * Write what was added since the last call, up to head, to the journal
+     */
+    bool flush(const std::string& head);
+
+    /**
+     * Forget everything, including the file on disk
+     */
+    void clear();
+
+    /**
+     * Messages matching filter, newest first.
+     * Only text messages and files are searched unless filter.type asks for
+     * another type, in which case every message of that type matches.
+     * @throw std::regex_error if filter.regexSearch is invalid
+     */
+    std::vector<SearchHit> search(const Filter& filter) const;
+
+    static std::vector<std::string> tokenize(std::string_view text);
+
+private:
+    struct Document
+    {
+        std::string id;
+        std::string author;
+        std::string type;
+        int64_t timestamp {0};
+        std::string text;
+    };
+
+    void apply(SearchIndexRecord&& record);
+    void indexText(uint32_t position, std::string_view text);
+    std::vector<uint32_t> candidates(std::string_view literal) const;
+    bool write() const;
+
+    std::filesystem::path path_;
+    // In indexing order
+    std::vector<Document> documents_;
+    std::unordered_map<std::string, uint32_t> positions_;
+    std::unordered_map<std::string, std::vector<uint32_t>> postings_;
+    std::vector<SearchIndexRecord> pending_;
+    std::string head_;
+    size_t records_ {0};
+    bool loaded_ {false};
+};
+
+} // namespace jami
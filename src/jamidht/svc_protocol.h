@@ -39,8 +39,24 @@ constexpr std::string_view Error = "error";
 constexpr std::string_view VersionMismatch = "version_mismatch";
 } // namespace MsgType
 
-/// Channel name prefix used for tunnels: "svc://<service-uuid>".
+/// Channel name prefix used for tunnels: "svc://<service-uuid>", optionally
+/// followed by options: "svc://<service-uuid>?<option>[&<option>...]". Hosts
+/// that predate the options refuse such channels as an unknown service.
 constexpr std::string_view TunnelChannelPrefix = "svc://";
+/// Option of the tunnel channels a client opens ahead of time. The host only
+/// connects to its local service once the client sends PooledStart, when a
+/// local connection takes the channel.
+constexpr std::string_view PooledOption = "pooled";
+/// First byte sent on a pre-opened tunnel channel, before the relayed bytes.
+constexpr uint8_t PooledStart = 0x01;
+/// Option of the tunnel channels relayed with flow control, in frames.
+constexpr std::string_view FlowOption = "flow";
+/// A frame is a type byte and a 32-bit big-endian length. A data frame is
+/// followed by as many relayed bytes, a credit frame grants the peer as many
+/// more bytes to send.
+constexpr size_t FrameHeaderSize = 5;
+constexpr uint8_t FrameData = 0x00;
+constexpr uint8_t FrameCredit = 0x01;
 /// Channel name used for discovery: "svcdisc://query".
 constexpr std::string_view DiscoveryChannelName = "svcdisc://query";
 
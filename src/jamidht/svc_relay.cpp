@@ -0,0 +1,476 @@
+/*
+ *  Copyright (C) 2004-2026 Savoir-faire Linux Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "jamidht/svc_relay.h"
+
+#include "logger.h"
+
+#include <asio/post.hpp>
+#include <asio/write.hpp>
+
+#include <algorithm>
+
+namespace jami {
+
+namespace {
+
+/// Free blocks shared by every relay, so that steady traffic does not
+/// allocate.
+class BlockPool
+{
+public:
+    // Idle memory kept for reuse
+    static constexpr size_t MAX_FREE_BLOCKS {32};
+
+    static BlockPool& instance()
+    {
+        static BlockPool pool;
+        return pool;
+    }
+
+    std::vector<uint8_t> acquire()
+    {
+        {
+            std::lock_guard lk(mtx_);
+            if (!free_.empty()) {
+                auto block = std::move(free_.back());
+                free_.pop_back();
+                return block;
+            }
+        }
+        std::vector<uint8_t> block;
+        block.reserve(SvcRelay::BLOCK_SIZE);
+        return block;
+    }
+
+    void release(std::vector<uint8_t>&& block)
+    {
+        if (block.capacity() < SvcRelay::BLOCK_SIZE)
+            return;
+        block.clear();
+        std::lock_guard lk(mtx_);
+        if (free_.size() < MAX_FREE_BLOCKS)
+            free_.emplace_back(std::move(block));
+    }
+
+private:
+    std::mutex mtx_;
+    std::vector<std::vector<uint8_t>> free_;
+};
+
+void
+putFrameHeader(uint8_t* out, uint8_t type, uint32_t length)
+{
+    out[0] = type;
+    out[1] = static_cast<uint8_t>(length >> 24);
+    out[2] = static_cast<uint8_t>(length >> 16);
+    out[3] = static_cast<uint8_t>(length >> 8);
+    out[4] = static_cast<uint8_t>(length);
+}
+
+} // namespace
+
+void
+SvcRelayStats::roll(std::chrono::steady_clock::time_point now) const
+{
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - windowStart_).count();
+    if (elapsed < 1000)
+        return;
+    counters_.rateFromPeer = windowFromPeer_ * 1000 / elapsed;
+    counters_.rateToPeer = windowToPeer_ * 1000 / elapsed;
+    windowFromPeer_ = 0;
+    windowToPeer_ = 0;
+    windowStart_ = now;
+}
+
+void
+SvcRelayStats::fromPeer(size_t bytes)
+{
+    std::lock_guard lk(mtx_);
+    roll(std::chrono::steady_clock::now());
+    counters_.bytesFromPeer += bytes;
+    windowFromPeer_ += bytes;
+}
+
+void
+SvcRelayStats::toPeer(size_t bytes)
+{
+    std::lock_guard lk(mtx_);
+    roll(std::chrono::steady_clock::now());
+    counters_.bytesToPeer += bytes;
+    windowToPeer_ += bytes;
+}
+
+void
+SvcRelayStats::queued(size_t relayQueued, int64_t delta)
+{
+    std::lock_guard lk(mtx_);
+    counters_.queuedBytes = static_cast<uint64_t>(static_cast<int64_t>(counters_.queuedBytes) + delta);
+    counters_.peakQueuedBytes = std::max<uint64_t>(counters_.peakQueuedBytes, relayQueued);
+}
+
+void
+SvcRelayStats::paused()
+{
+    std::lock_guard lk(mtx_);
+    counters_.pauses++;
+}
+
+SvcRelayStats::Snapshot
+SvcRelayStats::snapshot() const
+{
+    std::lock_guard lk(mtx_);
+    auto now = std::chrono::steady_clock::now();
+    roll(now);
+    // No traffic for a whole window: the last rate is stale
+    if (now - windowStart_ >= std::chrono::seconds(2)) {
+        counters_.rateFromPeer = 0;
+        counters_.rateToPeer = 0;
+    }
+    return counters_;
+}
+
+std::shared_ptr<SvcRelay>
+SvcRelay::create(asio::io_context& io,
+                 std::shared_ptr<dhtnet::ChannelSocket> channel,
+                 std::shared_ptr<SvcRelayStats> stats,
+                 bool flowControl,
+                 OnFirstData onFirstData)
+{
+    std::shared_ptr<SvcRelay> relay(
+        new SvcRelay(io, std::move(channel), std::move(stats), flowControl, std::move(onFirstData)));
+    std::weak_ptr<SvcRelay> w = relay;
+    relay->channel_->setOnRecv([w](const uint8_t* data, size_t size) -> ssize_t {
+        if (auto relay = w.lock())
+            relay->onChannelData(data, size);
+        return static_cast<ssize_t>(size);
+    });
+    relay->watchShutdown();
+    return relay;
+}
+
+SvcRelay::SvcRelay(asio::io_context& io,
+                   std::shared_ptr<dhtnet::ChannelSocket> channel,
+                   std::shared_ptr<SvcRelayStats> stats,
+                   bool flowControl,
+                   OnFirstData onFirstData)
+    : io_(io)
+    , channel_(std::move(channel))
+    , stats_(std::move(stats))
+    , flow_(flowControl)
+    , onFirstData_(std::move(onFirstData))
+{}
+
+SvcRelay::~SvcRelay()
+{
+    auto& pool = BlockPool::instance();
+    for (auto& block : queue_)
+        pool.release(std::move(block));
+    pool.release(std::move(readBuf_));
+    if (stats_ && queued_ != 0)
+        stats_->queued(0, -static_cast<int64_t>(queued_));
+}
+
+void
+SvcRelay::watchShutdown()
+{
+    std::weak_ptr<SvcRelay> w = weak_from_this();
+    channel_->onShutdown([w](const std::error_code&) {
+        if (auto relay = w.lock())
+            relay->stop();
+    });
+}
+
+size_t
+SvcRelay::queuedBytes() const
+{
+    std::lock_guard lk(mtx_);
+    return queued_;
+}
+
+void
+SvcRelay::onChannelData(const uint8_t* data, size_t size)
+{
+    if (onFirstData_ && size != 0) {
+        auto onFirstData = std::move(onFirstData_);
+        onFirstData_ = {};
+        auto consumed = std::min(onFirstData(*this, data, size), size);
+        data += consumed;
+        size -= consumed;
+        if (size == 0)
+            return;
+    }
+    if (flow_)
+        onFrames(data, size);
+    else
+        queueData(data, size);
+}
+
+void
+SvcRelay::onFrames(const uint8_t* data, size_t size)
+{
+    // Frames are not aligned on the packets of the channel
+    while (size != 0 && !framesDropped_) {
+        if (frameLeft_ == 0) {
+            auto n = std::min(size, frameHeader_.size() - frameHeaderSize_);
+            std::copy_n(data, n, frameHeader_.begin() + frameHeaderSize_);
+            frameHeaderSize_ += n;
+            data += n;
+            size -= n;
+            if (frameHeaderSize_ < frameHeader_.size())
+                return;
+            frameHeaderSize_ = 0;
+            size_t length = (size_t(frameHeader_[1]) << 24) | (size_t(frameHeader_[2]) << 16)
+                            | (size_t(frameHeader_[3]) << 8) | size_t(frameHeader_[4]);
+            if (frameHeader_[0] == svc_protocol::FrameCredit) {
+                onCredit(length);
+            } else if (frameHeader_[0] == svc_protocol::FrameData) {
+                frameLeft_ = length;
+            } else {
+                JAMI_WARNING("[SvcRelay] unknown frame type {}, closing", frameHeader_[0]);
+                framesDropped_ = true;
+                asio::post(io_, [w = weak_from_this()] {
+                    if (auto relay = w.lock())
+                        relay->stop();
+                });
+                return;
+            }
+            continue;
+        }
+        auto n = std::min(size, frameLeft_);
+        if (!queueData(data, n)) {
+            framesDropped_ = true;
+            return;
+        }
+        frameLeft_ -= n;
+        data += n;
+        size -= n;
+    }
+}
+
+bool
+SvcRelay::queueData(const uint8_t* data, size_t size)
+{
+    std::unique_lock lk(mtx_);
+    if (stopped_)
+        return false;
+    if (flow_ && queued_ + consumed_ + size > HIGH_WATERMARK) {
+        lk.unlock();
+        JAMI_WARNING("[SvcRelay] peer sent more than {} bytes without credit, closing", HIGH_WATERMARK);
+        asio::post(io_, [w = weak_from_this()] {
+            if (auto relay = w.lock())
+                relay->stop();
+        });
+        return false;
+    }
+    if (!flow_ && !warnedQueue_ && queued_ + size > HIGH_WATERMARK) {
+        // Blocking here would stall every channel to the peer device
+        warnedQueue_ = true;
+        JAMI_WARNING("[SvcRelay] more than {} bytes queued for a peer without flow control", HIGH_WATERMARK);
+    }
+
+    auto& pool = BlockPool::instance();
+    for (size_t pos = 0; pos < size;) {
+        // Blocks being written are left untouched
+        if (queue_.size() <= inflight_ || queue_.back().size() == BLOCK_SIZE)
+            queue_.emplace_back(pool.acquire());
+        auto& block = queue_.back();
+        auto n = std::min(size - pos, BLOCK_SIZE - block.size());
+        block.insert(block.end(), data + pos, data + pos + n);
+        pos += n;
+    }
+    queued_ += size;
+    if (stats_) {
+        stats_->fromPeer(size);
+        stats_->queued(queued_, static_cast<int64_t>(size));
+    }
+
+    if (started_ && !writing_) {
+        asio::post(io_, [w = weak_from_this()] {
+            if (auto relay = w.lock()) {
+                std::lock_guard lk(relay->mtx_);
+                relay->writeQueued();
+            }
+        });
+    }
+    return true;
+}
+
+void
+SvcRelay::onCredit(size_t credit)
+{
+    std::lock_guard lk(mtx_);
+    credit_ = std::min(credit_ + credit, HIGH_WATERMARK);
+    if (readPaused_ && !stopped_) {
+        readPaused_ = false;
+        asio::post(io_, [w = shared_from_this()] { w->readTcp(); });
+    }
+}
+
+void
+SvcRelay::start(std::shared_ptr<asio::ip::tcp::socket> tcp)
+{
+    // Every operation on the socket is started from the io context
+    asio::post(io_, [w = shared_from_this(), tcp = std::move(tcp)]() mutable { w->doStart(std::move(tcp)); });
+}
+
+void
+SvcRelay::doStart(std::shared_ptr<asio::ip::tcp::socket> tcp)
+{
+    {
+        std::lock_guard lk(mtx_);
+        tcp_ = std::move(tcp);
+        started_ = true;
+        if (stopped_) {
+            std::error_code ig;
+            tcp_->close(ig);
+            return;
+        }
+        writeQueued();
+    }
+    // Hooks registered by the caller may have replaced ours
+    watchShutdown();
+    readBuf_ = BlockPool::instance().acquire();
+    readBuf_.resize(BLOCK_SIZE);
+    readTcp();
+}
+
+void
+SvcRelay::writeQueued()
+{
+    if (writing_ || stopped_ || queue_.empty())
+        return;
+    std::vector<asio::const_buffer> buffers;
+    inflight_ = std::min(queue_.size(), MAX_GATHER);
+    buffers.reserve(inflight_);
+    for (size_t i = 0; i < inflight_; ++i)
+        buffers.emplace_back(asio::buffer(queue_[i]));
+    writing_ = true;
+    asio::async_write(*tcp_, buffers, [w = shared_from_this()](const std::error_code& ec, std::size_t n) {
+        w->onWritten(ec, n);
+    });
+}
+
+void
+SvcRelay::onWritten(const std::error_code& ec, size_t written)
+{
+    if (ec) {
+        if (ec != asio::error::operation_aborted)
+            JAMI_DEBUG("[SvcRelay] write to TCP failed: {}", ec.message());
+        stop();
+        return;
+    }
+    size_t grant = 0;
+    {
+        std::lock_guard lk(mtx_);
+        auto& pool = BlockPool::instance();
+        for (size_t i = 0; i < inflight_; ++i) {
+            pool.release(std::move(queue_.front()));
+            queue_.pop_front();
+        }
+        inflight_ = 0;
+        writing_ = false;
+        queued_ -= written;
+        if (stats_)
+            stats_->queued(queued_, -static_cast<int64_t>(written));
+        // Grant the written bytes back in batches, once the queue is low
+        if (flow_) {
+            consumed_ += written;
+            if (queued_ <= LOW_WATERMARK && consumed_ >= LOW_WATERMARK)
+                grant = std::exchange(consumed_, 0);
+        }
+        writeQueued();
+    }
+    if (grant != 0) {
+        std::array<uint8_t, svc_protocol::FrameHeaderSize> frame;
+        putFrameHeader(frame.data(), svc_protocol::FrameCredit, static_cast<uint32_t>(grant));
+        std::error_code wec;
+        channel_->write(frame.data(), frame.size(), wec);
+        if (wec)
+            stop();
+    }
+}
+
+void
+SvcRelay::readTcp()
+{
+    // Flow-controlled data is read after the room of its frame header
+    size_t offset = 0;
+    size_t size = readBuf_.size();
+    if (flow_) {
+        std::lock_guard lk(mtx_);
+        if (stopped_)
+            return;
+        if (credit_ == 0) {
+            // Resumed by onCredit, once the peer wrote enough of what we sent
+            readPaused_ = true;
+            if (stats_)
+                stats_->paused();
+            return;
+        }
+        offset = svc_protocol::FrameHeaderSize;
+        size = std::min(size - offset, credit_);
+    }
+    tcp_->async_read_some(asio::buffer(readBuf_.data() + offset, size),
+                          [w = shared_from_this(), offset](const std::error_code& ec, std::size_t n) {
+                              w->onRead(ec, n, offset);
+                          });
+}
+
+void
+SvcRelay::onRead(const std::error_code& ec, size_t read, size_t offset)
+{
+    if (ec || read == 0) {
+        stop();
+        return;
+    }
+    if (flow_) {
+        {
+            std::lock_guard lk(mtx_);
+            credit_ -= read;
+        }
+        putFrameHeader(readBuf_.data(), svc_protocol::FrameData, static_cast<uint32_t>(read));
+    }
+    std::error_code wec;
+    channel_->write(readBuf_.data(), offset + read, wec);
+    if (wec) {
+        stop();
+        return;
+    }
+    if (stats_)
+        stats_->toPeer(read);
+    readTcp();
+}
+
+void
+SvcRelay::stop()
+{
+    std::shared_ptr<asio::ip::tcp::socket> tcp;
+    {
+        std::lock_guard lk(mtx_);
+        if (stopped_)
+            return;
+        stopped_ = true;
+        tcp = tcp_;
+    }
+    channel_->shutdown();
+    if (tcp) {
+        std::error_code ig;
+        tcp->close(ig);
+    }
+}
+
+} // namespace jami
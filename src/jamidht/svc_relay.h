@@ -0,0 +1,182 @@
+/*
+ *  Copyright (C) 2004-2026 Savoir-faire Linux Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "jamidht/svc_protocol.h"
+
+#include <dhtnet/multiplexed_socket.h>
+
+#include <asio/io_context.hpp>
+#include <asio/ip/tcp.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace jami {
+
+/**
+ * Traffic counters shared by every relay of a service tunnel.
+ */
+class SvcRelayStats
+{
+public:
+    struct Snapshot
+    {
+        uint64_t bytesFromPeer {0};   ///< received on channels, written to local sockets
+        uint64_t bytesToPeer {0};     ///< read from local sockets, sent on channels
+        uint64_t rateFromPeer {0};    ///< bytes/s, over the last second
+        uint64_t rateToPeer {0};      ///< bytes/s, over the last second
+        uint64_t queuedBytes {0};     ///< received but not yet written to local sockets
+        uint64_t peakQueuedBytes {0}; ///< highest queuedBytes of a single relay
+        uint64_t pauses {0};          ///< times a relay stopped reading its local socket for the peer
+    };
+
+    void fromPeer(size_t bytes);
+    void toPeer(size_t bytes);
+    void queued(size_t relayQueued, int64_t delta);
+    void paused();
+
+    Snapshot snapshot() const;
+
+private:
+    void roll(std::chrono::steady_clock::time_point now) const;
+
+    mutable std::mutex mtx_;
+    mutable Snapshot counters_;
+    mutable std::chrono::steady_clock::time_point windowStart_ {std::chrono::steady_clock::now()};
+    mutable uint64_t windowFromPeer_ {0};
+    mutable uint64_t windowToPeer_ {0};
+};
+
+/**
+ * Bidirectional relay between a dhtnet channel and a local TCP socket.
+ *
+ * Data received on the channel is appended to a queue of fixed-size blocks
+ * taken from a process-wide pool, so that small packets are coalesced, and
+ * written to the socket with gather writes of all the queued blocks. The
+ * other direction reads the socket into a pooled block and writes it
+ * synchronously to the channel.
+ *
+ * The channel callback runs on the read loop of the whole connection to the
+ * peer device, so it never blocks. Instead, a flow-controlled relay frames
+ * what it sends (see svc_protocol::FrameData) and the peer may only send
+ * HIGH_WATERMARK bytes more than it was granted back: once the local socket
+ * wrote them and the queue is down to LOW_WATERMARK, the relay grants them
+ * with a svc_protocol::FrameCredit. A relay without credit left stops
+ * reading its local socket until it is granted more, so a slow reader on
+ * one side pauses the writer on the other side. Peers that predate flow
+ * control send raw bytes, which are queued without limit.
+ *
+ * A relay may be created before its socket exists (e.g. while connecting
+ * to the local service, or for a pre-opened channel): what the channel
+ * receives is queued until start(). Such a relay may be given a hook for
+ * the first bytes it receives, e.g. to connect the socket lazily.
+ */
+class SvcRelay : public std::enable_shared_from_this<SvcRelay>
+{
+public:
+    static constexpr size_t BLOCK_SIZE {64 * 1024};
+    /// Window of a flow-controlled channel, the same for both peers
+    static constexpr size_t HIGH_WATERMARK {8 * 1024 * 1024};
+    /// Queue size under which the bytes written are granted back to the peer
+    static constexpr size_t LOW_WATERMARK {2 * 1024 * 1024};
+    /// Maximum number of blocks written at once
+    static constexpr size_t MAX_GATHER {16};
+
+    /// Called once, from the channel, with the first bytes it receives.
+    /// Returns how many of them are consumed instead of relayed.
+    using OnFirstData = std::function<size_t(SvcRelay& relay, const uint8_t* data, size_t size)>;
+
+    /// Start queuing what channel receives. stats may be null. flowControl
+    /// must match the options of the channel, see svc_protocol::FlowOption.
+    static std::shared_ptr<SvcRelay> create(asio::io_context& io,
+                                            std::shared_ptr<dhtnet::ChannelSocket> channel,
+                                            std::shared_ptr<SvcRelayStats> stats,
+                                            bool flowControl,
+                                            OnFirstData onFirstData = {});
+    ~SvcRelay();
+
+    /// Relay between the channel and tcp, flushing what was queued so far.
+    void start(std::shared_ptr<asio::ip::tcp::socket> tcp);
+
+    /// Shut the channel and the socket down.
+    void stop();
+
+    const std::shared_ptr<dhtnet::ChannelSocket>& channel() const { return channel_; }
+    size_t queuedBytes() const;
+
+private:
+    using Block = std::vector<uint8_t>;
+
+    SvcRelay(asio::io_context& io,
+             std::shared_ptr<dhtnet::ChannelSocket> channel,
+             std::shared_ptr<SvcRelayStats> stats,
+             bool flowControl,
+             OnFirstData onFirstData);
+    void doStart(std::shared_ptr<asio::ip::tcp::socket> tcp);
+    void onChannelData(const uint8_t* data, size_t size);
+    /// Split the frames of a flow-controlled channel
+    void onFrames(const uint8_t* data, size_t size);
+    /// Queue bytes to write to the socket. Returns false once stopped.
+    bool queueData(const uint8_t* data, size_t size);
+    void onCredit(size_t credit);
+    /// Write the queued blocks unless a write is in progress. Called with
+    /// mtx_ held, on the io context.
+    void writeQueued();
+    void onWritten(const std::error_code& ec, size_t written);
+    void readTcp();
+    /// read bytes were read at offset of readBuf_
+    void onRead(const std::error_code& ec, size_t read, size_t offset);
+    void watchShutdown();
+
+    asio::io_context& io_;
+    std::shared_ptr<dhtnet::ChannelSocket> channel_;
+    std::shared_ptr<SvcRelayStats> stats_;
+    const bool flow_;
+    /// Only used by the channel callback
+    OnFirstData onFirstData_;
+    std::array<uint8_t, svc_protocol::FrameHeaderSize> frameHeader_ {};
+    size_t frameHeaderSize_ {0};
+    size_t frameLeft_ {0};
+    /// Set once the relay stops, on a protocol error
+    bool framesDropped_ {false};
+    std::shared_ptr<asio::ip::tcp::socket> tcp_;
+    Block readBuf_;
+
+    mutable std::mutex mtx_;
+    std::deque<Block> queue_;
+    size_t queued_ {0};
+    /// Number of blocks at the front of queue_ being written
+    size_t inflight_ {0};
+    bool writing_ {false};
+    bool started_ {false};
+    bool stopped_ {false};
+    bool warnedQueue_ {false};
+    /// Written to the socket, not granted back to the peer yet
+    size_t consumed_ {0};
+    /// Bytes the peer allows us to send
+    size_t credit_ {HIGH_WATERMARK};
+    bool readPaused_ {false};
+};
+
+} // namespace jami
@@ -20,22 +20,19 @@
 #include "jamidht/contact_list.h"
 #include "jamidht/service_manager.h"
 #include "jamidht/svc_protocol.h"
+#include "jamidht/svc_relay.h"
 #include "logger.h"
 #include "manager.h"
 
 #include <asio/connect.hpp>
 #include <asio/post.hpp>
-#include <asio/read.hpp>
-#include <asio/write.hpp>
+#include <asio/steady_timer.hpp>
 
 #include <atomic>
+#include <deque>
 
 namespace jami {
 
-namespace {
-constexpr size_t kRelayBufSize = 16 * 1024;
-}
-
 struct SvcTunnelChannelHandler::ClientTunnel
 {
     std::string id;
@@ -46,6 +43,8 @@ struct SvcTunnelChannelHandler::ClientTunnel
     std::shared_ptr<asio::ip::tcp::acceptor> acceptor;
     OnTunnelClosed onClosed;
     std::atomic_bool closed {false};
+    /// The host refused a channel with options: only open plain ones
+    std::atomic_bool legacyHost {false};
     /// Per-tunnel mutex protecting the active-connection list.
     std::mutex connsMtx;
     struct Conn
@@ -54,6 +53,27 @@ struct SvcTunnelChannelHandler::ClientTunnel
         std::weak_ptr<asio::ip::tcp::socket> tcp;
     };
     std::vector<Conn> activeConns;
+
+    /// Pool of pre-opened channels. poolMtx guards every field below.
+    std::mutex poolMtx;
+    std::deque<std::shared_ptr<SvcRelay>> pool;
+    size_t poolSize {kDefaultPoolSize};
+    size_t poolConnecting {0};
+    unsigned poolFailures {0};
+    bool poolBackingOff {false};
+    bool poolIdle {false};
+    std::chrono::steady_clock::time_point lastAccept;
+    std::unique_ptr<asio::steady_timer> poolRetryTimer;
+    std::unique_ptr<asio::steady_timer> poolReapTimer;
+
+    /// Traffic of every relay serving this tunnel
+    std::shared_ptr<SvcRelayStats> traffic {std::make_shared<SvcRelayStats>()};
+
+    /// Connection setup latency, from local accept to relay
+    uint64_t connections {0};
+    uint64_t pooledConnections {0};
+    std::chrono::steady_clock::duration lastSetup {};
+    std::chrono::steady_clock::duration totalSetup {};
 };
 
 SvcTunnelChannelHandler::SvcTunnelChannelHandler(const std::shared_ptr<JamiAccount>& acc,
@@ -80,7 +100,15 @@ SvcTunnelChannelHandler::~SvcTunnelChannelHandler()
         std::error_code ec;
         if (t->acceptor)
             t->acceptor->close(ec);
+        stopPool(t);
+    }
+    std::map<std::shared_ptr<SvcRelay>, std::string> pending;
+    {
+        std::lock_guard lk(mtx_);
+        pending.swap(pendingRelays_);
     }
+    for (auto& [relay, _serviceId] : pending)
+        relay->stop();
 }
 
 std::string
@@ -91,7 +119,64 @@ SvcTunnelChannelHandler::parseServiceId(const std::string& channelName)
         return {};
     if (channelName.compare(0, prefix.size(), prefix) != 0)
         return {};
-    return channelName.substr(prefix.size());
+    auto serviceId = channelName.substr(prefix.size());
+    auto options = serviceId.find('?');
+    if (options != std::string::npos)
+        serviceId.resize(options);
+    return serviceId;
+}
+
+bool
+SvcTunnelChannelHandler::hasChannelOption(const std::string& channelName, std::string_view option)
+{
+    auto pos = channelName.find('?');
+    if (pos == std::string::npos)
+        return false;
+    std::string_view options(channelName);
+    options.remove_prefix(pos + 1);
+    while (!options.empty()) {
+        auto end = options.find('&');
+        if (options.substr(0, end) == option)
+            return true;
+        if (end == std::string_view::npos)
+            break;
+        options.remove_prefix(end + 1);
+    }
+    return false;
+}
+
+bool
+SvcTunnelChannelHandler::isPooledChannel(const std::string& channelName)
+{
+    return hasChannelOption(channelName, svc_protocol::PooledOption) && !parseServiceId(channelName).empty();
+}
+
+std::string
+SvcTunnelChannelHandler::tunnelChannelName(const std::string& serviceId, bool pooled, bool flowControl)
+{
+    std::string name = std::string(svc_protocol::TunnelChannelPrefix) + serviceId;
+    char separator = '?';
+    if (pooled) {
+        name += separator;
+        name += svc_protocol::PooledOption;
+        separator = '&';
+    }
+    if (flowControl) {
+        name += separator;
+        name += svc_protocol::FlowOption;
+    }
+    return name;
+}
+
+std::chrono::milliseconds
+SvcTunnelChannelHandler::poolBackoff(unsigned failures)
+{
+    if (failures == 0)
+        return std::chrono::milliseconds(0);
+    std::chrono::milliseconds delay = kPoolMinBackoff;
+    for (unsigned i = 1; i < failures && delay < kPoolMaxBackoff; ++i)
+        delay *= 2;
+    return std::min<std::chrono::milliseconds>(delay, kPoolMaxBackoff);
 }
 
 void
@@ -159,160 +244,88 @@ SvcTunnelChannelHandler::onReady(const std::shared_ptr<dht::crypto::Certificate>
              rec->localHost,
              rec->localPort);
 
-    auto tcp = std::make_shared<asio::ip::tcp::socket>(*io_);
-    asio::ip::tcp::resolver resolver(*io_);
-    std::error_code ec;
-    auto endpoints = resolver.resolve(rec->localHost, std::to_string(rec->localPort), ec);
-    if (ec) {
-        JAMI_WARNING("[SvcTunnel] resolve {}:{} failed: {}", rec->localHost, rec->localPort, ec.message());
-        channel->shutdown();
+    auto flowControl = hasChannelOption(name, svc_protocol::FlowOption);
+    if (!isPooledChannel(name)) {
+        // A local connection is already waiting on the client side
+        connectService(SvcRelay::create(*io_, channel, nullptr, flowControl),
+                       serviceId,
+                       rec->localHost,
+                       rec->localPort);
         return;
     }
 
-    // Buffer any bytes received from the remote peer before we have a local
-    // TCP connection up; flush them through once async_connect succeeds.
-    struct PreConnectBuf
+    // Opened ahead of time by the client: only connect to the service once a
+    // local connection takes the channel, which the client signals first.
+    auto relay = SvcRelay::create(
+        *io_,
+        channel,
+        nullptr,
+        flowControl,
+        [this, serviceId, host = rec->localHost, port = rec->localPort](SvcRelay& self,
+                                                                        const uint8_t* data,
+                                                                        size_t size) -> size_t {
+            auto r = self.shared_from_this();
+            {
+                std::lock_guard lk(mtx_);
+                if (pendingRelays_.erase(r) == 0)
+                    return size;
+            }
+            if (data[0] != svc_protocol::PooledStart) {
+                JAMI_WARNING("[SvcTunnel] unexpected start of a pre-opened channel to service id={}", serviceId);
+                asio::post(*io_, [r] { r->stop(); });
+                return size;
+            }
+            asio::post(*io_, [this, r, serviceId, host, port] { connectService(r, serviceId, host, port); });
+            return 1;
+        });
     {
-        std::mutex m;
-        std::vector<uint8_t> bytes;
-        bool tcpReady {false};
-        std::shared_ptr<asio::ip::tcp::socket> tcp;
-    };
-    auto pre = std::make_shared<PreConnectBuf>();
-    pre->tcp = tcp;
-    auto channelKeep = channel;
-    channel->setOnRecv([pre, channelKeep](const uint8_t* data, size_t size) -> ssize_t {
-        std::lock_guard lk(pre->m);
-        if (pre->tcpReady) {
-            auto buf = std::make_shared<std::vector<uint8_t>>(data, data + size);
-            asio::async_write(*pre->tcp,
-                              asio::buffer(*buf),
-                              [buf, pre, channelKeep](const std::error_code& ec, std::size_t) {
-                                  if (ec) {
-                                      JAMI_DEBUG("[SvcTunnel] write to TCP failed: {}", ec.message());
-                                      channelKeep->shutdown();
-                                      std::error_code ig;
-                                      pre->tcp->close(ig);
-                                  }
-                              });
-        } else {
-            pre->bytes.insert(pre->bytes.end(), data, data + size);
+        std::lock_guard lk(mtx_);
+        pendingRelays_.emplace(relay, serviceId);
+    }
+    std::weak_ptr<SvcRelay> w = relay;
+    channel->onShutdown([this, w](const std::error_code&) {
+        auto r = w.lock();
+        if (!r)
+            return;
+        {
+            std::lock_guard lk(mtx_);
+            pendingRelays_.erase(r);
         }
-        return static_cast<ssize_t>(size);
+        r->stop();
     });
+}
 
+void
+SvcTunnelChannelHandler::connectService(const std::shared_ptr<SvcRelay>& relay,
+                                        const std::string& serviceId,
+                                        const std::string& host,
+                                        uint16_t port)
+{
+    auto tcp = std::make_shared<asio::ip::tcp::socket>(*io_);
+    asio::ip::tcp::resolver resolver(*io_);
+    std::error_code ec;
+    auto endpoints = resolver.resolve(host, std::to_string(port), ec);
+    if (ec) {
+        JAMI_WARNING("[SvcTunnel] resolve {}:{} failed: {}", host, port, ec.message());
+        relay->stop();
+        return;
+    }
+
+    // Bytes received from the remote peer before the local TCP connection is
+    // up are queued by the relay and flushed once async_connect succeeds.
     asio::async_connect(*tcp,
                         endpoints,
-                        [this, channel = channelKeep, tcp, pre, serviceId](const std::error_code& cec,
-                                                                           const asio::ip::tcp::endpoint&) {
+                        [this, relay, tcp, serviceId](const std::error_code& cec, const asio::ip::tcp::endpoint&) {
                             if (cec) {
                                 JAMI_WARNING("[SvcTunnel] connect failed: {}", cec.message());
-                                channel->shutdown();
+                                relay->stop();
                                 return;
                             }
-                            trackServerChannel(serviceId, channel, tcp);
-                            std::vector<uint8_t> drained;
-                            {
-                                std::lock_guard lk(pre->m);
-                                pre->tcpReady = true;
-                                drained.swap(pre->bytes);
-                            }
-                            if (!drained.empty()) {
-                                auto buf = std::make_shared<std::vector<uint8_t>>(std::move(drained));
-                                asio::async_write(*tcp,
-                                                  asio::buffer(*buf),
-                                                  [buf, channel, tcp](const std::error_code& ec, std::size_t) {
-                                                      if (ec) {
-                                                          JAMI_DEBUG("[SvcTunnel] flush failed: {}", ec.message());
-                                                          channel->shutdown();
-                                                          std::error_code ig;
-                                                          tcp->close(ig);
-                                                      }
-                                                  });
-                            }
-                            // Switch to a hot-path setOnRecv now that tcp is up.
-                            channel->setOnRecv([tcp, channel](const uint8_t* data, size_t n) -> ssize_t {
-                                auto buf = std::make_shared<std::vector<uint8_t>>(data, data + n);
-                                asio::async_write(*tcp,
-                                                  asio::buffer(*buf),
-                                                  [buf, channel, tcp](const std::error_code& ec, std::size_t) {
-                                                      if (ec) {
-                                                          JAMI_DEBUG("[SvcTunnel] write to TCP failed: {}",
-                                                                     ec.message());
-                                                          channel->shutdown();
-                                                          std::error_code ig;
-                                                          tcp->close(ig);
-                                                      }
-                                                  });
-                                return static_cast<ssize_t>(n);
-                            });
-                            relayTcpToChannel(channel, tcp);
+                            trackServerChannel(serviceId, relay->channel(), tcp);
+                            relay->start(tcp);
                         });
 }
 
-void
-SvcTunnelChannelHandler::relay(std::shared_ptr<dhtnet::ChannelSocket> channel,
-                               std::shared_ptr<asio::ip::tcp::socket> tcp)
-{
-    // ChannelSocket -> TCP
-    auto channelHold = channel;
-    channel->setOnRecv([tcp, channelHold](const uint8_t* data, size_t size) -> ssize_t {
-        auto buf = std::make_shared<std::vector<uint8_t>>(data, data + size);
-        asio::async_write(*tcp,
-                          asio::buffer(*buf),
-                          [buf, channelHold, tcp](const std::error_code& ec, std::size_t /*n*/) {
-                              if (ec) {
-                                  JAMI_DEBUG("[SvcTunnel] write to TCP failed: {}", ec.message());
-                                  channelHold->shutdown();
-                                  std::error_code ig;
-                                  tcp->close(ig);
-                              }
-                          });
-        return static_cast<ssize_t>(size);
-    });
-
-    // TCP -> ChannelSocket
-    relayTcpToChannel(channel, tcp);
-}
-
-void
-SvcTunnelChannelHandler::relayTcpToChannel(std::shared_ptr<dhtnet::ChannelSocket> channel,
-                                           std::shared_ptr<asio::ip::tcp::socket> tcp)
-{
-    auto buf = std::make_shared<std::vector<uint8_t>>(kRelayBufSize);
-    auto channelKeep = channel;
-    auto tcpKeep = tcp;
-    auto reader = std::make_shared<std::function<void()>>();
-    *reader = [channelKeep, tcpKeep, buf, reader]() {
-        tcpKeep->async_read_some(asio::buffer(*buf),
-                                 [channelKeep, tcpKeep, buf, reader](const std::error_code& ec, std::size_t n) {
-                                     if (ec || n == 0) {
-                                         channelKeep->shutdown();
-                                         std::error_code ig;
-                                         tcpKeep->close(ig);
-                                         *reader = nullptr; // break the cycle
-                                         return;
-                                     }
-                                     std::error_code wec;
-                                     channelKeep->write(buf->data(), n, wec);
-                                     if (wec) {
-                                         channelKeep->shutdown();
-                                         std::error_code ig;
-                                         tcpKeep->close(ig);
-                                         *reader = nullptr; // break the cycle
-                                         return;
-                                     }
-                                     (*reader)();
-                                 });
-    };
-    (*reader)();
-
-    channel->onShutdown([tcp = tcpKeep](const std::error_code&) {
-        std::error_code ig;
-        tcp->close(ig);
-    });
-}
-
 std::string
 SvcTunnelChannelHandler::openTunnel(std::string peerUri,
                                     DeviceId peerDevice,
@@ -357,6 +370,9 @@ SvcTunnelChannelHandler::openTunnel(std::string peerUri,
     }
 
     auto bound = static_cast<uint16_t>(t->acceptor->local_endpoint().port());
+    t->poolRetryTimer = std::make_unique<asio::steady_timer>(*io_);
+    t->poolReapTimer = std::make_unique<asio::steady_timer>(*io_);
+    t->lastAccept = std::chrono::steady_clock::now();
 
     {
         std::lock_guard lk(mtx_);
@@ -372,6 +388,8 @@ SvcTunnelChannelHandler::openTunnel(std::string peerUri,
         onOpened(t->id, bound);
 
     acceptLoop(t);
+    replenishPool(t);
+    schedulePoolReap(t);
     return t->id;
 }
 
@@ -390,43 +408,272 @@ SvcTunnelChannelHandler::acceptLoop(const std::shared_ptr<ClientTunnel>& tunnel)
             JAMI_DEBUG("[SvcTunnel] accept error: {}", ec.message());
             return;
         }
-        // Open a fresh dhtnet channel for this TCP connection.
-        std::string channelName = std::string(svc_protocol::TunnelChannelPrefix) + self->serviceId;
-        connectionManager_.connectDevice(self->peerDevice,
-                                         channelName,
-                                         [this, self, sock](std::shared_ptr<dhtnet::ChannelSocket> channel,
-                                                            const DeviceId&) {
-                                             if (!channel) {
-                                                 JAMI_WARNING("[SvcTunnel] tunnel id={}: connectDevice to peer "
-                                                              "returned null; closing tunnel",
-                                                              self->id);
-                                                 std::error_code ig;
-                                                 sock->close(ig);
-                                                 closeTunnelInternal(self->id, "connect-failed");
-                                                 return;
-                                             }
-                                             onClientChannelReady(self, sock, std::move(channel));
-                                         });
+        auto acceptedAt = std::chrono::steady_clock::now();
+        bool wasIdle = false;
+        {
+            std::lock_guard lk(self->poolMtx);
+            self->lastAccept = acceptedAt;
+            wasIdle = std::exchange(self->poolIdle, false);
+        }
+        if (wasIdle)
+            schedulePoolReap(self);
+
+        if (auto pooled = takePooledChannel(self)) {
+            onClientChannelReady(self, sock, std::move(pooled), acceptedAt, true);
+        } else {
+            // Pool empty: open a fresh dhtnet channel for this TCP connection.
+            connectOnDemand(self, sock, acceptedAt);
+        }
+        // Refill the pool for the next connections.
+        replenishPool(self);
         // Continue accepting.
         acceptLoop(self);
     });
 }
 
+void
+SvcTunnelChannelHandler::connectOnDemand(const std::shared_ptr<ClientTunnel>& tunnel,
+                                         std::shared_ptr<asio::ip::tcp::socket> tcp,
+                                         std::chrono::steady_clock::time_point acceptedAt)
+{
+    bool flowControl = !tunnel->legacyHost;
+    connectionManager_.connectDevice(
+        tunnel->peerDevice,
+        tunnelChannelName(tunnel->serviceId, false, flowControl),
+        [this, tunnel, tcp, acceptedAt, flowControl](std::shared_ptr<dhtnet::ChannelSocket> channel,
+                                                     const DeviceId&) {
+            if (!channel && flowControl && connectionManager_.isConnected(tunnel->peerDevice)) {
+                // Reachable but refused: the host predates the channel options
+                JAMI_LOG("[SvcTunnel] tunnel id={}: host without flow control, using plain channels", tunnel->id);
+                tunnel->legacyHost = true;
+                connectOnDemand(tunnel, tcp, acceptedAt);
+                return;
+            }
+            if (!channel) {
+                JAMI_WARNING("[SvcTunnel] tunnel id={}: connectDevice to peer returned null; closing tunnel",
+                             tunnel->id);
+                std::error_code ig;
+                tcp->close(ig);
+                closeTunnelInternal(tunnel->id, "connect-failed");
+                return;
+            }
+            onClientChannelReady(tunnel,
+                                 tcp,
+                                 SvcRelay::create(*io_, channel, tunnel->traffic, flowControl),
+                                 acceptedAt,
+                                 false);
+        });
+}
+
+void
+SvcTunnelChannelHandler::replenishPool(const std::shared_ptr<ClientTunnel>& tunnel)
+{
+    size_t missing = 0;
+    {
+        std::lock_guard lk(tunnel->poolMtx);
+        if (tunnel->closed || tunnel->legacyHost || tunnel->poolIdle || tunnel->poolBackingOff)
+            return;
+        auto have = tunnel->pool.size() + tunnel->poolConnecting;
+        if (have >= tunnel->poolSize)
+            return;
+        missing = tunnel->poolSize - have;
+        tunnel->poolConnecting += missing;
+    }
+    auto channelName = tunnelChannelName(tunnel->serviceId, true, true);
+    std::weak_ptr<ClientTunnel> wt = tunnel;
+    for (size_t i = 0; i < missing; ++i) {
+        connectionManager_.connectDevice(
+            tunnel->peerDevice,
+            channelName,
+            [this, wt](std::shared_ptr<dhtnet::ChannelSocket> channel, const DeviceId&) {
+                auto t = wt.lock();
+                if (!t) {
+                    if (channel)
+                        channel->shutdown();
+                    return;
+                }
+                if (!channel) {
+                    onPoolConnectFailed(t);
+                    return;
+                }
+                // The host waits for PooledStart before connecting to its service
+                auto pooled = SvcRelay::create(*io_, channel, t->traffic, true);
+                std::weak_ptr<SvcRelay> wp = pooled;
+                channel->onShutdown([wt, wp](const std::error_code&) {
+                    auto t = wt.lock();
+                    auto p = wp.lock();
+                    if (!t || !p)
+                        return;
+                    std::lock_guard lk(t->poolMtx);
+                    t->pool.erase(std::remove(t->pool.begin(), t->pool.end(), p), t->pool.end());
+                });
+                {
+                    std::lock_guard lk(t->poolMtx);
+                    t->poolConnecting--;
+                    t->poolFailures = 0;
+                    if (!t->closed && !t->poolIdle && t->pool.size() < t->poolSize) {
+                        t->pool.push_back(std::move(pooled));
+                        return;
+                    }
+                }
+                // Closed, idle or shrunk while connecting
+                pooled->stop();
+            });
+    }
+}
+
+void
+SvcTunnelChannelHandler::onPoolConnectFailed(const std::shared_ptr<ClientTunnel>& tunnel)
+{
+    // Reachable but refused: the host predates pooled channels
+    bool refused = connectionManager_.isConnected(tunnel->peerDevice);
+    std::lock_guard lk(tunnel->poolMtx);
+    tunnel->poolConnecting--;
+    if (refused) {
+        if (!tunnel->legacyHost.exchange(true))
+            JAMI_LOG("[SvcTunnel] tunnel id={}: host without pooled channels, using plain channels on demand",
+                     tunnel->id);
+        return;
+    }
+    // Attempts made together fail together: count them once.
+    if (tunnel->closed || tunnel->poolBackingOff)
+        return;
+    auto delay = poolBackoff(++tunnel->poolFailures);
+    JAMI_DEBUG("[SvcTunnel] tunnel id={}: unable to pre-open a channel, retrying in {} ms",
+               tunnel->id,
+               delay.count());
+    tunnel->poolBackingOff = true;
+    tunnel->poolRetryTimer->expires_after(delay);
+    std::weak_ptr<ClientTunnel> wt = tunnel;
+    tunnel->poolRetryTimer->async_wait([this, wt](const std::error_code& ec) {
+        if (ec == asio::error::operation_aborted)
+            return;
+        auto t = wt.lock();
+        if (!t)
+            return;
+        {
+            std::lock_guard lk(t->poolMtx);
+            t->poolBackingOff = false;
+        }
+        replenishPool(t);
+    });
+}
+
+void
+SvcTunnelChannelHandler::schedulePoolReap(const std::shared_ptr<ClientTunnel>& tunnel)
+{
+    std::lock_guard lk(tunnel->poolMtx);
+    if (tunnel->closed)
+        return;
+    tunnel->poolReapTimer->expires_at(tunnel->lastAccept + kPoolIdleTimeout);
+    std::weak_ptr<ClientTunnel> wt = tunnel;
+    tunnel->poolReapTimer->async_wait([this, wt](const std::error_code& ec) {
+        if (ec == asio::error::operation_aborted)
+            return;
+        auto t = wt.lock();
+        if (!t || t->closed)
+            return;
+        std::deque<std::shared_ptr<SvcRelay>> reaped;
+        bool active = false;
+        {
+            std::lock_guard lk(t->poolMtx);
+            active = std::chrono::steady_clock::now() - t->lastAccept < kPoolIdleTimeout;
+            if (!active) {
+                // Not refilled until the next accept
+                t->poolIdle = true;
+                reaped.swap(t->pool);
+            }
+        }
+        if (active) {
+            // Accepted a connection in the meantime: check again later.
+            schedulePoolReap(t);
+            return;
+        }
+        if (!reaped.empty())
+            JAMI_DEBUG("[SvcTunnel] tunnel id={}: idle, dropping {} pre-opened channel(s)", t->id, reaped.size());
+        for (auto& p : reaped)
+            p->stop();
+    });
+}
+
+void
+SvcTunnelChannelHandler::stopPool(const std::shared_ptr<ClientTunnel>& tunnel)
+{
+    std::deque<std::shared_ptr<SvcRelay>> pool;
+    {
+        std::lock_guard lk(tunnel->poolMtx);
+        if (tunnel->poolRetryTimer)
+            tunnel->poolRetryTimer->cancel();
+        if (tunnel->poolReapTimer)
+            tunnel->poolReapTimer->cancel();
+        pool.swap(tunnel->pool);
+    }
+    for (auto& p : pool)
+        p->stop();
+}
+
+std::shared_ptr<SvcRelay>
+SvcTunnelChannelHandler::takePooledChannel(const std::shared_ptr<ClientTunnel>& tunnel)
+{
+    std::lock_guard lk(tunnel->poolMtx);
+    if (tunnel->pool.empty())
+        return {};
+    auto pooled = std::move(tunnel->pool.front());
+    tunnel->pool.pop_front();
+    return pooled;
+}
+
 void
 SvcTunnelChannelHandler::onClientChannelReady(const std::shared_ptr<ClientTunnel>& tunnel,
                                               std::shared_ptr<asio::ip::tcp::socket> tcp,
-                                              std::shared_ptr<dhtnet::ChannelSocket> channel)
+                                              std::shared_ptr<SvcRelay> relay,
+                                              std::chrono::steady_clock::time_point acceptedAt,
+                                              bool pooled)
 {
     if (tunnel->closed) {
         // The tunnel was torn down while connectDevice was in flight; drop
         // this late connection instead of wiring up a dangling relay.
-        channel->shutdown();
+        relay->stop();
         std::error_code ig;
         tcp->close(ig);
         return;
     }
-    trackClientConnection(tunnel, channel, tcp);
-    relay(std::move(channel), std::move(tcp));
+    if (pooled) {
+        // Sent before start(), thus before any byte read from tcp
+        std::error_code ec;
+        relay->channel()->write(&svc_protocol::PooledStart, 1, ec);
+        if (ec) {
+            JAMI_DEBUG("[SvcTunnel] tunnel id={}: pre-opened channel failed: {}", tunnel->id, ec.message());
+            relay->stop();
+            std::error_code ig;
+            tcp->close(ig);
+            return;
+        }
+    }
+    auto setup = std::chrono::steady_clock::now() - acceptedAt;
+    bool resumePool = false;
+    {
+        std::lock_guard lk(tunnel->poolMtx);
+        tunnel->connections++;
+        if (pooled)
+            tunnel->pooledConnections++;
+        tunnel->lastSetup = setup;
+        tunnel->totalSetup += setup;
+        // The host is reachable again: stop backing off.
+        if (!pooled && std::exchange(tunnel->poolFailures, 0) != 0) {
+            tunnel->poolBackingOff = false;
+            tunnel->poolRetryTimer->cancel();
+            resumePool = true;
+        }
+    }
+    JAMI_DEBUG("[SvcTunnel] tunnel id={}: connection set up in {} ms ({})",
+               tunnel->id,
+               std::chrono::duration_cast<std::chrono::milliseconds>(setup).count(),
+               pooled ? "pre-opened channel" : "on demand");
+    trackClientConnection(tunnel, relay->channel(), tcp);
+    relay->start(std::move(tcp));
+    if (resumePool)
+        replenishPool(tunnel);
 }
 
 void
@@ -468,6 +715,32 @@ SvcTunnelChannelHandler::closeTunnel(const std::string& tunnelId)
     return closeTunnelInternal(tunnelId, "closed");
 }
 
+bool
+SvcTunnelChannelHandler::setPoolSize(const std::string& tunnelId, size_t poolSize)
+{
+    std::shared_ptr<ClientTunnel> t;
+    {
+        std::lock_guard lk(mtx_);
+        auto it = tunnels_.find(tunnelId);
+        if (it == tunnels_.end())
+            return false;
+        t = it->second;
+    }
+    std::vector<std::shared_ptr<SvcRelay>> excess;
+    {
+        std::lock_guard lk(t->poolMtx);
+        t->poolSize = std::min(poolSize, kMaxPoolSize);
+        while (t->pool.size() > t->poolSize) {
+            excess.emplace_back(std::move(t->pool.back()));
+            t->pool.pop_back();
+        }
+    }
+    for (auto& p : excess)
+        p->stop();
+    replenishPool(t);
+    return true;
+}
+
 bool
 SvcTunnelChannelHandler::closeTunnelInternal(const std::string& tunnelId, const std::string& reason)
 {
@@ -484,6 +757,7 @@ SvcTunnelChannelHandler::closeTunnelInternal(const std::string& tunnelId, const
     std::error_code ec;
     if (t->acceptor)
         t->acceptor->close(ec);
+    stopPool(t);
     // Tear down every per-connection relay (channel + local TCP) currently
     // serving this tunnel so that close actually severs the byte streams.
     std::vector<ClientTunnel::Conn> conns;
@@ -549,14 +823,25 @@ void
 SvcTunnelChannelHandler::closeServerChannelsForService(const std::string& serviceId)
 {
     std::vector<ServerConn> conns;
+    std::vector<std::shared_ptr<SvcRelay>> pending;
     {
         std::lock_guard lk(mtx_);
+        for (auto it = pendingRelays_.begin(); it != pendingRelays_.end();) {
+            if (it->second == serviceId) {
+                pending.emplace_back(it->first);
+                it = pendingRelays_.erase(it);
+            } else {
+                ++it;
+            }
+        }
         auto it = serverChannels_.find(serviceId);
-        if (it == serverChannels_.end())
-            return;
-        conns.swap(it->second);
-        serverChannels_.erase(it);
+        if (it != serverChannels_.end()) {
+            conns.swap(it->second);
+            serverChannels_.erase(it);
+        }
     }
+    for (auto& relay : pending)
+        relay->stop();
     for (auto& c : conns) {
         if (auto ch = c.channel.lock())
             ch->shutdown();
@@ -583,6 +868,16 @@ SvcTunnelChannelHandler::activeTunnels() const
         info.serviceId = t->serviceId;
         info.serviceName = t->serviceName;
         info.localPort = t->acceptor ? static_cast<uint16_t>(t->acceptor->local_endpoint().port()) : 0;
+        std::lock_guard plk(t->poolMtx);
+        info.poolSize = t->poolSize;
+        info.pooled = t->pool.size();
+        info.connections = t->connections;
+        info.pooledConnections = t->pooledConnections;
+        info.traffic = t->traffic->snapshot();
+        info.lastSetupLatency = std::chrono::duration_cast<std::chrono::milliseconds>(t->lastSetup);
+        if (t->connections != 0)
+            info.averageSetupLatency = std::chrono::duration_cast<std::chrono::milliseconds>(
+                t->totalSetup / t->connections);
         out.push_back(std::move(info));
     }
     return out;
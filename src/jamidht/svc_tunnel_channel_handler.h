@@ -18,17 +18,20 @@
 
 #include "jamidht/channel_handler.h"
 #include "jamidht/jamiaccount.h"
+#include "jamidht/svc_relay.h"
 
 #include <dhtnet/connectionmanager.h>
 
 #include <asio/io_context.hpp>
 #include <asio/ip/tcp.hpp>
 
+#include <chrono>
 #include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace jami {
@@ -45,11 +48,35 @@ namespace jami {
  *    until either side closes.
  *
  *  - Client: `openTunnel()` starts a local `asio::tcp::acceptor` bound to
- *    127.0.0.1; each accepted local TCP connection triggers a fresh
- *    `connectDevice("svc://<id>")` call to the host, and the resulting
- *    ChannelSocket is wired up as a bidirectional relay with the local TCP
- *    socket. The same tunnel can therefore serve multiple simultaneous TCP
- *    connections to the same remote service.
+ *    127.0.0.1; each accepted local TCP connection is wired up as a
+ *    bidirectional relay with a `svc://<id>` ChannelSocket to the host. The
+ *    same tunnel can therefore serve multiple simultaneous TCP connections to
+ *    the same remote service.
+ *
+ *  To spare each local connection the channel setup round-trips, every
+ *  client tunnel keeps a small pool of pre-opened channels (`poolSize`,
+ *  `kDefaultPoolSize` unless changed with `setPoolSize()`), refilled in the
+ *  background and handed out on accept; `connectDevice` is only called on
+ *  demand when the pool is empty. Pre-opened channels have the `pooled`
+ *  option, as in `svc://<service-uuid>?pooled&flow`: the host only connects
+ *  to its local service once the client hands the channel out and sends
+ *  `svc_protocol::PooledStart`, so that idle pooled channels hold no
+ *  connection to the service. Pooled
+ *  channels are dropped once the tunnel has not accepted any connection for
+ *  `kPoolIdleTimeout`, and the pool is only refilled on the next accept. A
+ *  failure to pre-open a channel does not close the tunnel: the pool backs
+ *  off exponentially, between `kPoolMinBackoff` and `kPoolMaxBackoff`. A
+ *  host that is reachable but refuses the channel predates pooled channels:
+ *  the pool stops, and local connections use plain channels opened on
+ *  demand.
+ *
+ *  In both roles, bytes are moved by an SvcRelay. Channels with the `flow`
+ *  option are flow-controlled: a slow local socket on one side pauses the
+ *  reads of the other side instead of growing the queues. Clients open
+ *  channels with options unless the host refused one, which means it
+ *  predates them: the tunnel then only opens plain `svc://<service-uuid>`
+ *  channels. The relays of a client tunnel share one SvcRelayStats,
+ *  reported by `activeTunnels()`.
  *
  *  `closeTunnel()` shuts down the local acceptor and tears down every
  *  per-connection relay currently serving the tunnel.
@@ -66,14 +93,27 @@ public:
     /// Description of an active client-side tunnel.
     struct Tunnel
     {
-        std::string id;          ///< opaque tunnel identifier
-        std::string peerUri;     ///< remote account URI
-        std::string peerDevice;  ///< remote device id (string form)
-        std::string serviceId;   ///< remote service uuid
-        std::string serviceName; ///< cached human-readable name
-        uint16_t localPort {0};  ///< actual TCP port the local listener is bound to
+        std::string id;                                    ///< opaque tunnel identifier
+        std::string peerUri;                               ///< remote account URI
+        std::string peerDevice;                            ///< remote device id (string form)
+        std::string serviceId;                             ///< remote service uuid
+        std::string serviceName;                           ///< cached human-readable name
+        uint16_t localPort {0};                            ///< actual TCP port the local listener is bound to
+        size_t poolSize {0};                               ///< number of channels kept pre-opened
+        size_t pooled {0};                                 ///< pre-opened channels currently available
+        uint64_t connections {0};                          ///< local connections relayed so far
+        uint64_t pooledConnections {0};                    ///< ... of which used a pre-opened channel
+        std::chrono::milliseconds lastSetupLatency {0};    ///< accept to relay, last connection
+        std::chrono::milliseconds averageSetupLatency {0}; ///< accept to relay, all connections
+        SvcRelayStats::Snapshot traffic {};                ///< throughput and queues of its relays
     };
 
+    static constexpr size_t kDefaultPoolSize {2};
+    static constexpr size_t kMaxPoolSize {8};
+    static constexpr std::chrono::seconds kPoolIdleTimeout {60};
+    static constexpr std::chrono::seconds kPoolMinBackoff {1};
+    static constexpr std::chrono::seconds kPoolMaxBackoff {60};
+
     using OnTunnelOpened = std::function<void(const std::string& tunnelId, uint16_t localPort)>;
     using OnTunnelClosed = std::function<void(const std::string& tunnelId, const std::string& reason)>;
 
@@ -120,6 +160,11 @@ public:
     /// "closed".
     bool closeTunnel(const std::string& tunnelId);
 
+    /// Change the number of channels kept pre-opened for a tunnel, capped to
+    /// kMaxPoolSize. 0 disables pre-opening. Returns false if the tunnel does
+    /// not exist.
+    bool setPoolSize(const std::string& tunnelId, size_t poolSize);
+
     /// Server-side: shutdown every active tunnel channel currently serving
     /// `serviceId`. Used when the local service is removed or disabled so
     /// that already-established connections from peers are torn down.
@@ -128,27 +173,61 @@ public:
     /// Snapshot of currently-active client tunnels.
     std::vector<Tunnel> activeTunnels() const;
 
-    /// Parse "svc://<uuid>" channel name, returning the uuid (empty if
-    /// malformed). Exposed for testing.
+    /// Parse "svc://<uuid>" channel name, possibly followed by options as in
+    /// "svc://<uuid>?pooled&flow", returning the uuid (empty if malformed).
+    /// Exposed for testing.
     static std::string parseServiceId(const std::string& channelName);
 
+    /// Whether the options of channelName include option.
+    static bool hasChannelOption(const std::string& channelName, std::string_view option);
+
+    /// Whether channelName names a tunnel channel pre-opened by a client.
+    static bool isPooledChannel(const std::string& channelName);
+
+    /// Name of a tunnel channel to serviceId, with the given options.
+    static std::string tunnelChannelName(const std::string& serviceId, bool pooled, bool flowControl);
+
+    /// Delay before the next attempt to pre-open a channel after `failures`
+    /// consecutive failures (0 if none). Exposed for testing.
+    static std::chrono::milliseconds poolBackoff(unsigned failures);
+
 private:
     struct ClientTunnel;
     void acceptLoop(const std::shared_ptr<ClientTunnel>& tunnel);
+    /// Open a channel for a local connection that found the pool empty.
+    void connectOnDemand(const std::shared_ptr<ClientTunnel>& tunnel,
+                         std::shared_ptr<asio::ip::tcp::socket> tcp,
+                         std::chrono::steady_clock::time_point acceptedAt);
+    /// Pre-open channels until the pool of `tunnel` holds `poolSize` of them,
+    /// unless it is idle or backing off.
+    void replenishPool(const std::shared_ptr<ClientTunnel>& tunnel);
+    void onPoolConnectFailed(const std::shared_ptr<ClientTunnel>& tunnel);
+    /// Drop the pooled channels of a tunnel that stopped accepting connections.
+    void schedulePoolReap(const std::shared_ptr<ClientTunnel>& tunnel);
+    /// Cancel the pool timers of a closed tunnel and shut its pooled channels down.
+    void stopPool(const std::shared_ptr<ClientTunnel>& tunnel);
+    /// Take a pre-opened channel, if any, out of the pool of `tunnel`.
+    std::shared_ptr<SvcRelay> takePooledChannel(const std::shared_ptr<ClientTunnel>& tunnel);
     /// Shared implementation behind closeTunnel(): removes the tunnel,
     /// shuts down its acceptor and every live per-connection relay, then
     /// fires `onClosed` with `reason`. Returns true if the tunnel existed.
     bool closeTunnelInternal(const std::string& tunnelId, const std::string& reason);
     void onClientChannelReady(const std::shared_ptr<ClientTunnel>& tunnel,
                               std::shared_ptr<asio::ip::tcp::socket> tcp,
-                              std::shared_ptr<dhtnet::ChannelSocket> channel);
-    void relay(std::shared_ptr<dhtnet::ChannelSocket> channel, std::shared_ptr<asio::ip::tcp::socket> tcp);
-    void relayTcpToChannel(std::shared_ptr<dhtnet::ChannelSocket> channel, std::shared_ptr<asio::ip::tcp::socket> tcp);
+                              std::shared_ptr<SvcRelay> relay,
+                              std::chrono::steady_clock::time_point acceptedAt,
+                              bool pooled);
     /// Track an active per-connection client-side relay so closeTunnel can
     /// tear it down.
     void trackClientConnection(const std::shared_ptr<ClientTunnel>& tunnel,
                                const std::shared_ptr<dhtnet::ChannelSocket>& channel,
                                const std::shared_ptr<asio::ip::tcp::socket>& tcp);
+    /// Server-side: connect to the local service at host:port and start
+    /// relaying the channel of `relay` to it.
+    void connectService(const std::shared_ptr<SvcRelay>& relay,
+                        const std::string& serviceId,
+                        const std::string& host,
+                        uint16_t port);
     /// Track an active server-side channel for `serviceId` and the local
     /// TCP socket relaying it.
     void trackServerChannel(const std::string& serviceId,
@@ -170,6 +249,9 @@ private:
         std::weak_ptr<asio::ip::tcp::socket> tcp;
     };
     std::map<std::string, std::vector<ServerConn>> serverChannels_;
+    /// Server-side relays of pre-opened channels not handed out yet, with
+    /// their serviceId.
+    std::map<std::shared_ptr<SvcRelay>, std::string> pendingRelays_;
 };
 
 } // namespace jami
@@ -0,0 +1,90 @@
+/*
+ *  Copyright (C) 2004-2026 Savoir-faire Linux Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "certificate_lookups.h"
+
+#include <opendht/thread_pool.h>
+
+namespace jami {
+
+bool
+CertificateLookups::wait(const dht::PkId& nodeId, CertificateCb&& cb, TakeOverCb&& takeOver, clock::time_point now)
+{
+    std::lock_guard lock(mutex_);
+    auto [it, inserted] = lookups_.try_emplace(nodeId);
+    auto& lookup = it->second;
+    if (!inserted && lookup.deadline > now) {
+        lookup.waiters.emplace_back(Waiter {std::move(cb), std::move(takeOver)});
+        return true;
+    }
+    // New lookup, or one whose owner gave up silently: waiters are kept for the new owner
+    lookup.deadline = now + LOOKUP_TIMEOUT;
+    return false;
+}
+
+void
+CertificateLookups::resolved(const dht::PkId& nodeId, const Certificate& certificate)
+{
+    std::vector<Waiter> waiters;
+    {
+        std::lock_guard lock(mutex_);
+        auto it = lookups_.find(nodeId);
+        if (it == lookups_.end())
+            return;
+        waiters = std::move(it->second.waiters);
+        lookups_.erase(it);
+    }
+    if (waiters.empty())
+        return;
+    // Waiters take their own swarm manager lock, which the caller may hold
+    dht::ThreadPool::io().run([waiters = std::move(waiters), certificate] {
+        for (const auto& waiter : waiters)
+            waiter.cb(certificate);
+    });
+}
+
+void
+CertificateLookups::release(const dht::PkId& nodeId, clock::time_point now)
+{
+    TakeOverCb takeOver;
+    {
+        std::lock_guard lock(mutex_);
+        auto it = lookups_.find(nodeId);
+        if (it == lookups_.end())
+            return;
+        auto& waiters = it->second.waiters;
+        if (waiters.empty()) {
+            lookups_.erase(it);
+            return;
+        }
+        // The next waiter owns the lookup, the others keep waiting for it
+        takeOver = std::move(waiters.front().takeOver);
+        waiters.erase(waiters.begin());
+        it->second.deadline = now + LOOKUP_TIMEOUT;
+    }
+    // Like the waiters, takes its own swarm manager lock
+    dht::ThreadPool::io().run(std::move(takeOver));
+}
+
+size_t
+CertificateLookups::pending() const
+{
+    std::lock_guard lock(mutex_);
+    return lookups_.size();
+}
+
+} // namespace jami
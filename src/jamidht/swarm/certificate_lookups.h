@@ -0,0 +1,105 @@
+/*
+ *  Copyright (C) 2004-2026 Savoir-faire Linux Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "noncopyable.h"
+
+#include <opendht/crypto.h>
+#include <opendht/infohash.h>
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace jami {
+
+/**
+ * Device certificate lookups shared by the swarm managers of an account's
+ * conversations.
+ *
+ * A mobile device member of many conversations gossips a lease in each of
+ * them, and every swarm manager used to resolve its certificate on its own:
+ * one CERT_REQ or DHT lookup per conversation for the same device. The first
+ * manager to need a certificate owns the lookup, the others wait for its
+ * result. An owner that gives up without an answer hands the lookup to the
+ * first waiter. A lookup whose owner never reports is forgotten after
+ * LOOKUP_TIMEOUT and the next manager to ask owns it.
+ */
+class CertificateLookups
+{
+public:
+    using clock = std::chrono::steady_clock;
+    using Certificate = std::shared_ptr<dht::crypto::Certificate>;
+    using CertificateCb = std::function<void(const Certificate&)>;
+    using TakeOverCb = std::function<void()>;
+
+    // A CERT_REQ timeout followed by a DHT lookup
+    static constexpr std::chrono::minutes LOOKUP_TIMEOUT {1};
+
+    CertificateLookups() = default;
+
+    /**
+     * Wait for a lookup of nodeId already in progress.
+     * @param cb        Called with the result of the lookup
+     * @param takeOver  Called instead of cb if the owner gives up: the caller
+     *                  then owns the lookup
+     * @return false if there is none: the caller owns a new lookup and must
+     *         call resolved() or release() once done. No callback is called in
+     *         that case.
+     */
+    bool wait(const dht::PkId& nodeId,
+              CertificateCb&& cb,
+              TakeOverCb&& takeOver,
+              clock::time_point now = clock::now());
+
+    /**
+     * End the lookup of nodeId. Waiters are called asynchronously, with
+     * nullptr if the certificate was not found.
+     */
+    void resolved(const dht::PkId& nodeId, const Certificate& certificate);
+
+    /**
+     * Give up the lookup of nodeId without an answer, e.g. on shutdown. The
+     * first waiter is asynchronously made its owner.
+     */
+    void release(const dht::PkId& nodeId, clock::time_point now = clock::now());
+
+    size_t pending() const;
+
+private:
+    NON_COPYABLE(CertificateLookups);
+
+    struct Waiter
+    {
+        CertificateCb cb;
+        TakeOverCb takeOver;
+    };
+
+    struct Lookup
+    {
+        clock::time_point deadline;
+        std::vector<Waiter> waiters;
+    };
+
+    mutable std::mutex mutex_;
+    std::map<dht::PkId, Lookup> lookups_;
+};
+
+} // namespace jami
@@ -150,16 +150,6 @@ Bucket::getKnownNodesRandom(unsigned numberNodes, std::mt19937_64& rd) const
     return nodesToReturn;
 }
 
-asio::steady_timer&
-Bucket::getNodeTimer(const std::shared_ptr<dhtnet::ChannelSocketInterface>& socket)
-{
-    auto node = nodes.find(socket->deviceId());
-    if (node == nodes.end()) {
-        throw std::range_error("Unable to find timer " + socket->deviceId().toString());
-    }
-    return node->second.refresh_timer;
-}
-
 bool
 Bucket::shutdownNode(const NodeId& nodeId)
 {
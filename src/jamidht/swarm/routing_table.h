@@ -35,13 +35,10 @@ using NodeId = dht::PkId;
 
 namespace jami {
 
-static constexpr const std::chrono::minutes FIND_PERIOD {10};
-
 struct NodeInfo
 {
     bool isMobile_ {false};
     std::shared_ptr<dhtnet::ChannelSocketInterface> socket {};
-    asio::steady_timer refresh_timer {*Manager::instance().ioContext(), FIND_PERIOD};
     NodeInfo() = delete;
     NodeInfo(NodeInfo&&) noexcept = default;
     NodeInfo(std::shared_ptr<dhtnet::ChannelSocketInterface> socket_)
@@ -219,13 +216,6 @@ public:
         return *node.begin();
     }
 
-    /**
-     * Returns socket's timer
-     * @param socket
-     * @return timer
-     */
-    asio::steady_timer& getNodeTimer(const std::shared_ptr<dhtnet::ChannelSocketInterface>& socket);
-
     /**
      * Shutdowns socket and removes it from nodes.
      * The corresponding node is moved to known_nodes or mobile_nodes
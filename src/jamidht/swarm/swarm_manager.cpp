@@ -16,6 +16,7 @@
  */
 
 #include "swarm_manager.h"
+#include "certificate_lookups.h"
 #include "jamidht/timestamp.h"
 #include <dhtnet/multiplexed_socket.h>
 #include <dhtnet/channel_utils.h>
@@ -33,7 +34,8 @@ SwarmManager::SwarmManager(const NodeId& id,
                            MobileLeaseProvider mobileLeaseProvider,
                            MobileLeaseIssuerValidator mobileLeaseIssuerValidator,
                            CertificateProvider certificateProvider,
-                           CertificateFetcher certificateFetcher)
+                           CertificateFetcher certificateFetcher,
+                           std::shared_ptr<CertificateLookups> certificateLookups)
     : id_(id)
     , isMobile_(isMobile)
     , conversationId_(std::move(conversationId))
@@ -42,6 +44,7 @@ SwarmManager::SwarmManager(const NodeId& id,
     , mobileLeaseIssuerValidator_(std::move(mobileLeaseIssuerValidator))
     , certificateProvider_(std::move(certificateProvider))
     , certificateFetcher_(std::move(certificateFetcher))
+    , certificateLookups_(certificateLookups ? std::move(certificateLookups) : std::make_shared<CertificateLookups>())
     , toConnectCb_(toConnectCb)
 {
     routing_table.setId(id);
@@ -189,10 +192,8 @@ SwarmManager::addChannel(const std::shared_ptr<dhtnet::ChannelSocketInterface>&
             auto bucket = routing_table.findBucket(channel->deviceId());
             added = routing_table.addNode(channel, bucket);
         }
-        if (added) {
-            std::error_code ec;
-            resetNodeExpiry(ec, channel, id_);
-        }
+        if (added)
+            sendRequest(channel, id_, Query::FIND, Bucket::BUCKET_MAX_SIZE);
         receiveMessage(channel);
         if (emit && onConnectionChanged_) {
             // If it's the first channel we add, we're now connected!
@@ -243,6 +244,11 @@ SwarmManager::shutdown()
         if (state.timer)
             state.timer->cancel();
     outstandingCertRequests_.clear();
+    // Not resolved with nullptr: the other conversations are still able to look the certificates up
+    for (const auto& [nodeId, owned] : certFetchInFlight_)
+        if (owned)
+            certificateLookups_->release(nodeId);
+    certFetchInFlight_.clear();
     routing_table.shutdownAllNodes();
 }
 
@@ -366,14 +372,36 @@ SwarmManager::enqueuePendingLeaseInternal(const MobileLease& lease,
     if (certFetchInFlight_.count(nodeId))
         return;
 
+    // The device may be a member of other conversations already resolving it
+    auto waiting = certificateLookups_->wait(
+        nodeId,
+        [w = weak(), nodeId](const auto& certificate) {
+            auto shared = w.lock();
+            if (!shared)
+                return;
+            if (certificate)
+                shared->onCertificateResolved(nodeId, certificate);
+            else {
+                std::lock_guard lock(shared->mutex);
+                shared->abandonLeaseInternal(nodeId);
+            }
+        },
+        [w = weak(), nodeId, lookups = std::weak_ptr(certificateLookups_)] {
+            if (auto shared = w.lock())
+                shared->takeOverCertificateLookup(nodeId);
+            else if (auto sharedLookups = lookups.lock())
+                sharedLookups->release(nodeId);
+        });
+    certFetchInFlight_.emplace(nodeId, !waiting);
+    if (waiting)
+        return;
+
     if (source) {
-        certFetchInFlight_.emplace(nodeId);
         dht::ThreadPool::io().run([w = weak(), source, nodeId] {
             if (auto shared = w.lock())
                 shared->requestCertificates(source, {nodeId});
         });
     } else {
-        certFetchInFlight_.emplace(nodeId);
         dht::ThreadPool::io().run([w = weak(), nodeId] {
             if (auto shared = w.lock())
                 shared->fetchCertificateFromDht(nodeId);
@@ -384,10 +412,57 @@ SwarmManager::enqueuePendingLeaseInternal(const MobileLease& lease,
 void
 SwarmManager::abandonLeaseInternal(const NodeId& nodeId)
 {
-    certFetchInFlight_.erase(nodeId);
+    endCertificateLookupInternal(nodeId, nullptr);
     pendingMobileLeases_.erase(nodeId);
 }
 
+void
+SwarmManager::endCertificateLookupInternal(const NodeId& nodeId,
+                                           const std::shared_ptr<dht::crypto::Certificate>& certificate)
+{
+    auto it = certFetchInFlight_.find(nodeId);
+    if (it == certFetchInFlight_.end())
+        return;
+    if (it->second)
+        certificateLookups_->resolved(nodeId, certificate);
+    certFetchInFlight_.erase(it);
+}
+
+void
+SwarmManager::releaseCertificateLookupInternal(const NodeId& nodeId)
+{
+    auto it = certFetchInFlight_.find(nodeId);
+    if (it == certFetchInFlight_.end())
+        return;
+    if (it->second)
+        certificateLookups_->release(nodeId);
+    certFetchInFlight_.erase(it);
+}
+
+void
+SwarmManager::takeOverCertificateLookup(const NodeId& nodeId)
+{
+    std::shared_ptr<dhtnet::ChannelSocketInterface> source;
+    {
+        std::lock_guard lock(mutex);
+        auto it = certFetchInFlight_.find(nodeId);
+        auto pending = pendingMobileLeases_.find(nodeId);
+        if (isShutdown_ || it == certFetchInFlight_.end() || pending == pendingMobileLeases_.end()) {
+            // Not needed anymore: the next waiter takes it over
+            if (it != certFetchInFlight_.end())
+                certFetchInFlight_.erase(it);
+            certificateLookups_->release(nodeId);
+            return;
+        }
+        it->second = true;
+        source = pending->second.source.lock();
+    }
+    if (source)
+        requestCertificates(source, {nodeId});
+    else
+        fetchCertificateFromDht(nodeId);
+}
+
 void
 SwarmManager::requestCertificates(const std::shared_ptr<dhtnet::ChannelSocketInterface>& socket,
                                   const std::vector<NodeId>& ids)
@@ -395,7 +470,7 @@ SwarmManager::requestCertificates(const std::shared_ptr<dhtnet::ChannelSocketInt
     if (!socket || ids.empty() || isShutdown_) {
         std::lock_guard lock(mutex);
         for (const auto& id : ids)
-            certFetchInFlight_.erase(id);
+            releaseCertificateLookupInternal(id);
         return;
     }
     const auto peer = NodeId(socket->deviceId());
@@ -407,12 +482,12 @@ SwarmManager::requestCertificates(const std::shared_ptr<dhtnet::ChannelSocketInt
             // One request in flight per peer: drop the resolution so that the
             // next gossip round asks again.
             for (const auto& id : ids)
-                certFetchInFlight_.erase(id);
+                releaseCertificateLookupInternal(id);
             return;
         }
         for (const auto& id : ids) {
             if (request.ids.size() >= MAX_CERT_REQUEST_IDS) {
-                certFetchInFlight_.erase(id);
+                releaseCertificateLookupInternal(id);
                 continue;
             }
             request.ids.emplace_back(id);
@@ -559,8 +634,10 @@ SwarmManager::fetchCertificateFromDht(const NodeId& nodeId)
     if (isShutdown_)
         return;
     if (!certificateFetcher_) {
+        // Unable to look it up, unlike the other conversations
         std::lock_guard lock(mutex);
-        abandonLeaseInternal(nodeId);
+        releaseCertificateLookupInternal(nodeId);
+        pendingMobileLeases_.erase(nodeId);
         return;
     }
     certificateFetcher_(nodeId, [w = weak(), nodeId](const std::shared_ptr<dht::crypto::Certificate>& certificate) {
@@ -585,7 +662,7 @@ SwarmManager::onCertificateResolved(const NodeId& nodeId, const std::shared_ptr<
     std::optional<MobileLease> lease;
     {
         std::lock_guard lock(mutex);
-        certFetchInFlight_.erase(nodeId);
+        endCertificateLookupInternal(nodeId, certificate);
         auto pending = pendingMobileLeases_.find(nodeId);
         if (pending == pendingMobileLeases_.end())
             return;
@@ -883,38 +960,6 @@ SwarmManager::receiveMessage(const std::shared_ptr<dhtnet::ChannelSocketInterfac
     });
 }
 
-void
-SwarmManager::resetNodeExpiry(const asio::error_code& ec,
-                              const std::shared_ptr<dhtnet::ChannelSocketInterface>& socket,
-                              NodeId node)
-{
-    NodeId idToFind;
-    std::list<Bucket>::iterator bucket;
-
-    if (ec == asio::error::operation_aborted)
-        return;
-
-    if (!node) {
-        bucket = routing_table.findBucket(socket->deviceId());
-        idToFind = bucket->randomId(rd);
-    } else {
-        bucket = routing_table.findBucket(node);
-        idToFind = node;
-    }
-
-    sendRequest(socket, idToFind, Query::FIND, Bucket::BUCKET_MAX_SIZE);
-
-    if (!node) {
-        auto& nodeTimer = bucket->getNodeTimer(socket);
-        nodeTimer.expires_after(FIND_PERIOD);
-        nodeTimer.async_wait(std::bind(&jami::SwarmManager::resetNodeExpiry,
-                                       shared_from_this(),
-                                       std::placeholders::_1,
-                                       socket,
-                                       NodeId {}));
-    }
-}
-
 void
 SwarmManager::tryConnect(const NodeId& nodeId, bool noNewSocket)
 {
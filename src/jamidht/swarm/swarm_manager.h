@@ -25,6 +25,8 @@ namespace jami {
 
 using namespace swarm_protocol;
 
+class CertificateLookups;
+
 class SwarmManager : public std::enable_shared_from_this<SwarmManager>
 {
     using ChannelCb = std::function<bool(const std::shared_ptr<dhtnet::ChannelSocketInterface>&)>;
@@ -50,7 +52,8 @@ public:
                           MobileLeaseProvider mobileLeaseProvider = {},
                           MobileLeaseIssuerValidator mobileLeaseIssuerValidator = {},
                           CertificateProvider certificateProvider = {},
-                          CertificateFetcher certificateFetcher = {});
+                          CertificateFetcher certificateFetcher = {},
+                          std::shared_ptr<CertificateLookups> certificateLookups = {});
     ~SwarmManager();
 
     NeedSocketCb needSocketCb_;
@@ -314,6 +317,23 @@ private:
      */
     void abandonLeaseInternal(const NodeId& nodeId);
 
+    /**
+     * Forget the certificate lookup of nodeId, giving its result to the other
+     * conversations waiting for it if we own it. Must be called with mutex held.
+     */
+    void endCertificateLookupInternal(const NodeId& nodeId,
+                                      const std::shared_ptr<dht::crypto::Certificate>& certificate);
+
+    /**
+     * Forget the certificate lookup of nodeId without an answer: if we own it,
+     * another conversation waiting for it takes it over. Must be called with
+     * mutex held.
+     */
+    void releaseCertificateLookupInternal(const NodeId& nodeId);
+
+    /** Become the owner of a certificate lookup given up by another conversation. */
+    void takeOverCertificateLookup(const NodeId& nodeId);
+
     bool isMobileNodeCurrentInternal(const NodeId& nodeId, int64_t now) const;
 
     std::optional<MobileNodeInfo> localMobileNodeInfo();
@@ -353,16 +373,6 @@ private:
      */
     void receiveMessage(const std::shared_ptr<dhtnet::ChannelSocketInterface>& socket);
 
-    /**
-     * Reset node's timer expiry
-     * @param ec
-     * @param socket
-     * @param node
-     */
-    void resetNodeExpiry(const asio::error_code& ec,
-                         const std::shared_ptr<dhtnet::ChannelSocketInterface>& socket,
-                         NodeId node = {});
-
     /**
      * Try to establish connection with specific node
      * @param nodeId
@@ -393,8 +403,11 @@ private:
     };
     std::map<NodeId, PendingLease> pendingMobileLeases_;
 
-    /** Nodes whose certificate resolution is already under way: avoids duplicate lookups. */
-    std::set<NodeId> certFetchInFlight_;
+    /**
+     * Nodes whose certificate resolution is already under way: avoids duplicate lookups.
+     * True if this manager owns the lookup, false if it waits for another conversation's.
+     */
+    std::map<NodeId, bool> certFetchInFlight_;
 
     /** At most one outstanding CERT_REQ per peer, keyed by the peer's device id. */
     struct CertRequestState
@@ -408,6 +421,8 @@ private:
     MobileLeaseIssuerValidator mobileLeaseIssuerValidator_;
     CertificateProvider certificateProvider_;
     CertificateFetcher certificateFetcher_;
+    /** Shared with the other conversations of the account */
+    std::shared_ptr<CertificateLookups> certificateLookups_;
     std::mutex mobileLeaseRenewalMtx_;
     std::optional<MobileNodeInfo> localMobileNodeInfo_;
     asio::steady_timer mobileLeaseExpiryTimer_ {*Manager::instance().ioContext()};
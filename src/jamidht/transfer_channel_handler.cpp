@@ -105,16 +105,18 @@ TransferChannelHandler::onReady(const std::shared_ptr<dht::crypto::Certificate>&
         idstr = idstr.substr(0, sep);
     }
 
-    auto start = 0u, end = 0u;
+    size_t start = 0, end = 0, length = 0;
     uint64_t lastModified = 0;
     std::string sha3Sum;
     for (const auto arg : split_string(arguments, '&')) {
         auto keyVal = split_string(arg, '=');
         if (keyVal.size() == 2) {
             if (keyVal[0] == "start") {
-                start = to_int<unsigned>(keyVal[1]);
+                start = to_int<size_t>(keyVal[1]);
             } else if (keyVal[0] == "end") {
-                end = to_int<unsigned>(keyVal[1]);
+                end = to_int<size_t>(keyVal[1]);
+            } else if (keyVal[0] == "length") {
+                length = to_int<size_t>(keyVal[1]);
             } else if (keyVal[0] == "sha3") {
                 sha3Sum = keyVal[1];
             } else if (keyVal[0] == "modified") {
@@ -126,6 +128,9 @@ TransferChannelHandler::onReady(const std::shared_ptr<dht::crypto::Certificate>&
             }
         }
     }
+    // Ranges of chunked downloads are given by their length, as peers that ignore it send up to the end
+    if (length != 0)
+        end = start + length;
 
     // Check if profile
     if (idstr == "profile.vcf") {
@@ -153,4 +153,32 @@ YrsDocument::encodeDiff(const Bytes& stateVector) const
     return update;
 }
 
+YrsDocument::Bytes
+YrsDocument::mergeUpdates(const std::vector<Bytes>& updates)
+{
+    if (updates.size() == 1)
+        return updates.front();
+    if (updates.empty())
+        return {};
+    std::vector<const char*> data;
+    std::vector<uint32_t> sizes;
+    data.reserve(updates.size());
+    sizes.reserve(updates.size());
+    for (const auto& update : updates) {
+        data.emplace_back(reinterpret_cast<const char*>(update.data()));
+        sizes.emplace_back(static_cast<uint32_t>(update.size()));
+    }
+    // Merged at the encoding level: runs of items one client inserted in a row
+    // are squashed, which is what makes a burst of keystrokes weigh barely more
+    // than a single one.
+    uint32_t len = 0;
+    char* merged = ymerge_updates_v1(data.data(), sizes.data(), static_cast<uint32_t>(updates.size()), &len);
+    Bytes update;
+    if (merged) {
+        update.assign(reinterpret_cast<const uint8_t*>(merged), reinterpret_cast<const uint8_t*>(merged) + len);
+        ybinary_destroy(merged, len);
+    }
+    return update;
+}
+
 } // namespace jami
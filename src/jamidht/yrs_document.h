@@ -79,6 +79,10 @@ public:
      */
     Bytes encodeDiff(const Bytes& stateVector) const;
 
+    /// Several updates as a single one, without a replica to apply them to.
+    /// Empty when @p updates is, or when one of them is malformed.
+    static Bytes mergeUpdates(const std::vector<Bytes>& updates);
+
     /// Whether the document moved since this was last called, and clears the
     /// flag. Answered by yrs itself, which only reports an update that brought
     /// something the replica did not already hold: applying a known update, or
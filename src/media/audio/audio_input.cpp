@@ -99,6 +99,13 @@ AudioInput::setSeekTime(int64_t time)
     }
 }
 
+void
+AudioInput::setStats(std::shared_ptr<MediaStreamStats> stats)
+{
+    std::lock_guard lk(fmtMutex_);
+    stats_ = std::move(stats);
+}
+
 void
 AudioInput::readFromDevice()
 {
@@ -113,14 +120,30 @@ AudioInput::readFromDevice()
         }
     }
 
+    std::shared_ptr<MediaStreamStats> stats;
+    {
+        std::lock_guard lk(fmtMutex_);
+        stats = stats_;
+    }
+
     auto& bufferPool = Manager::instance().getRingBufferPool();
-    if (not bufferPool.waitForDataAvailable(id_, wakeUp_))
-        std::this_thread::sleep_until(wakeUp_);
+    {
+        MediaStageTimer timer(stats.get(), MediaStage::RINGBUFFER_WAIT);
+        if (not bufferPool.waitForDataAvailable(id_, wakeUp_))
+            std::this_thread::sleep_until(wakeUp_);
+    }
     wakeUp_ += MS_PER_PACKET;
 
-    auto audioFrame = bufferPool.getData(id_);
-    if (not audioFrame)
+    std::shared_ptr<AudioFrame> audioFrame;
+    {
+        MediaStageTimer timer(stats.get(), MediaStage::CAPTURE);
+        audioFrame = bufferPool.getData(id_);
+    }
+    if (not audioFrame) {
+        if (stats)
+            stats->drop(MediaStage::CAPTURE);
         return;
+    }
 
     if (muteState_) {
         libav_utils::fillWithSilence(audioFrame->pointer());
@@ -128,8 +151,10 @@ AudioInput::readFromDevice()
     }
 
     std::lock_guard lk(fmtMutex_);
-    if (bufferPool.getInternalAudioFormat() != format_)
+    if (bufferPool.getInternalAudioFormat() != format_) {
+        MediaStageTimer timer(stats.get(), MediaStage::RESAMPLE);
         audioFrame = resampler_->resample(std::move(audioFrame), format_);
+    }
     resizer_->enqueue(std::move(audioFrame));
 
     if (recorderCallback_ && settingMS_.exchange(false)) {
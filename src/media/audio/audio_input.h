@@ -27,6 +27,7 @@
 #include "observer.h"
 #include "threadloop.h"
 #include "media/media_codec.h"
+#include "media/media_stats.h"
 
 namespace jami {
 class AudioDeviceGuard;
@@ -63,6 +64,11 @@ public:
 
     void setRecorderCallback(const std::function<void(const MediaStream& ms)>& cb);
 
+    /**
+     * Record ring buffer wait, capture and resampling latencies into stats.
+     */
+    void setStats(std::shared_ptr<MediaStreamStats> stats);
+
     std::string getId() const { return id_; };
 
     /**
@@ -90,6 +96,7 @@ private:
     uint64_t sent_samples = 0;
     mutable std::mutex fmtMutex_ {};
     AudioFormat format_;
+    std::shared_ptr<MediaStreamStats> stats_; // protected by fmtMutex_
     int frameSize_;
     std::atomic_bool paused_ {true};
 
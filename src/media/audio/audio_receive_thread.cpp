@@ -51,9 +51,11 @@ AudioReceiveThread::setup()
 {
     std::lock_guard lk(mutex_);
     audioDecoder_.reset(new MediaDecoder([this](std::shared_ptr<MediaFrame>&& frame) mutable {
+        MediaStageTimer timer(stats_.get(), MediaStage::RENDER);
         notify(frame);
         ringbuffer_->put(std::static_pointer_cast<AudioFrame>(frame));
     }));
+    audioDecoder_->setStats(stats_);
     audioDecoder_->setContextCallback([this]() {
         if (recorderCallback_)
             recorderCallback_(getInfo());
@@ -54,6 +54,11 @@ public:
 
     void setRecorderCallback(const std::function<void(const MediaStream& ms)>& cb);
 
+    /**
+     * Must be called before startReceiver().
+     */
+    void setStats(std::shared_ptr<MediaStreamStats> stats) { stats_ = std::move(stats); }
+
 private:
     NON_COPYABLE(AudioReceiveThread);
 
@@ -77,6 +82,7 @@ private:
     std::unique_ptr<MediaIOHandle> demuxContext_;
 
     std::shared_ptr<RingBuffer> ringbuffer_;
+    std::shared_ptr<MediaStreamStats> stats_;
 
     uint16_t mtu_;
 
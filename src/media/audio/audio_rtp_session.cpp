@@ -43,7 +43,7 @@ AudioRtpSession::AudioRtpSession(const std::string& callId,
                                  const std::string& streamId,
                                  const std::shared_ptr<MediaRecorder>& rec)
     : RtpSession(callId, streamId, MediaType::MEDIA_AUDIO)
-    , rtcpCheckerThread_([] { return true; }, [this] { processRtcpChecker(); }, [] {})
+    , rtcpChecker_(callId, [this] { processRtcpChecker(); }, RTCP_CHECKING_INTERVAL)
 
 {
     recorder_ = rec;
@@ -104,6 +104,7 @@ AudioRtpSession::startSender()
         });
     });
     audioInput_->setMuted(muteState_);
+    audioInput_->setStats(stats_);
     audioInput_->setSuccessfulSetupCb(onSuccessfulSetup_);
     if (!fileAudio) {
         auto newParams = audioInput_->switchInput(input_);
@@ -139,14 +140,15 @@ AudioRtpSession::startSender()
 
     if (voiceCallback_)
         sender_->setVoiceCallback(voiceCallback_);
+    sender_->setStats(stats_);
 
     // NOTE do after sender/encoder are ready
     auto codec = std::static_pointer_cast<SystemAudioCodecInfo>(send_.codec);
     audioInput_->setFormat(codec->audioformat);
     audioInput_->attach(sender_.get());
 
-    if (not rtcpCheckerThread_.isRunning())
-        rtcpCheckerThread_.start();
+    if (not rtcpChecker_.isRunning())
+        rtcpChecker_.start();
 }
 
 void
@@ -188,6 +190,7 @@ AudioRtpSession::startReceiver()
     });
     receiveThread_->addIOContext(*socketPair_);
     receiveThread_->setSuccessfulSetupCb(onSuccessfulSetup_);
+    receiveThread_->setStats(stats_);
     receiveThread_->startReceiver();
 
     // Make the default ring buffer read the audio from the stream
@@ -219,6 +222,9 @@ AudioRtpSession::start(std::unique_ptr<dhtnet::IceSocket> rtp_sock, std::unique_
         } else {
             socketPair_.reset(new SocketPair(getRemoteRtpUri().c_str(), receive_.addr.getPort()));
         }
+        socketPair_->setStats(stats_);
+        // Quality is adapted as soon as the peer reports
+        socketPair_->setRtcpCallback(rtcpChecker_.waker());
 
         if (send_.crypto and receive_.crypto) {
             socketPair_->createSRTP(receive_.crypto.getCryptoSuite().c_str(),
@@ -259,7 +265,7 @@ AudioRtpSession::stop()
     if (socketPair_)
         socketPair_->interrupt();
 
-    rtcpCheckerThread_.join();
+    rtcpChecker_.join();
 
     receiveThread_.reset();
     sender_.reset();
@@ -385,7 +391,6 @@ void
 AudioRtpSession::processRtcpChecker()
 {
     adaptQualityAndBitrate();
-    socketPair_->waitForRTCP(std::chrono::seconds(rtcp_checking_interval));
 }
 
 void
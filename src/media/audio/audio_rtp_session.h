@@ -20,7 +20,7 @@
 #include "media/rtp_session.h"
 #include "media/media_stream.h"
 
-#include "threadloop.h"
+#include "media/media_executor.h"
 
 #include <string>
 #include <memory>
@@ -79,12 +79,12 @@ private:
     unsigned packetLoss_ {10};
     DeviceParams localAudioParams_;
 
-    InterruptedThreadLoop rtcpCheckerThread_;
+    // RTCP checks run on the shared media executor, woken up by each RTCP
+    // report, or after this interval without any
+    static constexpr std::chrono::seconds RTCP_CHECKING_INTERVAL {4};
+    MediaTask rtcpChecker_;
     void processRtcpChecker();
 
-    // Interval in seconds between RTCP checking
-    std::chrono::seconds rtcp_checking_interval {4};
-
     std::function<void(bool)> voiceCallback_;
 
     void attachRemoteRecorder(const MediaStream& ms);
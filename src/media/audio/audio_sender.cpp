@@ -108,6 +108,13 @@ AudioSender::setVoiceCallback(std::function<void(bool)> cb)
     }
 }
 
+void
+AudioSender::setStats(const std::shared_ptr<MediaStreamStats>& stats)
+{
+    if (audioEncoder_)
+        audioEncoder_->setStats(stats);
+}
+
 uint16_t
 AudioSender::getLastSeqValue()
 {
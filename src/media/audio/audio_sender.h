@@ -43,6 +43,7 @@ public:
     int setPacketLoss(uint64_t pl);
 
     void setVoiceCallback(std::function<void(bool)> cb);
+    void setStats(const std::shared_ptr<MediaStreamStats>& stats);
 
     void update(Observable<std::shared_ptr<jami::MediaFrame>>*, const std::shared_ptr<jami::MediaFrame>&) override;
 
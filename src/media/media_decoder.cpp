@@ -693,6 +693,7 @@ MediaDecoder::decode(AVPacket& packet)
     }
 
     int frameFinished = 0;
+    auto decodeStart = stats_ ? MediaStreamStats::clock::now() : MediaStreamStats::clock::time_point {};
     auto ret = avcodec_send_packet(decoderCtx_, &packet);
     // TODO: Investigate avcodec_send_packet returning AVERROR_INVALIDDATA.
     // * Bug Windows documented here: git.jami.net/savoirfairelinux/jami-daemon/-/issues/1116
@@ -751,6 +752,8 @@ MediaDecoder::decode(AVPacket& packet)
         frameFinished = 1;
 
     if (frameFinished) {
+        if (stats_)
+            stats_->record(MediaStage::DECODE, MediaStreamStats::clock::now() - decodeStart);
         if (inputDecoder_->type == AVMEDIA_TYPE_VIDEO) {
             frame->format = (AVPixelFormat) correctPixFmt(frame->format);
         } else {
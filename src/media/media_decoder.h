@@ -34,6 +34,7 @@
 #include "media_device.h"
 #include "media_stream.h"
 #include "media_buffer.h"
+#include "media_stats.h"
 #include "noncopyable.h"
 
 #include <asio/steady_timer.hpp>
@@ -205,6 +206,12 @@ public:
 
     void setFEC(bool enable) { fecEnabled_ = enable; }
 
+    /**
+     * Record decoding latency into stats (MediaStage::DECODE). Must be set
+     * before decoding starts.
+     */
+    void setStats(std::shared_ptr<MediaStreamStats> stats) { stats_ = std::move(stats); }
+
     void setContextCallback(const std::function<void()>& cb)
     {
         firstDecode_.exchange(true);
@@ -228,6 +235,7 @@ private:
     bool passthrough_ = false;
     int64_t startTime_;
     int64_t lastTimestamp_ {0};
+    std::shared_ptr<MediaStreamStats> stats_;
 
     DeviceParams inputParams_;
 
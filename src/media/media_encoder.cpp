@@ -55,6 +55,10 @@ constexpr double LOGREG_PARAM_B {-5.};
 constexpr double LOGREG_PARAM_A_HEVC {96};
 constexpr double LOGREG_PARAM_B_HEVC {-5.};
 
+// CRF decrease (higher quality) when screen content is static
+constexpr uint8_t STATIC_CONTENT_CRF_OFFSET {8};
+constexpr uint8_t STATIC_CONTENT_MIN_CRF {18};
+
 MediaEncoder::MediaEncoder()
     : outputCtx_(avformat_alloc_context())
 {
@@ -497,6 +501,9 @@ MediaEncoder::encode(AVFrame* frame, int streamIdx)
     if (!encoderCtx)
         return -1;
 
+    auto encodeStart = stats_ ? MediaStreamStats::clock::now() : MediaStreamStats::clock::time_point {};
+    MediaStreamStats::clock::duration muxTime {};
+
     ret = avcodec_send_frame(encoderCtx, frame);
     if (ret < 0)
         return -1;
@@ -511,11 +518,20 @@ MediaEncoder::encode(AVFrame* frame, int streamIdx)
         }
 
         if (pkt.size) {
-            if (send(pkt, streamIdx))
+            auto muxStart = stats_ ? MediaStreamStats::clock::now() : MediaStreamStats::clock::time_point {};
+            bool done = send(pkt, streamIdx);
+            if (stats_) {
+                auto elapsed = MediaStreamStats::clock::now() - muxStart;
+                stats_->record(MediaStage::PACKETIZE, elapsed);
+                muxTime += elapsed;
+            }
+            if (done)
                 break;
         }
     }
 
+    if (stats_)
+        stats_->record(MediaStage::ENCODE, MediaStreamStats::clock::now() - encodeStart - muxTime);
     av_packet_unref(&pkt);
     return 0;
 }
@@ -885,6 +901,21 @@ MediaEncoder::setBitrate(uint64_t br)
     return 1; // OK
 }
 
+void
+MediaEncoder::setStaticContent(bool isStatic)
+{
+    std::lock_guard lk(encMutex_);
+    if (staticContent_ == isStatic)
+        return;
+    staticContent_ = isStatic;
+    AVCodecContext* encoderCtx = getCurrentVideoAVCtx();
+    if (not encoderCtx or encoderCtx->codec_id != AV_CODEC_ID_H264 or videoBitrate_ == 0)
+        return;
+    // libx264 picks up the new rate control parameters on the next frame
+    JAMI_DEBUG("Static screen content {}", isStatic ? "detected" : "ended");
+    initH264(encoderCtx, videoBitrate_);
+}
+
 int
 MediaEncoder::setPacketLoss(uint64_t pl)
 {
@@ -910,10 +941,13 @@ MediaEncoder::setPacketLoss(uint64_t pl)
 void
 MediaEncoder::initH264(AVCodecContext* encoderCtx, uint64_t br)
 {
+    videoBitrate_ = br;
     int64_t maxBitrate = static_cast<int64_t>(1000 * br);
     // 200 Kbit/s    -> CRF40
     // 6 Mbit/s      -> CRF23
     uint8_t crf = (uint8_t) std::round(LOGREG_PARAM_A + LOGREG_PARAM_B * std::log(maxBitrate));
+    if (staticContent_ and crf > STATIC_CONTENT_MIN_CRF)
+        crf = (uint8_t) std::max(crf - STATIC_CONTENT_CRF_OFFSET, (int) STATIC_CONTENT_MIN_CRF);
     // bufsize parameter impact the variation of the bitrate, reduce to half the maxrate to limit
     // peak and congestion
     // https://trac.ffmpeg.org/wiki/Limiting%20the%20output%20bitrate
@@ -29,6 +29,7 @@
 #include "media_buffer.h"
 #include "media_codec.h"
 #include "media_stream.h"
+#include "media_stats.h"
 
 #include <memory>
 #include <optional>
@@ -103,6 +104,19 @@ public:
     int setBitrate(uint64_t br);
     int setPacketLoss(uint64_t pl);
 
+    /**
+     * Tune the video encoder for static screen content: frames come rarely,
+     * so each of them can afford a better quality within the same bitrate cap.
+     * Only applied on the fly for H264, other codecs ignore it.
+     */
+    void setStaticContent(bool isStatic);
+
+    /**
+     * Record encoding and packetization latencies into stats. Must be set
+     * before the first frame is encoded.
+     */
+    void setStats(std::shared_ptr<MediaStreamStats> stats) { stats_ = std::move(stats); }
+
 #ifdef ENABLE_HWACCEL
     void enableAccel(bool enableAccel);
 #endif
@@ -154,6 +168,9 @@ private:
     std::mutex encMutex_;
     bool linkableHW_ {false};
     RateMode mode_ {RateMode::CRF_CONSTRAINED};
+    uint64_t videoBitrate_ {0};
+    bool staticContent_ {false};
+    std::shared_ptr<MediaStreamStats> stats_;
     bool fecEnabled_ {false};
 
 #ifdef ENABLE_VIDEO
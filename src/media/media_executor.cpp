@@ -0,0 +1,315 @@
+/*
+ *  Copyright (C) 2004-2026 Savoir-faire Linux Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "media_executor.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <queue>
+
+namespace jami {
+
+struct MediaExecutor::Worker
+{
+    struct Entry
+    {
+        clock::time_point when;
+        uint64_t seq;
+        Task task;
+
+        bool operator>(const Entry& o) const { return when > o.when or (when == o.when and seq > o.seq); }
+    };
+
+    Worker()
+        : thread_([this] { run(); })
+    {}
+
+    ~Worker() { stop(); }
+
+    void push(clock::time_point when, Task&& task)
+    {
+        {
+            std::lock_guard lk(mutex_);
+            if (not running_)
+                return;
+            queue_.emplace(Entry {when, seq_++, std::move(task)});
+        }
+        cv_.notify_one();
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard lk(mutex_);
+            running_ = false;
+        }
+        cv_.notify_one();
+        if (thread_.joinable()) {
+            if (thread_.get_id() == std::this_thread::get_id())
+                thread_.detach();
+            else
+                thread_.join();
+        }
+    }
+
+    void run()
+    {
+        std::unique_lock lk(mutex_);
+        while (running_) {
+            if (queue_.empty()) {
+                cv_.wait(lk, [this] { return not running_ or not queue_.empty(); });
+                continue;
+            }
+            auto when = queue_.top().when;
+            if (when > clock::now()) {
+                cv_.wait_until(lk, when, [this, when] {
+                    return not running_ or (not queue_.empty() and queue_.top().when < when);
+                });
+                continue;
+            }
+            // priority_queue::top is const, the task is moved out before pop()
+            auto task = std::move(const_cast<Entry&>(queue_.top()).task);
+            queue_.pop();
+            lk.unlock();
+            try {
+                task();
+            } catch (const std::exception& e) {
+                JAMI_ERROR("[media executor] Unhandled exception in task: {}", e.what());
+            }
+            lk.lock();
+        }
+        // Drop pending tasks outside of the lock: they may own media objects
+        auto pending = std::move(queue_);
+        lk.unlock();
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<>> queue_;
+    uint64_t seq_ {0};
+    bool running_ {true};
+    std::thread thread_;
+};
+
+MediaExecutor::MediaExecutor(unsigned workers)
+{
+    if (workers == 0)
+        workers = std::max(2u, std::thread::hardware_concurrency());
+    workers_.reserve(workers);
+    for (unsigned i = 0; i < workers; ++i)
+        workers_.emplace_back(std::make_unique<Worker>());
+    JAMI_DEBUG("[media executor] Started with {} workers", workers);
+}
+
+MediaExecutor::~MediaExecutor()
+{
+    shutdown();
+}
+
+MediaExecutor&
+MediaExecutor::instance()
+{
+    static MediaExecutor executor;
+    return executor;
+}
+
+uint64_t
+MediaExecutor::affinityKey(std::string_view id)
+{
+    return std::hash<std::string_view> {}(id);
+}
+
+void
+MediaExecutor::schedule(uint64_t affinity, clock::time_point when, Task&& task)
+{
+    workerFor(affinity).push(when, std::move(task));
+}
+
+void
+MediaExecutor::shutdown()
+{
+    for (auto& worker : workers_)
+        worker->stop();
+}
+
+bool
+MediaExecutor::isCurrentWorker(uint64_t affinity) const
+{
+    return workerFor(affinity).thread_.get_id() == std::this_thread::get_id();
+}
+
+struct MediaTask::State
+{
+    State(MediaExecutor& executor, uint64_t affinity, clock::duration period, std::function<void()>&& process)
+        : executor(executor)
+        , affinity(affinity)
+        , period(period)
+        , process(std::move(process))
+    {}
+
+    MediaExecutor& executor;
+    uint64_t affinity;
+    clock::duration period;
+    std::function<void()> process;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool running {false};
+    bool busy {false};
+    // Incremented on each start/stop so that runs scheduled by a previous
+    // start() are ignored
+    uint64_t generation {0};
+    // Incremented each time a run is scheduled: only the latest one is
+    // kept, so that a wake-up replaces the periodic run instead of adding
+    // another chain of runs
+    uint64_t run {0};
+    clock::time_point nextDeadline;
+};
+
+MediaTask::MediaTask(std::string_view affinity,
+                     std::function<void()>&& process,
+                     clock::duration period,
+                     MediaExecutor& executor)
+    : executor_(executor)
+    , affinity_(MediaExecutor::affinityKey(affinity))
+    , state_(std::make_shared<State>(executor, affinity_, period, std::move(process)))
+{}
+
+MediaTask::~MediaTask()
+{
+    join();
+}
+
+void
+MediaTask::start()
+{
+    uint64_t generation;
+    {
+        std::lock_guard lk(state_->mutex);
+        if (state_->running)
+            return;
+        state_->running = true;
+        generation = ++state_->generation;
+    }
+    scheduleNext(state_, clock::now(), generation);
+}
+
+void
+MediaTask::stop()
+{
+    std::lock_guard lk(state_->mutex);
+    state_->running = false;
+    ++state_->generation;
+}
+
+void
+MediaTask::join()
+{
+    std::unique_lock lk(state_->mutex);
+    state_->running = false;
+    ++state_->generation;
+    // join() from process() itself must not wait on its own completion
+    if (executor_.isCurrentWorker(affinity_))
+        return;
+    state_->cv.wait(lk, [this] { return not state_->busy; });
+}
+
+bool
+MediaTask::isRunning() const
+{
+    std::lock_guard lk(state_->mutex);
+    return state_->running;
+}
+
+void
+MediaTask::wake()
+{
+    wake(state_);
+}
+
+std::function<void()>
+MediaTask::waker() const
+{
+    return [w = std::weak_ptr(state_)] {
+        if (auto s = w.lock())
+            wake(s);
+    };
+}
+
+void
+MediaTask::wake(const std::shared_ptr<State>& state)
+{
+    uint64_t generation;
+    {
+        std::lock_guard lk(state->mutex);
+        if (not state->running)
+            return;
+        generation = state->generation;
+    }
+    scheduleNext(state, clock::now(), generation);
+}
+
+void
+MediaTask::setNextDeadline(clock::time_point deadline)
+{
+    std::lock_guard lk(state_->mutex);
+    state_->nextDeadline = deadline;
+}
+
+void
+MediaTask::scheduleNext(const std::shared_ptr<State>& state, clock::time_point when, uint64_t generation)
+{
+    uint64_t run;
+    {
+        std::lock_guard lk(state->mutex);
+        run = ++state->run;
+    }
+    state->executor.schedule(state->affinity, when, [w = std::weak_ptr(state), when, generation, run] {
+        auto s = w.lock();
+        if (not s)
+            return;
+        {
+            std::lock_guard lk(s->mutex);
+            if (not s->running or s->generation != generation or s->run != run)
+                return;
+            s->busy = true;
+            s->nextDeadline = when + s->period;
+        }
+        try {
+            s->process();
+        } catch (const std::exception& e) {
+            JAMI_ERROR("[media task] Unhandled exception: {}", e.what());
+        }
+        clock::time_point next;
+        {
+            std::lock_guard lk(s->mutex);
+            s->busy = false;
+            s->cv.notify_all();
+            // Stopped, or woken up while running: the wake-up run takes over
+            if (not s->running or s->generation != generation or s->run != run)
+                return;
+            next = s->nextDeadline;
+        }
+        // Do not try to catch up after a long stall, resume from now
+        auto now = clock::now();
+        if (next + s->period < now)
+            next = now;
+        scheduleNext(s, next, generation);
+    });
+}
+
+} // namespace jami
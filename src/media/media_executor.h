@@ -0,0 +1,140 @@
+/*
+ *  Copyright (C) 2004-2026 Savoir-faire Linux Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "noncopyable.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace jami {
+
+/**
+ * Small fixed pool of media workers shared by every call.
+ *
+ * Media pipeline stages that used to own a dedicated ThreadLoop are scheduled
+ * here as tasks. Each task carries an affinity key (usually the call id):
+ * tasks with the same key always run on the same worker, in submission order,
+ * which keeps per-call state warm in that worker's caches and removes the need
+ * for cross-stage locking inside a call.
+ *
+ * Tasks must not block: a stage waiting for data should reschedule itself
+ * instead of sleeping.
+ */
+class MediaExecutor
+{
+public:
+    using clock = std::chrono::steady_clock;
+    using Task = std::function<void()>;
+
+    /**
+     * @param workers number of worker threads, 0 to use one per core
+     */
+    explicit MediaExecutor(unsigned workers = 0);
+    ~MediaExecutor();
+
+    static MediaExecutor& instance();
+
+    static uint64_t affinityKey(std::string_view id);
+
+    void post(uint64_t affinity, Task&& task) { schedule(affinity, clock::now(), std::move(task)); }
+    void schedule(uint64_t affinity, clock::time_point when, Task&& task);
+
+    /**
+     * Stop all workers. Pending tasks are dropped.
+     */
+    void shutdown();
+
+    unsigned workerCount() const { return static_cast<unsigned>(workers_.size()); }
+
+    /**
+     * Return true if the calling thread is the worker serving this affinity.
+     */
+    bool isCurrentWorker(uint64_t affinity) const;
+
+private:
+    NON_COPYABLE(MediaExecutor);
+    struct Worker;
+
+    Worker& workerFor(uint64_t affinity) const { return *workers_[affinity % workers_.size()]; }
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+};
+
+/**
+ * Periodic media task, the executor counterpart of ThreadLoop.
+ *
+ * process() is called every period on the worker selected by the affinity
+ * key. It may return a shorter or longer delay to the next call through
+ * setNextDeadline(). join() guarantees that no callback is running or will
+ * run afterwards, so the owner can safely destroy the state it captures.
+ */
+class MediaTask
+{
+public:
+    using clock = MediaExecutor::clock;
+
+    MediaTask(std::string_view affinity,
+              std::function<void()>&& process,
+              clock::duration period,
+              MediaExecutor& executor = MediaExecutor::instance());
+    ~MediaTask();
+
+    void start();
+    void stop();
+    void join();
+
+    bool isRunning() const;
+
+    /**
+     * Run process() as soon as possible instead of waiting for the end of the
+     * period, e.g. when the data it waits for arrives. The period restarts
+     * from this run. Ignored if the task is not running.
+     */
+    void wake();
+
+    /**
+     * Callable that wakes the task and may outlive it, to be handed to the
+     * producer of the data process() waits for.
+     */
+    std::function<void()> waker() const;
+
+    /**
+     * Called from process() to override the deadline of the next run.
+     */
+    void setNextDeadline(clock::time_point deadline);
+
+private:
+    NON_COPYABLE(MediaTask);
+    struct State;
+
+    static void wake(const std::shared_ptr<State>& state);
+    static void scheduleNext(const std::shared_ptr<State>& state, clock::time_point when, uint64_t generation);
+
+    MediaExecutor& executor_;
+    uint64_t affinity_;
+    std::shared_ptr<State> state_;
+};
+
+} // namespace jami
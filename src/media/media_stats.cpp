@@ -0,0 +1,176 @@
+/*
+ *  Copyright (C) 2004-2026 Savoir-faire Linux Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "media_stats.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace jami {
+
+std::string_view
+toString(MediaStage stage)
+{
+    switch (stage) {
+    case MediaStage::CAPTURE:
+        return "capture";
+    case MediaStage::RINGBUFFER_WAIT:
+        return "ringbuffer_wait";
+    case MediaStage::RESAMPLE:
+        return "resample";
+    case MediaStage::ENCODE:
+        return "encode";
+    case MediaStage::PACKETIZE:
+        return "packetize";
+    case MediaStage::SEND:
+        return "send";
+    case MediaStage::RECEIVE:
+        return "receive";
+    case MediaStage::JITTER_BUFFER:
+        return "jitter_buffer";
+    case MediaStage::DECODE:
+        return "decode";
+    case MediaStage::MIX:
+        return "mix";
+    case MediaStage::RENDER:
+        return "render";
+    default:
+        return "unknown";
+    }
+}
+
+unsigned
+LatencyHistogram::bucketIndex(uint64_t value) noexcept
+{
+    if (value < SUB_BUCKETS)
+        return static_cast<unsigned>(value);
+    auto magnitude = static_cast<unsigned>(std::bit_width(value)) - 1;
+    if (magnitude > MAX_MAGNITUDE)
+        return BUCKET_COUNT - 1;
+    auto shift = magnitude - SUB_BUCKET_BITS;
+    auto sub = static_cast<unsigned>(value >> shift) & (SUB_BUCKETS - 1);
+    return (shift + 1) * SUB_BUCKETS + sub;
+}
+
+uint64_t
+LatencyHistogram::bucketUpperBound(unsigned index) noexcept
+{
+    if (index < SUB_BUCKETS)
+        return index;
+    auto shift = index / SUB_BUCKETS - 1;
+    auto sub = index % SUB_BUCKETS;
+    return ((static_cast<uint64_t>(SUB_BUCKETS + sub) << shift) + (uint64_t(1) << shift)) - 1;
+}
+
+void
+LatencyHistogram::record(uint64_t value) noexcept
+{
+    buckets_[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+    auto max = max_.load(std::memory_order_relaxed);
+    while (value > max and not max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {}
+}
+
+LatencyHistogram::Snapshot
+LatencyHistogram::snapshot() const
+{
+    Snapshot s;
+    for (unsigned i = 0; i < BUCKET_COUNT; ++i) {
+        s.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+        // Count from buckets so percentiles stay consistent with concurrent records
+        s.count += s.buckets[i];
+    }
+    s.sum = sum_.load(std::memory_order_relaxed);
+    s.max = max_.load(std::memory_order_relaxed);
+    return s;
+}
+
+void
+LatencyHistogram::reset() noexcept
+{
+    for (auto& bucket : buckets_)
+        bucket.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+uint64_t
+LatencyHistogram::Snapshot::percentile(double p) const
+{
+    if (count == 0)
+        return 0;
+    auto target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(std::clamp(p, 0., 100.) * count / 100.)));
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < BUCKET_COUNT; ++i) {
+        seen += buckets[i];
+        if (seen >= target)
+            return std::min(bucketUpperBound(i), max);
+    }
+    return max;
+}
+
+std::vector<std::map<std::string, std::string>>
+MediaStreamStats::report() const
+{
+    std::vector<std::map<std::string, std::string>> ret;
+    for (size_t i = 0; i < stages_.size(); ++i) {
+        const auto& stage = stages_[i];
+        auto latency = stage.latency.snapshot();
+        auto bytes = stage.bytes.load(std::memory_order_relaxed);
+        auto drops = stage.drops.load(std::memory_order_relaxed);
+        if (latency.count == 0 and bytes == 0 and drops == 0)
+            continue;
+        ret.emplace_back(std::map<std::string, std::string> {
+            {"stream", streamId_},
+            {"stage", std::string(toString(static_cast<MediaStage>(i)))},
+            {"count", std::to_string(latency.count)},
+            {"bytes", std::to_string(bytes)},
+            {"drops", std::to_string(drops)},
+            {"meanUs", std::to_string(latency.mean() / 1000)},
+            {"p50Us", std::to_string(latency.percentile(50) / 1000)},
+            {"p90Us", std::to_string(latency.percentile(90) / 1000)},
+            {"p99Us", std::to_string(latency.percentile(99) / 1000)},
+            {"maxUs", std::to_string(latency.max / 1000)},
+        });
+    }
+    return ret;
+}
+
+std::shared_ptr<MediaStreamStats>
+CallMediaStats::stream(const std::string& streamId)
+{
+    std::lock_guard lk(mutex_);
+    auto& stats = streams_[streamId];
+    if (not stats)
+        stats = std::make_shared<MediaStreamStats>(streamId);
+    return stats;
+}
+
+std::vector<std::map<std::string, std::string>>
+CallMediaStats::report() const
+{
+    std::lock_guard lk(mutex_);
+    std::vector<std::map<std::string, std::string>> ret;
+    for (const auto& [id, stats] : streams_) {
+        auto streamReport = stats->report();
+        ret.insert(ret.end(), std::make_move_iterator(streamReport.begin()), std::make_move_iterator(streamReport.end()));
+    }
+    return ret;
+}
+
+} // namespace jami
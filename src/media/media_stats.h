@@ -0,0 +1,199 @@
+/*
+ *  Copyright (C) 2004-2026 Savoir-faire Linux Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "noncopyable.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace jami {
+
+/**
+ * Media pipeline stages, from capture to render.
+ */
+enum class MediaStage : uint8_t {
+    CAPTURE,
+    RINGBUFFER_WAIT,
+    RESAMPLE,
+    ENCODE,
+    PACKETIZE,
+    SEND,
+    RECEIVE,
+    JITTER_BUFFER,
+    DECODE,
+    MIX,
+    RENDER,
+    COUNT
+};
+
+std::string_view toString(MediaStage stage);
+
+/**
+ * Lock-free latency histogram with HDR-style log-linear buckets.
+ *
+ * Values are split in power of two ranges, each of them divided in
+ * SUB_BUCKETS linear buckets, which bounds the relative error of reported
+ * percentiles to 1/SUB_BUCKETS. Recording is a handful of relaxed atomic
+ * operations and is safe from any thread.
+ */
+class LatencyHistogram
+{
+public:
+    static constexpr unsigned SUB_BUCKET_BITS {3};
+    static constexpr unsigned SUB_BUCKETS {1u << SUB_BUCKET_BITS};
+    // Highest tracked power of two, larger values go to the last bucket (about 2 minutes in ns)
+    static constexpr unsigned MAX_MAGNITUDE {36};
+    static constexpr unsigned BUCKET_COUNT {(MAX_MAGNITUDE - SUB_BUCKET_BITS + 2) * SUB_BUCKETS};
+
+    struct Snapshot
+    {
+        uint64_t count {0};
+        uint64_t sum {0};
+        uint64_t max {0};
+        std::array<uint64_t, BUCKET_COUNT> buckets {};
+
+        /**
+         * @param p percentile in [0, 100]
+         * @return upper bound of the bucket holding the percentile
+         */
+        uint64_t percentile(double p) const;
+        uint64_t mean() const { return count ? sum / count : 0; }
+    };
+
+    void record(uint64_t value) noexcept;
+    Snapshot snapshot() const;
+    void reset() noexcept;
+
+    static unsigned bucketIndex(uint64_t value) noexcept;
+    static uint64_t bucketUpperBound(unsigned index) noexcept;
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets_ {};
+    std::atomic<uint64_t> sum_ {0};
+    std::atomic<uint64_t> max_ {0};
+};
+
+/**
+ * Counters and latency histograms of every pipeline stage of one media stream.
+ */
+class MediaStreamStats
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    explicit MediaStreamStats(std::string streamId)
+        : streamId_(std::move(streamId))
+    {}
+
+    const std::string& streamId() const { return streamId_; }
+
+    void record(MediaStage stage, clock::duration latency) noexcept
+    {
+        stages_[static_cast<size_t>(stage)].latency.record(
+            static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count()));
+    }
+    void addBytes(MediaStage stage, uint64_t bytes) noexcept
+    {
+        stages_[static_cast<size_t>(stage)].bytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+    void drop(MediaStage stage, uint64_t count = 1) noexcept
+    {
+        stages_[static_cast<size_t>(stage)].drops.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    LatencyHistogram::Snapshot latency(MediaStage stage) const
+    {
+        return stages_[static_cast<size_t>(stage)].latency.snapshot();
+    }
+
+    /**
+     * One map per stage with activity: stream, stage, count, bytes, drops
+     * and mean, p50, p90, p99 and max latencies in microseconds.
+     */
+    std::vector<std::map<std::string, std::string>> report() const;
+
+private:
+    NON_COPYABLE(MediaStreamStats);
+
+    struct Stage
+    {
+        LatencyHistogram latency;
+        std::atomic<uint64_t> bytes {0};
+        std::atomic<uint64_t> drops {0};
+    };
+
+    const std::string streamId_;
+    std::array<Stage, static_cast<size_t>(MediaStage::COUNT)> stages_ {};
+};
+
+/**
+ * Measure the duration of a scope into a stage. Does nothing without stats.
+ */
+class MediaStageTimer
+{
+public:
+    MediaStageTimer(MediaStreamStats* stats, MediaStage stage)
+        : stats_(stats)
+        , stage_(stage)
+    {
+        if (stats_)
+            start_ = MediaStreamStats::clock::now();
+    }
+    ~MediaStageTimer()
+    {
+        if (stats_)
+            stats_->record(stage_, MediaStreamStats::clock::now() - start_);
+    }
+
+private:
+    NON_COPYABLE(MediaStageTimer);
+    MediaStreamStats* stats_;
+    MediaStage stage_;
+    MediaStreamStats::clock::time_point start_ {};
+};
+
+/**
+ * Media statistics of a call, one entry per stream.
+ */
+class CallMediaStats
+{
+public:
+    CallMediaStats() = default;
+
+    /**
+     * Return the stats of streamId, created on first use.
+     */
+    std::shared_ptr<MediaStreamStats> stream(const std::string& streamId);
+
+    std::vector<std::map<std::string, std::string>> report() const;
+
+private:
+    NON_COPYABLE(CallMediaStats);
+    mutable std::mutex mutex_;
+    std::map<std::string, std::shared_ptr<MediaStreamStats>> streams_;
+};
+
+} // namespace jami
@@ -18,6 +18,7 @@
 
 #include "socket_pair.h"
 #include "media/media_codec.h"
+#include "media/media_stats.h"
 
 #include <functional>
 #include <string>
@@ -58,6 +59,11 @@ public:
 
     void setMtu(uint16_t mtu) { mtu_ = mtu; }
 
+    /**
+     * Pipeline statistics of this stream, to be set before start().
+     */
+    void setStats(std::shared_ptr<MediaStreamStats> stats) { stats_ = std::move(stats); }
+
     void setSuccessfulSetupCb(const std::function<void(MediaType, bool)>& cb) { onSuccessfulSetup_ = cb; }
 
     virtual void initRecorder() = 0;
@@ -80,6 +86,7 @@ protected:
     uint16_t mtu_;
     std::shared_ptr<MediaRecorder> recorder_;
     std::function<void(MediaType, bool)> onSuccessfulSetup_;
+    std::shared_ptr<MediaStreamStats> stats_;
 
     std::string getRemoteRtpUri() const { return "rtp://" + send_.addr.toString(true); }
 };
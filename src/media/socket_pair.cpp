@@ -206,13 +206,11 @@ SocketPair::~SocketPair()
     JAMI_LOG("[{}] Instance destroyed", fmt::ptr(this));
 }
 
-bool
-SocketPair::waitForRTCP(std::chrono::seconds interval)
+void
+SocketPair::setRtcpCallback(std::function<void(void)> cb)
 {
-    std::unique_lock lock(rtcpInfo_mutex_);
-    return cvRtcpPacketReadyToRead_.wait_for(lock, interval, [this] {
-        return interrupted_ or not listRtcpRRHeader_.empty() or not listRtcpREMBHeader_.empty();
-    });
+    std::lock_guard lock(rtcpInfo_mutex_);
+    rtcpCallback_ = std::move(cb);
 }
 
 void
@@ -225,15 +223,19 @@ SocketPair::saveRtcpRRPacket(uint8_t* buf, size_t len)
     if (header->pt != 201) // 201 = RR PT
         return;
 
-    std::lock_guard lock(rtcpInfo_mutex_);
-
-    if (listRtcpRRHeader_.size() >= MAX_LIST_SIZE) {
-        listRtcpRRHeader_.pop_front();
-    }
+    std::function<void(void)> cb;
+    {
+        std::lock_guard lock(rtcpInfo_mutex_);
 
-    listRtcpRRHeader_.emplace_back(*header);
+        if (listRtcpRRHeader_.size() >= MAX_LIST_SIZE) {
+            listRtcpRRHeader_.pop_front();
+        }
 
-    cvRtcpPacketReadyToRead_.notify_one();
+        listRtcpRRHeader_.emplace_back(*header);
+        cb = rtcpCallback_;
+    }
+    if (cb)
+        cb();
 }
 
 void
@@ -249,15 +251,19 @@ SocketPair::saveRtcpREMBPacket(uint8_t* buf, size_t len)
     if (header->uid != 0x424D4552) // uid must be "REMB"
         return;
 
-    std::lock_guard lock(rtcpInfo_mutex_);
-
-    if (listRtcpREMBHeader_.size() >= MAX_LIST_SIZE) {
-        listRtcpREMBHeader_.pop_front();
-    }
+    std::function<void(void)> cb;
+    {
+        std::lock_guard lock(rtcpInfo_mutex_);
 
-    listRtcpREMBHeader_.push_back(*header);
+        if (listRtcpREMBHeader_.size() >= MAX_LIST_SIZE) {
+            listRtcpREMBHeader_.pop_front();
+        }
 
-    cvRtcpPacketReadyToRead_.notify_one();
+        listRtcpREMBHeader_.push_back(*header);
+        cb = rtcpCallback_;
+    }
+    if (cb)
+        cb();
 }
 
 std::list<rtcpRRHeader>
@@ -290,7 +296,6 @@ SocketPair::interrupt()
     if (rtcp_sock_)
         rtcp_sock_->setOnRecv(nullptr);
     cv_.notify_all();
-    cvRtcpPacketReadyToRead_.notify_all();
 }
 
 void
@@ -299,7 +304,6 @@ SocketPair::setReadBlockingMode(bool block)
     JAMI_LOG("[{}] Read operations in blocking mode [{}]", fmt::ptr(this), block ? "YES" : "NO");
     readBlockingMode_ = block;
     cv_.notify_all();
-    cvRtcpPacketReadyToRead_.notify_all();
 }
 
 void
@@ -485,6 +489,7 @@ SocketPair::readCallback(uint8_t* buf, int buf_size)
     if (datatype < 0)
         return datatype;
 
+    MediaStageTimer timer(stats_.get(), MediaStage::RECEIVE);
     int len = 0;
     bool fromRTCP = false;
 
@@ -544,13 +549,30 @@ SocketPair::readCallback(uint8_t* buf, int buf_size)
             rtpDelayCallback_(gradient, deltaT);
 
         auto err = ff_srtp_decrypt(&srtpContext_->srtp_in, buf, &len);
-        if (packetLossCallback_ and (buf[2] << 8 | buf[3]) != lastSeqNumIn_ + 1)
-            packetLossCallback_();
-        lastSeqNumIn_ = buf[2] << 8 | buf[3];
+        auto seqNum = static_cast<uint16_t>(buf[2] << 8 | buf[3]);
+        if (not hasSeqNumIn_) {
+            hasSeqNumIn_ = true;
+            lastSeqNumIn_ = seqNum;
+        } else {
+            // Packets missing since the previous one, modulo 2^16 as sequence numbers wrap
+            auto gap = static_cast<uint16_t>(seqNum - static_cast<uint16_t>(lastSeqNumIn_ + 1));
+            // A gap of more than half the range is a late or duplicated packet
+            if (gap < 0x8000) {
+                if (gap != 0) {
+                    if (stats_)
+                        stats_->drop(MediaStage::RECEIVE, gap);
+                    if (packetLossCallback_)
+                        packetLossCallback_();
+                }
+                lastSeqNumIn_ = seqNum;
+            }
+        }
         if (err < 0)
             JAMI_WARNING("decrypt error {}", err);
     }
 
+    if (stats_ and len > 0)
+        stats_->addBytes(MediaStage::RECEIVE, static_cast<uint64_t>(len));
     if (len != 0)
         return len;
     else
@@ -628,11 +650,16 @@ SocketPair::writeCallback(uint8_t* buf, int buf_size)
         rtcpPacketLoss_ = (header->pt == 201 && ntohl(header->fraction_lost) & RTCP_RR_FRACTION_MASK);
     }
 
-    do {
-        if (interrupted_)
-            return -EINTR;
-        ret = writeData(buf, buf_size);
-    } while (ret < 0 and errno == EAGAIN);
+    {
+        MediaStageTimer timer(stats_.get(), MediaStage::SEND);
+        do {
+            if (interrupted_)
+                return -EINTR;
+            ret = writeData(buf, buf_size);
+        } while (ret < 0 and errno == EAGAIN);
+    }
+    if (stats_ and ret > 0)
+        stats_->addBytes(MediaStage::SEND, static_cast<uint64_t>(ret));
 
     if (buf[1] == 200) // Sender Report
     {
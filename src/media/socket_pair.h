@@ -22,6 +22,7 @@
 #endif
 
 #include "media_io_handle.h"
+#include "media_stats.h"
 
 #ifndef _WIN32
 #include <sys/socket.h>
@@ -169,10 +170,21 @@ public:
     std::list<rtcpRRHeader> getRtcpRR();
     std::list<rtcpREMBHeader> getRtcpREMB();
 
-    bool waitForRTCP(std::chrono::seconds interval);
     double getLastLatency();
 
+    /**
+     * Called when an RTCP report (RR or REMB) is received, from the receive
+     * path: it must not block.
+     */
+    void setRtcpCallback(std::function<void(void)> cb);
+
     void setPacketLossCallback(std::function<void(void)> cb) { packetLossCallback_ = std::move(cb); }
+
+    /**
+     * Record send and receive latencies and byte counts into stats.
+     * Must be set before any IO context is created.
+     */
+    void setStats(std::shared_ptr<MediaStreamStats> stats) { stats_ = std::move(stats); }
     void setRtpDelayCallback(std::function<void(int, int)> cb);
 
     int writeData(uint8_t* buf, int buf_size);
@@ -212,6 +224,7 @@ private:
     std::atomic_bool noWrite_ {false};
     std::unique_ptr<SRTPProtoContext> srtpContext_;
     std::function<void(void)> packetLossCallback_;
+    std::shared_ptr<MediaStreamStats> stats_;
     std::function<void(int, int)> rtpDelayCallback_;
     bool getOneWayDelayGradient(float sendTS, bool marker, int32_t* gradient, int32_t* deltaR);
     bool parse_RTP_ext(uint8_t* buf, float* abs);
@@ -219,7 +232,7 @@ private:
     std::list<rtcpRRHeader> listRtcpRRHeader_;
     std::list<rtcpREMBHeader> listRtcpREMBHeader_;
     std::mutex rtcpInfo_mutex_;
-    std::condition_variable cvRtcpPacketReadyToRead_;
+    std::function<void(void)> rtcpCallback_;
     static constexpr unsigned MAX_LIST_SIZE {10};
 
     mutable std::atomic_bool rtcpPacketLoss_ {false};
@@ -230,6 +243,7 @@ private:
 
     time_point lastRR_time;
     uint16_t lastSeqNumIn_ {0};
+    bool hasSeqNumIn_ {false};
     float lastSendTS_ {0.0f};
     time_point lastReceiveTS_ {};
     time_point arrival_TS {};
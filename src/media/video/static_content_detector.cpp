@@ -0,0 +1,130 @@
+/*
+ *  Copyright (C) 2004-2026 Savoir-faire Linux Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "static_content_detector.h"
+#include "libav_deps.h"
+
+#include <cstring>
+
+namespace jami {
+namespace video {
+
+static constexpr uint64_t FNV_OFFSET {0xcbf29ce484222325ULL};
+static constexpr uint64_t FNV_PRIME {0x100000001b3ULL};
+
+static inline uint64_t
+hashBytes(uint64_t h, const uint8_t* data, size_t len)
+{
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        h = (h ^ word) * FNV_PRIME;
+    }
+    for (; i < len; ++i)
+        h = (h ^ data[i]) * FNV_PRIME;
+    return h;
+}
+
+bool
+StaticContentDetector::isScreenCapture(std::string_view format)
+{
+    return format == "x11grab" || format == "dxgigrab" || format == "pipewiregrab" || format == "gdigrab";
+}
+
+StaticContentDetector::StaticContentDetector(clock::duration refreshInterval)
+    : refreshInterval_(refreshInterval)
+{}
+
+void
+StaticContentDetector::reset()
+{
+    hashes_.clear();
+    width_ = 0;
+    height_ = 0;
+    format_ = -1;
+    static_ = false;
+    lastForwarded_ = {};
+}
+
+unsigned
+StaticContentDetector::update(const AVFrame& frame)
+{
+    constexpr unsigned blockCount = BLOCKS * BLOCKS;
+    const auto* desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(frame.format));
+    if (not desc or (desc->flags & AV_PIX_FMT_FLAG_HWACCEL) or not frame.data[0] or frame.height <= 0) {
+        // Unable to look at the content, always consider it changed
+        hashes_.clear();
+        return blockCount;
+    }
+
+    bool sameLayout = frame.width == width_ and frame.height == height_ and frame.format == format_
+                      and hashes_.size() == blockCount;
+    width_ = frame.width;
+    height_ = frame.height;
+    format_ = frame.format;
+
+    int rowBytes = av_image_get_linesize(static_cast<AVPixelFormat>(frame.format), frame.width, 0);
+    if (rowBytes <= 0) {
+        hashes_.clear();
+        return blockCount;
+    }
+
+    std::vector<uint64_t> current(blockCount, FNV_OFFSET);
+    size_t blockBytes[BLOCKS + 1];
+    for (unsigned bx = 0; bx <= BLOCKS; ++bx)
+        blockBytes[bx] = static_cast<size_t>(rowBytes) * bx / BLOCKS;
+
+    for (int y = 0; y < frame.height; y += ROW_STEP) {
+        const uint8_t* row = frame.data[0] + static_cast<ptrdiff_t>(y) * frame.linesize[0];
+        auto* blockRow = current.data() + static_cast<size_t>(y) * BLOCKS / frame.height * BLOCKS;
+        for (unsigned bx = 0; bx < BLOCKS; ++bx)
+            blockRow[bx] = hashBytes(blockRow[bx], row + blockBytes[bx], blockBytes[bx + 1] - blockBytes[bx]);
+    }
+
+    unsigned changed = blockCount;
+    if (sameLayout) {
+        changed = 0;
+        for (unsigned i = 0; i < blockCount; ++i)
+            changed += current[i] != hashes_[i];
+    }
+    hashes_ = std::move(current);
+    return changed;
+}
+
+bool
+StaticContentDetector::filter(const VideoFrame& frame, clock::time_point now)
+{
+    const auto* avframe = frame.pointer();
+    if (not avframe or frame.packet())
+        return true;
+
+    if (update(*avframe) > 0) {
+        static_ = false;
+        lastForwarded_ = now;
+        return true;
+    }
+    static_ = true;
+    if (now - lastForwarded_ >= refreshInterval_) {
+        lastForwarded_ = now;
+        return true;
+    }
+    return false;
+}
+
+} // namespace video
+} // namespace jami
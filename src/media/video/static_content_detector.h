@@ -0,0 +1,90 @@
+/*
+ *  Copyright (C) 2004-2026 Savoir-faire Linux Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "media/media_buffer.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+extern "C" {
+struct AVFrame;
+}
+
+namespace jami {
+namespace video {
+
+/**
+ * Cheap change detection for screen captures.
+ *
+ * The first plane of each frame is split in a BLOCKS x BLOCKS grid and every
+ * block is hashed from one row out of ROW_STEP. A frame is considered unchanged
+ * when all block hashes match the previous frame. Sampling rows may miss very
+ * small updates, which is why a refresh frame is still let through every
+ * refreshInterval.
+ */
+class StaticContentDetector
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    static constexpr unsigned BLOCKS {16};
+    static constexpr int ROW_STEP {4};
+    static constexpr std::chrono::milliseconds DEFAULT_REFRESH_INTERVAL {1000};
+
+    explicit StaticContentDetector(clock::duration refreshInterval = DEFAULT_REFRESH_INTERVAL);
+
+    /**
+     * True for the capture formats of a shared screen or window, the only
+     * sources that are expected to stay unchanged for long
+     */
+    static bool isScreenCapture(std::string_view format);
+
+    /**
+     * Return true if frame must be forwarded to the encoder, either because
+     * its content changed or because a refresh is due.
+     */
+    bool filter(const VideoFrame& frame, clock::time_point now = clock::now());
+
+    /**
+     * Compare frame with the previous one and remember it.
+     * Return the number of blocks that changed, all of them on the first
+     * frame or after a size or format change.
+     */
+    unsigned update(const AVFrame& frame);
+
+    /**
+     * True if the last frames were dropped as unchanged.
+     */
+    bool isStatic() const { return static_; }
+
+    void reset();
+
+private:
+    clock::duration refreshInterval_;
+    clock::time_point lastForwarded_ {};
+    std::vector<uint64_t> hashes_;
+    int width_ {0};
+    int height_ {0};
+    int format_ {-1};
+    bool static_ {false};
+};
+
+} // namespace video
+} // namespace jami
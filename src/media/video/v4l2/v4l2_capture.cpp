@@ -0,0 +1,440 @@
+/*
+ *  Copyright (C) 2004-2026 Savoir-faire Linux Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "libav_deps.h" // MUST BE INCLUDED FIRST
+#include "v4l2_capture.h"
+#include "logger.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+extern "C" {
+#include <linux/videodev2.h>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+}
+
+#define ZEROVAR(x) std::memset(&(x), 0, sizeof(x))
+
+namespace jami {
+namespace video {
+
+namespace {
+
+int
+xioctl(int fd, unsigned long request, void* arg)
+{
+    int ret;
+    do {
+        ret = ioctl(fd, request, arg);
+    } while (ret == -1 && errno == EINTR);
+    return ret;
+}
+
+// Raw formats that can be wrapped without conversion, in order of preference
+struct RawFormat
+{
+    uint32_t fourcc;
+    AVPixelFormat format;
+};
+
+constexpr RawFormat rawFormats[] = {
+    {V4L2_PIX_FMT_YUV420, AV_PIX_FMT_YUV420P},
+    {V4L2_PIX_FMT_NV12, AV_PIX_FMT_NV12},
+    {V4L2_PIX_FMT_YUYV, AV_PIX_FMT_YUYV422},
+    {V4L2_PIX_FMT_UYVY, AV_PIX_FMT_UYVY422},
+};
+
+AVPixelFormat
+rawPixelFormat(uint32_t fourcc)
+{
+    for (const auto& f : rawFormats)
+        if (f.fourcc == fourcc)
+            return f.format;
+    return AV_PIX_FMT_NONE;
+}
+
+} // namespace
+
+struct V4l2Capture::Buffers
+{
+    struct Mapping
+    {
+        void* start {MAP_FAILED};
+        size_t length {0};
+        int dmabufFd {-1};
+    };
+
+    ~Buffers()
+    {
+        for (auto& m : mappings) {
+            if (m.dmabufFd != -1)
+                ::close(m.dmabufFd);
+            if (m.start != MAP_FAILED)
+                munmap(m.start, m.length);
+        }
+        if (fd != -1)
+            ::close(fd);
+    }
+
+    void requeue(unsigned index)
+    {
+        std::lock_guard lk(mutex);
+        if (not streaming)
+            return;
+        v4l2_buffer buf;
+        ZEROVAR(buf);
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = index;
+        if (xioctl(fd, VIDIOC_QBUF, &buf) < 0)
+            JAMI_WARNING("[v4l2] Unable to requeue buffer {}: {}", index, strerror(errno));
+    }
+
+    int fd {-1};
+    std::vector<Mapping> mappings;
+    // Serializes QBUF from frame release callbacks against STREAMOFF
+    std::mutex mutex;
+    bool streaming {false};
+};
+
+bool
+V4l2Capture::isSupported(const DeviceParams& params)
+{
+    if (getenv("JAMI_DISABLE_V4L2_CAPTURE"))
+        return false;
+    // Passthrough packets and compressed formats other than MJPEG, which is
+    // decoded here, stay on libavdevice
+    return params.format == "video4linux2" and not params.passthrough
+           and (params.pixel_format.empty() or params.pixel_format == "mjpeg");
+}
+
+V4l2Capture::V4l2Capture(const DeviceParams& params, unsigned bufferCount)
+    : buffers_(std::make_shared<Buffers>())
+{
+    buffers_->fd = ::open(params.input.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (buffers_->fd == -1)
+        throw std::runtime_error("Unable to open " + params.input + ": " + strerror(errno));
+
+    v4l2_capability cap;
+    ZEROVAR(cap);
+    if (xioctl(buffers_->fd, VIDIOC_QUERYCAP, &cap) < 0)
+        throw std::runtime_error("Unable to query capabilities");
+    auto caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS) ? cap.device_caps : cap.capabilities;
+    if (!(caps & V4L2_CAP_VIDEO_CAPTURE) or !(caps & V4L2_CAP_STREAMING))
+        throw std::runtime_error("Device does not support streaming capture");
+
+    int channel = static_cast<int>(params.channel);
+    if (xioctl(buffers_->fd, VIDIOC_S_INPUT, &channel) < 0)
+        JAMI_WARNING("[v4l2] Unable to select input {}", channel);
+
+    setFormat(params);
+    setFramerate(params);
+    allocateBuffers(bufferCount);
+
+    {
+        std::lock_guard lk(buffers_->mutex);
+        for (unsigned i = 0; i < buffers_->mappings.size(); ++i) {
+            v4l2_buffer buf;
+            ZEROVAR(buf);
+            buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+            buf.memory = V4L2_MEMORY_MMAP;
+            buf.index = i;
+            if (xioctl(buffers_->fd, VIDIOC_QBUF, &buf) < 0)
+                throw std::runtime_error("Unable to queue buffer");
+        }
+        int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        if (xioctl(buffers_->fd, VIDIOC_STREAMON, &type) < 0)
+            throw std::runtime_error(std::string("Unable to start streaming: ") + strerror(errno));
+        buffers_->streaming = true;
+    }
+    if (fourcc_ == V4L2_PIX_FMT_MJPEG)
+        openDecoder();
+
+    JAMI_LOG("[v4l2] Capturing {} {}x{} @ {} fps with {} mmap buffers{}",
+             params.input,
+             width_,
+             height_,
+             fps_.real(),
+             buffers_->mappings.size(),
+             hasDmaBuf() ? " (DMABUF exported)" : "");
+}
+
+V4l2Capture::~V4l2Capture()
+{
+    {
+        std::lock_guard lk(buffers_->mutex);
+        if (buffers_->streaming) {
+            int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+            xioctl(buffers_->fd, VIDIOC_STREAMOFF, &type);
+            buffers_->streaming = false;
+        }
+    }
+    if (decoderCtx_)
+        avcodec_free_context(&decoderCtx_);
+    // Mappings are released once the last frame referencing them is gone
+}
+
+void
+V4l2Capture::setFormat(const DeviceParams& params)
+{
+    std::vector<uint32_t> candidates;
+    if (params.pixel_format == "mjpeg")
+        candidates.emplace_back(V4L2_PIX_FMT_MJPEG);
+    else
+        for (const auto& f : rawFormats)
+            candidates.emplace_back(f.fourcc);
+
+    for (auto fourcc : candidates) {
+        v4l2_format fmt;
+        ZEROVAR(fmt);
+        fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        fmt.fmt.pix.width = params.width;
+        fmt.fmt.pix.height = params.height;
+        fmt.fmt.pix.pixelformat = fourcc;
+        fmt.fmt.pix.field = V4L2_FIELD_NONE;
+        if (xioctl(buffers_->fd, VIDIOC_S_FMT, &fmt) < 0)
+            continue;
+        // The driver may pick another format than the one requested
+        if (fmt.fmt.pix.pixelformat != fourcc)
+            continue;
+        fourcc_ = fourcc;
+        width_ = static_cast<int>(fmt.fmt.pix.width);
+        height_ = static_cast<int>(fmt.fmt.pix.height);
+        bytesPerLine_ = fmt.fmt.pix.bytesperline;
+        pixelFormat_ = rawPixelFormat(fourcc);
+        return;
+    }
+    throw std::runtime_error("No supported pixel format");
+}
+
+void
+V4l2Capture::setFramerate(const DeviceParams& params)
+{
+    v4l2_streamparm parm;
+    ZEROVAR(parm);
+    parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (params.framerate and xioctl(buffers_->fd, VIDIOC_G_PARM, &parm) == 0
+        and (parm.parm.capture.capability & V4L2_CAP_TIMEPERFRAME)) {
+        parm.parm.capture.timeperframe.numerator = 1000;
+        parm.parm.capture.timeperframe.denominator = static_cast<uint32_t>(std::lround(params.framerate.real() * 1000));
+        if (xioctl(buffers_->fd, VIDIOC_S_PARM, &parm) < 0)
+            JAMI_WARNING("[v4l2] Unable to set frame rate");
+    }
+    ZEROVAR(parm);
+    parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (xioctl(buffers_->fd, VIDIOC_G_PARM, &parm) == 0 and parm.parm.capture.timeperframe.numerator)
+        fps_ = {static_cast<double>(parm.parm.capture.timeperframe.denominator),
+                static_cast<double>(parm.parm.capture.timeperframe.numerator)};
+    else
+        fps_ = params.framerate;
+}
+
+void
+V4l2Capture::allocateBuffers(unsigned count)
+{
+    v4l2_requestbuffers req;
+    ZEROVAR(req);
+    req.count = count;
+    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    req.memory = V4L2_MEMORY_MMAP;
+    if (xioctl(buffers_->fd, VIDIOC_REQBUFS, &req) < 0)
+        throw std::runtime_error(std::string("Unable to request mmap buffers: ") + strerror(errno));
+    if (req.count < 2)
+        throw std::runtime_error("Insufficient buffer memory");
+
+    buffers_->mappings.resize(req.count);
+    for (unsigned i = 0; i < req.count; ++i) {
+        v4l2_buffer buf;
+        ZEROVAR(buf);
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = i;
+        if (xioctl(buffers_->fd, VIDIOC_QUERYBUF, &buf) < 0)
+            throw std::runtime_error("Unable to query buffer");
+
+        auto& mapping = buffers_->mappings[i];
+        mapping.length = buf.length;
+        mapping.start = mmap(nullptr, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED, buffers_->fd, buf.m.offset);
+        if (mapping.start == MAP_FAILED)
+            throw std::runtime_error(std::string("Unable to map buffer: ") + strerror(errno));
+
+#ifdef VIDIOC_EXPBUF
+        v4l2_exportbuffer expbuf;
+        ZEROVAR(expbuf);
+        expbuf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        expbuf.index = i;
+        expbuf.flags = O_RDONLY | O_CLOEXEC;
+        if (xioctl(buffers_->fd, VIDIOC_EXPBUF, &expbuf) == 0)
+            mapping.dmabufFd = expbuf.fd;
+#endif
+    }
+}
+
+void
+V4l2Capture::openDecoder()
+{
+    const auto* codec = avcodec_find_decoder(AV_CODEC_ID_MJPEG);
+    if (not codec)
+        throw std::runtime_error("No MJPEG decoder");
+    decoderCtx_ = avcodec_alloc_context3(codec);
+    if (not decoderCtx_)
+        throw std::bad_alloc();
+    decoderCtx_->width = width_;
+    decoderCtx_->height = height_;
+    decoderCtx_->thread_count = 1;
+    if (avcodec_open2(decoderCtx_, codec, nullptr) < 0)
+        throw std::runtime_error("Unable to open MJPEG decoder");
+}
+
+unsigned
+V4l2Capture::getBufferCount() const
+{
+    return static_cast<unsigned>(buffers_->mappings.size());
+}
+
+bool
+V4l2Capture::hasDmaBuf() const
+{
+    return not buffers_->mappings.empty() and buffers_->mappings.front().dmabufFd != -1;
+}
+
+V4l2Capture::Status
+V4l2Capture::capture(std::shared_ptr<VideoFrame>& frame, std::chrono::milliseconds timeout)
+{
+    pollfd pfd {buffers_->fd, POLLIN, 0};
+    auto ret = poll(&pfd, 1, static_cast<int>(timeout.count()));
+    if (ret == 0 or (ret < 0 and errno == EINTR))
+        return Status::Again;
+    if (ret < 0 or (pfd.revents & (POLLERR | POLLHUP | POLLNVAL))) {
+        JAMI_ERROR("[v4l2] Poll error: {}", strerror(errno));
+        return Status::Error;
+    }
+
+    v4l2_buffer buf;
+    ZEROVAR(buf);
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = V4L2_MEMORY_MMAP;
+    if (xioctl(buffers_->fd, VIDIOC_DQBUF, &buf) < 0) {
+        if (errno == EAGAIN)
+            return Status::Again;
+        JAMI_ERROR("[v4l2] Unable to dequeue buffer: {}", strerror(errno));
+        return Status::Error;
+    }
+    if (buf.index >= buffers_->mappings.size())
+        return Status::Error;
+    if ((buf.flags & V4L2_BUF_FLAG_ERROR) or buf.bytesused == 0) {
+        buffers_->requeue(buf.index);
+        return Status::Again;
+    }
+
+    if (fourcc_ == V4L2_PIX_FMT_MJPEG)
+        return decodeMjpeg(buf.index, buf.bytesused, frame);
+    return wrapRaw(buf.index, buf.bytesused, frame);
+}
+
+V4l2Capture::Status
+V4l2Capture::wrapRaw(unsigned index, unsigned bytesused, std::shared_ptr<VideoFrame>& frame)
+{
+    auto* data = static_cast<uint8_t*>(buffers_->mappings[index].start);
+    // Drivers may pad lines: describe the buffer with its padded width so
+    // that plane pointers and strides match the driver layout
+    auto tight = av_image_get_linesize(pixelFormat_, width_, 0);
+    auto paddedWidth = (tight > 0 and bytesPerLine_ > static_cast<unsigned>(tight))
+                           ? static_cast<int>(static_cast<int64_t>(width_) * bytesPerLine_ / tight)
+                           : width_;
+    if (av_image_get_buffer_size(pixelFormat_, paddedWidth, height_, 1) > static_cast<int>(bytesused)) {
+        JAMI_WARNING("[v4l2] Short buffer ({} bytes)", bytesused);
+        buffers_->requeue(index);
+        return Status::Again;
+    }
+
+    frame = std::make_shared<VideoFrame>();
+    frame->setFromMemory(data, pixelFormat_, paddedWidth, height_, [buffers = buffers_, index](uint8_t*) {
+        buffers->requeue(index);
+    });
+    frame->pointer()->width = width_;
+    return Status::Success;
+}
+
+V4l2Capture::Status
+V4l2Capture::decodeMjpeg(unsigned index, unsigned bytesused, std::shared_ptr<VideoFrame>& frame)
+{
+    // Opaque of the AVBufferRef wrapping the mapped buffer
+    struct PacketRef
+    {
+        std::shared_ptr<Buffers> buffers;
+        unsigned index;
+    };
+
+    auto* data = static_cast<uint8_t*>(buffers_->mappings[index].start);
+    auto* ref = new PacketRef {buffers_, index};
+    auto* avbuf = av_buffer_create(
+        data,
+        bytesused,
+        [](void* opaque, uint8_t*) {
+            auto* ref = static_cast<PacketRef*>(opaque);
+            ref->buffers->requeue(ref->index);
+            delete ref;
+        },
+        ref,
+        AV_BUFFER_FLAG_READONLY);
+    if (not avbuf) {
+        delete ref;
+        buffers_->requeue(index);
+        return Status::Error;
+    }
+
+    // The packet references the mapped buffer: the driver gets it back as
+    // soon as the decoder no longer needs it
+    auto* packet = av_packet_alloc();
+    packet->buf = avbuf;
+    packet->data = data;
+    packet->size = static_cast<int>(bytesused);
+    packet->flags |= AV_PKT_FLAG_KEY;
+    auto ret = avcodec_send_packet(decoderCtx_, packet);
+    av_packet_free(&packet);
+    if (ret < 0) {
+        JAMI_WARNING("[v4l2] Unable to decode MJPEG frame: {}", libav_utils::getError(ret));
+        return Status::Again;
+    }
+
+    auto decoded = std::make_shared<VideoFrame>();
+    ret = avcodec_receive_frame(decoderCtx_, decoded->pointer());
+    if (ret == AVERROR(EAGAIN))
+        return Status::Again;
+    if (ret < 0) {
+        JAMI_WARNING("[v4l2] Unable to decode MJPEG frame: {}", libav_utils::getError(ret));
+        return Status::Again;
+    }
+    pixelFormat_ = static_cast<AVPixelFormat>(decoded->format());
+    frame = std::move(decoded);
+    return Status::Success;
+}
+
+} // namespace video
+} // namespace jami
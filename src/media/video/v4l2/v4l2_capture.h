@@ -0,0 +1,103 @@
+/*
+ *  Copyright (C) 2004-2026 Savoir-faire Linux Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "noncopyable.h"
+#include "media/media_buffer.h"
+#include "media/media_device.h"
+
+#include <chrono>
+#include <memory>
+
+extern "C" {
+#include <libavutil/pixfmt.h>
+struct AVCodecContext;
+}
+
+namespace jami {
+namespace video {
+
+/**
+ * Native V4L2 streaming capture.
+ *
+ * Buffers are allocated by the driver (VIDIOC_REQBUFS with mmap) and every
+ * dequeued buffer is wrapped as a VideoFrame without copy; releasing the frame
+ * queues the buffer back to the driver. MJPEG buffers are given to the decoder
+ * straight from the mapped memory.
+ *
+ * Buffers are also exported as DMABUF file descriptors when the driver
+ * supports it, for consumers able to import them.
+ *
+ * Constructor throws std::runtime_error if the device is unable to stream
+ * in a format handled here, in which case the caller should fall back to the
+ * libavdevice path.
+ */
+class V4l2Capture
+{
+public:
+    static constexpr unsigned DEFAULT_BUFFER_COUNT = 4;
+
+    enum class Status { Success, Again, Error };
+
+    explicit V4l2Capture(const DeviceParams& params, unsigned bufferCount = DEFAULT_BUFFER_COUNT);
+    ~V4l2Capture();
+
+    /**
+     * Returns true if params can be handled by this backend.
+     */
+    static bool isSupported(const DeviceParams& params);
+
+    /**
+     * Wait at most timeout for the next frame.
+     */
+    Status capture(std::shared_ptr<VideoFrame>& frame, std::chrono::milliseconds timeout);
+
+    int getWidth() const { return width_; }
+    int getHeight() const { return height_; }
+    /**
+     * Pixel format of delivered frames. For MJPEG devices, this is only known
+     * once the first frame has been decoded.
+     */
+    AVPixelFormat getPixelFormat() const { return pixelFormat_; }
+    rational<double> getFps() const { return fps_; }
+    unsigned getBufferCount() const;
+    bool hasDmaBuf() const;
+
+private:
+    NON_COPYABLE(V4l2Capture);
+    struct Buffers;
+
+    void setFormat(const DeviceParams& params);
+    void setFramerate(const DeviceParams& params);
+    void allocateBuffers(unsigned count);
+    void openDecoder();
+
+    Status wrapRaw(unsigned index, unsigned bytesused, std::shared_ptr<VideoFrame>& frame);
+    Status decodeMjpeg(unsigned index, unsigned bytesused, std::shared_ptr<VideoFrame>& frame);
+
+    std::shared_ptr<Buffers> buffers_;
+    uint32_t fourcc_ {0};
+    int width_ {0};
+    int height_ {0};
+    unsigned bytesPerLine_ {0};
+    AVPixelFormat pixelFormat_ {AV_PIX_FMT_NONE};
+    rational<double> fps_ {};
+    AVCodecContext* decoderCtx_ {nullptr};
+};
+
+} // namespace video
+} // namespace jami
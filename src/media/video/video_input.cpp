@@ -28,6 +28,9 @@
 #include "client/jami_signal.h"
 #include "logger.h"
 #include "media/media_buffer.h"
+#if defined(__linux__) && !defined(__ANDROID__)
+#include "v4l2/v4l2_capture.h"
+#endif
 
 #include <libavformat/avio.h>
 
@@ -118,6 +121,10 @@ VideoInput::getWidth() const
     if (videoManagedByClient()) {
         return static_cast<int>(decOpts_.width);
     }
+#if defined(__linux__) && !defined(__ANDROID__)
+    if (v4l2Capture_)
+        return v4l2Capture_->getWidth();
+#endif
     return decoder_ ? decoder_->getWidth() : 0;
 }
 
@@ -127,6 +134,10 @@ VideoInput::getHeight() const
     if (videoManagedByClient()) {
         return static_cast<int>(decOpts_.height);
     }
+#if defined(__linux__) && !defined(__ANDROID__)
+    if (v4l2Capture_)
+        return v4l2Capture_->getHeight();
+#endif
     return decoder_ ? decoder_->getHeight() : 0;
 }
 
@@ -134,6 +145,10 @@ AVPixelFormat
 VideoInput::getPixelFormat() const
 {
     if (!videoManagedByClient()) {
+#if defined(__linux__) && !defined(__ANDROID__)
+        if (v4l2Capture_)
+            return v4l2Capture_->getPixelFormat();
+#endif
         return decoder_->getPixelFormat();
     }
     return (AVPixelFormat) std::stoi(decOpts_.format);
@@ -205,6 +220,21 @@ bool
 VideoInput::captureFrame()
 {
     // Return true if capture could continue, false if must be stop
+#if defined(__linux__) && !defined(__ANDROID__)
+    if (v4l2Capture_) {
+        std::shared_ptr<VideoFrame> frame;
+        switch (v4l2Capture_->capture(frame, std::chrono::milliseconds(100))) {
+        case V4l2Capture::Status::Success:
+            publishFrame(std::move(frame));
+            return true;
+        case V4l2Capture::Status::Again:
+            return true;
+        default:
+            JAMI_ERROR("Failed to capture frame");
+            return false;
+        }
+    }
+#endif
     if (not decoder_)
         return false;
 
@@ -219,6 +249,17 @@ VideoInput::captureFrame()
         return true;
     }
 }
+
+void
+VideoInput::publishCapturedFrame(const std::shared_ptr<VideoFrame>& frame)
+{
+    // Unchanged screen content is neither converted nor encoded, only a
+    // periodic refresh frame goes through
+    if (staticContentDetector_ and not staticContentDetector_->filter(*frame))
+        return;
+    publishFrame(frame);
+}
+
 void
 VideoInput::flushBuffers()
 {
@@ -293,8 +334,18 @@ VideoInput::createDecoder()
         return;
     }
 
+#if defined(__linux__) && !defined(__ANDROID__)
+    if (createV4l2Capture())
+        return;
+#endif
+
+    if (StaticContentDetector::isScreenCapture(decOpts_.format)) {
+        staticContentDetector_ = std::make_unique<StaticContentDetector>();
+        JAMI_DEBUG("Static content detection enabled for {}", decOpts_.format);
+    }
+
     auto decoder = std::make_unique<MediaDecoder>([this](const std::shared_ptr<MediaFrame>& frame) mutable {
-        publishFrame(std::static_pointer_cast<VideoFrame>(frame));
+        publishCapturedFrame(std::static_pointer_cast<VideoFrame>(frame));
     });
 
     if (emulateRate_)
@@ -389,9 +440,69 @@ VideoInput::createDecoder()
     });
 }
 
+#if defined(__linux__) && !defined(__ANDROID__)
+bool
+VideoInput::createV4l2Capture()
+{
+    if (not V4l2Capture::isSupported(decOpts_))
+        return false;
+
+    std::unique_ptr<V4l2Capture> capture;
+    try {
+        capture = std::make_unique<V4l2Capture>(decOpts_);
+    } catch (const std::exception& e) {
+        JAMI_WARNING("Native capture unavailable for \"{}\", falling back to libavdevice: {}",
+                     decOpts_.input,
+                     e.what());
+        return false;
+    }
+
+    // Wait for a first frame: the pixel format of MJPEG devices is only known once decoded
+    static constexpr unsigned FIRST_FRAME_ATTEMPTS = 20;
+    std::shared_ptr<VideoFrame> frame;
+    auto status = V4l2Capture::Status::Again;
+    for (unsigned i = 0; i < FIRST_FRAME_ATTEMPTS && status == V4l2Capture::Status::Again && !isStopped_; ++i)
+        status = capture->capture(frame, std::chrono::milliseconds(100));
+    if (status != V4l2Capture::Status::Success) {
+        JAMI_WARNING("No frame from \"{}\" with native capture, falling back to libavdevice", decOpts_.input);
+        return false;
+    }
+
+    decOpts_.width = ((capture->getWidth() >> 3) << 3);
+    decOpts_.height = ((capture->getHeight() >> 3) << 3);
+    decOpts_.framerate = capture->getFps();
+    decOpts_.pixel_format = av_get_pix_fmt_name(capture->getPixelFormat());
+
+    JAMI_LOG("created native capture with video params : size={}X{}, fps={} pix={}",
+             decOpts_.width,
+             decOpts_.height,
+             decOpts_.framerate.real(),
+             decOpts_.pixel_format);
+    if (onSuccessfulSetup_)
+        onSuccessfulSetup_(MEDIA_VIDEO, 0);
+
+    v4l2Capture_ = std::move(capture);
+    foundDecOpts(decOpts_);
+
+    /* Signal the client about readable sink */
+    sink_->setFrameSize(v4l2Capture_->getWidth(), v4l2Capture_->getHeight());
+    if (recorderCallback_)
+        recorderCallback_(getInfo());
+    publishFrame(std::move(frame));
+    return true;
+}
+#endif
+
 void
 VideoInput::deleteDecoder()
 {
+#if defined(__linux__) && !defined(__ANDROID__)
+    if (v4l2Capture_) {
+        flushFrames();
+        v4l2Capture_.reset();
+    }
+#endif
+    staticContentDetector_.reset();
     if (not decoder_)
         return;
     flushFrames();
@@ -22,6 +22,7 @@
 #include "media/media_device.h" // DeviceParams
 #include "media/video/video_base.h"
 #include "media/media_codec.h"
+#include "media/video/static_content_detector.h"
 
 #include <atomic>
 #include <future>
@@ -40,6 +41,9 @@ namespace jami {
 namespace video {
 
 class SinkClient;
+#if defined(__linux__) && !defined(__ANDROID__)
+class V4l2Capture;
+#endif
 
 enum class VideoInputMode : uint8_t { ManagedByClient, ManagedByDaemon, Undefined };
 
@@ -121,6 +125,15 @@ private:
     void createDecoder();
     void deleteDecoder();
     std::unique_ptr<MediaDecoder> decoder_;
+#if defined(__linux__) && !defined(__ANDROID__)
+    // Native zero-copy capture, used instead of decoder_ for cameras when possible
+    std::unique_ptr<V4l2Capture> v4l2Capture_;
+    bool createV4l2Capture();
+#endif
+    // Drops unchanged frames when sharing a screen, null for other sources
+    std::unique_ptr<StaticContentDetector> staticContentDetector_;
+    void publishCapturedFrame(const std::shared_ptr<VideoFrame>& frame);
+
     std::shared_ptr<SinkClient> sink_;
     ThreadLoop loop_;
 
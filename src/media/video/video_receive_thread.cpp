@@ -89,8 +89,10 @@ VideoReceiveThread::setup()
         }
         if (displayMatrix)
             av_frame_new_side_data_from_buf(frame->pointer(), AV_FRAME_DATA_DISPLAYMATRIX, displayMatrix.release());
+        MediaStageTimer timer(stats_.get(), MediaStage::RENDER);
         publishFrame(std::static_pointer_cast<VideoFrame>(frame));
     }));
+    videoDecoder_->setStats(stats_);
     videoDecoder_->setContextCallback([this]() {
         if (recorderCallback_)
             recorderCallback_(getInfo());
@@ -24,6 +24,7 @@
 #include "media/media_codec.h"
 #include "media/media_device.h"
 #include "media/media_stream.h"
+#include "media/media_stats.h"
 #include "threadloop.h"
 #include "noncopyable.h"
 #include "media/libav_utils.h"
@@ -76,6 +77,11 @@ public:
 
     void setRecorderCallback(const std::function<void(const MediaStream& ms)>& cb);
 
+    /**
+     * Must be called before startLoop().
+     */
+    void setStats(std::shared_ptr<MediaStreamStats> stats) { stats_ = std::move(stats); }
+
 private:
     NON_COPYABLE(VideoReceiveThread);
 
@@ -93,6 +99,7 @@ private:
     MediaIOHandle sdpContext_;
     std::unique_ptr<MediaIOHandle> demuxContext_;
     std::shared_ptr<SinkClient> sink_;
+    std::shared_ptr<MediaStreamStats> stats_;
     bool isVideoConfigured_ {false};
     uint16_t mtu_;
     int rotation_ {0};
@@ -20,6 +20,7 @@
 #include "video_sender.h"
 #include "video_receive_thread.h"
 #include "video_mixer.h"
+#include "static_content_detector.h"
 #include "socket_pair.h"
 #include "manager.h"
 #ifdef ENABLE_PLUGIN
@@ -56,7 +57,7 @@ VideoRtpSession::VideoRtpSession(const string& callId,
     : RtpSession(callId, streamId, MediaType::MEDIA_VIDEO)
     , localVideoParams_(localVideoParams)
     , videoBitrateInfo_ {}
-    , rtcpCheckerThread_([] { return true; }, [this] { processRtcpChecker(); }, [] {})
+    , rtcpChecker_(callId, [this] { processRtcpChecker(); }, RTCP_CHECKING_INTERVAL)
     , cc(std::make_unique<CongestionControl>())
 {
     recorder_ = rec;
@@ -233,10 +234,20 @@ VideoRtpSession::startSender()
                 send_.bitrate = videoBitrateInfo_.videoBitrateCurrent;
                 ms.bitrate = static_cast<int>(send_.bitrate);
             }
-            sender_.reset(
-                new VideoSender(getRemoteRtpUri(), ms, send_, *socketPair_, initSeqVal_ + 1, mtu_, allowHwAccel));
+            // Only a shared screen skips unchanged frames: other sources keep
+            // one pts per frame
+            bool screenShare = !videoMixer_ && StaticContentDetector::isScreenCapture(localVideoParams_.format);
+            sender_.reset(new VideoSender(getRemoteRtpUri(),
+                                          ms,
+                                          send_,
+                                          *socketPair_,
+                                          initSeqVal_ + 1,
+                                          mtu_,
+                                          allowHwAccel,
+                                          screenShare));
             if (changeOrientationCallback_)
                 sender_->setChangeOrientationCallback(changeOrientationCallback_);
+            sender_->setStats(stats_);
             if (socketPair_)
                 socketPair_->setPacketLossCallback([this]() { cbKeyFrameRequest_(); });
 
@@ -247,10 +258,10 @@ VideoRtpSession::startSender()
         lastMediaRestart_ = clock::now();
         last_REMB_inc_ = clock::now();
         last_REMB_dec_ = clock::now();
-        if (autoQuality and not rtcpCheckerThread_.isRunning())
-            rtcpCheckerThread_.start();
-        else if (not autoQuality and rtcpCheckerThread_.isRunning())
-            rtcpCheckerThread_.join();
+        if (autoQuality and not rtcpChecker_.isRunning())
+            rtcpChecker_.start();
+        else if (not autoQuality and rtcpChecker_.isRunning())
+            rtcpChecker_.join();
         // Block reads to received feedback packets
         if (socketPair_)
             socketPair_->setReadBlockingMode(true);
@@ -320,6 +331,7 @@ VideoRtpSession::startReceiver()
         // XXX keyframe requests can timeout if unanswered
         receiveThread_->addIOContext(*socketPair_);
         receiveThread_->setSuccessfulSetupCb(onSuccessfulSetup_);
+        receiveThread_->setStats(stats_);
         receiveThread_->startLoop();
         receiveThread_->setRequestKeyFrameCallback([this]() { cbKeyFrameRequest_(); });
         receiveThread_->setRotation(rotation_.load());
@@ -429,6 +441,9 @@ VideoRtpSession::start(std::unique_ptr<dhtnet::IceSocket> rtp_sock, std::unique_
         } else {
             socketPair_.reset(new SocketPair(getRemoteRtpUri().c_str(), receive_.addr.getPort()));
         }
+        socketPair_->setStats(stats_);
+        // Quality is adapted as soon as the peer reports
+        socketPair_->setRtcpCallback(rtcpChecker_.waker());
 
         last_REMB_inc_ = clock::now();
         last_REMB_dec_ = clock::now();
@@ -472,7 +487,7 @@ VideoRtpSession::stop()
     if (socketPair_)
         socketPair_->interrupt();
 
-    rtcpCheckerThread_.join();
+    rtcpChecker_.join();
 
     // reset default video quality if exist
     if (videoBitrateInfo_.videoQualityCurrent != SystemCodecInfo::DEFAULT_NO_QUALITY)
@@ -832,7 +847,6 @@ void
 VideoRtpSession::processRtcpChecker()
 {
     adaptQualityAndBitrate();
-    socketPair_->waitForRTCP(std::chrono::seconds(rtcp_checking_interval));
 }
 
 void
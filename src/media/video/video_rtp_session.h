@@ -20,7 +20,7 @@
 #include "media/media_device.h"
 
 #include "media_stream.h"
-#include "threadloop.h"
+#include "media/media_executor.h"
 
 #include <string>
 #include <memory>
@@ -156,16 +156,16 @@ private:
     // packet loss threshold
     static constexpr float PACKET_LOSS_THRESHOLD {1.0};
 
-    InterruptedThreadLoop rtcpCheckerThread_;
+    // RTCP checks run on the shared media executor, woken up by each RTCP
+    // report, or after this interval without any
+    static constexpr std::chrono::seconds RTCP_CHECKING_INTERVAL {4};
+    MediaTask rtcpChecker_;
     void processRtcpChecker();
 
     std::function<void(int)> changeOrientationCallback_;
 
     std::function<void(bool)> recordingStateCallback_;
 
-    // interval in seconds between RTCP checkings
-    std::chrono::seconds rtcp_checking_interval {4};
-
     time_point lastMediaRestart_ {time_point::min()};
     time_point last_REMB_inc_ {time_point::min()};
     time_point last_REMB_dec_ {time_point::min()};
@@ -26,6 +26,9 @@
 
 #include <unistd.h>
 
+#include <algorithm>
+#include <cmath>
+
 namespace jami {
 namespace video {
 
@@ -37,11 +40,14 @@ VideoSender::VideoSender(const std::string& dest,
                          SocketPair& socketPair,
                          const uint16_t seqVal,
                          uint16_t mtu,
-                         bool enableHwAccel)
+                         bool enableHwAccel,
+                         bool screenShare)
     : muxContext_(socketPair.createIOContext(mtu))
     , videoEncoder_(new MediaEncoder)
+    , screenShare_(screenShare)
 {
     keyFrameFreq_ = static_cast<int>(opts.frameRate.numerator() * KEY_FRAME_PERIOD);
+    frameRate_ = opts.frameRate.real<double>();
     videoEncoder_->openOutput(dest, "rtp");
     videoEncoder_->setOptions(opts);
     videoEncoder_->setOptions(args);
@@ -71,7 +77,7 @@ VideoSender::encodeAndSendVideo(const std::shared_ptr<VideoFrame>& input_frame)
         if (is_keyframe)
             --forceKeyFrame_;
 
-        if (videoEncoder_->encode(input_frame, is_keyframe, frameNumber_++) < 0)
+        if (videoEncoder_->encode(input_frame, is_keyframe, nextFrameNumber()) < 0)
             JAMI_ERROR("encoding failed");
     }
 #ifdef DEBUG_SDP
@@ -80,6 +86,31 @@ VideoSender::encodeAndSendVideo(const std::shared_ptr<VideoFrame>& input_frame)
 #endif
 }
 
+int64_t
+VideoSender::nextFrameNumber()
+{
+    // Camera and file sources keep one pts per frame, whatever their timing
+    if (!screenShare_)
+        return frameNumber_++;
+
+    // Frame numbers are used as pts: when frames were skipped upstream,
+    // advance by the number of elapsed frame intervals to keep timing right.
+    auto now = std::chrono::steady_clock::now();
+    if (lastFrameTime_ != std::chrono::steady_clock::time_point {}) {
+        auto gap = now - lastFrameTime_;
+        int64_t elapsed = frameRate_ > 0 ? std::llround(std::chrono::duration<double>(gap).count() * frameRate_) : 1;
+        frameNumber_ += std::max<int64_t>(elapsed, 1);
+
+        bool isStatic = gap >= STATIC_CONTENT_GAP;
+        if (isStatic != staticContent_) {
+            staticContent_ = isStatic;
+            videoEncoder_->setStaticContent(isStatic);
+        }
+    }
+    lastFrameTime_ = now;
+    return frameNumber_;
+}
+
 void
 VideoSender::update(Observable<std::shared_ptr<MediaFrame>>* /*obs*/, const std::shared_ptr<MediaFrame>& frame_p)
 {
@@ -23,6 +23,7 @@
 #include <string>
 #include <memory>
 #include <atomic>
+#include <chrono>
 
 // Forward declarations
 namespace jami {
@@ -42,7 +43,8 @@ public:
                 SocketPair& socketPair,
                 const uint16_t seqVal,
                 uint16_t mtu,
-                bool allowHwAccel = true);
+                bool allowHwAccel = true,
+                bool screenShare = false);
 
     ~VideoSender() {};
 
@@ -55,10 +57,13 @@ public:
 
     void setChangeOrientationCallback(std::function<void(int)> cb);
     int setBitrate(uint64_t br);
+    void setStats(const std::shared_ptr<MediaStreamStats>& stats) { videoEncoder_->setStats(stats); }
 
 private:
     static constexpr int KEYFRAMES_AT_START {1};    // Number of keyframes to enforce at stream startup
     static constexpr unsigned KEY_FRAME_PERIOD {0}; // seconds before forcing a keyframe
+    // Screen-share frames further apart than this mean the content is static
+    static constexpr std::chrono::milliseconds STATIC_CONTENT_GAP {300};
 
     NON_COPYABLE(VideoSender);
 
@@ -67,10 +72,16 @@ private:
     // encoder MUST be deleted before muxContext
     std::unique_ptr<MediaIOHandle> muxContext_ = nullptr;
     std::unique_ptr<MediaEncoder> videoEncoder_ = nullptr;
+    // Frames may be skipped while the content is unchanged (see StaticContentDetector)
+    const bool screenShare_ {false};
 
     std::atomic<int> forceKeyFrame_ {KEYFRAMES_AT_START};
     int keyFrameFreq_ {0}; // Set keyframe rate, 0 to disable auto-keyframe. Computed in constructor
     int64_t frameNumber_ = 0;
+    double frameRate_ {0};
+    std::chrono::steady_clock::time_point lastFrameTime_ {};
+    bool staticContent_ {false};
+    int64_t nextFrameNumber();
 
     int rotation_ = -1;
     std::function<void(int)> changeOrientationCallback_;
@@ -190,7 +190,7 @@ SIPCall::createRtpSession(RtpStream& stream)
     // Must be valid at this point.
     if (not stream.rtpSession_)
         throw std::runtime_error("Failed to create RTP session");
-    ;
+    stream.rtpSession_->setStats(mediaStats_->stream(stream.mediaAttribute_->label_));
 }
 
 void
@@ -33,6 +33,7 @@
 #include "media/video/sinkclient.h"
 #include "sip/sipcall.h"
 #include "sip/siptransport.h"
+#include "json_utils.h"
 
 #include <dhtnet/connectionmanager.h>
 
@@ -107,6 +108,8 @@ private:
     void testBrokenParticipantAudioOnly();
     void testAudioOnlyLeaveLayout();
     void testRemoveConferenceInOneOne();
+    void testConfInfoDelta();
+    void testConfInfoDeltaNegotiation();
 
     CPPUNIT_TEST_SUITE(ConferenceTest);
     CPPUNIT_TEST(testGetConference);
@@ -132,6 +135,8 @@ private:
     CPPUNIT_TEST(testBrokenParticipantAudioOnly);
     CPPUNIT_TEST(testAudioOnlyLeaveLayout);
     CPPUNIT_TEST(testRemoveConferenceInOneOne);
+    CPPUNIT_TEST(testConfInfoDelta);
+    CPPUNIT_TEST(testConfInfoDeltaNegotiation);
     CPPUNIT_TEST_SUITE_END();
 
     // Common parts
@@ -1330,6 +1335,89 @@ ConferenceTest::testRemoveConferenceInOneOne()
     libjami::unregisterSignalHandlers();
 }
 
+void
+ConferenceTest::testConfInfoDelta()
+{
+    auto participant = [](const std::string& uri, const std::string& sinkId) {
+        ParticipantInfo info;
+        info.uri = uri;
+        info.device = uri + "_device";
+        info.sinkId = sinkId;
+        info.w = 320;
+        info.h = 180;
+        return info;
+    };
+    ConfInfo base;
+    base.w = 1280;
+    base.h = 720;
+    for (int i = 0; i < 10; ++i)
+        base.emplace_back(participant("peer" + std::to_string(i), "video_" + std::to_string(i)));
+
+    // One voice activity flip, one participant leaving and one joining
+    ConfInfo next = base;
+    next[3].voiceActivity = true;
+    next.erase(next.begin() + 5);
+    next.emplace_back(participant("peer10", "video_10"));
+    next.layout = 2;
+
+    auto delta = next.toDeltaString(base, 2);
+    CPPUNIT_ASSERT(delta.size() < next.toString(2).size() / 2);
+
+    Json::Value json;
+    CPPUNIT_ASSERT(json::parse(delta, json));
+    CPPUNIT_ASSERT(json["base"].asUInt64() == 1);
+    CPPUNIT_ASSERT(json["seq"].asUInt64() == 2);
+    CPPUNIT_ASSERT(json["p"].size() == 2);
+    CPPUNIT_ASSERT(json["removed"].size() == 1);
+
+    ConfInfo applied = base;
+    applied.applyDelta(json);
+    CPPUNIT_ASSERT(applied.sameContent(next));
+    CPPUNIT_ASSERT(applied.w == 1280 and applied.h == 720);
+
+    // No change, empty delta
+    CPPUNIT_ASSERT(json::parse(next.toDeltaString(next, 3), json));
+    CPPUNIT_ASSERT(json["p"].empty() and json["removed"].empty());
+}
+
+void
+ConferenceTest::testConfInfoDeltaNegotiation()
+{
+    registerSignalHandlers();
+
+    auto bobAccount = Manager::instance().getAccount<JamiAccount>(bobId);
+
+    startConference();
+    auto bobCallPtr = bobAccount->getCall(bobCall.callId);
+    CPPUNIT_ASSERT(bobCallPtr);
+
+    // Bob asks for deltas when receiving the first revision: the following
+    // layout changes must reach him as deltas
+    uint32_t layout = 0;
+    auto deltaApplied = false;
+    for (auto i = 0; i < 5 and !deltaApplied; ++i) {
+        layout = (layout + 1) % 3;
+        libjami::setConferenceLayout(aliceId, confId, layout);
+        std::unique_lock lk {mtx};
+        deltaApplied = cv.wait_for(lk, 5s, [&] { return bobCallPtr->getConfInfoDeltasApplied() > 0; });
+    }
+    CPPUNIT_ASSERT(deltaApplied);
+
+    // The deltas rebuild what a full revision would have given
+    auto deltas = bobCallPtr->getConfInfoDeltasApplied();
+    layout = (layout + 1) % 3;
+    libjami::setConferenceLayout(aliceId, confId, layout);
+    {
+        std::unique_lock lk {mtx};
+        CPPUNIT_ASSERT(cv.wait_for(lk, 5s, [&] { return bobCallPtr->getConfInfoDeltasApplied() > deltas; }));
+    }
+    CPPUNIT_ASSERT(bobCallPtr->getConferenceInfos().size() == libjami::getConferenceInfos(aliceId, confId).size());
+
+    hangupConference();
+
+    libjami::unregisterSignalHandlers();
+}
+
 } // namespace test
 } // namespace jami
 
@@ -26,6 +26,9 @@
 #include "account_const.h"
 #include "fileutils.h"
 #include "manager.h"
+#include "jamidht/collaborative_editing.h"
+#include "jamidht/conversation.h"
+#include "jamidht/conversation_module.h"
 #include "jamidht/jamiaccount.h"
 
 extern "C" {
@@ -188,6 +191,8 @@ public:
     /// the fixture lock so it may call daemon APIs freely; predicates reading
     /// fields written by the signal handlers must lock @c mtx themselves.
     bool poll(std::function<bool()> pred, std::chrono::seconds timeout = 30s);
+    /// Wait until every member of @p docId declared @p format, as @p accountId sees it.
+    bool waitForFormat(const std::string& accountId, const std::string& docId, int format);
     /// Wait until a checkpoint of @p docId is visible in @p accountId's history.
     bool waitForCheckpoint(const std::string& accountId,
                            const std::string& convId,
@@ -202,6 +207,8 @@ private:
     void testPerDeviceOptIn();
     void testRenameAdminOnly();
     void testAttachmentReplication();
+    void testSnapshotCompaction();
+    void testFormatWaitsForEveryMember();
     void testRemoveDocumentEverywhere();
     void testRemoveDocumentLocallyAndReopen();
     void testDocumentBanRefusesClone();
@@ -210,6 +217,7 @@ private:
     void testContactRemovalDropsDocuments();
     void testReopenAfterParentRejoin();
     void testRealtimeUpdatePropagation();
+    void testRealtimeUpdateBatching();
     void testAwareness();
 
     CPPUNIT_TEST_SUITE(CollabTest);
@@ -220,6 +228,8 @@ private:
     CPPUNIT_TEST(testPerDeviceOptIn);
     CPPUNIT_TEST(testRenameAdminOnly);
     CPPUNIT_TEST(testAttachmentReplication);
+    CPPUNIT_TEST(testSnapshotCompaction);
+    CPPUNIT_TEST(testFormatWaitsForEveryMember);
     CPPUNIT_TEST(testRemoveDocumentEverywhere);
     CPPUNIT_TEST(testRemoveDocumentLocallyAndReopen);
     CPPUNIT_TEST(testDocumentBanRefusesClone);
@@ -228,6 +238,7 @@ private:
     CPPUNIT_TEST(testContactRemovalDropsDocuments);
     CPPUNIT_TEST(testReopenAfterParentRejoin);
     CPPUNIT_TEST(testRealtimeUpdatePropagation);
+    CPPUNIT_TEST(testRealtimeUpdateBatching);
     CPPUNIT_TEST(testAwareness);
     CPPUNIT_TEST_SUITE_END();
 };
@@ -465,6 +476,16 @@ CollabTest::waitForCheckpoint(const std::string& accountId,
                 30s);
 }
 
+bool
+CollabTest::waitForFormat(const std::string& accountId, const std::string& docId, int format)
+{
+    auto account = Manager::instance().getAccount<JamiAccount>(accountId);
+    return poll([&] {
+        auto conversation = account->convModule()->getConversation(docId);
+        return conversation && conversation->documentFormat() == format;
+    });
+}
+
 void
 CollabTest::testCreateDocument()
 {
@@ -707,6 +728,113 @@ CollabTest::testAttachmentReplication()
         poll([&] { return libjami::collaborativeAttachment(bobId, convId, docId, attachmentId) == payload; }));
 }
 
+void
+CollabTest::testSnapshotCompaction()
+{
+    std::cout << "\nRunning test: " << __func__ << std::endl;
+    connectSignals();
+
+    auto convId = createConversationWithBob();
+    auto docId = libjami::createCollaborativeDocument(aliceId, convId, "Notes", "text/plain");
+    ClientReplica aliceReplica;
+
+    // A batch reaching its cap (200 updates) is checkpointed at once, and every
+    // 20th checkpoint is followed by a snapshot.
+    size_t length = 0;
+    for (size_t checkpoint = 1; checkpoint <= 20; ++checkpoint) {
+        for (size_t i = 0; i < 200; ++i, ++length)
+            libjami::applyCollaborativeUpdate(aliceId, convId, docId, aliceReplica.insert(length, "a"));
+        CPPUNIT_ASSERT(waitForCheckpoint(aliceId, convId, docId, checkpoint));
+    }
+    auto snapshots = docRepoPath(aliceId, docId) / "snapshots";
+    CPPUNIT_ASSERT(
+        poll([&] { return std::filesystem::is_directory(snapshots) && !std::filesystem::is_empty(snapshots); }));
+
+    // Bob accepts the snapshot and rebuilds the document from it.
+    CPPUNIT_ASSERT(poll([&] { return !documentEntry(bobId, convId, docId).empty(); }));
+    ClientReplica bobReplica;
+    bobReplica.apply(libjami::openCollaborativeDocument(bobId, convId, docId));
+    CPPUNIT_ASSERT(poll(
+        [&] {
+            bobReplica.apply(libjami::collaborativeDocumentState(bobId, convId, docId));
+            return bobReplica.text() == aliceReplica.text();
+        },
+        60s));
+
+    // So does a past version, and asking again is answered the same.
+    auto history = libjami::getCollaborativeDocumentHistory(bobId, convId, docId, 1);
+    CPPUNIT_ASSERT(!history.empty());
+    auto state = libjami::collaborativeDocumentStateAt(bobId, convId, docId, history[0].at("id"));
+    ClientReplica past;
+    CPPUNIT_ASSERT(past.apply(state));
+    CPPUNIT_ASSERT_EQUAL(aliceReplica.text(), past.text());
+    CPPUNIT_ASSERT(state == libjami::collaborativeDocumentStateAt(bobId, convId, docId, history[0].at("id")));
+}
+
+void
+CollabTest::testFormatWaitsForEveryMember()
+{
+    std::cout << "\nRunning test: " << __func__ << std::endl;
+    connectSignals();
+
+    // Bob runs a version that reads neither snapshots nor batches in the tree
+    auto bobAccount = Manager::instance().getAccount<JamiAccount>(bobId);
+    bobAccount->collaborativeEditing()->setDeclaresFormat(false);
+
+    auto convId = createConversationWithBob();
+    auto docId = libjami::createCollaborativeDocument(aliceId, convId, "Notes", "text/plain");
+    CPPUNIT_ASSERT(poll([&] { return !documentEntry(bobId, convId, docId).empty(); }));
+    ClientReplica bobReplica;
+    bobReplica.apply(libjami::openCollaborativeDocument(bobId, convId, docId));
+    // Alice knows Bob's device once she merged his join
+    auto devices = docRepoPath(aliceId, docId) / "devices";
+    CPPUNIT_ASSERT(poll([&] {
+        std::error_code ec;
+        auto it = std::filesystem::directory_iterator(devices, ec);
+        return !ec && std::distance(it, std::filesystem::directory_iterator {}) == 2;
+    }));
+
+    ClientReplica aliceReplica;
+    size_t length = 0;
+    size_t checkpoint = 0;
+    auto addCheckpoint = [&] {
+        for (size_t i = 0; i < 200; ++i, ++length)
+            libjami::applyCollaborativeUpdate(aliceId, convId, docId, aliceReplica.insert(length, "a"));
+        return waitForCheckpoint(aliceId, convId, docId, ++checkpoint);
+    };
+    auto snapshots = docRepoPath(aliceId, docId) / "snapshots";
+    auto updates = docRepoPath(aliceId, docId) / "updates";
+    for (size_t i = 0; i < 21; ++i)
+        CPPUNIT_ASSERT(addCheckpoint());
+    CPPUNIT_ASSERT(!std::filesystem::exists(snapshots));
+    CPPUNIT_ASSERT(!std::filesystem::exists(updates));
+    auto history = libjami::getCollaborativeDocumentHistory(aliceId, convId, docId, 1);
+    CPPUNIT_ASSERT(!history.empty());
+    CPPUNIT_ASSERT_EQUAL("1"s, history[0].at("deltas"));
+
+    // Updated: Bob declares the format with his next synchronization, after
+    // which Alice snapshots the document and stores batches in the tree
+    bobAccount->collaborativeEditing()->setDeclaresFormat(true);
+    CPPUNIT_ASSERT(addCheckpoint());
+    CPPUNIT_ASSERT(waitForFormat(aliceId, docId, DocumentFormat::CURRENT));
+    CPPUNIT_ASSERT(addCheckpoint());
+    CPPUNIT_ASSERT(std::filesystem::is_directory(updates) && !std::filesystem::is_empty(updates));
+    CPPUNIT_ASSERT(poll(
+        [&] {
+            if (std::filesystem::is_directory(snapshots) && !std::filesystem::is_empty(snapshots))
+                return true;
+            addCheckpoint();
+            return false;
+        },
+        120s));
+    CPPUNIT_ASSERT(poll(
+        [&] {
+            bobReplica.apply(libjami::collaborativeDocumentState(bobId, convId, docId));
+            return bobReplica.text() == aliceReplica.text();
+        },
+        60s));
+}
+
 void
 CollabTest::testRemoveDocumentEverywhere()
 {
@@ -1056,6 +1184,56 @@ CollabTest::testRealtimeUpdatePropagation()
     CPPUNIT_ASSERT_EQUAL("live"s, bobReplica.text());
 }
 
+void
+CollabTest::testRealtimeUpdateBatching()
+{
+    std::cout << "\nRunning test: " << __func__ << std::endl;
+    connectSignals();
+
+    auto convId = createConversationWithBob();
+    auto docId = libjami::createCollaborativeDocument(aliceId, convId, "Notes", "text/plain");
+
+    ClientReplica aliceReplica;
+    aliceReplica.apply(libjami::openCollaborativeDocument(aliceId, convId, docId));
+    CPPUNIT_ASSERT(poll([&] { return !documentEntry(bobId, convId, docId).empty(); }));
+    ClientReplica bobReplica;
+    bobReplica.apply(libjami::openCollaborativeDocument(bobId, convId, docId));
+    CPPUNIT_ASSERT(poll([&] { return std::filesystem::is_directory(docRepoPath(bobId, docId)); }));
+    // Batches are only stored in the tree once Bob declared he reads them
+    CPPUNIT_ASSERT(waitForFormat(aliceId, docId, DocumentFormat::CURRENT));
+
+    std::this_thread::sleep_for(2s);
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        bobData.docUpdates.clear();
+    }
+    // A burst of keystrokes travels as a handful of merged frames.
+    const std::string typed(50, 'a');
+    for (size_t i = 0; i < typed.size(); ++i)
+        libjami::applyCollaborativeUpdate(aliceId, convId, docId, aliceReplica.insert(i, typed.substr(i, 1)));
+    size_t frames = 0;
+    CPPUNIT_ASSERT(poll(
+        [&] {
+            std::lock_guard<std::mutex> lock(mtx);
+            for (const auto& update : bobData.docUpdates[docId])
+                bobReplica.apply(update);
+            frames += bobData.docUpdates[docId].size();
+            bobData.docUpdates[docId].clear();
+            return bobReplica.text() == typed;
+        },
+        5s));
+    CPPUNIT_ASSERT(frames < typed.size());
+
+    // Closing checkpoints the burst as a single update, stored raw in the tree.
+    libjami::closeCollaborativeDocument(aliceId, convId, docId);
+    CPPUNIT_ASSERT(waitForCheckpoint(aliceId, convId, docId));
+    auto updates = docRepoPath(aliceId, docId) / "updates";
+    CPPUNIT_ASSERT(std::filesystem::is_directory(updates) && !std::filesystem::is_empty(updates));
+    auto history = libjami::getCollaborativeDocumentHistory(aliceId, convId, docId, 1);
+    CPPUNIT_ASSERT(!history.empty());
+    CPPUNIT_ASSERT_EQUAL("1"s, history[0].at("deltas"));
+}
+
 void
 CollabTest::testAwareness()
 {
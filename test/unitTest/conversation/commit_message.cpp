@@ -46,6 +46,8 @@ private:
     void testExampleMessages();
     // A default-constructed CommitMessage has the expected initial values
     void testDefaultValues();
+    // toMap() gives the same fields as toJson()
+    void testToMapMatchesToJson();
 
     CPPUNIT_TEST_SUITE(CommitMessageTest);
     CPPUNIT_TEST(testToStringFromStringRoundtrip);
@@ -53,6 +55,7 @@ private:
     CPPUNIT_TEST(testFromStringInvalidJson);
     CPPUNIT_TEST(testExampleMessages);
     CPPUNIT_TEST(testDefaultValues);
+    CPPUNIT_TEST(testToMapMatchesToJson);
     CPPUNIT_TEST_SUITE_END();
 };
 
@@ -65,7 +68,8 @@ messagesEqual(const CommitMessage& a, const CommitMessage& b)
            && a.editedId == b.editedId && a.action == b.action && a.uri == b.uri && a.device == b.device
            && a.confId == b.confId && a.to == b.to && a.reason == b.reason && a.duration == b.duration && a.tid == b.tid
            && a.displayName == b.displayName && a.totalSize == b.totalSize && a.sha3sum == b.sha3sum && a.mode == b.mode
-           && a.invited == b.invited && a.mimeType == b.mimeType && a.parent == b.parent;
+           && a.invited == b.invited && a.mimeType == b.mimeType && a.parent == b.parent && a.snapshot == b.snapshot
+           && a.update == b.update && a.format == b.format;
 }
 
 void
@@ -92,6 +96,9 @@ CommitMessageTest::testDefaultValues()
     CPPUNIT_ASSERT(msg.invited.empty());
     CPPUNIT_ASSERT(msg.mimeType.empty());
     CPPUNIT_ASSERT(msg.parent.empty());
+    CPPUNIT_ASSERT(msg.snapshot.empty());
+    CPPUNIT_ASSERT(msg.update.empty());
+    CPPUNIT_ASSERT_EQUAL(-1, msg.format);
 }
 
 void
@@ -221,6 +228,15 @@ CommitMessageTest::testToStringFromStringRoundtrip()
             update = randomBase64();
         assertRoundtrip(CommitMessage::checkpoint(updates));
 
+        // CommitMessage::snapshotCheckpoint(snapshotId)
+        assertRoundtrip(CommitMessage::snapshotCheckpoint(randomHex(40)));
+
+        // CommitMessage::updateCheckpoint(updateId)
+        assertRoundtrip(CommitMessage::updateCheckpoint(randomHex(40)));
+
+        // CommitMessage::formatCheckpoint(format)
+        assertRoundtrip(CommitMessage::formatCheckpoint(DocumentFormat::CURRENT));
+
         // CommitMessage::initial for one-to-one conversation
         assertRoundtrip(CommitMessage::initial(ConversationMode::ONE_TO_ONE, randomHex(40)));
 
@@ -265,6 +281,9 @@ CommitMessageTest::testFromStringToStringRoundtrip()
         R"({"edit":"8a3828b5d0450f69988d84baaf0ded8b4614cd14","type":"application/collab-doc+json"})",
         R"({"body":"AQHZAdIBBGh0bWwDBWlucHV0\nAQLaAYgBBnJlbW92ZQ==","type":"application/checkpoint"})",
         R"({"body":"","type":"application/checkpoint"})",
+        R"({"body":"","snapshot":"d670460b4b4aece5915caf5c68d12f560a9fe3e4","type":"application/checkpoint"})",
+        R"({"body":"","type":"application/checkpoint","update":"5b1f2ab0c3cb3bb6e4bc1ad3b7cf6cc0a5f1c0d9"})",
+        R"({"body":"","format":2,"type":"application/checkpoint"})",
         "Merge commit 'ad512a444a7dc7d608c7ea41c86715d06f40988c'",
         R"({"invited":"f32701048c59f9ad6a095c6d14650294b4cf30a4","mode":0,"type":"initial"})",
         R"({"mode":1,"type":"initial"})",
@@ -284,6 +303,34 @@ CommitMessageTest::testFromStringToStringRoundtrip()
     }
 }
 
+void
+CommitMessageTest::testToMapMatchesToJson()
+{
+    const std::vector<CommitMessage> messages = {
+        CommitMessage::text("Hello!", "c82443c9f8e4834b8e6a880185a857a4e5b5e5ad"),
+        CommitMessage::reaction("+1", "d015708ff060104912b5e02cb1e25b017246ecf9"),
+        CommitMessage::edit("", "8ac3b807ae657fb67e638393c27415976e80421f"),
+        CommitMessage::member(CommitAction::ADD, "1239121ca897ed518a61d7f3935add5d58b139bc"),
+        CommitMessage::outgoingCallEnd("ff114e1934db7b79e4f7ac676cb943d97ffb6a32", 80805, "declined"),
+        CommitMessage::fileSent("SomeFile.txt", "aa2a57c7", 4977122036805143, 6600),
+        CommitMessage::fileDeleted("00cae7e31da86e3524c1c34ede750f19cd78aa36"),
+        CommitMessage::initial(ConversationMode::ONE_TO_ONE, "f32701048c59f9ad6a095c6d14650294b4cf30a4"),
+        CommitMessage::initial(ConversationMode::PUBLIC),
+        CommitMessage::checkpoint({"AQHZAdIBBGh0bWwDBWlucHV0"}),
+        CommitMessage::snapshotCheckpoint("d670460b4b4aece5915caf5c68d12f560a9fe3e4"),
+        CommitMessage::updateCheckpoint("5b1f2ab0c3cb3bb6e4bc1ad3b7cf6cc0a5f1c0d9"),
+        CommitMessage::formatCheckpoint(DocumentFormat::SNAPSHOTS),
+        CommitMessage::updateProfile(),
+    };
+    for (const auto& msg : messages) {
+        auto json = msg.toJson();
+        std::map<std::string, std::string> expected;
+        for (const auto& key : json.getMemberNames())
+            expected.emplace(key, json[key].asString());
+        CPPUNIT_ASSERT(msg.toMap() == expected);
+    }
+}
+
 void
 CommitMessageTest::testFromStringInvalidJson()
 {
@@ -563,6 +610,38 @@ CommitMessageTest::testExampleMessages()
         CPPUNIT_ASSERT(msg.has_value());
         CPPUNIT_ASSERT_EQUAL(std::string(CommitType::CHECKPOINT), msg->type);
         CPPUNIT_ASSERT(msg->body.empty());
+        CPPUNIT_ASSERT(msg->snapshot.empty());
+    }
+
+    // Snapshot (the merged state enters the tree, named in the "snapshot" field)
+    {
+        auto msg = CommitMessage::fromString(
+            R"({"body":"","snapshot":"d670460b4b4aece5915caf5c68d12f560a9fe3e4","type":"application/checkpoint"})");
+        CPPUNIT_ASSERT(msg.has_value());
+        CPPUNIT_ASSERT_EQUAL(std::string(CommitType::CHECKPOINT), msg->type);
+        CPPUNIT_ASSERT(msg->body.empty());
+        CPPUNIT_ASSERT_EQUAL(std::string("d670460b4b4aece5915caf5c68d12f560a9fe3e4"), msg->snapshot);
+    }
+
+    // Batch of updates merged into one (stored in the tree, named in the "update" field)
+    {
+        auto msg = CommitMessage::fromString(
+            R"({"body":"","type":"application/checkpoint","update":"5b1f2ab0c3cb3bb6e4bc1ad3b7cf6cc0a5f1c0d9"})");
+        CPPUNIT_ASSERT(msg.has_value());
+        CPPUNIT_ASSERT_EQUAL(std::string(CommitType::CHECKPOINT), msg->type);
+        CPPUNIT_ASSERT(msg->body.empty());
+        CPPUNIT_ASSERT(msg->snapshot.empty());
+        CPPUNIT_ASSERT_EQUAL(std::string("5b1f2ab0c3cb3bb6e4bc1ad3b7cf6cc0a5f1c0d9"), msg->update);
+    }
+
+    // Document format declared by a device (nothing else in the commit)
+    {
+        auto msg = CommitMessage::fromString(R"({"body":"","format":2,"type":"application/checkpoint"})");
+        CPPUNIT_ASSERT(msg.has_value());
+        CPPUNIT_ASSERT_EQUAL(std::string(CommitType::CHECKPOINT), msg->type);
+        CPPUNIT_ASSERT(msg->body.empty());
+        CPPUNIT_ASSERT(msg->update.empty());
+        CPPUNIT_ASSERT_EQUAL(DocumentFormat::SNAPSHOTS, msg->format);
     }
 
     // --- Initial commits ---
@@ -22,9 +22,13 @@
 #include "../../test_runner.h"
 
 #include "jamidht/conversation.h"
+#include "jamidht/conversation_module.h"
+#include "jamidht/journal_store.h"
 
 #include <msgpack.hpp>
 
+#include <filesystem>
+#include <fstream>
 #include <string>
 
 namespace jami {
@@ -77,6 +81,15 @@ private:
     void testRequestMsgpackRoundtrip();
     // Client-facing map keeps exposing seconds
     void testRequestToMapStaysSeconds();
+    // convInfo is stored as a journal, files of previous versions are still read
+    void testConvInfoJournal();
+    void testConvInfoLegacyFile();
+    // Only the changed entries are appended, a torn record is dropped
+    void testJournalAppendOnly();
+    void testJournalTornTail();
+    void testJournalDamagedRecord();
+    // Staged changes are written together, by the first sync
+    void testJournalStagedChanges();
     // isRemoved() distinguishes events within the same second
     void testIsRemovedMsResolution();
 
@@ -90,6 +103,12 @@ private:
     CPPUNIT_TEST(testRequestMsgpackRoundtrip);
     CPPUNIT_TEST(testRequestToMapStaysSeconds);
     CPPUNIT_TEST(testIsRemovedMsResolution);
+    CPPUNIT_TEST(testConvInfoJournal);
+    CPPUNIT_TEST(testConvInfoLegacyFile);
+    CPPUNIT_TEST(testJournalAppendOnly);
+    CPPUNIT_TEST(testJournalTornTail);
+    CPPUNIT_TEST(testJournalDamagedRecord);
+    CPPUNIT_TEST(testJournalStagedChanges);
     CPPUNIT_TEST_SUITE_END();
 };
 
@@ -265,6 +284,170 @@ ConvInfoSerializationTest::testIsRemovedMsResolution()
     CPPUNIT_ASSERT(!info.isRemoved());
 }
 
+static std::filesystem::path
+journalTestDir()
+{
+    auto dir = std::filesystem::temp_directory_path() / "jami_journal_unittest";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    return dir;
+}
+
+void
+ConvInfoSerializationTest::testConvInfoJournal()
+{
+    auto dir = journalTestDir();
+    std::map<std::string, ConvInfo> infos;
+    ConvInfo info(std::string("conv1"));
+    info.created = timePointFromMilliseconds(1700000001500);
+    info.members = {"alice", "bob"};
+    infos.emplace(info.id, info);
+    infos.emplace("conv2", ConvInfo(std::string("conv2")));
+
+    ConversationModule::saveConvInfosToPath(dir, infos);
+    CPPUNIT_ASSERT(JournalStore::isJournal(dir / "convInfo.journal"));
+    CPPUNIT_ASSERT(!std::filesystem::exists(dir / "convInfo"));
+    auto loaded = ConversationModule::convInfosFromPath(dir);
+    CPPUNIT_ASSERT_EQUAL(size_t(2), loaded.size());
+    CPPUNIT_ASSERT(loaded.at("conv1").created == info.created);
+    CPPUNIT_ASSERT(loaded.at("conv1").members == info.members);
+    std::filesystem::remove_all(dir);
+}
+
+void
+ConvInfoSerializationTest::testConvInfoLegacyFile()
+{
+    auto dir = journalTestDir();
+    std::map<std::string, ConvInfo> infos;
+    ConvInfo info(std::string("conv1"));
+    info.created = timePointFromMilliseconds(1700000001500);
+    infos.emplace(info.id, info);
+    {
+        std::ofstream file(dir / "convInfo", std::ios::trunc | std::ios::binary);
+        msgpack::pack(file, infos);
+    }
+    CPPUNIT_ASSERT(!JournalStore::isJournal(dir / "convInfo"));
+    auto loaded = ConversationModule::convInfosFromPath(dir);
+    CPPUNIT_ASSERT_EQUAL(size_t(1), loaded.size());
+    CPPUNIT_ASSERT(loaded.at("conv1").created == info.created);
+    std::filesystem::remove_all(dir);
+}
+
+void
+ConvInfoSerializationTest::testJournalAppendOnly()
+{
+    auto path = journalTestDir() / "journal";
+    {
+        JournalStore store(path);
+        store.assign({{"a", "1"}, {"b", "2"}});
+        auto size = store.fileSize();
+        // Unchanged entries are not written again
+        store.assign({{"a", "1"}, {"b", "2"}});
+        CPPUNIT_ASSERT_EQUAL(size, store.fileSize());
+        store.assign({{"a", "1"}, {"b", "3"}, {"c", "4"}});
+        store.erase("a");
+        store.update({{"c", std::nullopt}, {"d", "5"}, {"e", std::nullopt}});
+        CPPUNIT_ASSERT(store.fileSize() > size);
+        CPPUNIT_ASSERT_EQUAL(std::filesystem::file_size(path), static_cast<uintmax_t>(store.fileSize()));
+    }
+    std::map<std::string, std::string> expected {{"b", "3"}, {"d", "5"}};
+    CPPUNIT_ASSERT(JournalStore::read(path) == expected);
+
+    JournalStore store(path);
+    CPPUNIT_ASSERT(store.values() == expected);
+    auto size = store.fileSize();
+    store.compact();
+    CPPUNIT_ASSERT(store.fileSize() < size);
+    CPPUNIT_ASSERT(JournalStore::read(path) == expected);
+    std::filesystem::remove_all(path.parent_path());
+}
+
+void
+ConvInfoSerializationTest::testJournalTornTail()
+{
+    auto path = journalTestDir() / "journal";
+    size_t size = 0;
+    {
+        JournalStore store(path);
+        store.put("a", "1");
+        size = store.fileSize();
+        store.put("b", std::string(100, 'x'));
+    }
+    // Simulate a crash in the middle of the last record
+    std::filesystem::resize_file(path, size + 20);
+    std::map<std::string, std::string> expected {{"a", "1"}};
+    CPPUNIT_ASSERT(JournalStore::read(path) == expected);
+
+    JournalStore store(path);
+    CPPUNIT_ASSERT(store.values() == expected);
+    CPPUNIT_ASSERT_EQUAL(size, store.fileSize());
+    CPPUNIT_ASSERT_EQUAL(static_cast<uintmax_t>(size), std::filesystem::file_size(path));
+    store.put("c", "2");
+    CPPUNIT_ASSERT(JournalStore::read(path).count("c") == 1);
+    std::filesystem::remove_all(path.parent_path());
+}
+
+void
+ConvInfoSerializationTest::testJournalDamagedRecord()
+{
+    auto path = journalTestDir() / "journal";
+    size_t size = 0;
+    {
+        JournalStore store(path);
+        store.put("a", "1");
+        size = store.fileSize();
+        store.put("b", std::string(100, 'x'));
+        store.put("c", "2");
+    }
+    // Damage the value of the record in the middle
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(static_cast<std::streamoff>(size + 50));
+        file.put('y');
+    }
+    // The records after it are kept
+    std::map<std::string, std::string> expected {{"a", "1"}, {"c", "2"}};
+    CPPUNIT_ASSERT(JournalStore::read(path) == expected);
+
+    JournalStore store(path);
+    CPPUNIT_ASSERT(store.values() == expected);
+    CPPUNIT_ASSERT_EQUAL(std::filesystem::file_size(path), static_cast<uintmax_t>(store.fileSize()));
+    store.put("d", "3");
+    expected.emplace("d", "3");
+    CPPUNIT_ASSERT(JournalStore::read(path) == expected);
+    std::filesystem::remove_all(path.parent_path());
+}
+
+void
+ConvInfoSerializationTest::testJournalStagedChanges()
+{
+    auto path = journalTestDir() / "journal";
+    JournalStore store(path);
+    auto size = store.fileSize();
+    CPPUNIT_ASSERT_EQUAL(uint64_t(0), store.stage({{"a", std::nullopt}}));
+    auto first = store.stage({{"a", "1"}});
+    auto second = store.stage({{"b", "2"}, {"c", std::nullopt}});
+    CPPUNIT_ASSERT(first != 0 && second > first);
+    // Applied, not written yet
+    CPPUNIT_ASSERT(store.get("b") == "2");
+    CPPUNIT_ASSERT_EQUAL(size, store.fileSize());
+
+    store.sync(first);
+    std::map<std::string, std::string> expected {{"a", "1"}, {"b", "2"}};
+    CPPUNIT_ASSERT(JournalStore::read(path) == expected);
+    size = store.fileSize();
+    store.sync(second);
+    CPPUNIT_ASSERT_EQUAL(size, store.fileSize());
+
+    auto compacted = 0;
+    store.onCompacted([&] { ++compacted; });
+    store.compact();
+    store.compact();
+    CPPUNIT_ASSERT_EQUAL(1, compacted);
+    CPPUNIT_ASSERT(JournalStore::read(path) == expected);
+    std::filesystem::remove_all(path.parent_path());
+}
+
 } // namespace test
 } // namespace jami
 
@@ -158,6 +158,8 @@ private:
     void testLoadPartiallyRemovedConversation();
     void testReactionsOnEditedMessage();
     void testUpdateProfileMultiDevice();
+    void testLazyLoadConversation();
+    void testAnnounceBurstOfMessages();
 
     CPPUNIT_TEST_SUITE(ConversationTest);
     CPPUNIT_TEST(testCreateConversation);
@@ -210,6 +212,8 @@ private:
     CPPUNIT_TEST(testLoadPartiallyRemovedConversation);
     CPPUNIT_TEST(testReactionsOnEditedMessage);
     CPPUNIT_TEST(testUpdateProfileMultiDevice);
+    CPPUNIT_TEST(testLazyLoadConversation);
+    CPPUNIT_TEST(testAnnounceBurstOfMessages);
     CPPUNIT_TEST_SUITE_END();
 };
 
@@ -2309,6 +2313,86 @@ ConversationTest::testUpdateProfileMultiDevice()
     CPPUNIT_ASSERT(cv.wait_for(lk, 30s, [&]() { return bobMsgSize + 1 == bobData.messages.size(); }));
 }
 
+void
+ConversationTest::testLazyLoadConversation()
+{
+    std::cout << "\nRunning test: " << __func__ << std::endl;
+    connectSignals();
+
+    auto aliceAccount = Manager::instance().getAccount<JamiAccount>(aliceId);
+    aliceAccount->convModule()->onManifestSaved([&] { cv.notify_one(); });
+    auto convId = libjami::startConversation(aliceId);
+    CPPUNIT_ASSERT(cv.wait_for(lk, 30s, [&]() { return !aliceData.conversationId.empty(); }));
+    libjami::updateConversationInfos(aliceId, convId, {{"title", "Lazy"}});
+    libjami::sendMessage(aliceId, convId, "hi"s, "");
+    CPPUNIT_ASSERT(cv.wait_for(lk, 30s, [&]() { return aliceData.messages.size() == 2; }));
+    auto lastMessageId = aliceData.messages.back().id;
+    // The manifest is updated once the message is announced
+    CPPUNIT_ASSERT(cv.wait_for(lk, 30s, [&]() {
+        return libjami::conversationSummary(aliceId, convId)["lastMessageId"] == lastMessageId;
+    }));
+    auto members = libjami::getConversationMembers(aliceId, convId);
+
+    // Summarized conversations are not opened at startup
+    aliceAccount->convModule()->loadConversations();
+    aliceAccount->convModule()->onManifestSaved({});
+    CPPUNIT_ASSERT(!aliceAccount->convModule()->isConversationLoaded(convId));
+    CPPUNIT_ASSERT(libjami::conversationSummary(aliceId, convId)["lastMessageId"] == lastMessageId);
+    CPPUNIT_ASSERT(libjami::getConversations(aliceId).size() == 1);
+    // Nor to be listed
+    CPPUNIT_ASSERT(libjami::conversationInfos(aliceId, convId)["title"] == "Lazy");
+    auto unloadedMembers = libjami::getConversationMembers(aliceId, convId);
+    CPPUNIT_ASSERT(unloadedMembers.size() == members.size());
+    for (size_t i = 0; i < members.size(); ++i) {
+        CPPUNIT_ASSERT(unloadedMembers[i]["uri"] == members[i]["uri"]);
+        CPPUNIT_ASSERT(unloadedMembers[i]["role"] == members[i]["role"]);
+    }
+    CPPUNIT_ASSERT(!aliceAccount->convModule()->isConversationLoaded(convId));
+
+    // But on first use
+    CPPUNIT_ASSERT(aliceAccount->convModule()->getConversation(convId));
+    CPPUNIT_ASSERT(aliceAccount->convModule()->isConversationLoaded(convId));
+    libjami::sendMessage(aliceId, convId, "hello"s, "");
+    CPPUNIT_ASSERT(cv.wait_for(lk, 30s, [&]() { return aliceData.messages.size() == 3; }));
+}
+
+void
+ConversationTest::testAnnounceBurstOfMessages()
+{
+    std::cout << "\nRunning test: " << __func__ << std::endl;
+    connectSignals();
+
+    auto bobAccount = Manager::instance().getAccount<JamiAccount>(bobId);
+    auto bobUri = bobAccount->getUsername();
+
+    auto convId = libjami::startConversation(aliceId);
+    libjami::addConversationMember(aliceId, convId, bobUri);
+    CPPUNIT_ASSERT(cv.wait_for(lk, 30s, [&]() { return bobData.requestReceived; }));
+    libjami::acceptConversationRequest(bobId, convId);
+    CPPUNIT_ASSERT(cv.wait_for(lk, 30s, [&]() { return !bobData.conversationId.empty(); }));
+    CPPUNIT_ASSERT(cv.wait_for(lk, 30s, [&]() { return aliceData.messages.size() == 2; }));
+
+    // Announcements of a burst are coalesced, the last one brings every message
+    auto aliceAccount = Manager::instance().getAccount<JamiAccount>(aliceId);
+    std::mutex announcementsMtx;
+    std::map<std::string, size_t> announcements;
+    aliceAccount->convModule()->onAnnouncementSent([&](const std::string& target, const std::string& conversationId) {
+        std::lock_guard lk {announcementsMtx};
+        if (conversationId == convId)
+            announcements[target]++;
+    });
+    auto bobMsgSize = bobData.messages.size();
+    for (auto i = 0; i < 10; ++i)
+        libjami::sendMessage(aliceId, convId, fmt::format("message {}", i), "");
+    CPPUNIT_ASSERT(cv.wait_for(lk, 60s, [&]() { return bobData.messages.size() == bobMsgSize + 10; }));
+    CPPUNIT_ASSERT(bobData.messages.back().body["body"] == "message 9");
+    aliceAccount->convModule()->onAnnouncementSent({});
+    std::lock_guard alk {announcementsMtx};
+    CPPUNIT_ASSERT(!announcements.empty());
+    for (const auto& [target, count] : announcements)
+        CPPUNIT_ASSERT(count < 10);
+}
+
 } // namespace test
 } // namespace jami
 
@@ -0,0 +1,329 @@
+/*
+ *  Copyright (C) 2004-2026 Savoir-faire Linux Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <string>
+
+#include "../../test_runner.h"
+#include "account_const.h"
+#include "base64.h"
+#include "common.h"
+#include "conversation/conversationcommon.h"
+#include "fileutils.h"
+#include "jami.h"
+#include "jamidht/conversationrepository.h"
+#include "jamidht/jamiaccount.h"
+#include "manager.h"
+
+using namespace std::string_literals;
+using namespace std::literals::chrono_literals;
+using namespace libjami::Account;
+
+namespace jami {
+namespace test {
+
+struct UserData
+{
+    std::string conversationId;
+    bool requestReceived {false};
+    bool bobJoined {false};
+    std::vector<std::string> messages;
+    std::vector<int> errors;
+};
+
+/**
+ * Clones of long histories from a trusted device: only the newest commits are
+ * fetched, and the older ones when they are loaded.
+ */
+class ConversationShallowTest : public CppUnit::TestFixture
+{
+public:
+    ~ConversationShallowTest() { libjami::fini(); }
+    static std::string name() { return "ConversationShallow"; }
+    void setUp();
+    void tearDown();
+
+    std::string aliceId;
+    UserData aliceData;
+    std::string bobId;
+    UserData bobData;
+
+    std::mutex mtx;
+    std::condition_variable cv;
+
+    template<typename Rep, typename Period, typename Predicate>
+    bool waitFor(const std::chrono::duration<Rep, Period>& timeout, Predicate&& predicate)
+    {
+        std::unique_lock lk {mtx};
+        return cv.wait_for(lk, timeout, std::forward<Predicate>(predicate));
+    }
+
+    void connectSignals();
+    // Commit messages until the history is count commits longer
+    void addMessages(const std::string& convId, unsigned count);
+    std::string inviteBob(const std::string& convId);
+    // Load the whole history of Bob, which backfills it
+    void loadBobHistory(const std::string& convId);
+
+private:
+    void testShallowCloneIsUsable();
+    void testForgedShallowRoot();
+    void testBackfillNotReachingInitialCommit();
+
+    CPPUNIT_TEST_SUITE(ConversationShallowTest);
+    CPPUNIT_TEST(testShallowCloneIsUsable);
+    CPPUNIT_TEST(testForgedShallowRoot);
+    CPPUNIT_TEST(testBackfillNotReachingInitialCommit);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION(ConversationShallowTest, ConversationShallowTest::name());
+
+void
+ConversationShallowTest::setUp()
+{
+    libjami::init(libjami::InitFlag(libjami::LIBJAMI_FLAG_DEBUG | libjami::LIBJAMI_FLAG_CONSOLE_LOG));
+    if (not Manager::instance().initialized)
+        CPPUNIT_ASSERT(libjami::start("jami-sample.yml"));
+
+    auto actors = load_actors("actors/alice-bob.yml");
+    aliceId = actors["alice"];
+    bobId = actors["bob"];
+
+    aliceData = {};
+    bobData = {};
+
+    wait_for_announcement_of({aliceId, bobId});
+}
+
+void
+ConversationShallowTest::tearDown()
+{
+    wait_for_removal_of({aliceId, bobId});
+}
+
+void
+ConversationShallowTest::connectSignals()
+{
+    std::map<std::string, std::shared_ptr<libjami::CallbackWrapperBase>> confHandlers;
+    confHandlers.insert(libjami::exportable_callback<libjami::ConversationSignal::ConversationReady>(
+        [&](const std::string& accountId, const std::string& conversationId) {
+            std::lock_guard guard {mtx};
+            if (accountId == aliceId)
+                aliceData.conversationId = conversationId;
+            else if (accountId == bobId)
+                bobData.conversationId = conversationId;
+            cv.notify_one();
+        }));
+    confHandlers.insert(libjami::exportable_callback<libjami::ConversationSignal::ConversationRequestReceived>(
+        [&](const std::string& accountId, const std::string&, std::map<std::string, std::string>) {
+            std::lock_guard guard {mtx};
+            if (accountId == bobId)
+                bobData.requestReceived = true;
+            cv.notify_one();
+        }));
+    confHandlers.insert(libjami::exportable_callback<libjami::ConversationSignal::ConversationMemberEvent>(
+        [&](const std::string& accountId, const std::string&, const std::string& uri, int event) {
+            std::lock_guard guard {mtx};
+            auto bobAccount = Manager::instance().getAccount<JamiAccount>(bobId);
+            if (accountId == aliceId && bobAccount && uri == bobAccount->getUsername() && event == 1)
+                aliceData.bobJoined = true;
+            cv.notify_one();
+        }));
+    confHandlers.insert(libjami::exportable_callback<libjami::ConversationSignal::SwarmMessageReceived>(
+        [&](const std::string& accountId, const std::string&, libjami::SwarmMessage message) {
+            std::lock_guard guard {mtx};
+            if (accountId == aliceId && message.type == "text/plain")
+                aliceData.messages.emplace_back(message.body["body"]);
+            cv.notify_one();
+        }));
+    confHandlers.insert(libjami::exportable_callback<libjami::ConversationSignal::OnConversationError>(
+        [&](const std::string& accountId, const std::string&, int code, const std::string&) {
+            std::lock_guard guard {mtx};
+            if (accountId == aliceId)
+                aliceData.errors.emplace_back(code);
+            else if (accountId == bobId)
+                bobData.errors.emplace_back(code);
+            cv.notify_one();
+        }));
+    libjami::registerSignalHandlers(confHandlers);
+}
+
+void
+ConversationShallowTest::addMessages(const std::string& convId, unsigned count)
+{
+    auto aliceAccount = Manager::instance().getAccount<JamiAccount>(aliceId);
+    ConversationRepository::DISABLE_RESET = true;
+    ConversationRepository repository(aliceAccount, convId);
+    for (unsigned i = 0; i < count; ++i)
+        CPPUNIT_ASSERT(!repository.commitMessage(CommitMessage::text(fmt::format("message {}", i)).toString()).empty());
+}
+
+std::string
+ConversationShallowTest::inviteBob(const std::string& convId)
+{
+    auto bobUri = Manager::instance().getAccount<JamiAccount>(bobId)->getUsername();
+    libjami::addConversationMember(aliceId, convId, bobUri);
+    CPPUNIT_ASSERT(waitFor(30s, [&] { return bobData.requestReceived; }));
+    libjami::acceptConversationRequest(bobId, convId);
+    return bobUri;
+}
+
+void
+ConversationShallowTest::loadBobHistory(const std::string& convId)
+{
+    libjami::loadConversation(bobId, convId, "", 0);
+}
+
+/**
+ * Signed commit without any parent, with the tree of HEAD, which main is
+ * moved to
+ */
+static std::string
+orphanCommit(const std::shared_ptr<JamiAccount>& account, const std::string& convId, const std::string& msg)
+{
+    auto repoPath = fileutils::get_data_dir() / account->getAccountID() / "conversations" / convId;
+    git_repository* repo_ptr = nullptr;
+    CPPUNIT_ASSERT(git_repository_open(&repo_ptr, repoPath.c_str()) == 0);
+    GitRepository repo {repo_ptr};
+
+    git_object* head_ptr = nullptr;
+    CPPUNIT_ASSERT(git_revparse_single(&head_ptr, repo.get(), "HEAD^{tree}") == 0);
+    GitObject headTree {head_ptr};
+    git_tree* tree = reinterpret_cast<git_tree*>(headTree.get());
+
+    auto deviceId = std::string(account->currentDeviceId());
+    git_signature* sig_ptr = nullptr;
+    CPPUNIT_ASSERT(git_signature_new(&sig_ptr, deviceId.c_str(), deviceId.c_str(), std::time(nullptr), 0) == 0);
+    GitSignature sig {sig_ptr};
+
+    git_buf to_sign = {};
+    CPPUNIT_ASSERT(
+        git_commit_create_buffer(&to_sign, repo.get(), sig.get(), sig.get(), nullptr, msg.c_str(), tree, 0, nullptr)
+        == 0);
+    auto signed_buf = account->identity().first->sign(std::vector<uint8_t>(to_sign.ptr, to_sign.ptr + to_sign.size));
+    git_oid commit_id;
+    CPPUNIT_ASSERT(git_commit_create_with_signature(&commit_id,
+                                                    repo.get(),
+                                                    to_sign.ptr,
+                                                    base64::encode(signed_buf).c_str(),
+                                                    "signature")
+                   == 0);
+    git_buf_dispose(&to_sign);
+
+    git_reference* ref_ptr = nullptr;
+    CPPUNIT_ASSERT(git_reference_create(&ref_ptr, repo.get(), "refs/heads/main", &commit_id, true, nullptr) == 0);
+    git_reference_free(ref_ptr);
+    return git_oid_tostr_s(&commit_id);
+}
+
+void
+ConversationShallowTest::testShallowCloneIsUsable()
+{
+    std::cout << "\nRunning test: " << __func__ << std::endl;
+    connectSignals();
+
+    auto convId = libjami::startConversation(aliceId);
+    CPPUNIT_ASSERT(waitFor(30s, [&] { return aliceData.conversationId == convId; }));
+    // Longer than a clone fetches
+    addMessages(convId, ConversationRepository::SHALLOW_CLONE_DEPTH + 100);
+    inviteBob(convId);
+
+    // Alice invited Bob: he joins and writes from the history she sent
+    CPPUNIT_ASSERT(waitFor(60s, [&] { return aliceData.bobJoined; }));
+    auto bobRepoPath = fileutils::get_data_dir() / bobId / "conversations" / convId;
+    CPPUNIT_ASSERT(!ConversationRepository::shallowRoots(bobRepoPath).empty());
+    libjami::sendMessage(bobId, convId, "shallow"s, "");
+    CPPUNIT_ASSERT(waitFor(30s, [&] {
+        return std::find(aliceData.messages.begin(), aliceData.messages.end(), "shallow") != aliceData.messages.end();
+    }));
+
+    // The older history is fetched once it is loaded
+    loadBobHistory(convId);
+    CPPUNIT_ASSERT(waitFor(60s, [&] { return ConversationRepository::shallowRoots(bobRepoPath).empty(); }));
+    CPPUNIT_ASSERT(bobData.errors.empty());
+}
+
+void
+ConversationShallowTest::testForgedShallowRoot()
+{
+    std::cout << "\nRunning test: " << __func__ << std::endl;
+    connectSignals();
+
+    auto aliceAccount = Manager::instance().getAccount<JamiAccount>(aliceId);
+    auto convId = libjami::startConversation(aliceId);
+    CPPUNIT_ASSERT(waitFor(30s, [&] { return aliceData.conversationId == convId; }));
+    // A message that also adds a file: invalid, but signed by a member, which
+    // is all that is checked of the oldest commit of a shallow clone
+    addFile(aliceAccount, convId, "BADFILE");
+    commit(aliceAccount, convId, CommitMessage::text("forged"));
+    // It is the oldest of the commits a clone fetches, with the invitation
+    addMessages(convId, ConversationRepository::SHALLOW_CLONE_DEPTH - 2);
+    inviteBob(convId);
+    CPPUNIT_ASSERT(waitFor(60s, [&] { return aliceData.bobJoined; }));
+    auto bobRepoPath = fileutils::get_data_dir() / bobId / "conversations" / convId;
+    auto roots = ConversationRepository::shallowRoots(bobRepoPath);
+    CPPUNIT_ASSERT(!roots.empty());
+
+    // Bob finds it out once he has the parent: the older history is not
+    // added, what he has is kept
+    loadBobHistory(convId);
+    CPPUNIT_ASSERT(waitFor(60s, [&] {
+        return std::find(bobData.errors.begin(), bobData.errors.end(), EVALIDFETCH) != bobData.errors.end();
+    }));
+    CPPUNIT_ASSERT(ConversationRepository::shallowRoots(bobRepoPath) == roots);
+    CPPUNIT_ASSERT(libjami::getConversations(bobId).size() == 1);
+}
+
+void
+ConversationShallowTest::testBackfillNotReachingInitialCommit()
+{
+    std::cout << "\nRunning test: " << __func__ << std::endl;
+    connectSignals();
+
+    auto aliceAccount = Manager::instance().getAccount<JamiAccount>(aliceId);
+    auto convId = libjami::startConversation(aliceId);
+    CPPUNIT_ASSERT(waitFor(30s, [&] { return aliceData.conversationId == convId; }));
+    // The history served starts with another commit than the conversation:
+    // the initial commit is still sent, but nothing leads to it
+    ConversationRepository::DISABLE_RESET = true;
+    auto orphan = orphanCommit(aliceAccount, convId, "orphan");
+    CPPUNIT_ASSERT(!orphan.empty() && orphan != convId);
+    addMessages(convId, ConversationRepository::SHALLOW_CLONE_DEPTH - 1);
+    inviteBob(convId);
+    CPPUNIT_ASSERT(waitFor(60s, [&] { return aliceData.bobJoined; }));
+    auto bobRepoPath = fileutils::get_data_dir() / bobId / "conversations" / convId;
+    auto roots = ConversationRepository::shallowRoots(bobRepoPath);
+    CPPUNIT_ASSERT(!roots.empty());
+
+    loadBobHistory(convId);
+    CPPUNIT_ASSERT(waitFor(60s, [&] {
+        return std::find(bobData.errors.begin(), bobData.errors.end(), EVALIDFETCH) != bobData.errors.end();
+    }));
+    CPPUNIT_ASSERT(ConversationRepository::shallowRoots(bobRepoPath) == roots);
+}
+
+} // namespace test
+} // namespace jami
+
+JAMI_TEST_RUNNER(jami::test::ConversationShallowTest::name())
@@ -20,12 +20,16 @@
 #include <cppunit/extensions/HelperMacros.h>
 
 #include <dhtnet/channel_socket.h>
+#include <fmt/format.h>
 
 #include <chrono>
 #include <condition_variable>
 #include <filesystem>
+#include <fstream>
+#include <future>
 #include <git2.h>
 #include <mutex>
+#include <thread>
 #include <string>
 #include <vector>
 
@@ -98,9 +102,14 @@ public:
     }
     void onRecv(std::vector<uint8_t>&& pkt) override
     {
-        std::lock_guard lk(mutex_);
-        if (recvCb_)
-            recvCb_(pkt.data(), pkt.size());
+        // Called unlocked, as the server writes its answer from the callback
+        RecvCb cb;
+        {
+            std::lock_guard lk(mutex_);
+            cb = recvCb_;
+        }
+        if (cb)
+            cb(pkt.data(), pkt.size());
     }
     uint64_t txBytes() const override { return 0; }
     uint64_t rxBytes() const override { return 0; }
@@ -108,6 +117,14 @@ public:
 
     bool isShutdown() const { return isShutdown_; }
 
+    void receive(std::string_view data) { onRecv(std::vector<uint8_t>(data.begin(), data.end())); }
+
+    std::string written() const
+    {
+        std::lock_guard lk(mutex_);
+        return std::string(written_.begin(), written_.end());
+    }
+
     /** Block until the socket is shut down, or the timeout expires. */
     bool waitForShutdown(std::chrono::milliseconds timeout)
     {
@@ -145,11 +162,26 @@ private:
     void testStopShutsDownChannel();
     void testDestructorShutsDownChannel();
     void testStopIsIdempotent();
+    void testPackCacheSharesBuild();
+    void testPackCacheEviction();
+    void testPackCachePublishBeforeSending();
+    void testShallowFetch();
+    void testDeepenShallowPeer();
+    void testShallowServer();
+
+    /** Commit count empty commits on HEAD, from the oldest to the newest */
+    std::vector<std::string> makeHistory(size_t count);
 
     CPPUNIT_TEST_SUITE(GitServerTest);
     CPPUNIT_TEST(testStopShutsDownChannel);
     CPPUNIT_TEST(testDestructorShutsDownChannel);
     CPPUNIT_TEST(testStopIsIdempotent);
+    CPPUNIT_TEST(testPackCacheSharesBuild);
+    CPPUNIT_TEST(testPackCacheEviction);
+    CPPUNIT_TEST(testPackCachePublishBeforeSending);
+    CPPUNIT_TEST(testShallowFetch);
+    CPPUNIT_TEST(testDeepenShallowPeer);
+    CPPUNIT_TEST(testShallowServer);
     CPPUNIT_TEST_SUITE_END();
 
     // GitServer derives the repository path from the account and conversation
@@ -182,6 +214,55 @@ GitServerTest::tearDown()
     git_libgit2_shutdown();
 }
 
+static std::string
+pktLine(std::string_view data)
+{
+    return fmt::format("{:04x}{}", data.size() + 4, data);
+}
+
+std::vector<std::string>
+GitServerTest::makeHistory(size_t count)
+{
+    git_repository* repo = nullptr;
+    CPPUNIT_ASSERT_EQUAL(0, git_repository_open(&repo, repoPath_.string().c_str()));
+    git_treebuilder* builder = nullptr;
+    git_oid treeId;
+    CPPUNIT_ASSERT_EQUAL(0, git_treebuilder_new(&builder, repo, nullptr));
+    CPPUNIT_ASSERT_EQUAL(0, git_treebuilder_write(&treeId, builder));
+    git_treebuilder_free(builder);
+    git_tree* tree = nullptr;
+    CPPUNIT_ASSERT_EQUAL(0, git_tree_lookup(&tree, repo, &treeId));
+    git_signature* sig = nullptr;
+    CPPUNIT_ASSERT_EQUAL(0, git_signature_now(&sig, "test", "test@jami.net"));
+
+    std::vector<std::string> ids;
+    git_commit* parent = nullptr;
+    for (size_t i = 0; i < count; ++i) {
+        const git_commit* parents[] = {parent};
+        git_oid id;
+        auto message = fmt::format("commit {}", i);
+        CPPUNIT_ASSERT_EQUAL(0,
+                             git_commit_create(&id,
+                                               repo,
+                                               "HEAD",
+                                               sig,
+                                               sig,
+                                               nullptr,
+                                               message.c_str(),
+                                               tree,
+                                               parent ? 1 : 0,
+                                               parents));
+        git_commit_free(parent);
+        CPPUNIT_ASSERT_EQUAL(0, git_commit_lookup(&parent, repo, &id));
+        ids.emplace_back(git_oid_tostr_s(&id));
+    }
+    git_commit_free(parent);
+    git_signature_free(sig);
+    git_tree_free(tree);
+    git_repository_free(repo);
+    return ids;
+}
+
 void
 GitServerTest::testStopShutsDownChannel()
 {
@@ -222,6 +303,177 @@ GitServerTest::testStopIsIdempotent()
     CPPUNIT_ASSERT(socket->waitForShutdown(10s));
 }
 
+void
+GitServerTest::testPackCacheSharesBuild()
+{
+    GitPackCache cache;
+    GitPackCache::Key key {repoPath_.string(), "want", {"have"}};
+    std::atomic_int builds {0};
+    auto build = [&] {
+        ++builds;
+        std::this_thread::sleep_for(100ms);
+        return std::make_shared<const std::string>("PACK");
+    };
+
+    // Concurrent identical requests wait for a single build
+    std::vector<GitPackCache::Pack> packs(8);
+    std::vector<std::thread> threads;
+    for (auto& pack : packs)
+        threads.emplace_back([&] { pack = cache.get(key, build); });
+    for (auto& thread : threads)
+        thread.join();
+    CPPUNIT_ASSERT_EQUAL(1, builds.load());
+    for (const auto& pack : packs)
+        CPPUNIT_ASSERT(pack and pack == packs.front());
+
+    // Another have set is another pack
+    key.haves = {"other"};
+    cache.get(key, build);
+    CPPUNIT_ASSERT_EQUAL(2, builds.load());
+    CPPUNIT_ASSERT_EQUAL(std::size_t(2), cache.count());
+
+    // Packs that are not to be shared are not kept
+    key.want = "big";
+    CPPUNIT_ASSERT(not cache.get(key, [] { return GitPackCache::Pack {}; }));
+    CPPUNIT_ASSERT_EQUAL(std::size_t(2), cache.count());
+}
+
+void
+GitServerTest::testPackCacheEviction()
+{
+    GitPackCache cache(10);
+    auto pack = [](char c) {
+        return [c] { return std::make_shared<const std::string>(4, c); };
+    };
+    cache.get({"repo", "a", {}}, pack('a'));
+    cache.get({"repo", "b", {}}, pack('b'));
+    // Refresh a, b is now the least recently used
+    cache.get({"repo", "a", {}}, pack('x'));
+    cache.get({"repo", "c", {}}, pack('c'));
+    CPPUNIT_ASSERT_EQUAL(std::size_t(8), cache.size());
+    CPPUNIT_ASSERT_EQUAL(std::string(4, 'a'), *cache.get({"repo", "a", {}}, pack('x')));
+    CPPUNIT_ASSERT_EQUAL(std::string(4, 'x'), *cache.get({"repo", "b", {}}, pack('x')));
+
+    // Too big to be kept at all
+    cache.get({"repo", "d", {}}, [] { return std::make_shared<const std::string>(20, 'd'); });
+    CPPUNIT_ASSERT_EQUAL(std::string(4, 'y'), *cache.get({"repo", "d", {}}, pack('y')));
+
+    cache.clear();
+    CPPUNIT_ASSERT_EQUAL(std::size_t(0), cache.size());
+    CPPUNIT_ASSERT_EQUAL(std::size_t(0), cache.count());
+}
+
+void
+GitServerTest::testPackCachePublishBeforeSending()
+{
+    GitPackCache cache;
+    GitPackCache::Key key {repoPath_.string(), "want", {}};
+    std::promise<void> building, sent;
+    std::thread builder([&] {
+        cache.get(key, [&](const GitPackCache::Publish& publish) {
+            auto pack = std::make_shared<const std::string>("PACK");
+            publish(pack);
+            building.set_value();
+            // Sending to a slow peer
+            sent.get_future().wait();
+            return pack;
+        });
+    });
+    building.get_future().wait();
+
+    // Concurrent requests do not wait for the pack to be sent
+    auto pack = cache.get(key, [] { return GitPackCache::Pack {}; });
+    CPPUNIT_ASSERT(pack and *pack == "PACK");
+    CPPUNIT_ASSERT_EQUAL(std::size_t(4), cache.size());
+
+    // Nor for a pack too big to be shared, they build their own
+    key.want = "big";
+    std::promise<void> released, streamed;
+    std::thread streamer([&] {
+        cache.get(key, [&](const GitPackCache::Publish& publish) {
+            publish(nullptr);
+            released.set_value();
+            streamed.get_future().wait();
+            return GitPackCache::Pack {};
+        });
+    });
+    released.get_future().wait();
+    auto own = false;
+    cache.get(key, [&] {
+        own = true;
+        return GitPackCache::Pack {};
+    });
+    CPPUNIT_ASSERT(own);
+
+    sent.set_value();
+    streamed.set_value();
+    builder.join();
+    streamer.join();
+    CPPUNIT_ASSERT_EQUAL(std::size_t(1), cache.count());
+}
+
+void
+GitServerTest::testShallowFetch()
+{
+    auto commits = makeHistory(4);
+    auto socket = std::make_shared<FakeChannelSocket>();
+    auto gitServer = std::make_unique<GitServer>(accountId_, conversationId_, socket);
+
+    socket->receive(pktLine("want " + commits[3] + "\n") + pktLine("deepen 2\n") + "0000");
+    // The peer's history is cut below the second newest commit
+    auto update = socket->written();
+    CPPUNIT_ASSERT_EQUAL(pktLine("shallow " + commits[2] + "\n") + "0000", update);
+
+    socket->receive(pktLine("done\n"));
+    auto pack = socket->written().substr(update.size());
+    CPPUNIT_ASSERT(pack.starts_with("0008NAK\n"));
+    CPPUNIT_ASSERT(pack.find("PACK") != std::string::npos);
+    CPPUNIT_ASSERT(!socket->isShutdown());
+}
+
+void
+GitServerTest::testDeepenShallowPeer()
+{
+    auto commits = makeHistory(4);
+    auto socket = std::make_shared<FakeChannelSocket>();
+    auto gitServer = std::make_unique<GitServer>(accountId_, conversationId_, socket);
+
+    // A peer that has the two newest commits asks for the whole history
+    socket->receive(pktLine("want " + commits[3] + "\n") + pktLine("shallow " + commits[2] + "\n")
+                    + pktLine("deepen 10\n") + "0000");
+    auto update = socket->written();
+    CPPUNIT_ASSERT_EQUAL(pktLine("unshallow " + commits[2] + "\n") + "0000", update);
+
+    socket->receive(pktLine("have " + commits[3] + "\n") + "0000" + pktLine("done\n"));
+    CPPUNIT_ASSERT(socket->written().find("PACK") != std::string::npos);
+}
+
+void
+GitServerTest::testShallowServer()
+{
+    auto commits = makeHistory(4);
+    // Only the two newest commits are complete here
+    std::ofstream(repoPath_ / ".git" / "shallow") << commits[2] << "\n";
+
+    // A peer asking for a shallow history gets what is here
+    auto socket = std::make_shared<FakeChannelSocket>();
+    auto gitServer = std::make_unique<GitServer>(accountId_, conversationId_, socket);
+    socket->receive(pktLine("want " + commits[3] + "\n") + pktLine("deepen 1\n") + "0000");
+    auto update = socket->written();
+    CPPUNIT_ASSERT_EQUAL(pktLine("shallow " + commits[3] + "\n") + "0000", update);
+    socket->receive(pktLine("done\n"));
+    CPPUNIT_ASSERT(socket->written().find("PACK") != std::string::npos);
+    CPPUNIT_ASSERT(!socket->isShutdown());
+
+    // A peer without shallow support asks for everything: sending what is
+    // here would give it a history it is unable to validate
+    auto fullSocket = std::make_shared<FakeChannelSocket>();
+    auto fullServer = std::make_unique<GitServer>(accountId_, conversationId_, fullSocket);
+    fullSocket->receive(pktLine("want " + commits[3] + "\n") + "0000" + pktLine("done\n"));
+    CPPUNIT_ASSERT(fullSocket->waitForShutdown(10s));
+    CPPUNIT_ASSERT(fullSocket->written().find("PACK") == std::string::npos);
+}
+
 } // namespace test
 } // namespace jami
 
@@ -20,6 +20,7 @@
 #include <cppunit/extensions/HelperMacros.h>
 
 #include <dhtnet/channel_socket.h>
+#include <fmt/format.h>
 
 #include <atomic>
 #include <cstring>
@@ -135,6 +136,8 @@ private:
     void testReadFailsWhenTheChannelIsClosed();
     void testReadReturnsZeroOnAnIdleChannel();
     void testReadFailsWhenTheCommandCannotBeSent();
+    void testWriteStripsDeepenForOldServers();
+    void testWriteKeepsDeepenForDeepeningServers();
 
     CPPUNIT_TEST_SUITE(GitTransportTest);
     CPPUNIT_TEST(testSendCmdWritesTheRequest);
@@ -143,6 +146,8 @@ private:
     CPPUNIT_TEST(testReadFailsWhenTheChannelIsClosed);
     CPPUNIT_TEST(testReadReturnsZeroOnAnIdleChannel);
     CPPUNIT_TEST(testReadFailsWhenTheCommandCannotBeSent);
+    CPPUNIT_TEST(testWriteStripsDeepenForOldServers);
+    CPPUNIT_TEST(testWriteKeepsDeepenForDeepeningServers);
     CPPUNIT_TEST_SUITE_END();
 
     std::shared_ptr<FakeChannelSocket> socket_;
@@ -243,6 +248,66 @@ GitTransportTest::testReadFailsWhenTheCommandCannotBeSent()
     CPPUNIT_ASSERT_EQUAL(size_t(0), read);
 }
 
+static std::string
+pktLine(std::string_view data)
+{
+    return fmt::format("{:04x}{}", data.size() + 4, data);
+}
+
+// Reference advertisement of a server with these capabilities
+static std::string
+advertisement(std::string_view capabilities)
+{
+    auto head = std::string(40, 'a') + " HEAD";
+    head += '\0';
+    head += capabilities;
+    head += '\n';
+    return pktLine(head) + "0000";
+}
+
+void
+GitTransportTest::testWriteStripsDeepenForOldServers()
+{
+    // A server predating shallow clones
+    socket_->queue(advertisement("side-band side-band-64k shallow no-progress include-tag"));
+    char buffer[256];
+    size_t read = 0;
+    CPPUNIT_ASSERT_EQUAL(0, P2PStreamRead(&stream_.base, buffer, sizeof(buffer), &read));
+    CPPUNIT_ASSERT(stream_.capabilitiesParsed);
+    CPPUNIT_ASSERT(!stream_.serverDeepens);
+
+    auto sent = socket_->written().size();
+    auto want = pktLine("want " + std::string(40, 'a') + "\n");
+    auto request = want + pktLine("deepen 500\n") + "0000";
+    CPPUNIT_ASSERT_EQUAL(0, P2PStreamWrite(&stream_.base, request.data(), request.size()));
+    auto written = socket_->written();
+    // It would never answer a deepen: the whole history is asked for
+    CPPUNIT_ASSERT_EQUAL(want + "0000", std::string(written.begin() + sent, written.end()));
+
+    // And the shallow update it does not send is answered locally, empty
+    read = 0;
+    CPPUNIT_ASSERT_EQUAL(0, P2PStreamRead(&stream_.base, buffer, sizeof(buffer), &read));
+    CPPUNIT_ASSERT_EQUAL(std::string("0000"), std::string(buffer, read));
+    CPPUNIT_ASSERT(!stream_.pendingShallowFlush);
+}
+
+void
+GitTransportTest::testWriteKeepsDeepenForDeepeningServers()
+{
+    socket_->queue(advertisement(fmt::format("side-band side-band-64k shallow no-progress {}", DEEPEN_CAPABILITY)));
+    char buffer[256];
+    size_t read = 0;
+    CPPUNIT_ASSERT_EQUAL(0, P2PStreamRead(&stream_.base, buffer, sizeof(buffer), &read));
+    CPPUNIT_ASSERT(stream_.serverDeepens);
+
+    auto sent = socket_->written().size();
+    auto request = pktLine("want " + std::string(40, 'a') + "\n") + pktLine("deepen 500\n") + "0000";
+    CPPUNIT_ASSERT_EQUAL(0, P2PStreamWrite(&stream_.base, request.data(), request.size()));
+    auto written = socket_->written();
+    CPPUNIT_ASSERT_EQUAL(request, std::string(written.begin() + sent, written.end()));
+    CPPUNIT_ASSERT(!stream_.pendingShallowFlush);
+}
+
 } // namespace test
 } // namespace jami
 
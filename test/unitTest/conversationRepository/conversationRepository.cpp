@@ -21,6 +21,8 @@
 #include "jamidht/conversation_module.h"
 #include "jamidht/conversationrepository.h"
 #include "jamidht/gitserver.h"
+#include "jamidht/git_maintenance.h"
+#include "jamidht/message_search_index.h"
 #include "jamidht/jamiaccount.h"
 #include "../../test_runner.h"
 #include "jami.h"
@@ -38,11 +40,14 @@
 #include <cppunit/TestFixture.h>
 #include <cppunit/extensions/HelperMacros.h>
 
+#include <chrono>
 #include <condition_variable>
+#include <iostream>
 #include <string>
 #include <fstream>
 #include <streambuf>
 #include <filesystem>
+#include <regex>
 #include <thread>
 
 using namespace std::string_literals;
@@ -96,12 +101,24 @@ private:
     void testCheckpointWithInvalidFileRejected();
     void testNonContentAddressedAttachmentRejected();
     void testCheckpointDeletingDeviceCertRejected();
+    void testDocumentSnapshots();
+    void testSnapshotRemovedByCheckpointRejected();
+    void testDocumentUpdates();
+    void testUnnamedUpdateRejected();
     void testAttachmentInConversationRejected();
     void testMessageInDocumentRejected();
+    void testCommitIndexPaging();
+    void testSearchIndex();
+    void testParallelCommitValidation();
+    void testLogBenchmark();
+    void testRepositoryMaintenance();
+    void testShallowHistoryIsUsable();
+    // signer: account whose key signs the commit, account if null
     std::string addCommit(git_repository* repo,
                           const std::shared_ptr<JamiAccount> account,
                           const std::string& branch,
-                          const std::string& commit_msg);
+                          const std::string& commit_msg,
+                          const std::shared_ptr<JamiAccount>& signer = {});
     std::string addMergeCommit(git_repository* repo,
                                const std::shared_ptr<JamiAccount> account,
                                const std::string& wanted_ref);
@@ -130,8 +147,18 @@ private:
     CPPUNIT_TEST(testCheckpointWithInvalidFileRejected);
     CPPUNIT_TEST(testNonContentAddressedAttachmentRejected);
     CPPUNIT_TEST(testCheckpointDeletingDeviceCertRejected);
+    CPPUNIT_TEST(testDocumentSnapshots);
+    CPPUNIT_TEST(testSnapshotRemovedByCheckpointRejected);
+    CPPUNIT_TEST(testDocumentUpdates);
+    CPPUNIT_TEST(testUnnamedUpdateRejected);
     CPPUNIT_TEST(testAttachmentInConversationRejected);
     CPPUNIT_TEST(testMessageInDocumentRejected);
+    CPPUNIT_TEST(testCommitIndexPaging);
+    CPPUNIT_TEST(testSearchIndex);
+    CPPUNIT_TEST(testParallelCommitValidation);
+    CPPUNIT_TEST(testLogBenchmark);
+    CPPUNIT_TEST(testRepositoryMaintenance);
+    CPPUNIT_TEST(testShallowHistoryIsUsable);
     CPPUNIT_TEST_SUITE_END();
 };
 
@@ -233,13 +260,22 @@ ConversationRepositoryTest::testAddSomeMessages()
     CPPUNIT_ASSERT(messages[2].author.name == messages[3].author.name);
     CPPUNIT_ASSERT(messages[2].author.email == messages[3].author.email);
     CPPUNIT_ASSERT(messages[2].parents.front() == repository->id());
-    // Check sig
-    CPPUNIT_ASSERT(aliceAccount->identity().second->getPublicKey().checkSignature(messages[0].signed_content,
-                                                                                  messages[0].signature));
-    CPPUNIT_ASSERT(aliceAccount->identity().second->getPublicKey().checkSignature(messages[1].signed_content,
-                                                                                  messages[1].signature));
-    CPPUNIT_ASSERT(aliceAccount->identity().second->getPublicKey().checkSignature(messages[2].signed_content,
-                                                                                  messages[2].signature));
+    // Check sig, only extracted by the validation
+    git_repository* repo;
+    auto repoPath = fileutils::get_data_dir() / aliceAccount->getAccountID() / "conversations" / repository->id();
+    CPPUNIT_ASSERT(git_repository_open(&repo, repoPath.c_str()) == 0);
+    for (size_t i = 0; i < 3; ++i) {
+        git_oid oid;
+        CPPUNIT_ASSERT(git_oid_fromstr(&oid, messages[i].id.c_str()) == 0);
+        git_buf signature = {}, signedData = {};
+        CPPUNIT_ASSERT(git_commit_extract_signature(&signature, &signedData, repo, &oid, "signature") == 0);
+        CPPUNIT_ASSERT(aliceAccount->identity().second->getPublicKey().checkSignature(
+            std::vector<uint8_t>(signedData.ptr, signedData.ptr + signedData.size),
+            base64::decode(std::string_view(signature.ptr, signature.size))));
+        git_buf_dispose(&signature);
+        git_buf_dispose(&signedData);
+    }
+    git_repository_free(repo);
 }
 
 void
@@ -275,7 +311,8 @@ std::string
 ConversationRepositoryTest::addCommit(git_repository* repo,
                                       const std::shared_ptr<JamiAccount> account,
                                       const std::string& branch,
-                                      const std::string& commit_msg)
+                                      const std::string& commit_msg,
+                                      const std::shared_ptr<JamiAccount>& signer)
 {
     auto deviceId = DeviceId(std::string(account->currentDeviceId()));
     auto name = account->getDisplayName();
@@ -341,7 +378,7 @@ ConversationRepositoryTest::addCommit(git_repository* repo,
 
     // git commit -S
     auto to_sign_vec = std::vector<uint8_t>(to_sign.ptr, to_sign.ptr + to_sign.size);
-    auto signed_buf = account->identity().first->sign(to_sign_vec);
+    auto signed_buf = (signer ? signer : account)->identity().first->sign(to_sign_vec);
     std::string signed_str = base64::encode(signed_buf);
     if (git_commit_create_with_signature(&commit_id, repo, to_sign.ptr, signed_str.c_str(), "signature") < 0) {
         JAMI_ERROR("Unable to sign commit");
@@ -1493,6 +1530,166 @@ ConversationRepositoryTest::testCheckpointDeletingDeviceCertRejected()
     CPPUNIT_ASSERT(cv.wait_for(lk, 30s, [&] { return isInvalid; }));
 }
 
+void
+ConversationRepositoryTest::testDocumentSnapshots()
+{
+    auto aliceAccount = Manager::instance().getAccount<JamiAccount>(aliceId);
+    auto repository = ConversationRepository::createDocument(aliceAccount, "some-conversation-id", "text/html");
+    CPPUNIT_ASSERT(repository != nullptr);
+    auto repoPath = fileutils::get_data_dir() / aliceAccount->getAccountID() / "conversations" / repository->id();
+
+    CPPUNIT_ASSERT(!repository->commitMessage(CommitMessage::checkpoint({"dXBkYXRlMQ=="}).toString()).empty());
+
+    // Only on top of the commit the state was built at
+    std::vector<uint8_t> first {0x01, 0x02, 0x03};
+    auto staleHead = repository->getHead();
+    CPPUNIT_ASSERT(!repository->commitMessage(CommitMessage::checkpoint({"dXBkYXRlMg=="}).toString()).empty());
+    CPPUNIT_ASSERT(repository->addSnapshot(first, staleHead).empty());
+
+    auto firstCommit = repository->addSnapshot(first, repository->getHead());
+    CPPUNIT_ASSERT(!firstCommit.empty());
+    auto firstId = repository->getCommit(firstCommit)->commitMsg.snapshot;
+    CPPUNIT_ASSERT(std::filesystem::is_regular_file(repoPath / "snapshots" / firstId));
+    CPPUNIT_ASSERT(repository->blob(firstId) == first);
+
+    // The same state twice is not a new snapshot
+    CPPUNIT_ASSERT(repository->addSnapshot(first, repository->getHead()).empty());
+
+    // A later snapshot drops the first from the tree, which stays readable
+    auto checkpointId = repository->commitMessage(CommitMessage::checkpoint({"dXBkYXRlMw=="}).toString());
+    std::vector<uint8_t> second {0x04, 0x05, 0x06};
+    auto secondCommit = repository->addSnapshot(second, repository->getHead());
+    CPPUNIT_ASSERT(!secondCommit.empty());
+    auto secondId = repository->getCommit(secondCommit)->commitMsg.snapshot;
+    CPPUNIT_ASSERT(!std::filesystem::exists(repoPath / "snapshots" / firstId));
+    CPPUNIT_ASSERT(std::filesystem::is_regular_file(repoPath / "snapshots" / secondId));
+    CPPUNIT_ASSERT(repository->blob(firstId) == first);
+    CPPUNIT_ASSERT(repository->blob(secondId) == second);
+
+    // What a rebuild from the first snapshot walks
+    std::vector<std::string> since;
+    repository->logSince(firstCommit, [&](auto&& commit) { since.emplace_back(commit.id); });
+    CPPUNIT_ASSERT((since == std::vector<std::string> {checkpointId, secondCommit}));
+    since.clear();
+    repository->logSince(firstCommit, [&](auto&& commit) { since.emplace_back(commit.id); }, checkpointId);
+    CPPUNIT_ASSERT((since == std::vector<std::string> {checkpointId}));
+
+    CPPUNIT_ASSERT(repository->validCommits(repository->log()));
+}
+
+// Only a snapshot may drop the snapshots it supersedes: a plain checkpoint
+// removing one must be rejected.
+void
+ConversationRepositoryTest::testSnapshotRemovedByCheckpointRejected()
+{
+    std::map<std::string, std::shared_ptr<libjami::CallbackWrapperBase>> confHandlers;
+    bool isInvalid = false;
+    confHandlers.insert(libjami::exportable_callback<libjami::ConversationSignal::OnConversationError>(
+        [&](const std::string&, const std::string&, int code, const std::string&) {
+            if (code == EVALIDFETCH)
+                isInvalid = true;
+            cv.notify_one();
+        }));
+    libjami::registerSignalHandlers(confHandlers);
+
+    auto aliceAccount = Manager::instance().getAccount<JamiAccount>(aliceId);
+    auto repository = ConversationRepository::createDocument(aliceAccount, "some-conversation-id", "text/html");
+    CPPUNIT_ASSERT(repository != nullptr);
+    auto repoPath = fileutils::get_data_dir() / aliceAccount->getAccountID() / "conversations" / repository->id();
+
+    auto snapshotCommit = repository->addSnapshot({0x01, 0x02, 0x03}, repository->getHead());
+    CPPUNIT_ASSERT(!snapshotCommit.empty());
+    auto snapshotFile = "snapshots/" + repository->getCommit(snapshotCommit)->commitMsg.snapshot;
+
+    git_repository* repo;
+    CPPUNIT_ASSERT(git_repository_open(&repo, repoPath.c_str()) == 0);
+    std::filesystem::remove(repoPath / snapshotFile);
+    git_index* index_ptr = nullptr;
+    CPPUNIT_ASSERT(git_repository_index(&index_ptr, repo) == 0);
+    GitIndex index {index_ptr};
+    CPPUNIT_ASSERT(git_index_remove_bypath(index.get(), snapshotFile.c_str()) == 0);
+    CPPUNIT_ASSERT(git_index_write(index.get()) == 0);
+
+    auto commitId = addCommit(repo, aliceAccount, "main", CommitMessage::checkpoint({"dXBkYXRlMQ=="}).toString());
+    git_repository_free(repo);
+    CPPUNIT_ASSERT(!commitId.empty());
+
+    CPPUNIT_ASSERT(!repository->validCommits(repository->log()));
+    CPPUNIT_ASSERT(cv.wait_for(lk, 30s, [&] { return isInvalid; }));
+}
+
+void
+ConversationRepositoryTest::testDocumentUpdates()
+{
+    auto aliceAccount = Manager::instance().getAccount<JamiAccount>(aliceId);
+    auto repository = ConversationRepository::createDocument(aliceAccount, "some-conversation-id", "text/html");
+    CPPUNIT_ASSERT(repository != nullptr);
+    auto repoPath = fileutils::get_data_dir() / aliceAccount->getAccountID() / "conversations" / repository->id();
+
+    // Stored raw, named after its content and in the commit message
+    std::vector<uint8_t> first {0x01, 0x02, 0x03};
+    auto firstId = repository->addUpdate(first);
+    CPPUNIT_ASSERT(!firstId.empty());
+    auto firstCommit = repository->getHead();
+    CPPUNIT_ASSERT_EQUAL(firstId, repository->getCommit(firstCommit)->commitMsg.update);
+    CPPUNIT_ASSERT(repository->getCommit(firstCommit)->commitMsg.body.empty());
+    CPPUNIT_ASSERT(std::filesystem::is_regular_file(repoPath / "updates" / firstId));
+    CPPUNIT_ASSERT(repository->blob(firstId) == first);
+
+    // The same batch twice is stored once
+    CPPUNIT_ASSERT_EQUAL(firstId, repository->addUpdate(first));
+    CPPUNIT_ASSERT_EQUAL(firstCommit, repository->getHead());
+
+    // The next batch replaces it in the tree, and it stays readable
+    std::vector<uint8_t> second {0x04, 0x05, 0x06};
+    auto secondId = repository->addUpdate(second);
+    CPPUNIT_ASSERT(!secondId.empty());
+    CPPUNIT_ASSERT(!std::filesystem::exists(repoPath / "updates" / firstId));
+    CPPUNIT_ASSERT(std::filesystem::is_regular_file(repoPath / "updates" / secondId));
+    CPPUNIT_ASSERT(repository->blob(firstId) == first);
+    CPPUNIT_ASSERT(repository->blob(secondId) == second);
+
+    // Alongside checkpoints written the way older versions did
+    CPPUNIT_ASSERT(!repository->commitMessage(CommitMessage::checkpoint({"dXBkYXRlMQ=="}).toString()).empty());
+    CPPUNIT_ASSERT(repository->validCommits(repository->log()));
+}
+
+// A batch enters the tree only with the checkpoint that names it: a plain
+// checkpoint adding one must be rejected.
+void
+ConversationRepositoryTest::testUnnamedUpdateRejected()
+{
+    std::map<std::string, std::shared_ptr<libjami::CallbackWrapperBase>> confHandlers;
+    bool isInvalid = false;
+    confHandlers.insert(libjami::exportable_callback<libjami::ConversationSignal::OnConversationError>(
+        [&](const std::string&, const std::string&, int code, const std::string&) {
+            if (code == EVALIDFETCH)
+                isInvalid = true;
+            cv.notify_one();
+        }));
+    libjami::registerSignalHandlers(confHandlers);
+
+    auto aliceAccount = Manager::instance().getAccount<JamiAccount>(aliceId);
+    auto repository = ConversationRepository::createDocument(aliceAccount, "some-conversation-id", "text/html");
+    CPPUNIT_ASSERT(repository != nullptr);
+    auto repoPath = fileutils::get_data_dir() / aliceAccount->getAccountID() / "conversations" / repository->id();
+
+    git_repository* repo;
+    CPPUNIT_ASSERT(git_repository_open(&repo, repoPath.c_str()) == 0);
+
+    std::filesystem::create_directories(repoPath / "updates");
+    std::ofstream file(repoPath / "updates" / "0000000000000000000000000000000000000000");
+    file << "an update nothing names";
+    file.close();
+    addAll(repo);
+    auto commitId = addCommit(repo, aliceAccount, "main", CommitMessage::checkpoint({}).toString());
+    git_repository_free(repo);
+    CPPUNIT_ASSERT(!commitId.empty());
+
+    CPPUNIT_ASSERT(!repository->validCommits(repository->log()));
+    CPPUNIT_ASSERT(cv.wait_for(lk, 30s, [&] { return isInvalid; }));
+}
+
 // Attachments only exist in document repositories: in a conversation,
 // addAttachment() must refuse rather than write a checkpoint commit its own
 // validator then rejects.
@@ -1537,6 +1734,326 @@ ConversationRepositoryTest::testMessageInDocumentRejected()
     CPPUNIT_ASSERT(cv.wait_for(lk, 30s, [&] { return isInvalid; }));
 }
 
+void
+ConversationRepositoryTest::testCommitIndexPaging()
+{
+    auto aliceAccount = Manager::instance().getAccount<JamiAccount>(aliceId);
+    auto repository = ConversationRepository::createConversation(aliceAccount);
+    for (int i = 0; i < 20; ++i)
+        repository->commitMessage(fmt::format(R"({{"body":"Commit {}","type":"text/plain"}})", i));
+
+    auto checkPaging = [&] {
+        auto all = repository->log();
+        // Pages seeked from the index must match the full walk
+        for (size_t i = 0; i < all.size(); i += 3) {
+            LogOptions options;
+            options.from = all[i].id;
+            options.nbOfCommits = 5;
+            auto page = repository->log(options);
+            CPPUNIT_ASSERT(page.size() == std::min<size_t>(5, all.size() - i));
+            for (size_t j = 0; j < page.size(); ++j) {
+                CPPUNIT_ASSERT(page[j].id == all[i + j].id);
+                if (j + 1 < page.size())
+                    CPPUNIT_ASSERT(page[j].linearized_parent == all[i + j].linearized_parent);
+            }
+        }
+        for (size_t i = 0; i + 1 < all.size(); ++i)
+            CPPUNIT_ASSERT(repository->linearizedParent(all[i].id) == all[i + 1].id);
+        CPPUNIT_ASSERT(not repository->linearizedParent(all.back().id));
+        return all.size();
+    };
+    CPPUNIT_ASSERT(checkPaging() == 21);
+
+    // Appended on new commits
+    repository->commitMessage(R"({"body":"Commit 20","type":"text/plain"})");
+    CPPUNIT_ASSERT(checkPaging() == 22);
+
+    // Rebuilt after a merge
+    auto repoPath = fileutils::get_data_dir() / aliceAccount->getAccountID() / "conversations" / repository->id();
+    git_repository* repo;
+    CPPUNIT_ASSERT(git_repository_open(&repo, repoPath.c_str()) == 0);
+    git_reference* ref = nullptr;
+    git_commit* commit = nullptr;
+    git_oid commit_id;
+    git_oid_fromstr(&commit_id, repository->id().c_str());
+    git_commit_lookup(&commit, repo, &commit_id);
+    git_branch_create(&ref, repo, "to_merge", commit, false);
+    git_reference_free(ref);
+    git_commit_free(commit);
+    git_repository_set_head(repo, "refs/heads/to_merge");
+    auto id = addCommit(repo, aliceAccount, "to_merge", R"({"body":"Branch","type":"text/plain"})");
+    git_repository_free(repo);
+    repository->merge(id);
+    CPPUNIT_ASSERT(checkPaging() == 24);
+
+    // Corrupted index files are rebuilt
+    auto indexPath = fileutils::get_data_dir() / aliceAccount->getAccountID() / "conversation_data"
+                     / repository->id() / "commit_index";
+    CPPUNIT_ASSERT(std::filesystem::is_regular_file(indexPath));
+    {
+        std::ofstream file(indexPath, std::ios::binary | std::ios::app);
+        file << "\x92";
+    }
+    repository = std::make_unique<ConversationRepository>(aliceAccount, repository->id());
+    CPPUNIT_ASSERT(checkPaging() == 24);
+}
+
+
+void
+ConversationRepositoryTest::testSearchIndex()
+{
+    auto aliceAccount = Manager::instance().getAccount<JamiAccount>(aliceId);
+    auto aliceUri = aliceAccount->getUsername();
+    auto repository = ConversationRepository::createConversation(aliceAccount);
+    auto first = repository->commitMessage(R"({"body":"Hello World","type":"text/plain"})");
+    repository->commitMessage(R"({"body":"hello again","type":"text/plain"})");
+    repository->commitMessage(R"({"displayName":"holidays.png","tid":"1","type":"application/data-transfer+json"})");
+    repository->commitMessage(fmt::format(R"({{"body":"👍","react-to":"{}","type":"text/plain"}})", first));
+
+    auto indexPath = fileutils::get_data_dir() / aliceAccount->getAccountID() / "conversation_data"
+                     / repository->id() / "searchIndex";
+    MessageSearchIndex index(indexPath);
+    auto sync = [&] {
+        auto head = repository->logSince(index.head(), [&](ConversationCommit&& commit) { index.add(commit); });
+        CPPUNIT_ASSERT(head);
+        CPPUNIT_ASSERT(index.flush(*head));
+    };
+    auto search = [&](const std::string& regex, bool caseSensitive = false) {
+        Filter filter;
+        filter.regexSearch = regex;
+        filter.caseSensitive = caseSensitive;
+        return index.search(filter);
+    };
+    CPPUNIT_ASSERT(not index.load());
+    sync();
+
+    CPPUNIT_ASSERT(search("hello").size() == 2);
+    CPPUNIT_ASSERT(search("Hello", true).size() == 1);
+    CPPUNIT_ASSERT(search("ell").size() == 2);
+    CPPUNIT_ASSERT(search("hello world").size() == 1);
+    CPPUNIT_ASSERT(search("holidays").size() == 1);
+    CPPUNIT_ASSERT(search("^h.*n$").size() == 1);
+    // Reactions are not messages
+    CPPUNIT_ASSERT(search("👍").empty());
+    // Newest first
+    auto hits = search("");
+    CPPUNIT_ASSERT(hits.size() == 3);
+    CPPUNIT_ASSERT(hits.back().id == first);
+
+    Filter filter;
+    filter.type = "initial";
+    CPPUNIT_ASSERT(index.search(filter).size() == 1);
+    filter.type = "";
+    filter.author = aliceUri;
+    filter.maxResult = 2;
+    CPPUNIT_ASSERT(index.search(filter).size() == 2);
+    filter.author = "00";
+    CPPUNIT_ASSERT(index.search(filter).empty());
+
+    // Edits replace the text, new commits are indexed incrementally
+    repository->commitMessage(fmt::format(R"({{"body":"Goodbye","edit":"{}","type":"text/plain"}})", first));
+    sync();
+    CPPUNIT_ASSERT(search("world").empty());
+    hits = search("goodbye");
+    CPPUNIT_ASSERT(hits.size() == 1);
+    CPPUNIT_ASSERT(hits.front().id == first);
+    CPPUNIT_ASSERT(hits.front().text == "Goodbye");
+
+    // Replayed from the journal
+    MessageSearchIndex reloaded(indexPath);
+    CPPUNIT_ASSERT(reloaded.load());
+    CPPUNIT_ASSERT(reloaded.head() == index.head());
+    CPPUNIT_ASSERT(reloaded.size() == index.size());
+    Filter goodbye;
+    goodbye.regexSearch = "goodbye";
+    CPPUNIT_ASSERT(reloaded.search(goodbye).size() == 1);
+
+    // Invalid patterns are reported
+    CPPUNIT_ASSERT_THROW(search("(unbalanced"), std::regex_error);
+}
+
+
+void
+ConversationRepositoryTest::testParallelCommitValidation()
+{
+    std::map<std::string, std::shared_ptr<libjami::CallbackWrapperBase>> confHandlers;
+    bool errorDetected = false;
+    confHandlers.insert(libjami::exportable_callback<libjami::ConversationSignal::OnConversationError>(
+        [&](const std::string& /*accountId*/,
+            const std::string& /*conversationId*/,
+            int code,
+            const std::string& /*what*/) {
+            if (code == EVALIDFETCH)
+                errorDetected = true;
+            cv.notify_one();
+        }));
+    libjami::registerSignalHandlers(confHandlers);
+
+    auto aliceAccount = Manager::instance().getAccount<JamiAccount>(aliceId);
+    auto bobAccount = Manager::instance().getAccount<JamiAccount>(bobId);
+    auto repository = ConversationRepository::createConversation(aliceAccount);
+    // Enough commits for signatures to be checked on the computation pool
+    for (int i = 0; i < 100; ++i)
+        repository->commitMessage(fmt::format(R"({{"body":"Commit {}","type":"text/plain"}})", i));
+    CPPUNIT_ASSERT(repository->validCommits(repository->log()));
+    CPPUNIT_ASSERT(not errorDetected);
+
+    // A commit from Alice's device signed by Bob, buried in the history
+    auto repoPath = fileutils::get_data_dir() / aliceAccount->getAccountID() / "conversations" / repository->id();
+    git_repository* repo;
+    CPPUNIT_ASSERT(git_repository_open(&repo, repoPath.c_str()) == 0);
+    auto forged = addCommit(repo, aliceAccount, "main", R"({"body":"forged","type":"text/plain"})", bobAccount);
+    git_repository_free(repo);
+    CPPUNIT_ASSERT(not forged.empty());
+    for (int i = 0; i < 50; ++i)
+        repository->commitMessage(fmt::format(R"({{"body":"After {}","type":"text/plain"}})", i));
+
+    CPPUNIT_ASSERT(not repository->validCommits(repository->log()));
+    CPPUNIT_ASSERT(cv.wait_for(lk, 30s, [&] { return errorDetected; }));
+}
+
+
+void
+ConversationRepositoryTest::testLogBenchmark()
+{
+    constexpr int COMMITS = 10000;
+    auto aliceAccount = Manager::instance().getAccount<JamiAccount>(aliceId);
+    auto repository = ConversationRepository::createConversation(aliceAccount);
+    auto repoPath = fileutils::get_data_dir() / aliceAccount->getAccountID() / "conversations" / repository->id();
+
+    // Build the history directly: signing 10k commits would take longer than logging them.
+    // Signatures are the right size but are never verified here.
+    git_repository* repo;
+    CPPUNIT_ASSERT(git_repository_open(&repo, repoPath.c_str()) == 0);
+    git_oid headId;
+    CPPUNIT_ASSERT(git_reference_name_to_id(&headId, repo, "HEAD") == 0);
+    git_commit* head = nullptr;
+    CPPUNIT_ASSERT(git_commit_lookup(&head, repo, &headId) == 0);
+    git_tree* tree = nullptr;
+    CPPUNIT_ASSERT(git_commit_tree(&tree, head) == 0);
+    git_signature* sig = nullptr;
+    CPPUNIT_ASSERT(git_signature_now(&sig, "alice", std::string(aliceAccount->currentDeviceId()).c_str()) == 0);
+    auto fakeSignature = base64::encode(std::vector<uint8_t>(512, 0x42));
+    for (int i = 0; i < COMMITS; ++i) {
+#if LIBGIT2_VER_MAJOR == 1 && LIBGIT2_VER_MINOR == 8 \
+    && (LIBGIT2_VER_REVISION == 0 || LIBGIT2_VER_REVISION == 1 || LIBGIT2_VER_REVISION == 3)
+        git_commit* const parents[1] = {head};
+#else
+        const git_commit* parents[1] = {head};
+#endif
+        git_buf buffer = {};
+        auto msg = fmt::format(R"({{"body":"Message {} with some text","type":"text/plain"}})", i);
+        CPPUNIT_ASSERT(git_commit_create_buffer(&buffer, repo, sig, sig, nullptr, msg.c_str(), tree, 1, parents) == 0);
+        CPPUNIT_ASSERT(
+            git_commit_create_with_signature(&headId, repo, buffer.ptr, fakeSignature.c_str(), "signature") == 0);
+        git_buf_dispose(&buffer);
+        git_commit_free(head);
+        CPPUNIT_ASSERT(git_commit_lookup(&head, repo, &headId) == 0);
+    }
+    git_reference* ref = nullptr;
+    CPPUNIT_ASSERT(git_reference_create(&ref, repo, "refs/heads/main", &headId, true, nullptr) == 0);
+    git_reference_free(ref);
+    git_signature_free(sig);
+    git_tree_free(tree);
+    git_commit_free(head);
+    git_repository_free(repo);
+
+    auto measure = [](auto&& fn) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    };
+    std::vector<ConversationCommit> commits;
+    auto logTime = measure([&] { commits = repository->log(); });
+    CPPUNIT_ASSERT(commits.size() == COMMITS + 1);
+    std::vector<std::map<std::string, std::string>> maps;
+    auto mapTime = measure([&] { maps = repository->convCommitsToMap(commits); });
+    CPPUNIT_ASSERT(maps.size() == COMMITS + 1);
+    CPPUNIT_ASSERT(maps.front().at("body") == fmt::format("Message {} with some text", COMMITS - 1));
+    std::cout << "log() of " << commits.size() << " commits: " << logTime.count() << " ms, to maps: " << mapTime.count()
+              << " ms" << std::endl;
+}
+
+void
+ConversationRepositoryTest::testRepositoryMaintenance()
+{
+    auto aliceAccount = Manager::instance().getAccount<JamiAccount>(aliceId);
+    auto repository = ConversationRepository::createConversation(aliceAccount);
+    auto repoPath = fileutils::get_data_dir() / aliceAccount->getAccountID() / "conversations" / repository->id();
+    for (int i = 0; i < 30; ++i)
+        repository->commitMessage(fmt::format(R"({{"body":"Commit {}","type":"text/plain"}})", i));
+
+    // An object no reference leads to
+    git_repository* repo;
+    CPPUNIT_ASSERT(git_repository_open(&repo, repoPath.c_str()) == 0);
+    git_oid dangling;
+    std::string data = "dangling";
+    CPPUNIT_ASSERT(git_blob_create_from_buffer(&dangling, repo, data.data(), data.size()) == 0);
+    git_repository_free(repo);
+
+    auto before = git_maintenance::inspect(repoPath);
+    CPPUNIT_ASSERT(before.looseObjects > 30);
+    CPPUNIT_ASSERT(git_maintenance::needed(before));
+
+    auto result = git_maintenance::run(repoPath, 0, 0s);
+    CPPUNIT_ASSERT(result);
+    CPPUNIT_ASSERT(result->before.looseObjects == before.looseObjects);
+    CPPUNIT_ASSERT(result->after.looseObjects == 0);
+    CPPUNIT_ASSERT(result->after.packs == 1);
+    CPPUNIT_ASSERT(result->packedObjects > 30);
+    CPPUNIT_ASSERT(result->prunedObjects >= 1);
+    CPPUNIT_ASSERT(result->commitGraph);
+    CPPUNIT_ASSERT(!result->multiPackIndex);
+    CPPUNIT_ASSERT(std::filesystem::is_regular_file(repoPath / ".git" / "objects" / "info" / "commit-graph"));
+    CPPUNIT_ASSERT(!git_maintenance::needed(result->after));
+
+    // Still readable and writable, including by the repository opened before
+    CPPUNIT_ASSERT(repository->log().size() == 31);
+    repository->commitMessage(R"({"body":"After maintenance","type":"text/plain"})");
+    CPPUNIT_ASSERT(repository->log().size() == 32);
+    CPPUNIT_ASSERT(git_repository_open(&repo, repoPath.c_str()) == 0);
+    git_blob* blob = nullptr;
+    CPPUNIT_ASSERT(git_blob_lookup(&blob, repo, &dangling) != 0);
+    git_repository_free(repo);
+
+    // Unreachable objects within the grace period are kept
+    CPPUNIT_ASSERT(git_repository_open(&repo, repoPath.c_str()) == 0);
+    CPPUNIT_ASSERT(git_blob_create_from_buffer(&dangling, repo, data.data(), data.size()) == 0);
+    git_repository_free(repo);
+    result = git_maintenance::run(repoPath, 0);
+    CPPUNIT_ASSERT(result);
+    CPPUNIT_ASSERT(result->prunedObjects == 0);
+    CPPUNIT_ASSERT(result->after.looseObjects == 1);
+    CPPUNIT_ASSERT(result->after.packs == 1);
+    CPPUNIT_ASSERT(repository->log().size() == 32);
+}
+
+void
+ConversationRepositoryTest::testShallowHistoryIsUsable()
+{
+    auto aliceAccount = Manager::instance().getAccount<JamiAccount>(aliceId);
+    auto repository = ConversationRepository::createConversation(aliceAccount);
+    auto repoPath = fileutils::get_data_dir() / aliceAccount->getAccountID() / "conversations" / repository->id();
+    std::vector<std::string> ids;
+    for (int i = 0; i < 5; ++i)
+        ids.emplace_back(repository->commitMessage(fmt::format(R"({{"body":"Commit {}","type":"text/plain"}})", i)));
+
+    // As cloned from a trusted device: the oldest commits are missing, the
+    // others are checked from the newest one that is there
+    std::ofstream(repoPath / ".git" / "shallow") << ids[1] << "\n";
+    CPPUNIT_ASSERT(repository->isShallow());
+    CPPUNIT_ASSERT(ConversationRepository::shallowRoots(repoPath) == std::vector<std::string> {ids[1]});
+
+    // Messages are committed on top of it
+    auto id = repository->commitMessage(R"({"body":"Shallow","type":"text/plain"})");
+    CPPUNIT_ASSERT(!id.empty());
+    CPPUNIT_ASSERT(repository->getHead() == id);
+    CPPUNIT_ASSERT(ConversationRepository::shallowRoots(repoPath) == std::vector<std::string> {ids[1]});
+
+    std::filesystem::remove(repoPath / ".git" / "shallow");
+    CPPUNIT_ASSERT(!repository->isShallow());
+}
+
 } // namespace test
 } // namespace jami
 
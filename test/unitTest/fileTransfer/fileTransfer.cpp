@@ -35,6 +35,7 @@
 #include <condition_variable>
 #include <string>
 #include <filesystem>
+#include <iostream>
 #include <random>
 
 using namespace std::literals::chrono_literals;
@@ -97,6 +98,9 @@ private:
     void testBadSha3sumOut();
     void testBadSha3sumIn();
     void testAskToMultipleParticipants();
+    void testChunkScheduler();
+    void testChunkedTransferFromMultipleDevices();
+    void testLoopbackThroughput();
     void testCancelInTransfer();
     void testResumeTransferAfterInterruption();
     void testDontDownloadExistingFile();
@@ -113,6 +117,9 @@ private:
     CPPUNIT_TEST(testBadSha3sumOut);
     CPPUNIT_TEST(testBadSha3sumIn);
     CPPUNIT_TEST(testAskToMultipleParticipants);
+    CPPUNIT_TEST(testChunkScheduler);
+    CPPUNIT_TEST(testChunkedTransferFromMultipleDevices);
+    CPPUNIT_TEST(testLoopbackThroughput);
     CPPUNIT_TEST(testCancelInTransfer);
     CPPUNIT_TEST(testResumeTransferAfterInterruption);
     CPPUNIT_TEST(testDontDownloadExistingFile);
@@ -522,6 +529,147 @@ FileTransferTest::testAskToMultipleParticipants()
     CPPUNIT_ASSERT(dhtnet::fileutils::isFile(recvPath));
 }
 
+void
+FileTransferTest::testChunkScheduler()
+{
+    auto now = ChunkScheduler::clock::now();
+    ChunkScheduler scheduler(10 * 1000 + 1, 1000);
+    CPPUNIT_ASSERT_EQUAL(size_t(11), scheduler.chunkCount());
+
+    // Devices with an unknown throughput are given a single chunk
+    auto fast = scheduler.assign("fast", now);
+    auto slow = scheduler.assign("slow", now);
+    CPPUNIT_ASSERT(fast && fast->first == 0 && fast->second == 1);
+    CPPUNIT_ASSERT(slow && slow->first == 1 && slow->second == 2);
+
+    // Then ranges follow their throughput
+    CPPUNIT_ASSERT(scheduler.received("fast", 0, now + 1ms));
+    fast = scheduler.assign("fast", now + 1ms);
+    CPPUNIT_ASSERT(fast && fast->first == 2 && fast->second == 11);
+
+    // Once everything is requested, idle devices duplicate the end of other ranges
+    CPPUNIT_ASSERT(scheduler.received("slow", 1, now + 2s));
+    slow = scheduler.assign("slow", now + 2s);
+    CPPUNIT_ASSERT(slow && slow->first == 10 && slow->second == 11);
+    CPPUNIT_ASSERT(scheduler.received("slow", 10, now + 3s));
+    CPPUNIT_ASSERT(!scheduler.received("fast", 10, now + 3s));
+
+    // Chunks of a device that stops are given to others
+    scheduler.release("fast");
+    CPPUNIT_ASSERT_EQUAL(size_t(1), scheduler.activeCount());
+    slow = scheduler.assign("slow", now + 3s);
+    CPPUNIT_ASSERT(slow && slow->first == 2 && slow->second == 3);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(2001), scheduler.doneBytes());
+    CPPUNIT_ASSERT(!scheduler.complete());
+}
+
+void
+FileTransferTest::testChunkedTransferFromMultipleDevices()
+{
+    auto aliceAccount = Manager::instance().getAccount<JamiAccount>(aliceId);
+    auto bobAccount = Manager::instance().getAccount<JamiAccount>(bobId);
+    auto carlaAccount = Manager::instance().getAccount<JamiAccount>(carlaId);
+    auto bobUri = bobAccount->getUsername();
+    auto carlaUri = carlaAccount->getUsername();
+    connectSignals();
+    auto convId = libjami::startConversation(aliceId);
+
+    libjami::addConversationMember(aliceId, convId, bobUri);
+    libjami::addConversationMember(aliceId, convId, carlaUri);
+    CPPUNIT_ASSERT(cv.wait_for(lk, 60s, [&]() { return bobData.requestReceived && carlaData.requestReceived; }));
+
+    auto aliceMsgSize = aliceData.messages.size();
+    libjami::acceptConversationRequest(bobId, convId);
+    CPPUNIT_ASSERT(cv.wait_for(lk, 30s, [&]() { return aliceMsgSize + 1 == aliceData.messages.size(); }));
+    aliceMsgSize = aliceData.messages.size();
+    auto bobMsgSize = bobData.messages.size();
+    libjami::acceptConversationRequest(carlaId, convId);
+    CPPUNIT_ASSERT(cv.wait_for(lk, 30s, [&]() {
+        return aliceMsgSize + 1 == aliceData.messages.size() && bobMsgSize + 1 == bobData.messages.size();
+    }));
+
+    // Create a file large enough to be downloaded by chunks
+    std::ofstream sendFile(sendPath);
+    CPPUNIT_ASSERT(sendFile.is_open());
+    for (size_t i = 0; i <= ChunkedFile::MIN_SIZE / 64000; ++i)
+        sendFile << std::string(64000, static_cast<char>('A' + i % 26));
+    sendFile.close();
+
+    bobMsgSize = bobData.messages.size();
+    auto carlaMsgSize = carlaData.messages.size();
+    libjami::sendFile(aliceId, convId, sendPath, "Display name", "");
+
+    CPPUNIT_ASSERT(cv.wait_for(lk, 45s, [&]() {
+        return bobData.messages.size() == bobMsgSize + 1 && carlaData.messages.size() == carlaMsgSize + 1;
+    }));
+    auto id = bobData.messages.rbegin()->id;
+    auto fileId = bobData.messages.rbegin()->body["fileId"];
+
+    libjami::downloadFile(carlaId, convId, id, fileId, recv2Path);
+    CPPUNIT_ASSERT(cv.wait_for(lk, 60s, [&]() {
+        return carlaData.code == static_cast<int>(libjami::DataTransferEventCode::finished);
+    }));
+    CPPUNIT_ASSERT(compare(sendPath.string(), recv2Path.string()));
+
+    // Bob gets chunks from both Alice and Carla
+    libjami::downloadFile(bobId, convId, id, fileId, recvPath);
+    CPPUNIT_ASSERT(cv.wait_for(lk, 60s, [&]() {
+        return bobData.code == static_cast<int>(libjami::DataTransferEventCode::finished);
+    }));
+    CPPUNIT_ASSERT(compare(sendPath.string(), recvPath.string()));
+    auto chunksPath = recvPath;
+    chunksPath += ".chunks";
+    CPPUNIT_ASSERT(!std::filesystem::exists(chunksPath));
+}
+
+void
+FileTransferTest::testLoopbackThroughput()
+{
+    auto bobAccount = Manager::instance().getAccount<JamiAccount>(bobId);
+    auto bobUri = bobAccount->getUsername();
+    connectSignals();
+    auto convId = libjami::startConversation(aliceId);
+
+    libjami::addConversationMember(aliceId, convId, bobUri);
+    CPPUNIT_ASSERT(cv.wait_for(lk, 30s, [&]() { return bobData.requestReceived; }));
+
+    auto aliceMsgSize = aliceData.messages.size();
+    libjami::acceptConversationRequest(bobId, convId);
+    CPPUNIT_ASSERT(cv.wait_for(lk, 30s, [&]() { return aliceMsgSize + 1 == aliceData.messages.size(); }));
+
+    // Sent through a single channel, with a last block shorter than the others
+    constexpr size_t blockSize = 64 * 1024;
+    constexpr auto fileSize = static_cast<size_t>(ChunkedFile::MIN_SIZE - 1);
+    std::ofstream sendFile(sendPath, std::ios::binary);
+    CPPUNIT_ASSERT(sendFile.is_open());
+    std::mt19937_64 rd(42);
+    std::vector<char> block(blockSize);
+    for (size_t written = 0; written < fileSize; written += blockSize) {
+        std::generate(block.begin(), block.end(), [&] { return static_cast<char>(rd()); });
+        sendFile.write(block.data(), static_cast<std::streamsize>(std::min(blockSize, fileSize - written)));
+    }
+    sendFile.close();
+
+    auto bobMsgSize = bobData.messages.size();
+    libjami::sendFile(aliceId, convId, sendPath, "Display name", "");
+    CPPUNIT_ASSERT(cv.wait_for(lk, 60s, [&]() { return bobMsgSize + 1 == bobData.messages.size(); }));
+    auto id = bobData.messages.rbegin()->id;
+    auto fileId = bobData.messages.rbegin()->body["fileId"];
+
+    auto start = std::chrono::steady_clock::now();
+    libjami::downloadFile(bobId, convId, id, fileId, recvPath);
+    CPPUNIT_ASSERT(cv.wait_for(lk, 60s, [&]() {
+        return bobData.code == static_cast<int>(libjami::DataTransferEventCode::finished);
+    }));
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    CPPUNIT_ASSERT(compare(sendPath.string(), recvPath.string()));
+    CPPUNIT_ASSERT_EQUAL(static_cast<uintmax_t>(fileSize), std::filesystem::file_size(recvPath));
+
+    // Only reported, it depends on the machine
+    std::cout << "Loopback transfer of " << static_cast<double>(fileSize) / (1024 * 1024) << " MiB in " << elapsed
+              << " s: " << static_cast<double>(fileSize) / (1024 * 1024) / elapsed << " MiB/s" << std::endl;
+}
+
 void
 FileTransferTest::testCancelInTransfer()
 {
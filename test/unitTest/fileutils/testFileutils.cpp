@@ -21,6 +21,8 @@
 
 #include "../../test_runner.h"
 #include "fileutils.h"
+#include "jamidht/file_digest_cache.h"
+#include "jamidht/file_store.h"
 
 #include "jami.h"
 
@@ -28,6 +30,7 @@
 #include <iostream>
 #include <filesystem>
 #include <cstdlib>
+#include <vector>
 #include <fstream>
 
 #include <unistd.h>
@@ -59,6 +62,10 @@ private:
     void testSha3FileDirectory();
     void testSha3FileLargeExactMultiple();
     void testSha3FileLargeNonMultiple();
+    void testSha3StreamMatchesSha3File();
+    void testFileDigestCache();
+    void testFileStore();
+    void testFileReader();
 
     CPPUNIT_TEST_SUITE(FileutilsTest);
     CPPUNIT_TEST(testPath);
@@ -74,6 +81,10 @@ private:
     CPPUNIT_TEST(testSha3FileDirectory);
     CPPUNIT_TEST(testSha3FileLargeExactMultiple);
     CPPUNIT_TEST(testSha3FileLargeNonMultiple);
+    CPPUNIT_TEST(testSha3StreamMatchesSha3File);
+    CPPUNIT_TEST(testFileDigestCache);
+    CPPUNIT_TEST(testFileStore);
+    CPPUNIT_TEST(testFileReader);
     CPPUNIT_TEST_SUITE_END();
 
     static constexpr auto tmpFileName = "temp_file";
@@ -270,6 +281,196 @@ FileutilsTest::testSha3FileLargeNonMultiple()
     std::filesystem::remove(largePath);
 }
 
+void
+FileutilsTest::testSha3StreamMatchesSha3File()
+{
+    std::vector<uint8_t> data(100000ul);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = static_cast<uint8_t>(i & 0xFF);
+
+    // Parts of any size give the digest of the whole
+    Sha3Stream stream;
+    for (size_t pos = 0; pos < data.size(); pos += 777)
+        stream.update(data.data() + pos, std::min<size_t>(777, data.size() - pos));
+    CPPUNIT_ASSERT_EQUAL(sha3sum(data), stream.digest());
+
+    // A received prefix followed by the rest
+    auto prefixPath = TEST_PATH / "prefix";
+    {
+        std::ofstream ofs(prefixPath, std::ios::binary);
+        ofs.write(reinterpret_cast<const char*>(data.data()), 1000);
+    }
+    CPPUNIT_ASSERT(stream.updateFile(prefixPath));
+    stream.update(data.data() + 1000, data.size() - 1000);
+    CPPUNIT_ASSERT_EQUAL(sha3sum(data), stream.digest());
+    std::filesystem::remove(prefixPath);
+}
+
+void
+FileutilsTest::testFileDigestCache()
+{
+    auto storePath = TEST_PATH / "digests";
+    auto filePath = TEST_PATH / "shared";
+    {
+        std::ofstream ofs(filePath, std::ios::binary);
+        ofs << "first version";
+    }
+    {
+        FileDigestCache cache(storePath);
+        CPPUNIT_ASSERT_EQUAL(sha3File(filePath), cache.sha3(filePath));
+        CPPUNIT_ASSERT(cache.sha3(NON_EXISTANT_PATH).empty());
+    }
+    // Reopened: served from the journal, then invalidated by a write
+    {
+        FileDigestCache cache(storePath);
+        CPPUNIT_ASSERT_EQUAL(sha3File(filePath), cache.sha3(filePath));
+        {
+            std::ofstream ofs(filePath, std::ios::binary | std::ios::app);
+            ofs << ", then a second one";
+        }
+        CPPUNIT_ASSERT_EQUAL(sha3File(filePath), cache.sha3(filePath));
+    }
+    std::filesystem::remove(filePath);
+    std::filesystem::remove(storePath);
+
+    // Above its size, removed files are forgotten first, then the oldest ones
+    std::vector<std::filesystem::path> files;
+    for (auto i = 0; i < 6; ++i) {
+        files.emplace_back(TEST_PATH / ("digested" + std::to_string(i)));
+        std::ofstream ofs(files.back(), std::ios::binary);
+        ofs << "content " << i;
+    }
+    {
+        FileDigestCache cache(storePath, 4);
+        for (auto i = 0; i < 4; ++i)
+            CPPUNIT_ASSERT_EQUAL(sha3File(files[i]), cache.sha3(files[i]));
+        CPPUNIT_ASSERT_EQUAL((size_t) 4, cache.size());
+        std::filesystem::remove(files[1]);
+        CPPUNIT_ASSERT_EQUAL(sha3File(files[4]), cache.sha3(files[4]));
+        CPPUNIT_ASSERT_EQUAL((size_t) 3, cache.size());
+    }
+    // Not swept when reopened
+    std::filesystem::remove(files[2]);
+    {
+        FileDigestCache cache(storePath, 4);
+        CPPUNIT_ASSERT_EQUAL((size_t) 3, cache.size());
+        CPPUNIT_ASSERT_EQUAL(sha3File(files[5]), cache.sha3(files[5]));
+        CPPUNIT_ASSERT_EQUAL((size_t) 4, cache.size());
+    }
+    for (const auto& file : files)
+        std::filesystem::remove(file);
+    std::filesystem::remove(storePath);
+}
+
+void
+FileutilsTest::testFileStore()
+{
+    auto storePath = TEST_PATH / "store";
+    auto write = [](const std::filesystem::path& path, const std::string& content) {
+        std::filesystem::create_directories(path.parent_path());
+        std::ofstream ofs(path, std::ios::binary);
+        ofs << content;
+    };
+    auto first = TEST_PATH / "conv1" / "first";
+    auto second = TEST_PATH / "conv2" / "second";
+    auto other = TEST_PATH / "conv2" / "other";
+    write(first, "shared content");
+    write(second, "shared content");
+    write(other, "other content");
+    auto sha3 = sha3File(first);
+    auto otherSha3 = sha3File(other);
+    {
+        FileStore store(storePath);
+        CPPUNIT_ASSERT(!store.has(sha3));
+        CPPUNIT_ASSERT(!store.link(sha3, TEST_PATH / "conv3" / "linked"));
+        // Digests name files
+        CPPUNIT_ASSERT(!store.adopt(first, "../" + sha3.substr(3)));
+
+        CPPUNIT_ASSERT(store.adopt(first, sha3));
+        CPPUNIT_ASSERT(store.has(sha3));
+        CPPUNIT_ASSERT(std::filesystem::equivalent(first, store.objectPath(sha3)));
+        // Same content received again: shares the stored file
+        CPPUNIT_ASSERT(store.adopt(second, sha3));
+        CPPUNIT_ASSERT(std::filesystem::equivalent(first, second));
+        CPPUNIT_ASSERT(store.link(sha3, TEST_PATH / "conv3" / "linked"));
+        CPPUNIT_ASSERT_EQUAL(sha3, sha3File(TEST_PATH / "conv3" / "linked"));
+        CPPUNIT_ASSERT_EQUAL((size_t) 3, store.references(sha3));
+        CPPUNIT_ASSERT(!store.link(otherSha3, TEST_PATH / "conv3" / "other"));
+        CPPUNIT_ASSERT(store.adopt(other, otherSha3));
+
+        std::filesystem::remove(first);
+        store.release(first);
+        CPPUNIT_ASSERT_EQUAL((size_t) 2, store.references(sha3));
+    }
+    // Removed without being released: forgotten when reopened
+    std::filesystem::remove(second);
+    {
+        FileStore store(storePath);
+        CPPUNIT_ASSERT_EQUAL((size_t) 1, store.references(sha3));
+        CPPUNIT_ASSERT(store.has(otherSha3));
+
+        std::filesystem::remove_all(TEST_PATH / "conv3");
+        store.releaseAll(TEST_PATH / "conv3");
+        CPPUNIT_ASSERT(!store.has(sha3));
+        CPPUNIT_ASSERT(!std::filesystem::exists(store.objectPath(sha3)));
+        CPPUNIT_ASSERT(store.has(otherSha3));
+
+        // Written to in place by another application: neither linked nor
+        // trusted anymore
+        CPPUNIT_ASSERT(store.stores(other));
+        CPPUNIT_ASSERT(store.intact(otherSha3));
+        write(other, "other content, edited");
+        CPPUNIT_ASSERT(!store.intact(otherSha3));
+        CPPUNIT_ASSERT(!store.link(otherSha3, TEST_PATH / "conv3" / "other"));
+        // Until the content is received again
+        auto received = TEST_PATH / "conv4" / "other";
+        write(received, "other content");
+        CPPUNIT_ASSERT(store.adopt(received, otherSha3));
+        CPPUNIT_ASSERT(store.intact(otherSha3));
+        CPPUNIT_ASSERT_EQUAL(otherSha3, sha3File(received));
+        CPPUNIT_ASSERT(!std::filesystem::equivalent(received, other));
+    }
+    std::filesystem::remove_all(TEST_PATH / "conv1");
+    std::filesystem::remove_all(TEST_PATH / "conv2");
+    std::filesystem::remove_all(TEST_PATH / "conv4");
+    std::filesystem::remove_all(storePath);
+}
+
+void
+FileutilsTest::testFileReader()
+{
+    std::vector<uint8_t> data(3 * FileReader::READ_AHEAD + 123);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = static_cast<uint8_t>(i * 7);
+    auto path = TEST_PATH / "reader";
+    {
+        std::ofstream ofs(path, std::ios::binary);
+        ofs.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    }
+
+    CPPUNIT_ASSERT(!FileReader(TEST_PATH / "missing").isOpen());
+    FileReader reader(path);
+    CPPUNIT_ASSERT(reader.isOpen());
+
+    // Sequential reads, past read-ahead windows
+    std::vector<uint8_t> read(data.size());
+    std::vector<uint8_t> buffer(UINT16_MAX);
+    uint64_t pos = 0;
+    while (auto n = reader.read(pos, buffer.data(), buffer.size())) {
+        CPPUNIT_ASSERT(n > 0);
+        std::copy_n(buffer.begin(), n, read.begin() + static_cast<std::ptrdiff_t>(pos));
+        pos += static_cast<uint64_t>(n);
+    }
+    CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(data.size()), pos);
+    CPPUNIT_ASSERT(read == data);
+
+    // Reads at any offset
+    CPPUNIT_ASSERT_EQUAL(int64_t(10), reader.read(1000, buffer.data(), 10));
+    CPPUNIT_ASSERT(std::equal(buffer.begin(), buffer.begin() + 10, data.begin() + 1000));
+    CPPUNIT_ASSERT_EQUAL(int64_t(23), reader.read(data.size() - 23, buffer.data(), 100));
+    std::filesystem::remove(path);
+}
+
 } // namespace test
 } // namespace fileutils
 } // namespace jami
@@ -0,0 +1,236 @@
+/*
+ *  Copyright (C) 2004-2026 Savoir-faire Linux Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "../../test_runner.h"
+#include "../common.h"
+
+#include "im/message_engine.h"
+#include "im/timer_wheel.h"
+#include "jamidht/jamiaccount.h"
+#include "jamidht/journal_store.h"
+#include "manager.h"
+
+#include <asio/post.hpp>
+#include <msgpack.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <list>
+#include <string>
+
+using namespace std::literals::chrono_literals;
+
+namespace jami {
+namespace test {
+
+// Layout of the messages written by versions before the journal
+struct LegacyMessage
+{
+    im::MessageToken token {};
+    std::string to {};
+    std::map<std::string, std::string> payloads {};
+    im::MessageStatus status {im::MessageStatus::IDLE};
+    unsigned retried {0};
+    std::chrono::system_clock::time_point last_op {};
+
+    MSGPACK_DEFINE_MAP(token, to, payloads, status, retried, last_op)
+};
+
+class MessageEngineTest : public CppUnit::TestFixture
+{
+public:
+    ~MessageEngineTest() { libjami::fini(); }
+    static std::string name() { return "MessageEngine"; }
+    void setUp();
+    void tearDown();
+
+    std::string aliceId;
+    std::filesystem::path path;
+
+private:
+    void testRetryBackoff();
+    void testRetryWheel();
+    void testLegacyMigrationReload();
+    void testPerPeerOrdering();
+
+    CPPUNIT_TEST_SUITE(MessageEngineTest);
+    CPPUNIT_TEST(testRetryBackoff);
+    CPPUNIT_TEST(testRetryWheel);
+    CPPUNIT_TEST(testLegacyMigrationReload);
+    CPPUNIT_TEST(testPerPeerOrdering);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION(MessageEngineTest, MessageEngineTest::name());
+
+void
+MessageEngineTest::setUp()
+{
+    // Init daemon
+    libjami::init(libjami::InitFlag(libjami::LIBJAMI_FLAG_DEBUG | libjami::LIBJAMI_FLAG_CONSOLE_LOG));
+    if (not Manager::instance().initialized)
+        CPPUNIT_ASSERT(libjami::start("jami-sample.yml"));
+
+    auto actors = load_actors("actors/alice.yml");
+    aliceId = actors["alice"];
+    path = std::filesystem::temp_directory_path() / "jami_message_engine_unittest" / "messages";
+    std::filesystem::remove_all(path.parent_path());
+    std::filesystem::create_directories(path.parent_path());
+}
+
+void
+MessageEngineTest::tearDown()
+{
+    std::filesystem::remove_all(path.parent_path());
+    wait_for_removal_of(aliceId);
+}
+
+// Wait for the tasks posted by the engine, which run on the io context
+static void
+flushIoContext()
+{
+    std::promise<void> done;
+    asio::post(*Manager::instance().ioContext(), [&] { done.set_value(); });
+    CPPUNIT_ASSERT(done.get_future().wait_for(10s) == std::future_status::ready);
+}
+
+void
+MessageEngineTest::testRetryBackoff()
+{
+    CPPUNIT_ASSERT(im::MessageEngine::retryDelay(0) == im::MessageEngine::RETRY_DELAY);
+    CPPUNIT_ASSERT(im::MessageEngine::retryDelay(1) == im::MessageEngine::RETRY_DELAY);
+    CPPUNIT_ASSERT(im::MessageEngine::retryDelay(2) == 2 * im::MessageEngine::RETRY_DELAY);
+    CPPUNIT_ASSERT(im::MessageEngine::retryDelay(5) == 16 * im::MessageEngine::RETRY_DELAY);
+    for (unsigned retried = 2; retried <= im::MessageEngine::MAX_RETRIES; ++retried) {
+        auto delay = im::MessageEngine::retryDelay(retried);
+        auto previous = im::MessageEngine::retryDelay(retried - 1);
+        CPPUNIT_ASSERT(delay <= im::MessageEngine::MAX_RETRY_DELAY);
+        CPPUNIT_ASSERT(delay == std::min(2 * previous, im::MessageEngine::MAX_RETRY_DELAY));
+    }
+    CPPUNIT_ASSERT(im::MessageEngine::retryDelay(im::MessageEngine::MAX_RETRIES) == im::MessageEngine::MAX_RETRY_DELAY);
+}
+
+void
+MessageEngineTest::testRetryWheel()
+{
+    // The wheel is the clock: every advance() is a tick
+    constexpr size_t SLOTS = 16;
+    im::TimerWheel<unsigned> wheel(SLOTS);
+    std::map<unsigned, size_t> dueAt;
+    for (unsigned retried = 1; retried <= 8; ++retried) {
+        auto ticks = static_cast<size_t>(im::MessageEngine::retryDelay(retried).count());
+        wheel.schedule(retried, ticks);
+        dueAt[retried] = ticks;
+    }
+    // Due after a full turn, and after several ones
+    CPPUNIT_ASSERT(dueAt[5] == SLOTS);
+    CPPUNIT_ASSERT(dueAt[8] > 2 * SLOTS);
+    CPPUNIT_ASSERT_EQUAL(size_t(8), wheel.size());
+
+    std::map<unsigned, size_t> fired;
+    for (size_t tick = 1; tick <= dueAt[8]; ++tick) {
+        for (auto retried : wheel.advance()) {
+            CPPUNIT_ASSERT(fired.emplace(retried, tick).second);
+            CPPUNIT_ASSERT_EQUAL(dueAt[retried], tick);
+        }
+    }
+    CPPUNIT_ASSERT_EQUAL(size_t(8), fired.size());
+    CPPUNIT_ASSERT(wheel.empty());
+
+    // Scheduled from the current position, not from the start
+    wheel.schedule(42, 0);
+    CPPUNIT_ASSERT_EQUAL(size_t(1), wheel.size());
+    auto due = wheel.advance();
+    CPPUNIT_ASSERT(due == std::vector<unsigned> {42});
+}
+
+void
+MessageEngineTest::testLegacyMigrationReload()
+{
+    auto aliceAccount = Manager::instance().getAccount<JamiAccount>(aliceId);
+    std::map<std::string, std::list<LegacyMessage>> legacy;
+    for (auto token : {3, 1, 2})
+        legacy["bob"].emplace_back(LegacyMessage {static_cast<im::MessageToken>(token), "bob", {{"text/plain", "hi"}}});
+    legacy["carla"].emplace_back(LegacyMessage {5, "carla", {{"text/plain", "hi"}}, im::MessageStatus::SENDING, 2});
+    {
+        std::ofstream file(path, std::ios::trunc | std::ios::binary);
+        msgpack::pack(file, legacy);
+    }
+
+    {
+        im::MessageEngine engine(*aliceAccount, path);
+        CPPUNIT_ASSERT(JournalStore::isJournal(path));
+        engine.load();
+        CPPUNIT_ASSERT(engine.pending("bob") == std::vector<im::MessageToken>({3, 1, 2}));
+        CPPUNIT_ASSERT(engine.pending("carla") == std::vector<im::MessageToken> {5});
+        // Attempts in progress when it was saved are lost
+        CPPUNIT_ASSERT(engine.getStatus(5) == im::MessageStatus::IDLE);
+        CPPUNIT_ASSERT(engine.getStatus(4) == im::MessageStatus::UNKNOWN);
+    }
+
+    // The migrated journal is read again as is, in the same order
+    im::MessageEngine engine(*aliceAccount, path);
+    engine.load();
+    CPPUNIT_ASSERT(engine.pending("bob") == std::vector<im::MessageToken>({3, 1, 2}));
+    CPPUNIT_ASSERT(engine.getStatus(1) == im::MessageStatus::IDLE);
+}
+
+void
+MessageEngineTest::testPerPeerOrdering()
+{
+    auto aliceAccount = Manager::instance().getAccount<JamiAccount>(aliceId);
+    std::vector<im::MessageToken> bobTokens;
+    std::vector<im::MessageToken> carlaTokens;
+    {
+        im::MessageEngine engine(*aliceAccount, path);
+        engine.load();
+        // Not valid URIs: the account fails them at once, without any network
+        for (auto i = 0; i < 5; ++i) {
+            bobTokens.emplace_back(engine.sendMessage("bob", "", {{"text/plain", std::to_string(i)}}, 0));
+            carlaTokens.emplace_back(engine.sendMessage("carla", "", {{"text/plain", std::to_string(i)}}, 0));
+        }
+        CPPUNIT_ASSERT(engine.pending("bob") == bobTokens);
+        CPPUNIT_ASSERT(engine.pending("carla") == carlaTokens);
+
+        // A refreshed message keeps its place
+        CPPUNIT_ASSERT_EQUAL(bobTokens[2], engine.sendMessage("bob", "", {{"text/plain", "new"}}, bobTokens[2]));
+        CPPUNIT_ASSERT(engine.pending("bob") == bobTokens);
+
+        // Acknowledged messages leave the queue, the others stay in order
+        flushIoContext();
+        engine.onMessageSent("bob", bobTokens[1], true);
+        bobTokens.erase(bobTokens.begin() + 1);
+        CPPUNIT_ASSERT(engine.pending("bob") == bobTokens);
+        engine.save();
+        flushIoContext();
+    }
+
+    im::MessageEngine engine(*aliceAccount, path);
+    engine.load();
+    CPPUNIT_ASSERT(engine.pending("bob") == bobTokens);
+    CPPUNIT_ASSERT(engine.pending("carla") == carlaTokens);
+}
+
+} // namespace test
+} // namespace jami
+
+CORE_TEST_RUNNER(jami::test::MessageEngineTest::name())
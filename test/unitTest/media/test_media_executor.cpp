@@ -0,0 +1,244 @@
+/*
+ *  Copyright (C) 2004-2026 Savoir-faire Linux Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "media/media_executor.h"
+
+#include "../../test_runner.h"
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <set>
+
+using namespace std::literals::chrono_literals;
+
+namespace jami {
+namespace test {
+
+class MediaExecutorTest : public CppUnit::TestFixture
+{
+public:
+    static std::string name() { return "media_executor"; }
+
+private:
+    void testOrdering();
+    void testAffinity();
+    void testJoin();
+    void testWake();
+    void testSimulatedCalls();
+
+    CPPUNIT_TEST_SUITE(MediaExecutorTest);
+    CPPUNIT_TEST(testOrdering);
+    CPPUNIT_TEST(testAffinity);
+    CPPUNIT_TEST(testJoin);
+    CPPUNIT_TEST(testWake);
+    CPPUNIT_TEST(testSimulatedCalls);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION(MediaExecutorTest, MediaExecutorTest::name());
+
+void
+MediaExecutorTest::testOrdering()
+{
+    MediaExecutor executor(2);
+    auto key = MediaExecutor::affinityKey("call");
+    std::vector<int> order;
+    std::promise<void> done;
+    auto now = MediaExecutor::clock::now();
+    executor.schedule(key, now + 30ms, [&] { order.emplace_back(3); });
+    executor.schedule(key, now + 10ms, [&] { order.emplace_back(1); });
+    executor.schedule(key, now + 10ms, [&] { order.emplace_back(2); });
+    executor.schedule(key, now + 50ms, [&] { done.set_value(); });
+    CPPUNIT_ASSERT(done.get_future().wait_for(5s) == std::future_status::ready);
+    CPPUNIT_ASSERT((order == std::vector<int> {1, 2, 3}));
+}
+
+void
+MediaExecutorTest::testAffinity()
+{
+    MediaExecutor executor(4);
+    auto key = MediaExecutor::affinityKey("call");
+    std::mutex mtx;
+    std::set<std::thread::id> threads;
+    std::atomic_int count {0};
+    // Asserted from the test thread: failures in tasks would be swallowed
+    std::atomic_bool onWorker {true};
+    for (int i = 0; i < 100; ++i) {
+        executor.post(key, [&] {
+            std::lock_guard lk(mtx);
+            threads.emplace(std::this_thread::get_id());
+            if (not executor.isCurrentWorker(key))
+                onWorker = false;
+            count++;
+        });
+    }
+    auto deadline = std::chrono::steady_clock::now() + 5s;
+    while (count < 100 and std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(10ms);
+    CPPUNIT_ASSERT(count == 100);
+    CPPUNIT_ASSERT(onWorker);
+    std::lock_guard lk(mtx);
+    CPPUNIT_ASSERT(threads.size() == 1);
+}
+
+void
+MediaExecutorTest::testJoin()
+{
+    MediaExecutor executor(2);
+    std::atomic_int runs {0};
+    std::atomic_bool inside {false};
+    MediaTask task(
+        "call",
+        [&] {
+            inside = true;
+            std::this_thread::sleep_for(20ms);
+            runs++;
+            inside = false;
+        },
+        5ms,
+        executor);
+    task.start();
+    CPPUNIT_ASSERT(task.isRunning());
+    std::this_thread::sleep_for(100ms);
+    task.join();
+    CPPUNIT_ASSERT(not inside);
+    CPPUNIT_ASSERT(not task.isRunning());
+    auto count = runs.load();
+    CPPUNIT_ASSERT(count > 0);
+    std::this_thread::sleep_for(100ms);
+    CPPUNIT_ASSERT(runs == count);
+
+    // A task can be restarted after join
+    task.start();
+    std::this_thread::sleep_for(100ms);
+    task.join();
+    CPPUNIT_ASSERT(runs > count);
+}
+
+void
+MediaExecutorTest::testWake()
+{
+    MediaExecutor executor(2);
+    std::atomic_int runs {0};
+    auto waitRuns = [&](int expected) {
+        auto deadline = std::chrono::steady_clock::now() + 5s;
+        while (runs < expected and std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(5ms);
+        return runs.load();
+    };
+    std::function<void()> waker;
+    {
+        // The periodic run is never due during the test
+        MediaTask task("call", [&] { runs++; }, 1h, executor);
+        waker = task.waker();
+        waker();
+        std::this_thread::sleep_for(50ms);
+        CPPUNIT_ASSERT_EQUAL(0, runs.load());
+
+        task.start();
+        CPPUNIT_ASSERT_EQUAL(1, waitRuns(1));
+        waker();
+        CPPUNIT_ASSERT_EQUAL(2, waitRuns(2));
+        task.wake();
+        CPPUNIT_ASSERT_EQUAL(3, waitRuns(3));
+
+        task.join();
+        waker();
+        std::this_thread::sleep_for(50ms);
+        CPPUNIT_ASSERT_EQUAL(3, runs.load());
+    }
+    // Outlives the task
+    waker();
+}
+
+void
+MediaExecutorTest::testSimulatedCalls()
+{
+    // 100 calls, each with an audio capture stage every 20ms and an RTCP
+    // check every 500ms, served by a pool of one worker per core.
+    constexpr int NB_CALLS = 100;
+    constexpr auto DURATION = 2s;
+    MediaExecutor executor;
+
+    struct Call
+    {
+        std::atomic_int frames {0};
+        std::atomic_int rtcp {0};
+        std::atomic<int64_t> maxLateness {0};
+        MediaExecutor::clock::time_point expected;
+        std::unique_ptr<MediaTask> capture;
+        std::unique_ptr<MediaTask> rtcpChecker;
+    };
+    std::vector<std::unique_ptr<Call>> calls;
+    calls.reserve(NB_CALLS);
+    for (int i = 0; i < NB_CALLS; ++i) {
+        auto call = std::make_unique<Call>();
+        auto callId = "call" + std::to_string(i);
+        auto* c = call.get();
+        c->capture = std::make_unique<MediaTask>(
+            callId,
+            [c] {
+                auto now = MediaExecutor::clock::now();
+                if (c->frames++ > 0) {
+                    auto late = std::chrono::duration_cast<std::chrono::microseconds>(now - c->expected).count();
+                    if (late > c->maxLateness)
+                        c->maxLateness = late;
+                }
+                c->expected = now + 20ms;
+            },
+            20ms,
+            executor);
+        c->rtcpChecker = std::make_unique<MediaTask>(callId, [c] { c->rtcp++; }, 500ms, executor);
+        calls.emplace_back(std::move(call));
+    }
+    auto start = MediaExecutor::clock::now();
+    for (auto& call : calls) {
+        call->capture->start();
+        call->rtcpChecker->start();
+    }
+    std::this_thread::sleep_for(DURATION);
+    for (auto& call : calls) {
+        call->capture->join();
+        call->rtcpChecker->join();
+    }
+    // The test thread itself may have slept longer than asked
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(MediaExecutor::clock::now() - start);
+
+    constexpr int expectedFrames = std::chrono::milliseconds(DURATION).count() / 20;
+    const int maxFrames = static_cast<int>(elapsed.count() / 20) + 2;
+    int64_t worstLateness = 0;
+    for (auto& call : calls) {
+        // Loose bounds: loaded CI machines may stall workers or the test thread
+        CPPUNIT_ASSERT(call->frames >= expectedFrames / 2);
+        CPPUNIT_ASSERT(call->frames <= maxFrames);
+        CPPUNIT_ASSERT(call->rtcp >= 2);
+        worstLateness = std::max(worstLateness, call->maxLateness.load());
+    }
+    std::cout << "Worst capture lateness over " << NB_CALLS << " calls: " << worstLateness << "us with "
+              << executor.workerCount() << " workers" << std::endl;
+}
+
+} // namespace test
+} // namespace jami
+
+CORE_TEST_RUNNER(jami::test::MediaExecutorTest::name());
@@ -0,0 +1,178 @@
+/*
+ *  Copyright (C) 2004-2026 Savoir-faire Linux Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "media/media_stats.h"
+
+#include "../../test_runner.h"
+
+#include <iostream>
+#include <thread>
+
+using namespace std::literals::chrono_literals;
+
+namespace jami {
+namespace test {
+
+class MediaStatsTest : public CppUnit::TestFixture
+{
+public:
+    static std::string name() { return "media_stats"; }
+
+private:
+    void testBuckets();
+    void testPercentiles();
+    void testConcurrentRecord();
+    void testReport();
+    void testRecordCost();
+
+    CPPUNIT_TEST_SUITE(MediaStatsTest);
+    CPPUNIT_TEST(testBuckets);
+    CPPUNIT_TEST(testPercentiles);
+    CPPUNIT_TEST(testConcurrentRecord);
+    CPPUNIT_TEST(testReport);
+    CPPUNIT_TEST(testRecordCost);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION(MediaStatsTest, MediaStatsTest::name());
+
+void
+MediaStatsTest::testBuckets()
+{
+    // Small values are exact
+    for (uint64_t v = 0; v < 16; ++v) {
+        auto index = LatencyHistogram::bucketIndex(v);
+        CPPUNIT_ASSERT(LatencyHistogram::bucketUpperBound(index) == v);
+    }
+    // Every value falls in a bucket whose bound is within 1/SUB_BUCKETS
+    uint64_t previous = 0;
+    for (uint64_t v = 16; v < (uint64_t(1) << 34); v = v * 9 / 8 + 1) {
+        auto index = LatencyHistogram::bucketIndex(v);
+        CPPUNIT_ASSERT(index >= previous);
+        previous = index;
+        auto bound = LatencyHistogram::bucketUpperBound(index);
+        CPPUNIT_ASSERT(bound >= v);
+        CPPUNIT_ASSERT(bound - v <= v / LatencyHistogram::SUB_BUCKETS);
+    }
+    CPPUNIT_ASSERT(LatencyHistogram::bucketIndex(UINT64_MAX) == LatencyHistogram::BUCKET_COUNT - 1);
+}
+
+void
+MediaStatsTest::testPercentiles()
+{
+    LatencyHistogram histogram;
+    for (uint64_t v = 1; v <= 1000; ++v)
+        histogram.record(v * 1000);
+    auto snapshot = histogram.snapshot();
+    CPPUNIT_ASSERT(snapshot.count == 1000);
+    CPPUNIT_ASSERT(snapshot.max == 1000000);
+    CPPUNIT_ASSERT(snapshot.mean() == 500500);
+    auto near = [](uint64_t value, uint64_t expected) {
+        return value >= expected and value <= expected + expected / LatencyHistogram::SUB_BUCKETS;
+    };
+    CPPUNIT_ASSERT(near(snapshot.percentile(50), 500000));
+    CPPUNIT_ASSERT(near(snapshot.percentile(90), 900000));
+    CPPUNIT_ASSERT(near(snapshot.percentile(99), 990000));
+    CPPUNIT_ASSERT(snapshot.percentile(100) == 1000000);
+
+    histogram.reset();
+    CPPUNIT_ASSERT(histogram.snapshot().count == 0);
+    CPPUNIT_ASSERT(histogram.snapshot().percentile(50) == 0);
+}
+
+void
+MediaStatsTest::testConcurrentRecord()
+{
+    LatencyHistogram histogram;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+        threads.emplace_back([&, t] {
+            for (uint64_t i = 0; i < 100000; ++i)
+                histogram.record(i + t);
+        });
+    for (auto& thread : threads)
+        thread.join();
+    auto snapshot = histogram.snapshot();
+    CPPUNIT_ASSERT(snapshot.count == 400000);
+    CPPUNIT_ASSERT(snapshot.max == 100002);
+}
+
+void
+MediaStatsTest::testReport()
+{
+    CallMediaStats stats;
+    auto audio = stats.stream("audio_0");
+    CPPUNIT_ASSERT(stats.stream("audio_0") == audio);
+    audio->record(MediaStage::ENCODE, 150us);
+    audio->record(MediaStage::ENCODE, 250us);
+    audio->addBytes(MediaStage::SEND, 1200);
+    audio->drop(MediaStage::RECEIVE);
+    // Three packets missing at once
+    audio->drop(MediaStage::RECEIVE, 3);
+    {
+        MediaStageTimer timer(stats.stream("video_0").get(), MediaStage::DECODE);
+        std::this_thread::sleep_for(1ms);
+    }
+    {
+        MediaStageTimer timer(nullptr, MediaStage::DECODE);
+    }
+
+    auto report = stats.report();
+    CPPUNIT_ASSERT(report.size() == 4);
+    bool foundEncode = false, foundDecode = false;
+    for (const auto& entry : report) {
+        if (entry.at("stream") == "audio_0" and entry.at("stage") == "encode") {
+            foundEncode = true;
+            CPPUNIT_ASSERT(entry.at("count") == "2");
+            CPPUNIT_ASSERT(entry.at("meanUs") == "200");
+            CPPUNIT_ASSERT(entry.at("maxUs") == "250");
+        } else if (entry.at("stream") == "audio_0" and entry.at("stage") == "send") {
+            CPPUNIT_ASSERT(entry.at("bytes") == "1200");
+            CPPUNIT_ASSERT(entry.at("count") == "0");
+        } else if (entry.at("stream") == "audio_0" and entry.at("stage") == "receive") {
+            CPPUNIT_ASSERT(entry.at("drops") == "4");
+        } else if (entry.at("stream") == "video_0" and entry.at("stage") == "decode") {
+            foundDecode = true;
+            CPPUNIT_ASSERT(std::stoull(entry.at("maxUs")) >= 1000);
+        }
+    }
+    CPPUNIT_ASSERT(foundEncode and foundDecode);
+}
+
+void
+MediaStatsTest::testRecordCost()
+{
+    constexpr int N = 1000000;
+    MediaStreamStats stats("audio_0");
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < N; ++i)
+        stats.record(MediaStage::ENCODE, std::chrono::nanoseconds(i & 0xffff));
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    auto perEvent = elapsed.count() / N;
+    std::cout << "Histogram record cost: " << perEvent << "ns" << std::endl;
+    // Only reported: the cost depends on the load and instrumentation of the build
+    CPPUNIT_ASSERT(stats.latency(MediaStage::ENCODE).count == N);
+}
+
+} // namespace test
+} // namespace jami
+
+CORE_TEST_RUNNER(jami::test::MediaStatsTest::name());
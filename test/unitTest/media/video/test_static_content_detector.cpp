@@ -0,0 +1,142 @@
+/*
+ *  Copyright (C) 2004-2026 Savoir-faire Linux Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "libav_deps.h"
+#include "videomanager_interface.h"
+#include "media/video/static_content_detector.h"
+
+#include "../../../test_runner.h"
+
+#include <cstring>
+
+using namespace std::literals::chrono_literals;
+
+namespace jami {
+namespace video {
+namespace test {
+
+class StaticContentDetectorTest : public CppUnit::TestFixture
+{
+public:
+    static std::string name() { return "static_content_detector"; }
+
+private:
+    void testUnchangedFramesDropped();
+    void testSmallChangeDetected();
+    void testPeriodicRefresh();
+    void testSizeChange();
+    void testScreenCaptureFormats();
+
+    CPPUNIT_TEST_SUITE(StaticContentDetectorTest);
+    CPPUNIT_TEST(testUnchangedFramesDropped);
+    CPPUNIT_TEST(testSmallChangeDetected);
+    CPPUNIT_TEST(testPeriodicRefresh);
+    CPPUNIT_TEST(testSizeChange);
+    CPPUNIT_TEST(testScreenCaptureFormats);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION(StaticContentDetectorTest, StaticContentDetectorTest::name());
+
+static std::shared_ptr<libjami::VideoFrame>
+makeScreenFrame(int width, int height, uint8_t value = 0)
+{
+    auto frame = std::make_shared<libjami::VideoFrame>();
+    frame->reserve(AV_PIX_FMT_BGR0, width, height);
+    auto* avframe = frame->pointer();
+    for (int y = 0; y < height; ++y)
+        std::memset(avframe->data[0] + y * avframe->linesize[0], value, width * 4);
+    return frame;
+}
+
+void
+StaticContentDetectorTest::testUnchangedFramesDropped()
+{
+    StaticContentDetector detector;
+    auto now = StaticContentDetector::clock::now();
+    auto frame = makeScreenFrame(1920, 1080);
+    CPPUNIT_ASSERT(detector.filter(*frame, now));
+    CPPUNIT_ASSERT(not detector.isStatic());
+    for (int i = 1; i < 10; ++i)
+        CPPUNIT_ASSERT(not detector.filter(*makeScreenFrame(1920, 1080), now + i * 33ms));
+    CPPUNIT_ASSERT(detector.isStatic());
+}
+
+void
+StaticContentDetectorTest::testSmallChangeDetected()
+{
+    StaticContentDetector detector;
+    auto frame = makeScreenFrame(1280, 720);
+    CPPUNIT_ASSERT(detector.update(*frame->pointer()) == StaticContentDetector::BLOCKS * StaticContentDetector::BLOCKS);
+    CPPUNIT_ASSERT(detector.update(*frame->pointer()) == 0);
+
+    // A text caret sized update in a single block
+    auto* avframe = frame->pointer();
+    for (int y = 370; y < 386; ++y)
+        std::memset(avframe->data[0] + y * avframe->linesize[0] + 600 * 4, 0xff, 2 * 4);
+    CPPUNIT_ASSERT(detector.update(*avframe) == 1);
+    CPPUNIT_ASSERT(detector.update(*avframe) == 0);
+}
+
+void
+StaticContentDetectorTest::testPeriodicRefresh()
+{
+    StaticContentDetector detector(500ms);
+    auto now = StaticContentDetector::clock::now();
+    auto frame = makeScreenFrame(640, 480);
+    CPPUNIT_ASSERT(detector.filter(*frame, now));
+    CPPUNIT_ASSERT(not detector.filter(*frame, now + 100ms));
+    CPPUNIT_ASSERT(not detector.filter(*frame, now + 400ms));
+    CPPUNIT_ASSERT(detector.filter(*frame, now + 500ms));
+    CPPUNIT_ASSERT(detector.isStatic());
+    CPPUNIT_ASSERT(not detector.filter(*frame, now + 600ms));
+}
+
+void
+StaticContentDetectorTest::testSizeChange()
+{
+    StaticContentDetector detector;
+    auto now = StaticContentDetector::clock::now();
+    CPPUNIT_ASSERT(detector.filter(*makeScreenFrame(640, 480), now));
+    CPPUNIT_ASSERT(not detector.filter(*makeScreenFrame(640, 480), now + 33ms));
+    // Window sharing: the captured window was resized
+    CPPUNIT_ASSERT(detector.filter(*makeScreenFrame(800, 600), now + 66ms));
+    CPPUNIT_ASSERT(not detector.isStatic());
+}
+
+void
+StaticContentDetectorTest::testScreenCaptureFormats()
+{
+    CPPUNIT_ASSERT(StaticContentDetector::isScreenCapture("x11grab"));
+    CPPUNIT_ASSERT(StaticContentDetector::isScreenCapture("pipewiregrab"));
+    CPPUNIT_ASSERT(StaticContentDetector::isScreenCapture("dxgigrab"));
+    // Cameras and files are never treated as static content
+    CPPUNIT_ASSERT(not StaticContentDetector::isScreenCapture("v4l2"));
+    CPPUNIT_ASSERT(not StaticContentDetector::isScreenCapture("avfoundation"));
+    CPPUNIT_ASSERT(not StaticContentDetector::isScreenCapture("lavfi"));
+    CPPUNIT_ASSERT(not StaticContentDetector::isScreenCapture(""));
+}
+
+} // namespace test
+} // namespace video
+} // namespace jami
+
+CORE_TEST_RUNNER(jami::video::test::StaticContentDetectorTest::name());
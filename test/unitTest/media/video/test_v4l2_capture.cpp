@@ -0,0 +1,199 @@
+/*
+ *  Copyright (C) 2004-2026 Savoir-faire Linux Inc.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cppunit/TestAssert.h>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "test_runner.h"
+
+#include "libav_deps.h"
+#include "media/video/v4l2/v4l2_capture.h"
+
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <linux/videodev2.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+}
+
+namespace jami {
+namespace test {
+
+/**
+ * Uses the vivid virtual driver (modprobe vivid). Tests are skipped when no
+ * vivid device is present.
+ */
+class V4l2CaptureTest : public CppUnit::TestFixture
+{
+public:
+    static std::string name() { return "v4l2_capture"; }
+
+    void setUp();
+
+private:
+    void testBackendSelection();
+    void testRawCapture();
+    void testBufferRecycling();
+    void testFramesOutliveCapture();
+
+    CPPUNIT_TEST_SUITE(V4l2CaptureTest);
+    CPPUNIT_TEST(testBackendSelection);
+    CPPUNIT_TEST(testRawCapture);
+    CPPUNIT_TEST(testBufferRecycling);
+    CPPUNIT_TEST(testFramesOutliveCapture);
+    CPPUNIT_TEST_SUITE_END();
+
+    DeviceParams params_;
+    bool available_ {false};
+};
+
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION(V4l2CaptureTest, V4l2CaptureTest::name());
+
+static std::string
+findVividDevice()
+{
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator("/dev", ec)) {
+        auto path = entry.path().string();
+        if (path.rfind("/dev/video", 0) != 0)
+            continue;
+        int fd = open(path.c_str(), O_RDWR | O_NONBLOCK);
+        if (fd < 0)
+            continue;
+        v4l2_capability cap {};
+        bool vivid = ioctl(fd, VIDIOC_QUERYCAP, &cap) == 0
+                     && std::string(reinterpret_cast<const char*>(cap.driver)) == "vivid"
+                     && (cap.device_caps & V4L2_CAP_VIDEO_CAPTURE);
+        close(fd);
+        if (vivid)
+            return path;
+    }
+    return {};
+}
+
+void
+V4l2CaptureTest::setUp()
+{
+    auto device = findVividDevice();
+    available_ = not device.empty();
+    if (not available_) {
+        std::cout << "No vivid device found, skipping" << std::endl;
+        return;
+    }
+    params_.input = device;
+    params_.format = "video4linux2";
+    params_.width = 640;
+    params_.height = 360;
+    params_.framerate = 30;
+}
+
+void
+V4l2CaptureTest::testBackendSelection()
+{
+    // Does not need a device
+    if (getenv("JAMI_DISABLE_V4L2_CAPTURE"))
+        return;
+    DeviceParams params;
+    params.format = "video4linux2";
+    CPPUNIT_ASSERT(video::V4l2Capture::isSupported(params));
+    params.pixel_format = "mjpeg";
+    CPPUNIT_ASSERT(video::V4l2Capture::isSupported(params));
+    // The packets of a passthrough camera are sent as is, not decoded
+    params.passthrough = true;
+    CPPUNIT_ASSERT(!video::V4l2Capture::isSupported(params));
+    params.pixel_format = "h264";
+    CPPUNIT_ASSERT(!video::V4l2Capture::isSupported(params));
+    params.passthrough = false;
+    CPPUNIT_ASSERT(!video::V4l2Capture::isSupported(params));
+    params.pixel_format = {};
+    params.format = "x11grab";
+    CPPUNIT_ASSERT(!video::V4l2Capture::isSupported(params));
+}
+
+void
+V4l2CaptureTest::testRawCapture()
+{
+    if (not available_)
+        return;
+    video::V4l2Capture capture(params_);
+    CPPUNIT_ASSERT(capture.getWidth() > 0);
+    CPPUNIT_ASSERT(capture.getHeight() > 0);
+    CPPUNIT_ASSERT(capture.getPixelFormat() != AV_PIX_FMT_NONE);
+
+    std::shared_ptr<VideoFrame> frame;
+    auto status = video::V4l2Capture::Status::Again;
+    for (int i = 0; i < 50 && status == video::V4l2Capture::Status::Again; ++i)
+        status = capture.capture(frame, std::chrono::milliseconds(100));
+    CPPUNIT_ASSERT(status == video::V4l2Capture::Status::Success);
+    CPPUNIT_ASSERT(frame);
+    CPPUNIT_ASSERT(frame->width() == capture.getWidth());
+    CPPUNIT_ASSERT(frame->height() == capture.getHeight());
+    CPPUNIT_ASSERT(frame->pointer()->data[0] != nullptr);
+}
+
+void
+V4l2CaptureTest::testBufferRecycling()
+{
+    if (not available_)
+        return;
+    video::V4l2Capture capture(params_, 3);
+    // Many more frames than buffers: each released frame must go back to the driver
+    int captured = 0;
+    for (int i = 0; i < 300 && captured < 30; ++i) {
+        std::shared_ptr<VideoFrame> frame;
+        auto status = capture.capture(frame, std::chrono::milliseconds(100));
+        CPPUNIT_ASSERT(status != video::V4l2Capture::Status::Error);
+        if (status == video::V4l2Capture::Status::Success)
+            ++captured;
+    }
+    CPPUNIT_ASSERT(captured == 30);
+}
+
+void
+V4l2CaptureTest::testFramesOutliveCapture()
+{
+    if (not available_)
+        return;
+    std::vector<std::shared_ptr<VideoFrame>> frames;
+    {
+        video::V4l2Capture capture(params_);
+        for (int i = 0; i < 100 && frames.size() < 2; ++i) {
+            std::shared_ptr<VideoFrame> frame;
+            if (capture.capture(frame, std::chrono::milliseconds(100)) == video::V4l2Capture::Status::Success)
+                frames.emplace_back(std::move(frame));
+        }
+    }
+    CPPUNIT_ASSERT(frames.size() == 2);
+    // Mappings must still be valid once the capture is gone
+    for (const auto& frame : frames) {
+        volatile uint8_t first = frame->pointer()->data[0][0];
+        (void) first;
+        CPPUNIT_ASSERT(frame->size() > 0);
+    }
+    frames.clear();
+}
+
+} // namespace test
+} // namespace jami
+
+CORE_TEST_RUNNER(jami::test::V4l2CaptureTest::name());
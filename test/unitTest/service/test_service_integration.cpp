@@ -20,6 +20,7 @@
 #include <cppunit/extensions/HelperMacros.h>
 
 #include <atomic>
+#include <cerrno>
 #include <chrono>
 #include <condition_variable>
 #include <mutex>
@@ -38,6 +39,8 @@
 #include "jami/networkservice_interface.h"
 #include "jamidht/jamiaccount.h"
 #include "jamidht/service_manager.h"
+#include "jamidht/svc_relay.h"
+#include "logger.h"
 #include "manager.h"
 
 using namespace std::literals::chrono_literals;
@@ -148,9 +151,11 @@ public:
 
 private:
     void testQueryAndTunnelEcho();
+    void testTunnelThroughput();
 
     CPPUNIT_TEST_SUITE(ServiceIntegrationTest);
     CPPUNIT_TEST(testQueryAndTunnelEcho);
+    CPPUNIT_TEST(testTunnelThroughput);
     CPPUNIT_TEST_SUITE_END();
 
     std::string aliceId;
@@ -317,34 +322,250 @@ ServiceIntegrationTest::testQueryAndTunnelEcho()
     CPPUNIT_ASSERT(openedLocalPort != 0);
 
     // --- Connect a TCP client to the local tunnel and round-trip data ---
-    int client = ::socket(AF_INET, SOCK_STREAM, 0);
-    CPPUNIT_ASSERT(client >= 0);
-    sockaddr_in addr {};
-    addr.sin_family = AF_INET;
-    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
-    addr.sin_port = htons(openedLocalPort);
-    CPPUNIT_ASSERT(::connect(client, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
-
-    const char* hello = "ping";
-    CPPUNIT_ASSERT_EQUAL(ssize_t {4}, ::send(client, hello, 4, 0));
-
-    char buf[16] {};
-    // The first read may need a few retries while the dhtnet channel finishes
-    // its handshake on the alice side.
-    ssize_t n = 0;
+    auto echoThroughTunnel = [&](const std::string& message) {
+        int client = ::socket(AF_INET, SOCK_STREAM, 0);
+        CPPUNIT_ASSERT(client >= 0);
+        sockaddr_in addr {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(openedLocalPort);
+        CPPUNIT_ASSERT(::connect(client, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+
+        auto size = static_cast<ssize_t>(message.size());
+        CPPUNIT_ASSERT_EQUAL(size, ::send(client, message.data(), message.size(), 0));
+
+        char buf[16] {};
+        // The first read may need a few retries while the dhtnet channel finishes
+        // its handshake on the alice side.
+        ssize_t n = 0;
+        auto until = std::chrono::steady_clock::now() + 30s;
+        while (n < size && std::chrono::steady_clock::now() < until) {
+            ssize_t r = ::recv(client, buf + n, size - n, 0);
+            if (r > 0)
+                n += r;
+            else if (r == 0)
+                break;
+            else
+                std::this_thread::sleep_for(50ms);
+        }
+        ::close(client);
+        CPPUNIT_ASSERT_EQUAL(size, n);
+        CPPUNIT_ASSERT_EQUAL(message, std::string(buf, n));
+    };
+    echoThroughTunnel("ping");
+
+    // --- Later connections are served by channels pre-opened in the background ---
+    auto tunnelInfo = [&]() -> std::map<std::string, std::string> {
+        for (auto& t : libjami::getActiveTunnels(bobId))
+            if (t["id"] == tunnelId)
+                return t;
+        return {};
+    };
     auto until = std::chrono::steady_clock::now() + 30s;
-    while (n < 4 && std::chrono::steady_clock::now() < until) {
-        ssize_t r = ::recv(client, buf + n, 4 - n, 0);
-        if (r > 0)
-            n += r;
-        else if (r == 0)
+    while (tunnelInfo()["pooledChannels"] != tunnelInfo()["poolSize"] && std::chrono::steady_clock::now() < until)
+        std::this_thread::sleep_for(50ms);
+    CPPUNIT_ASSERT(tunnelInfo()["poolSize"] != "0");
+    CPPUNIT_ASSERT_EQUAL(tunnelInfo()["poolSize"], tunnelInfo()["pooledChannels"]);
+    echoThroughTunnel("pong");
+    auto info = tunnelInfo();
+    CPPUNIT_ASSERT_EQUAL(std::string("2"), info["connections"]);
+    CPPUNIT_ASSERT(info["pooledConnections"] != "0");
+    CPPUNIT_ASSERT(!info["averageSetupLatencyMs"].empty());
+
+    // --- Disabling the pool drops the pre-opened channels ---
+    CPPUNIT_ASSERT(libjami::setServiceTunnelPoolSize(bobId, tunnelId, 0));
+    CPPUNIT_ASSERT_EQUAL(std::string("0"), tunnelInfo()["pooledChannels"]);
+    echoThroughTunnel("ping");
+
+    CPPUNIT_ASSERT(libjami::closeServiceTunnel(bobId, tunnelId));
+}
+
+void
+ServiceIntegrationTest::testTunnelThroughput()
+{
+    auto alice = Manager::instance().getAccount<JamiAccount>(aliceId);
+    auto bob = Manager::instance().getAccount<JamiAccount>(bobId);
+    auto aliceUri = alice->getUsername();
+    auto bobUri = bob->getUsername();
+
+    bool bobReceivedRequest = false;
+    bool contactsAdded = false;
+    std::string openedTunnelId;
+    uint16_t openedLocalPort = 0;
+    handlers_.insert(libjami::exportable_callback<libjami::ConfigurationSignal::IncomingTrustRequest>(
+        [&](const std::string& accountId,
+            const std::string&,
+            const std::string&,
+            const std::vector<uint8_t>&,
+            time_t) {
+            std::lock_guard lk(mtx_);
+            if (accountId == bobId)
+                bobReceivedRequest = true;
+            cv_.notify_all();
+        }));
+    handlers_.insert(libjami::exportable_callback<libjami::ConfigurationSignal::ContactAdded>(
+        [&](const std::string& accountId, const std::string&, bool confirmed) {
+            std::lock_guard lk(mtx_);
+            if (accountId == aliceId && confirmed)
+                contactsAdded = true;
+            cv_.notify_all();
+        }));
+    handlers_.insert(libjami::exportable_callback<libjami::ServiceSignal::TunnelOpened>(
+        [&](const std::string& accountId, const std::string& tunnelId, uint16_t localPort) {
+            if (accountId != bobId)
+                return;
+            std::lock_guard lk(mtx_);
+            openedTunnelId = tunnelId;
+            openedLocalPort = localPort;
+            cv_.notify_all();
+        }));
+    libjami::registerSignalHandlers(handlers_);
+
+    TinyEchoServer echo;
+    ServiceRecord rec;
+    rec.name = "echo";
+    rec.localHost = "127.0.0.1";
+    rec.localPort = echo.port();
+    rec.policy = AccessPolicy::PUBLIC;
+    auto serviceId = alice->serviceManager().addService(rec, alice->rand);
+    CPPUNIT_ASSERT(!serviceId.empty());
+
+    alice->addContact(bobUri);
+    alice->sendTrustRequest(bobUri, {});
+    {
+        std::unique_lock lk(mtx_);
+        CPPUNIT_ASSERT(cv_.wait_for(lk, 60s, [&] { return bobReceivedRequest; }));
+    }
+    CPPUNIT_ASSERT(bob->acceptTrustRequest(aliceUri));
+    {
+        std::unique_lock lk(mtx_);
+        CPPUNIT_ASSERT(cv_.wait_for(lk, 60s, [&] { return contactsAdded; }));
+    }
+
+    auto deviceId = std::string(alice->currentDeviceId());
+    auto tunnelId = libjami::openServiceTunnel(bobId, aliceUri, deviceId, serviceId, "echo", 0);
+    CPPUNIT_ASSERT(!tunnelId.empty());
+    {
+        std::unique_lock lk(mtx_);
+        CPPUNIT_ASSERT(cv_.wait_for(lk, 5s, [&] { return openedTunnelId == tunnelId; }));
+    }
+
+    auto connectTunnel = [&] {
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        CPPUNIT_ASSERT(fd >= 0);
+        sockaddr_in addr {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(openedLocalPort);
+        CPPUNIT_ASSERT(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+        return fd;
+    };
+    auto tunnelInfo = [&] {
+        std::map<std::string, std::string> info;
+        for (auto& t : libjami::getActiveTunnels(bobId))
+            if (t["id"] == tunnelId)
+                info = t;
+        return info;
+    };
+    int client = connectTunnel();
+
+    // Stream 32 MiB through the tunnel and the echo service, reading the
+    // echoed data while it is sent.
+    constexpr size_t TOTAL = 32 * 1024 * 1024;
+    auto pattern = [](size_t i) {
+        return static_cast<char>((i * 31) % 251);
+    };
+    auto start = std::chrono::steady_clock::now();
+    std::thread writer([&] {
+        std::vector<char> chunk(64 * 1024);
+        for (size_t sent = 0; sent < TOTAL;) {
+            auto n = std::min(chunk.size(), TOTAL - sent);
+            for (size_t i = 0; i < n; ++i)
+                chunk[i] = pattern(sent + i);
+            for (size_t off = 0; off < n;) {
+                auto w = ::send(client, chunk.data() + off, n - off, MSG_NOSIGNAL);
+                if (w <= 0)
+                    return;
+                off += static_cast<size_t>(w);
+            }
+            sent += n;
+        }
+    });
+    size_t received = 0;
+    bool intact = true;
+    std::vector<char> buf(64 * 1024);
+    auto until = std::chrono::steady_clock::now() + 120s;
+    while (received < TOTAL && std::chrono::steady_clock::now() < until) {
+        auto r = ::recv(client, buf.data(), buf.size(), 0);
+        if (r <= 0)
+            break;
+        for (ssize_t i = 0; i < r; ++i)
+            intact = intact && buf[i] == pattern(received + i);
+        received += static_cast<size_t>(r);
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    ::shutdown(client, SHUT_RDWR);
+    writer.join();
+    ::close(client);
+
+    auto info = tunnelInfo();
+    JAMI_LOG("Tunnel throughput: {} MiB echoed in {:.2f} s ({:.1f} MiB/s), peak queue {} bytes",
+             TOTAL / (1024 * 1024),
+             elapsed,
+             TOTAL / (1024. * 1024.) / elapsed,
+             info["peakQueuedBytes"]);
+
+    CPPUNIT_ASSERT_EQUAL(TOTAL, received);
+    CPPUNIT_ASSERT(intact);
+    CPPUNIT_ASSERT_EQUAL(std::to_string(TOTAL), info["bytesToPeer"]);
+    CPPUNIT_ASSERT_EQUAL(std::to_string(TOTAL), info["bytesFromPeer"]);
+    CPPUNIT_ASSERT(std::stoull(info["peakQueuedBytes"]) <= SvcRelay::HIGH_WATERMARK);
+
+    // A local reader that is stuck pauses the writer on the other side,
+    // instead of growing the queues or stalling every channel to the peer
+    // device. Its connection stays open.
+    auto pauses = tunnelInfo()["flowPauses"];
+    int stuck = connectTunnel();
+    timeval timeout {1, 0};
+    ::setsockopt(stuck, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    std::vector<char> chunk(64 * 1024, 'x');
+    size_t stuckSent = 0;
+    until = std::chrono::steady_clock::now() + 60s;
+    while (tunnelInfo()["flowPauses"] == pauses && std::chrono::steady_clock::now() < until) {
+        auto w = ::send(stuck, chunk.data(), chunk.size(), MSG_NOSIGNAL);
+        if (w > 0)
+            stuckSent += static_cast<size_t>(w);
+        else if (errno != EAGAIN && errno != EWOULDBLOCK)
+            break;
+    }
+    CPPUNIT_ASSERT(tunnelInfo()["flowPauses"] != pauses);
+    CPPUNIT_ASSERT(std::stoull(tunnelInfo()["peakQueuedBytes"]) <= SvcRelay::HIGH_WATERMARK);
+    // Once read again, every byte comes back
+    size_t stuckReceived = 0;
+    until = std::chrono::steady_clock::now() + 60s;
+    while (stuckReceived < stuckSent && std::chrono::steady_clock::now() < until) {
+        auto r = ::recv(stuck, buf.data(), buf.size(), 0);
+        if (r <= 0)
+            break;
+        stuckReceived += static_cast<size_t>(r);
+    }
+    CPPUNIT_ASSERT_EQUAL(stuckSent, stuckReceived);
+    ::close(stuck);
+
+    // The tunnel keeps serving the other connections
+    client = connectTunnel();
+    CPPUNIT_ASSERT_EQUAL(ssize_t(4), ::send(client, "ping", 4, MSG_NOSIGNAL));
+    char pong[4] {};
+    size_t n = 0;
+    until = std::chrono::steady_clock::now() + 30s;
+    while (n < sizeof(pong) && std::chrono::steady_clock::now() < until) {
+        auto r = ::recv(client, pong + n, sizeof(pong) - n, 0);
+        if (r <= 0)
             break;
-        else
-            std::this_thread::sleep_for(50ms);
+        n += static_cast<size_t>(r);
     }
     ::close(client);
-    CPPUNIT_ASSERT_EQUAL(ssize_t {4}, n);
-    CPPUNIT_ASSERT_EQUAL(std::string("ping"), std::string(buf, 4));
+    CPPUNIT_ASSERT_EQUAL(std::string("ping"), std::string(pong, n));
 
     CPPUNIT_ASSERT(libjami::closeServiceTunnel(bobId, tunnelId));
 }
@@ -21,6 +21,7 @@
 
 #include "jamidht/service_manager.h"
 #include "jamidht/svc_protocol.h"
+#include "jamidht/svc_tunnel_channel_handler.h"
 #include "uri.h"
 
 #include <filesystem>
@@ -84,6 +85,8 @@ private:
     void protocol_peek_type_test();
     void protocol_peek_version_test();
     void protocol_version_mismatch_roundtrip_test();
+    void tunnel_pool_backoff_test();
+    void tunnel_channel_name_test();
 
     CPPUNIT_TEST_SUITE(ServiceManagerTest);
     CPPUNIT_TEST(uuid_format_test);
@@ -107,6 +110,8 @@ private:
     CPPUNIT_TEST(protocol_peek_type_test);
     CPPUNIT_TEST(protocol_peek_version_test);
     CPPUNIT_TEST(protocol_version_mismatch_roundtrip_test);
+    CPPUNIT_TEST(tunnel_pool_backoff_test);
+    CPPUNIT_TEST(tunnel_channel_name_test);
     CPPUNIT_TEST_SUITE_END();
 };
 
@@ -500,6 +505,45 @@ ServiceManagerTest::protocol_version_mismatch_roundtrip_test()
     CPPUNIT_ASSERT_EQUAL(uint8_t {1}, decoded.max_supported);
 }
 
+void
+ServiceManagerTest::tunnel_pool_backoff_test()
+{
+    using namespace std::chrono_literals;
+    using Handler = SvcTunnelChannelHandler;
+    CPPUNIT_ASSERT(Handler::poolBackoff(0) == 0ms);
+    CPPUNIT_ASSERT(Handler::poolBackoff(1) == Handler::kPoolMinBackoff);
+    CPPUNIT_ASSERT(Handler::poolBackoff(2) == 2 * Handler::kPoolMinBackoff);
+    CPPUNIT_ASSERT(Handler::poolBackoff(3) == 4 * Handler::kPoolMinBackoff);
+    CPPUNIT_ASSERT(Handler::poolBackoff(10) == Handler::kPoolMaxBackoff);
+    CPPUNIT_ASSERT(Handler::poolBackoff(1000) == Handler::kPoolMaxBackoff);
+}
+
+void
+ServiceManagerTest::tunnel_channel_name_test()
+{
+    using Handler = SvcTunnelChannelHandler;
+    auto id = generateServiceUuid(rng_);
+    auto name = std::string(svc_protocol::TunnelChannelPrefix) + id;
+    CPPUNIT_ASSERT_EQUAL(name, Handler::tunnelChannelName(id, false, false));
+    auto pooledName = Handler::tunnelChannelName(id, true, true);
+    auto flowName = Handler::tunnelChannelName(id, false, true);
+    CPPUNIT_ASSERT_EQUAL(name + "?pooled&flow", pooledName);
+    CPPUNIT_ASSERT_EQUAL(name + "?flow", flowName);
+    CPPUNIT_ASSERT_EQUAL(id, Handler::parseServiceId(name));
+    CPPUNIT_ASSERT_EQUAL(id, Handler::parseServiceId(pooledName));
+    CPPUNIT_ASSERT_EQUAL(id, Handler::parseServiceId(flowName));
+    CPPUNIT_ASSERT(!Handler::isPooledChannel(name));
+    CPPUNIT_ASSERT(Handler::isPooledChannel(pooledName));
+    CPPUNIT_ASSERT(!Handler::isPooledChannel(flowName));
+    CPPUNIT_ASSERT(!Handler::hasChannelOption(name, svc_protocol::FlowOption));
+    CPPUNIT_ASSERT(Handler::hasChannelOption(pooledName, svc_protocol::FlowOption));
+    CPPUNIT_ASSERT(Handler::hasChannelOption(flowName, svc_protocol::FlowOption));
+    CPPUNIT_ASSERT(!Handler::hasChannelOption(name + "?flowing", svc_protocol::FlowOption));
+    CPPUNIT_ASSERT(Handler::parseServiceId("svc://").empty());
+    CPPUNIT_ASSERT(!Handler::isPooledChannel("svc://?pooled"));
+    CPPUNIT_ASSERT(Handler::parseServiceId("svcdisc://query").empty());
+}
+
 } // namespace test
 } // namespace jami
 
@@ -29,6 +29,7 @@
 #include "../../test_runner.h"
 #include "jami.h"
 #include "../common.h"
+#include "jamidht/swarm/certificate_lookups.h"
 #include "jamidht/swarm/swarm_manager.h"
 #include "nodes.h"
 
@@ -212,6 +213,8 @@ private:
     void testUnverifiableLeaseIsNeverFetched();
     void testResolvedCertificateWithBadSignatureIsRejected();
     void testPendingCertificateRequestsAreRetried();
+    void testCertificateLookupsAreShared();
+    void testCertificateLookupHandedOver();
     void testNotifyAgainstBruteForceOracle();
     void testNotifyResponsibilityHandover();
     void testKnownMobileNodes();
@@ -242,6 +245,8 @@ private:
     CPPUNIT_TEST(testUnverifiableLeaseIsNeverFetched);
     CPPUNIT_TEST(testResolvedCertificateWithBadSignatureIsRejected);
     CPPUNIT_TEST(testPendingCertificateRequestsAreRetried);
+    CPPUNIT_TEST(testCertificateLookupsAreShared);
+    CPPUNIT_TEST(testCertificateLookupHandedOver);
     CPPUNIT_TEST(testNotifyAgainstBruteForceOracle);
     CPPUNIT_TEST(testNotifyResponsibilityHandover);
     CPPUNIT_TEST(testKnownMobileNodes);
@@ -1234,6 +1239,80 @@ MobileWakeUpTest::testNotifyWithoutConnectedNodes()
     CPPUNIT_ASSERT(toSet(rt.getKnownMobileNodes()) == mobiles);
 }
 
+void
+MobileWakeUpTest::testCertificateLookupsAreShared()
+{
+    std::cout << "\nRunning test: " << __func__ << std::endl;
+
+    CertificateLookups lookups;
+    auto nodeId = PkId::get("device");
+    auto now = CertificateLookups::clock::now();
+    std::atomic_int found {0};
+    auto waiter = [&found](const auto& certificate) {
+        if (certificate)
+            ++found;
+    };
+    auto takeOver = [] {};
+
+    // The first conversation owns the lookup, the others wait for it
+    CPPUNIT_ASSERT(!lookups.wait(nodeId, waiter, takeOver, now));
+    CPPUNIT_ASSERT(lookups.wait(nodeId, waiter, takeOver, now));
+    CPPUNIT_ASSERT(lookups.wait(nodeId, waiter, takeOver, now));
+    CPPUNIT_ASSERT_EQUAL(size_t(1), lookups.pending());
+
+    auto certificate = dht::crypto::generateIdentity("device").second;
+    lookups.resolved(nodeId, certificate);
+    CPPUNIT_ASSERT(waitFor([&] { return found.load() == 2; }, 5s));
+    CPPUNIT_ASSERT_EQUAL(size_t(0), lookups.pending());
+
+    // An owner that never reports is replaced
+    CPPUNIT_ASSERT(!lookups.wait(nodeId, waiter, takeOver, now));
+    CPPUNIT_ASSERT(lookups.wait(nodeId, waiter, takeOver, now));
+    CPPUNIT_ASSERT(!lookups.wait(nodeId, waiter, takeOver, now + CertificateLookups::LOOKUP_TIMEOUT));
+    lookups.resolved(nodeId, certificate);
+    CPPUNIT_ASSERT(waitFor([&] { return found.load() == 3; }, 5s));
+}
+
+void
+MobileWakeUpTest::testCertificateLookupHandedOver()
+{
+    std::cout << "\nRunning test: " << __func__ << std::endl;
+
+    CertificateLookups lookups;
+    auto nodeId = PkId::get("device");
+    std::atomic_int found {0};
+    std::atomic_int missing {0};
+    auto waiter = [&](const auto& certificate) {
+        if (certificate)
+            ++found;
+        else
+            ++missing;
+    };
+    std::atomic_int takenOver {0};
+    auto takeOver = [&] { ++takenOver; };
+
+    CPPUNIT_ASSERT(!lookups.wait(nodeId, waiter, takeOver));
+    CPPUNIT_ASSERT(lookups.wait(nodeId, waiter, takeOver));
+    CPPUNIT_ASSERT(lookups.wait(nodeId, waiter, takeOver));
+
+    // The owner shuts down: one waiter owns the lookup, the other keeps waiting
+    lookups.release(nodeId);
+    CPPUNIT_ASSERT(waitFor([&] { return takenOver.load() == 1; }, 5s));
+    CPPUNIT_ASSERT_EQUAL(0, missing.load());
+    CPPUNIT_ASSERT_EQUAL(size_t(1), lookups.pending());
+    CPPUNIT_ASSERT(lookups.wait(nodeId, waiter, takeOver));
+
+    lookups.resolved(nodeId, dht::crypto::generateIdentity("device").second);
+    CPPUNIT_ASSERT(waitFor([&] { return found.load() == 2; }, 5s));
+    CPPUNIT_ASSERT_EQUAL(1, takenOver.load());
+
+    // Released without any waiter, the lookup is forgotten
+    CPPUNIT_ASSERT(!lookups.wait(nodeId, waiter, takeOver));
+    lookups.release(nodeId);
+    CPPUNIT_ASSERT_EQUAL(size_t(0), lookups.pending());
+    CPPUNIT_ASSERT_EQUAL(0, missing.load());
+}
+
 void
 MobileWakeUpTest::testNotifyAgainstBruteForceOracle()
 {